@@ -8,22 +8,45 @@
 #include "lexer.h"
 #include "tokens.h"
 #include "statement_parser.h"
+#include "native_library.h"
 
 
 using namespace flexMC;
 
 
-int main() {
+int main(int argc, char *argv[]) {
 
     // report version
     std::cout << "Version: " << APP_VERSION_MAJOR << "."
               << APP_VERSION_MINOR << "."
               << APP_VERSION_PATCH << std::endl;
 
+    // app <library> <function> : runs a script transpiled by flexmc_transpile, without parameters
+    if (argc == 3) {
+        NativeLibrary library;
+        if (const MaybeError report = library.open(argv[1]); report.isError()) {
+            std::cout << report.msg() << "\n";
+            return 1;
+        }
+        const auto [report, function] = library.function(argv[2]);
+        if (report.isError()) {
+            std::cout << report.msg() << "\n";
+            return 1;
+        }
+        CalcStacks stacks(16, 16, 0, 0);
+        const Parameters parameters;
+        function(stacks, parameters, vectorMath::kernels());
+        for (const SCALAR &s: stacks.scalars()) {
+            std::cout << s << " ";
+        }
+        std::cout << "\n";
+        return 0;
+    }
+
 //    std::string program = "myVariableDate PAY *= ";
 //
 //    Lexer l;
-//    std::deque<Token> infix = l.tokenize(program);
+//    std::vector<Token> infix = l.tokenize(program);
 //
 //    const auto [parse_report, line_start] = splitLine(infix);
 //
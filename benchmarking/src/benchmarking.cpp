@@ -1,15 +1,32 @@
+#include <algorithm>
+#include <functional>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <cassert>
+#include <cstdlib>
 #include <ranges>
+#if !defined(_WIN32)
+#include <spawn.h>
+#include <sys/wait.h>
+#endif
 #include <benchmark/benchmark.h>
 
 #include <iostream>
 
 #include "lexer.h"
+#include "script.h"
+#include "script_compiler.h"
 #include "expression_parser.h"
+#include "statement_parser.h"
 #include "expression_compiler.h"
 #include "expression_stacks.h"
+#include "byte_code.h"
+#include "register_code.h"
+#include "peephole.h"
+#include "loop_fusion.h"
+#include "jit_code.h"
+#include "vector_math.h"
 
 
 using namespace flexMC;
@@ -18,8 +35,11 @@ using namespace flexMC;
 // Learn about inheritance in c++ to reduce code duplication
 
 
+// Expression_t is either Expression (one std::function per postfix node), ByteCode (flat instruction stream) or
+// JitCode (machine code for scalar expressions)
+template<class Expression_t>
 CompileReport parseExpressions(const std::vector<std::string> &str_expressions,
-                               std::vector<Expression> &expressions,
+                               std::vector<Expression_t> &expressions,
                                StaticVStorage &s_variables) {
     assert(expressions.size() == str_expressions.size());
     Lexer l;
@@ -100,8 +120,24 @@ const std::vector<std::string> VECTOR_REDUCE_EXPRESSIONS = {
 };
 
 
+StaticVStorage scalarVariables() {
+    StaticVStorage s_variables;
+    s_variables.insert<SCALAR>("one", 1);
+    s_variables.insert<SCALAR>("x", 2);
+    s_variables.insert<SCALAR>("y", 3);
+    s_variables.insert<SCALAR>("z", 4);
+    s_variables.insert<SCALAR>("a", 5);
+    s_variables.insert<SCALAR>("b", 7);
+    s_variables.insert<SCALAR>("c", 8);
+    s_variables.insert<SCALAR>("d", 9);
+    s_variables.insert<SCALAR>("e", 10);
+    return s_variables;
+}
+
+
+template<class Expression_t>
 static void BM_Scalars(benchmark::State &state) {
-    std::vector<Expression> expressions(5);
+    std::vector<Expression_t> expressions(5);
     StaticVStorage s_variables;
     const auto report = parseExpressions(SCALAR_EXPRESSIONS, expressions, s_variables);
     CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
@@ -119,8 +155,9 @@ static void BM_Scalars(benchmark::State &state) {
 }
 
 
+template<class Expression_t>
 static void BM_Vectors(benchmark::State &state) {
-    std::vector<Expression> expressions(5);
+    std::vector<Expression_t> expressions(5);
     StaticVStorage s_variables;
     const auto report = parseExpressions(VECTOR_EXPRESSIONS, expressions, s_variables);
     CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
@@ -137,8 +174,9 @@ static void BM_Vectors(benchmark::State &state) {
 }
 
 
+template<class Expression_t>
 static void BM_ReduceScalars(benchmark::State &state) {
-    std::vector<Expression> expressions(6);
+    std::vector<Expression_t> expressions(6);
     StaticVStorage s_variables;
     const auto report = parseExpressions(SCALAR_REDUCE_EXPRESSIONS, expressions, s_variables);
     CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
@@ -155,8 +193,9 @@ static void BM_ReduceScalars(benchmark::State &state) {
 }
 
 
+template<class Expression_t>
 static void BM_ReduceVectors(benchmark::State &state) {
-    std::vector<Expression> expressions(6);
+    std::vector<Expression_t> expressions(6);
     StaticVStorage s_variables;
     const auto report = parseExpressions(VECTOR_REDUCE_EXPRESSIONS, expressions, s_variables);
     CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
@@ -173,18 +212,304 @@ static void BM_ReduceVectors(benchmark::State &state) {
 }
 
 
-static void BM_StaticScalarVars(benchmark::State &state) {
-    std::vector<Expression> expressions(5);
+const std::vector<std::string> LENGTH_REDUCE_EXPRESSIONS = {
+    {"SUM(values)"},
+    {"PROD(values)"},
+    {"MAX(values)"},
+    {"ARGMIN(values)"},
+};
+
+
+// close to one, PROD stays finite for a million elements
+std::vector<SCALAR> reduceValues(const std::size_t &size) {
+    std::vector<SCALAR> values(size);
+    for (std::size_t i{0}; i < size; ++i) {
+        values[i] = 1.0 + 1e-7 * static_cast<double>((i * 37) % 97);
+    }
+    return values;
+}
+
+
+// range(0) is the length of the reduced vector, a parameter so that the reductions are not folded at compile time
+template<class Expression_t>
+static void BM_ReduceVectorLength(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    std::vector<Expression_t> expressions(LENGTH_REDUCE_EXPRESSIONS.size());
     StaticVStorage s_variables;
-    s_variables.insert<SCALAR>("one", 1);
-    s_variables.insert<SCALAR>("x", 2);
-    s_variables.insert<SCALAR>("y", 3);
-    s_variables.insert<SCALAR>("z", 4);
-    s_variables.insert<SCALAR>("a", 5);
-    s_variables.insert<SCALAR>("b", 7);
-    s_variables.insert<SCALAR>("c", 8);
-    s_variables.insert<SCALAR>("d", 9);
-    s_variables.insert<SCALAR>("e", 10);
+    s_variables.insertParameter<VECTOR>("values", reduceValues(size));
+    const auto report = parseExpressions(LENGTH_REDUCE_EXPRESSIONS, expressions, s_variables);
+    CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
+    for (auto _: state) {
+        for (const auto &exp: expressions) {
+            exp(stacks);
+            benchmark::DoNotOptimize(stacks.scalars().back());
+            stacks.scalars().pop_back();
+            assert(stacks.ready());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size * expressions.size()));
+}
+
+
+// the same reductions with std::accumulate and std::min_element / std::max_element, for reference
+static void BM_ReduceVectorLengthStd(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const std::vector<SCALAR> values = reduceValues(size);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(std::accumulate(values.begin(), values.end(), 0.0));
+        benchmark::DoNotOptimize(std::accumulate(values.begin(), values.end(), 1.0, std::multiplies<>()));
+        benchmark::DoNotOptimize(*std::max_element(values.begin(), values.end()));
+        benchmark::DoNotOptimize(std::min_element(values.begin(), values.end()) - values.begin());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(size * 4));
+}
+
+
+// Operators and functions of all kinds, as in a payoff script: compile throughput depends on how fast the compiler
+// dispatches each of them
+const std::vector<std::string> COMPILE_EXPRESSIONS = {
+    "(x * y*LOG(EXP(-x))) / -(a - x) + e - SQRT(z) - SQUARE(x)",
+    "MAX(x / a - 1, y / b - 1, z / c - 1, 0) * 100",
+    "MIN(x / a, y / b, z / c) ** 2 - ABS(d - e)",
+    "SUM(range * 2 + 1) / LEN(range) + PROD(range / 4)",
+    "ARGMAX(range - x) + ARGMIN(range * range) + MAX(EXP(range))",
+};
+
+
+// compiles range(0) expressions per iteration from their postfix tokens, lexer and parser are not timed
+template<class Expression_t>
+static void BM_Compile(benchmark::State &state) {
+    StaticVStorage s_variables = scalarVariables();
+    s_variables.insert<VECTOR>("range", {1, 2, 3, 4});
+    Lexer l;
+    std::vector<std::vector<Token>> postfixes;
+    for (const auto &exp_str: COMPILE_EXPRESSIONS) {
+        postfixes.push_back(infixToPostfix(l.tokenize(exp_str)).second);
+    }
+    for (auto _: state) {
+        const std::size_t end = state.range(0);
+        for (std::size_t i{0}; i < end; ++i) {
+            for (const auto &postfix: postfixes) {
+                Expression_t exp;
+                benchmark::DoNotOptimize(compileExpression(postfix, exp, s_variables));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(postfixes.size()));
+}
+
+
+#if !defined(_WIN32)
+// Set in the environment of the child processes of BM_Startup
+constexpr const char *STARTUP_PROBE = "FLEXMC_STARTUP_PROBE";
+
+// argv[0] of the benchmarking process, spawned again by BM_Startup
+static const char *self_path = nullptr;
+
+
+// What a child process of BM_Startup does instead of running the benchmarks
+static int compileFirstExpression() {
+    StaticVStorage s_variables = scalarVariables();
+    Lexer l;
+    ByteCode exp;
+    const auto [report, postfix] = infixToPostfix(l.tokenize(COMPILE_EXPRESSIONS[0]));
+    if (report.isError()) {
+        return EXIT_FAILURE;
+    }
+    return compileExpression(postfix, exp, s_variables).first.isError() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+// Process launch to the first compiled expression, i.e. loading and static initialisation of the binary
+static void BM_Startup(benchmark::State &state) {
+    const std::string probe = std::string(STARTUP_PROBE) + "=1";
+    char *const argv[] = {const_cast<char *>(self_path), nullptr};
+    char *const envp[] = {const_cast<char *>(probe.c_str()), nullptr};
+    for (auto _: state) {
+        pid_t pid;
+        int status{0};
+        if ((posix_spawnp(&pid, self_path, nullptr, nullptr, argv, envp) != 0) ||
+            (waitpid(pid, &status, 0) != pid) ||
+            !WIFEXITED(status) ||
+            (WEXITSTATUS(status) != EXIT_SUCCESS)) {
+            state.SkipWithError("Startup probe failed");
+            break;
+        }
+    }
+}
+#endif
+
+
+// tokenizes a line of range(0) characters made of COMPILE_EXPRESSIONS, up to MAX_LINE_LEN
+static void BM_Lexer(benchmark::State &state) {
+    std::string line;
+    for (std::size_t i{0}; line.size() < static_cast<std::size_t>(state.range(0)); ++i) {
+        line += COMPILE_EXPRESSIONS[i % COMPILE_EXPRESSIONS.size()] + " + ";
+    }
+    line.resize(state.range(0));
+    Lexer l;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(l.tokenize(line));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+
+// lexes and parses COMPILE_EXPRESSIONS into postfix, range(0) times per iteration
+static void BM_FrontEnd(benchmark::State &state) {
+    Lexer l;
+    for (auto _: state) {
+        const std::size_t end = state.range(0);
+        for (std::size_t i{0}; i < end; ++i) {
+            for (const auto &exp_str: COMPILE_EXPRESSIONS) {
+                benchmark::DoNotOptimize(infixToPostfix(l.tokenize(exp_str)));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) *
+                            static_cast<std::int64_t>(COMPILE_EXPRESSIONS.size()));
+}
+
+
+// parses the lexed COMPILE_EXPRESSIONS, into tokens or into nodes with reused buffers
+template<bool index_mode>
+static void BM_Parse(benchmark::State &state) {
+    Lexer l;
+    std::vector<std::vector<Token>> infixes;
+    for (const auto &exp_str: COMPILE_EXPRESSIONS) {
+        infixes.push_back(l.tokenize(exp_str));
+    }
+    std::vector<PostfixNode> postfix;
+    std::vector<PostfixNode> operators;
+    for (auto _: state) {
+        for (const auto &infix: infixes) {
+            if constexpr (index_mode) {
+                benchmark::DoNotOptimize(infixToPostfix(infix, postfix, operators));
+                benchmark::DoNotOptimize(postfix.data());
+            }
+            else {
+                benchmark::DoNotOptimize(infixToPostfix(infix));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(COMPILE_EXPRESSIONS.size()));
+}
+
+
+// matches the start of lexed lines, without or with copying the statement and expression tokens
+template<bool copy>
+static void BM_StartOfLine(benchmark::State &state) {
+    const std::vector<std::string> lines = {
+        "myDate x := EXP(0) + y",
+        "myDate IF x > 1",
+        "    PAY_AT(d, a) := x",
+        "CONTINUOUS y **= 2",
+        "ELSE",
+        "    TERMINATE",
+    };
+    Lexer l;
+    std::vector<std::vector<Token>> tokenized;
+    for (const auto &line: lines) {
+        tokenized.push_back(l.tokenize(line));
+    }
+    StatementMatch match;
+    for (auto _: state) {
+        for (const auto &tokens: tokenized) {
+            if constexpr (copy) {
+                benchmark::DoNotOptimize(parseStartOfLine(tokens));
+            }
+            else {
+                benchmark::DoNotOptimize(lineParseUtils::matchStartOfLine(tokens, match));
+                benchmark::DoNotOptimize(match);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(lines.size()));
+}
+
+
+// splits, lexes and parses a script of range(0) statements
+static void BM_ParseScript(benchmark::State &state) {
+    std::string source;
+    for (std::size_t i{0}; i < static_cast<std::size_t>(state.range(0)); ++i) {
+        source += i % 4 == 3 ? "    TERMINATE\n" : "myDate x" + std::to_string(i) + " := " +
+                                                   COMPILE_EXPRESSIONS[i % COMPILE_EXPRESSIONS.size()] + "\n";
+    }
+    const Script script(std::move(source));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(parseScript(script.source()));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(script.source().size()));
+}
+
+
+// Evaluates an IF/ELSE script on range(0) paths, as one compiled script or as separate expressions glued together by
+// branching host code
+template<bool compiled>
+static void BM_Script(benchmark::State &state) {
+    StaticVStorage storage;
+    storage.insert<DATE>("today", 1);
+    const std::size_t s_slot = storage.insertParameter<SCALAR>("s", 0.0);
+    const auto [report, script] = compileScript(
+        "today IF s - 0.5\n"
+        "    x := EXP(s) * 2\n"
+        "    y := x * x\n"
+        "ELSE\n"
+        "    x := LOG(s + 1)\n"
+        "    y := 0\n"
+        "today z := x + y\n",
+        storage);
+    assert(!report.isError());
+
+    const std::size_t x_slot = storage.insertParameter<SCALAR>("x", 0.0);
+    const std::size_t y_slot = storage.insertParameter<SCALAR>("y", 0.0);
+    std::vector<ByteCode> glued(5);
+    const std::vector<std::string> expressions = {"s - 0.5", "EXP(s) * 2", "x * x", "LOG(s + 1)", "x + y"};
+    Lexer l;
+    for (std::size_t i{0}; i < expressions.size(); ++i) {
+        compileExpression(infixToPostfix(l.tokenize(expressions[i])).second, glued[i], storage);
+    }
+    const auto evaluate = [](const ByteCode &code, CalcStacks &calc) {
+        code(calc);
+        const SCALAR result = calc.scalars().back();
+        calc.scalars().pop_back();
+        return result;
+    };
+
+    CalcStacks stacks(16, 16, 0, 0);
+    const auto paths = static_cast<std::size_t>(state.range(0));
+    for (auto _: state) {
+        for (std::size_t path{0}; path < paths; ++path) {
+            storage.updateParameter(s_slot, static_cast<SCALAR>(path % 4) * 0.25);
+            if constexpr (compiled) {
+                benchmark::DoNotOptimize(script(stacks, 1));
+            }
+            else {
+                SCALAR x;
+                SCALAR y{0.0};
+                if (evaluate(glued[0], stacks) != 0.0) {
+                    x = evaluate(glued[1], stacks);
+                    storage.updateParameter(x_slot, x);
+                    y = evaluate(glued[2], stacks);
+                }
+                else {
+                    x = evaluate(glued[3], stacks);
+                }
+                storage.updateParameter(x_slot, x);
+                storage.updateParameter(y_slot, y);
+                benchmark::DoNotOptimize(evaluate(glued[4], stacks));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+template<class Expression_t>
+static void BM_StaticScalarVars(benchmark::State &state) {
+    std::vector<Expression_t> expressions(5);
+    StaticVStorage s_variables = scalarVariables();
     const auto report = parseExpressions(SCALAR_S_VARIABLES, expressions, s_variables);
     CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
     for (auto _: state) {
@@ -200,8 +525,9 @@ static void BM_StaticScalarVars(benchmark::State &state) {
 }
 
 
+template<class Expression_t>
 static void BM_StaticVectorVars(benchmark::State &state) {
-    std::vector<Expression> expressions(5);
+    std::vector<Expression_t> expressions(5);
     StaticVStorage s_variables;
     s_variables.insert<VECTOR>("ones", {1, 1});
     s_variables.insert<VECTOR>("twos", {2, 2});
@@ -231,18 +557,420 @@ static void BM_StaticVectorVars(benchmark::State &state) {
     }
 }
 
-BENCHMARK(BM_Scalars)->Arg(1);
-BENCHMARK(BM_Vectors)->Arg(1);
-BENCHMARK(BM_ReduceVectors)->Arg(1);
-BENCHMARK(BM_ReduceScalars)->Arg(1);
-BENCHMARK(BM_StaticScalarVars)->Arg(1);
-BENCHMARK(BM_StaticVectorVars)->Arg(1);
+// Every RegisterCode owns its registers since the constants live there
+static void evaluateRegisters(benchmark::State &state,
+                              const std::vector<std::string> &str_expressions,
+                              StaticVStorage &s_variables) {
+    std::vector<RegisterCode> expressions(str_expressions.size());
+    parseExpressions(str_expressions, expressions, s_variables);
+    std::vector<Registers> registers;
+    for (const auto &exp: expressions) {
+        registers.push_back(exp.makeRegisters());
+    }
+    for (auto _: state) {
+        const std::size_t end = state.range(0);
+        for (std::size_t i{0}; i < end; ++i) {
+            for (std::size_t j{0}; j < expressions.size(); ++j) {
+                expressions[j](registers[j]);
+            }
+        }
+        benchmark::DoNotOptimize(registers.front().scalars().data());
+    }
+}
+
+
+static void BM_RegisterScalars(benchmark::State &state) {
+    StaticVStorage s_variables;
+    evaluateRegisters(state, SCALAR_EXPRESSIONS, s_variables);
+}
+
+
+static void BM_RegisterVectors(benchmark::State &state) {
+    StaticVStorage s_variables;
+    evaluateRegisters(state, VECTOR_EXPRESSIONS, s_variables);
+}
+
+
+static void BM_RegisterReduceScalars(benchmark::State &state) {
+    StaticVStorage s_variables;
+    evaluateRegisters(state, SCALAR_REDUCE_EXPRESSIONS, s_variables);
+}
+
+
+static void BM_RegisterStaticScalarVars(benchmark::State &state) {
+    StaticVStorage s_variables = scalarVariables();
+    evaluateRegisters(state, SCALAR_S_VARIABLES, s_variables);
+}
+
+// Parameters are not folded, such that the scalar variable expressions keep all their instructions
+StaticVStorage scalarParameters() {
+    StaticVStorage s_variables;
+    s_variables.insertParameter<SCALAR>("one", 1);
+    s_variables.insertParameter<SCALAR>("x", 2);
+    s_variables.insertParameter<SCALAR>("y", 3);
+    s_variables.insertParameter<SCALAR>("z", 4);
+    s_variables.insertParameter<SCALAR>("a", 5);
+    s_variables.insertParameter<SCALAR>("b", 7);
+    s_variables.insertParameter<SCALAR>("c", 8);
+    s_variables.insertParameter<SCALAR>("d", 9);
+    s_variables.insertParameter<SCALAR>("e", 10);
+    return s_variables;
+}
+
+
+// fuse runs the peephole stage, the dispatches counter is the number of instructions per evaluation of all expressions
+template<bool fuse>
+static void BM_ParameterScalars(benchmark::State &state) {
+    std::vector<ByteCode> expressions(5);
+    StaticVStorage s_variables = scalarParameters();
+    const auto report = parseExpressions(SCALAR_S_VARIABLES, expressions, s_variables);
+    std::size_t dispatches{0};
+    for (auto &exp: expressions) {
+        if (fuse) {
+            exp = fuseInstructions(exp);
+        }
+        dispatches += exp.size();
+    }
+    CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
+    for (auto _: state) {
+        const std::size_t end = state.range(0);
+        for (std::size_t i{0}; i < end; ++i) {
+            for (const auto &exp: expressions) {
+                exp(stacks);
+                stacks.scalars().pop_back();
+                assert(stacks.ready());
+            }
+        }
+    }
+    state.counters["dispatches"] = static_cast<double>(dispatches);
+}
+
+
+// element-wise chains over the fixings of an Asian option
+const std::vector<std::string> FIXING_EXPRESSIONS = {
+    "SQUARE(SQRT(ABS(-1 * LOG(EXP(fixings)))))",
+    "EXP(-0.5 * fixings) * 2 + 1",
+    "2 * (fixings / 100 - 1)",
+};
+
+
+// reductions over element-wise chains, e.g. an average or a dot product with weights
+const std::vector<std::string> FIXING_REDUCE_EXPRESSIONS = {
+    "SUM(fixings * weights)",
+    "SUM(ABS(fixings - 100)) / LEN(fixings)",
+    "MAX(EXP(-0.5 * fixings) * 2 + 1)",
+};
+
+
+// fixings and weights of an Asian option as parameters
+StaticVStorage fixingParameters() {
+    StaticVStorage s_variables;
+    VECTOR fixings(250);
+    for (std::size_t i{0}; i < fixings.size(); ++i) {
+        fixings[i] = 90.0 + static_cast<SCALAR>(i % 20);
+    }
+    s_variables.insertParameter<VECTOR>("fixings", fixings);
+    s_variables.insertParameter<VECTOR>("weights", VECTOR(fixings.size(), 1.0 / static_cast<SCALAR>(fixings.size())));
+    return s_variables;
+}
+
+
+// fuse runs fuseVectorLoops, which evaluates each chain in one pass over the 250 fixings and reduces without writing
+// the mapped vector, the dispatches counter is the number of instructions per evaluation of all expressions
+template<bool fuse, bool reduce>
+static void BM_FixingVectors(benchmark::State &state) {
+    const std::vector<std::string> &str_expressions = reduce ? FIXING_REDUCE_EXPRESSIONS : FIXING_EXPRESSIONS;
+    std::vector<ByteCode> expressions(str_expressions.size());
+    StaticVStorage s_variables = fixingParameters();
+    const auto report = parseExpressions(str_expressions, expressions, s_variables);
+    std::size_t dispatches{0};
+    for (auto &exp: expressions) {
+        if (fuse) {
+            exp = fuseVectorLoops(exp);
+        }
+        dispatches += exp.size();
+    }
+    CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
+    for (auto _: state) {
+        const std::size_t end = state.range(0);
+        for (std::size_t i{0}; i < end; ++i) {
+            for (const auto &exp: expressions) {
+                exp(stacks);
+                if (reduce) {
+                    stacks.scalars().pop_back();
+                }
+                else {
+                    stacks.popVectorResult();
+                }
+                assert(stacks.ready());
+            }
+        }
+    }
+    state.counters["dispatches"] = static_cast<double>(dispatches);
+}
+
+
+// log-returns and discount factors over the fixings, dominated by EXP, LOG, SQRT and POW
+const std::vector<std::string> TRANSCENDENTAL_EXPRESSIONS = {
+    "LOG(fixings / 100)",
+    "EXP(-0.03 * fixings / 250)",
+    "SQRT(fixings) * 0.2",
+    "(fixings / 100) ** 1.5",
+};
+
+
+// the vectorMath kernels run on isa, the benchmark is skipped if the CPU does not support it
+template<vectorMath::Isa isa>
+static void BM_TranscendentalVectors(benchmark::State &state) {
+    const vectorMath::Isa selected = vectorMath::isa();
+    if (!vectorMath::selectIsa(isa)) {
+        state.SkipWithError("instruction set not available");
+        return;
+    }
+    std::vector<ByteCode> expressions(TRANSCENDENTAL_EXPRESSIONS.size());
+    StaticVStorage s_variables = fixingParameters();
+    const auto report = parseExpressions(TRANSCENDENTAL_EXPRESSIONS, expressions, s_variables);
+    CalcStacks stacks{report.max_scalar, report.max_vector, 0, 0};
+    for (auto _: state) {
+        const std::size_t end = state.range(0);
+        for (std::size_t i{0}; i < end; ++i) {
+            for (const auto &exp: expressions) {
+                exp(stacks);
+                stacks.popVectorResult();
+                assert(stacks.ready());
+            }
+        }
+    }
+    vectorMath::selectIsa(selected);
+}
+
+
+// range(0) paths are evaluated in batches of LANES paths, one dispatch per instruction and batch
+constexpr std::size_t LANES{64};
+
+static void evaluateBatches(benchmark::State &state,
+                            const std::vector<std::string> &str_expressions,
+                            StaticVStorage &s_variables) {
+    std::vector<ByteCode> expressions(str_expressions.size());
+    const auto report = parseExpressions(str_expressions, expressions, s_variables);
+    BatchStacks stacks{LANES, report.max_scalar, report.max_vector, 0, 0};
+    for (auto _: state) {
+        const std::size_t end = (static_cast<std::size_t>(state.range(0)) + LANES - 1) / LANES;
+        for (std::size_t i{0}; i < end; ++i) {
+            for (const auto &exp: expressions) {
+                exp(stacks);
+                benchmark::DoNotOptimize(stacks.scalars().data());
+                stacks.scalars().clear();
+                stacks.vectors().clear();
+                stacks.vectorSizes().clear();
+                assert(stacks.ready());
+            }
+        }
+    }
+}
+
 
-BENCHMARK(BM_Scalars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
-BENCHMARK(BM_Vectors)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
-BENCHMARK(BM_ReduceScalars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
-BENCHMARK(BM_ReduceVectors)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
-BENCHMARK(BM_StaticScalarVars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
-BENCHMARK(BM_StaticVectorVars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+static void BM_BatchScalars(benchmark::State &state) {
+    StaticVStorage s_variables;
+    evaluateBatches(state, SCALAR_EXPRESSIONS, s_variables);
+}
 
-BENCHMARK_MAIN();
+
+static void BM_BatchVectors(benchmark::State &state) {
+    StaticVStorage s_variables;
+    evaluateBatches(state, VECTOR_EXPRESSIONS, s_variables);
+}
+
+
+static void BM_BatchReduceScalars(benchmark::State &state) {
+    StaticVStorage s_variables;
+    evaluateBatches(state, SCALAR_REDUCE_EXPRESSIONS, s_variables);
+}
+
+
+static void BM_BatchStaticScalarVars(benchmark::State &state) {
+    StaticVStorage s_variables = scalarVariables();
+    evaluateBatches(state, SCALAR_S_VARIABLES, s_variables);
+}
+
+
+// The IF/ELSE script of BM_Script on range(0) paths, per path or in batches of LANES paths. If range(1) is set the
+// lanes of a batch disagree on the condition and both branches run under a mask, otherwise the batch branches.
+template<bool batched>
+static void BM_BatchScript(benchmark::State &state) {
+    StaticVStorage storage;
+    storage.insert<DATE>("start", 0);
+    storage.insert<DATE>("today", 1);
+    const std::size_t input = storage.insertParameter<SCALAR>("input", 0.0);
+    const auto [report, script] = compileScript(
+        "start s := input\n"
+        "today IF s - 0.5\n"
+        "    x := EXP(s) * 2\n"
+        "    y := x * x\n"
+        "ELSE\n"
+        "    x := LOG(s + 1)\n"
+        "    y := 0\n"
+        "today z := x + y\n",
+        storage);
+    assert(!report.isError());
+
+    std::vector<SCALAR> s(LANES, 0.0);
+    if (state.range(1) != 0) {
+        for (std::size_t lane{0}; lane < LANES; ++lane) {
+            s[lane] = static_cast<SCALAR>(lane % 4) * 0.25;
+        }
+    }
+    const std::size_t paths = static_cast<std::size_t>(state.range(0));
+    for (auto _: state) {
+        if constexpr (batched) {
+            BatchStacks stacks(LANES, script.maxScalar(), script.maxVector(), 0, 0);
+            for (std::size_t batch{0}; batch < (paths + LANES - 1) / LANES; ++batch) {
+                script(stacks, 0);
+                script.setScalar(stacks, "s", s.data());
+                benchmark::DoNotOptimize(script(stacks, 1));
+            }
+        }
+        else {
+            CalcStacks stacks(script.maxScalar(), script.maxVector(), 0, 0);
+            for (std::size_t path{0}; path < paths; ++path) {
+                storage.updateParameter(input, s[path % LANES]);
+                script(stacks, 0);
+                benchmark::DoNotOptimize(script(stacks, 1));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+// An autocallable like script on range(0) paths in batches of LANES paths, every date terminates a tenth of the paths.
+// With compaction the terminated lanes are dropped, otherwise they are carried along masked out until the batch ends.
+template<bool compaction>
+static void BM_BatchTerminate(benchmark::State &state) {
+    StaticVStorage storage;
+    storage.insert<DATE>("start", 0);
+    const auto [report, script] = compileScript(
+        "start s := 0\n"
+        "start k := -0.1\n"
+        "start w := (1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16) / 16\n"
+        "CONTINUOUS k += 0.1\n"
+        "CONTINUOUS w := EXP(w * s) * 0.5 + SQRT(w)\n"
+        "CONTINUOUS IF k > s\n"
+        "    payoff := SUM(w) * k\n"
+        "    TERMINATE\n",
+        storage);
+    assert(!report.isError());
+
+    std::vector<SCALAR> s(LANES);
+    for (std::size_t lane{0}; lane < LANES; ++lane) {
+        s[lane] = (static_cast<SCALAR>(lane) + 0.5) / static_cast<SCALAR>(LANES);
+    }
+    const std::size_t paths = static_cast<std::size_t>(state.range(0));
+    for (auto _: state) {
+        for (std::size_t batch{0}; batch < (paths + LANES - 1) / LANES; ++batch) {
+            BatchStacks stacks(LANES, script.maxScalar(), script.maxVector(), 0, 0);
+            stacks.setCompactionThreshold(compaction ? 0.75 : 0.0);
+            script(stacks, 0);
+            script.setScalar(stacks, "s", s.data());
+            for (DATE date{1}; script(stacks, date); ++date) {}
+            benchmark::DoNotOptimize(script.scalar(stacks, "payoff"));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_Scalars, Expression)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Scalars, ByteCode)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Scalars, JitCode)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Vectors, Expression)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Vectors, ByteCode)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ReduceVectors, Expression)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ReduceVectors, ByteCode)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Compile, Expression)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Compile, ByteCode)->Arg(1);
+#if !defined(_WIN32)
+BENCHMARK(BM_Startup)->Unit(benchmark::kMicrosecond)->UseRealTime();
+#endif
+BENCHMARK(BM_Lexer)->RangeMultiplier(4)->Range(16, MAX_LINE_LEN);
+BENCHMARK(BM_FrontEnd)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Parse, false);
+BENCHMARK_TEMPLATE(BM_Parse, true);
+BENCHMARK_TEMPLATE(BM_StartOfLine, true);
+BENCHMARK_TEMPLATE(BM_StartOfLine, false);
+BENCHMARK_TEMPLATE(BM_Script, true)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_Script, false)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_BatchScript, false)->Args({1 << 10, 1});
+BENCHMARK_TEMPLATE(BM_BatchScript, true)->Args({1 << 10, 1});
+BENCHMARK_TEMPLATE(BM_BatchScript, true)->Args({1 << 10, 0});
+BENCHMARK_TEMPLATE(BM_BatchTerminate, false)->Arg(1 << 10);
+BENCHMARK_TEMPLATE(BM_BatchTerminate, true)->Arg(1 << 10);
+BENCHMARK(BM_ParseScript)->RangeMultiplier(8)->Range(64, 1 << 15);
+BENCHMARK_TEMPLATE(BM_ReduceVectorLength, Expression)->RangeMultiplier(8)->Range(4, 1000000);
+BENCHMARK_TEMPLATE(BM_ReduceVectorLength, ByteCode)->RangeMultiplier(8)->Range(4, 1000000);
+BENCHMARK(BM_ReduceVectorLengthStd)->RangeMultiplier(8)->Range(4, 1000000);
+BENCHMARK_TEMPLATE(BM_ReduceScalars, Expression)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ReduceScalars, ByteCode)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ReduceScalars, JitCode)->Arg(1);
+BENCHMARK_TEMPLATE(BM_StaticScalarVars, Expression)->Arg(1);
+BENCHMARK_TEMPLATE(BM_StaticScalarVars, ByteCode)->Arg(1);
+BENCHMARK_TEMPLATE(BM_StaticVectorVars, Expression)->Arg(1);
+BENCHMARK_TEMPLATE(BM_StaticVectorVars, ByteCode)->Arg(1);
+BENCHMARK(BM_RegisterScalars)->Arg(1);
+BENCHMARK(BM_RegisterVectors)->Arg(1);
+BENCHMARK(BM_RegisterReduceScalars)->Arg(1);
+BENCHMARK(BM_RegisterStaticScalarVars)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ParameterScalars, false)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ParameterScalars, true)->Arg(1);
+BENCHMARK_TEMPLATE(BM_FixingVectors, false, false)->Arg(1);
+BENCHMARK_TEMPLATE(BM_FixingVectors, true, false)->Arg(1);
+BENCHMARK_TEMPLATE(BM_FixingVectors, false, true)->Arg(1);
+BENCHMARK_TEMPLATE(BM_FixingVectors, true, true)->Arg(1);
+BENCHMARK_TEMPLATE(BM_TranscendentalVectors, vectorMath::Isa::scalar)->Arg(1);
+BENCHMARK_TEMPLATE(BM_TranscendentalVectors, vectorMath::Isa::sse2)->Arg(1);
+BENCHMARK_TEMPLATE(BM_TranscendentalVectors, vectorMath::Isa::avx2)->Arg(1);
+BENCHMARK_TEMPLATE(BM_TranscendentalVectors, vectorMath::Isa::avx512)->Arg(1);
+BENCHMARK(BM_BatchScalars)->Arg(LANES);
+BENCHMARK(BM_BatchVectors)->Arg(LANES);
+BENCHMARK(BM_BatchReduceScalars)->Arg(LANES);
+BENCHMARK(BM_BatchStaticScalarVars)->Arg(LANES);
+
+BENCHMARK_TEMPLATE(BM_Scalars, Expression)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Scalars, ByteCode)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Scalars, JitCode)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Vectors, Expression)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Vectors, ByteCode)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ReduceScalars, Expression)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ReduceScalars, ByteCode)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ReduceScalars, JitCode)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ReduceVectors, Expression)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ReduceVectors, ByteCode)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_StaticScalarVars, Expression)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_StaticScalarVars, ByteCode)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_StaticVectorVars, Expression)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_StaticVectorVars, ByteCode)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_RegisterScalars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_RegisterVectors)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_RegisterReduceScalars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_RegisterStaticScalarVars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ParameterScalars, false)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ParameterScalars, true)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_BatchScalars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_BatchVectors)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_BatchReduceScalars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+BENCHMARK(BM_BatchStaticScalarVars)->Unit(benchmark::kMillisecond)->Range(1 << 12, 1 << 20);
+
+int main(int argc, char **argv) {
+#if !defined(_WIN32)
+    if (std::getenv(STARTUP_PROBE) != nullptr) {
+        return compileFirstExpression();
+    }
+    self_path = argv[0];
+#endif
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
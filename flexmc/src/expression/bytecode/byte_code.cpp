@@ -0,0 +1,967 @@
+#include <cassert>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
+#include "utils.h"
+#include "terminals.h"
+#include "operand.h"
+#include "operators_calc.h"
+#include "functions_real.h"
+#include "kernels.h"
+#include "vector_math.h"
+#include "reductions.h"
+#include "symbols.h"
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    namespace {
+
+        // indexed by operatorIndex(symbol)
+        constexpr std::array<OpCode, NUM_OPERATORS> BINARY_BLOCKS{
+            OpCode::plus_sc_sc,
+            OpCode::minus_sc_sc,
+            OpCode::mul_sc_sc,
+            OpCode::div_sc_sc,
+            OpCode::pow_sc_sc,
+            OpCode::lt_sc_sc,
+            OpCode::gt_sc_sc,
+            OpCode::le_sc_sc,
+            OpCode::ge_sc_sc,
+            OpCode::and_sc_sc,
+            OpCode::or_sc_sc,
+        };
+
+        // indexed by scalarFunctionIndex(symbol)
+        constexpr std::array<OpCode, NUM_SCALAR_FUNCTIONS> FUNCTION_PAIRS{
+            OpCode::exp_sc,
+            OpCode::log_sc,
+            OpCode::abs_sc,
+            OpCode::sqrt_sc,
+            OpCode::square_sc,
+        };
+
+        // indexed by reduceFunctionIndex(symbol)
+        constexpr std::array<OpCode, NUM_REDUCE_FUNCTIONS> REDUCE_VECTOR{
+            OpCode::sum_vec,
+            OpCode::prod_vec,
+            OpCode::max_vec,
+            OpCode::min_vec,
+            OpCode::argmax_vec,
+            OpCode::argmin_vec,
+            OpCode::len_vec,
+        };
+
+        // indexed by reduceFunctionIndex(symbol), LEN has no argument version
+        constexpr std::array<OpCode, NUM_REDUCE_FUNCTIONS - 1> REDUCE_ARGUMENTS{
+            OpCode::sum_args,
+            OpCode::prod_args,
+            OpCode::max_args,
+            OpCode::min_args,
+            OpCode::argmax_args,
+            OpCode::argmin_args,
+        };
+
+        OpCode offset(const OpCode &base, const std::size_t &by) {
+            return static_cast<OpCode>(static_cast<std::size_t>(base) + by);
+        }
+
+        // elements per tile of a map_vec loop, all steps run on a tile while it is in the L1 cache
+        constexpr std::size_t MAP_TILE = 256;
+
+        template<class scalar_function>
+        void mapTile(SCALAR *values, const std::size_t &size, scalar_function f) {
+            for (std::size_t i{0}; i < size; ++i) {
+                values[i] = f(values[i]);
+            }
+        }
+
+        template<class binary_function>
+        void mapTile(SCALAR *values, const std::size_t &size, const MapStep &step, binary_function f) {
+            const SCALAR scalar = step.scalar;
+            if (binaryVariant(step.code) == 1) {
+                mapTile(values, size, [scalar, f](const SCALAR &value) { return f(scalar, value); });
+            }
+            else {
+                mapTile(values, size, [scalar, f](const SCALAR &value) { return f(value, scalar); });
+            }
+        }
+
+        void mapStep(SCALAR *values, const std::size_t &size, const MapStep &step) {
+            using namespace kernels;
+            using
+            enum OpCode;
+            switch (step.code) {
+                case neg_vec:
+                    return mapTile(values, size, NEG_F);
+                case not_vec:
+                    return mapTile(values, size, NOT_F);
+                case exp_vec:
+                    return vectorMath::exp(values, values, size);
+                case log_vec:
+                    return vectorMath::log(values, values, size);
+                case abs_vec:
+                    return mapTile(values, size, ABS_F);
+                case sqrt_vec:
+                    return vectorMath::sqrt(values, values, size);
+                case square_vec:
+                    return mapTile(values, size, SQUARE_F);
+                default:
+                    break;
+            }
+            assert(isBinary(step.code));
+            switch ((static_cast<std::size_t>(step.code) - static_cast<std::size_t>(plus_sc_sc)) / 4) {
+                case 0:
+                    return mapTile(values, size, step, PLUS_F);
+                case 1:
+                    return mapTile(values, size, step, MINUS_F);
+                case 2:
+                    return mapTile(values, size, step, MUL_F);
+                case 3:
+                    return mapTile(values, size, step, DIV_F);
+                case 4:
+                    if (binaryVariant(step.code) == 1) {
+                        return vectorMath::pow(step.scalar, values, values, size);
+                    }
+                    return vectorMath::pow(values, step.scalar, values, size);
+                case 5:
+                    return mapTile(values, size, step, LT_F);
+                case 6:
+                    return mapTile(values, size, step, GT_F);
+                case 7:
+                    return mapTile(values, size, step, LE_F);
+                case 8:
+                    return mapTile(values, size, step, GE_F);
+                case 9:
+                    return mapTile(values, size, step, AND_F);
+                default:
+                    return mapTile(values, size, step, OR_F);
+            }
+        }
+
+        // the elements of the vector on top of the stacks, of all lanes for BatchStacks
+        std::size_t topVectorBlock(const CalcStacks &stacks) { return stacks.vectorSizes().back(); }
+
+        std::size_t topVectorBlock(const BatchStacks &stacks) { return stacks.vectorSizes().back() * stacks.lanes(); }
+
+        template<class Stacks>
+        void mapLoop(Stacks &stacks, const MapStep *steps, const std::size_t &num) {
+            assert(!stacks.vectorSizes().empty());
+            const std::size_t block = topVectorBlock(stacks);
+            SCALAR *values = stacks.vectors().data() + stacks.vectors().size() - block;
+            for (std::size_t tile{0}; tile < block; tile += MAP_TILE) {
+                const std::size_t size = std::min(MAP_TILE, block - tile);
+                for (std::size_t s{0}; s < num; ++s) {
+                    mapStep(values + tile, size, steps[s]);
+                }
+            }
+        }
+
+        template<class binary_function>
+        void zipTile(SCALAR *out, const SCALAR *left, const SCALAR *right, const std::size_t &size,
+                     binary_function f) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = f(left[i], right[i]);
+            }
+        }
+
+        void zipStep(SCALAR *out, const SCALAR *left, const SCALAR *right, const std::size_t &size,
+                     const OpCode &code) {
+            using namespace kernels;
+            switch ((static_cast<std::size_t>(code) - static_cast<std::size_t>(OpCode::plus_sc_sc)) / 4) {
+                case 0:
+                    return zipTile(out, left, right, size, PLUS_F);
+                case 1:
+                    return zipTile(out, left, right, size, MINUS_F);
+                case 2:
+                    return zipTile(out, left, right, size, MUL_F);
+                case 3:
+                    return zipTile(out, left, right, size, DIV_F);
+                case 4:
+                    return vectorMath::pow(left, right, out, size);
+                case 5:
+                    return zipTile(out, left, right, size, LT_F);
+                case 6:
+                    return zipTile(out, left, right, size, GT_F);
+                case 7:
+                    return zipTile(out, left, right, size, LE_F);
+                case 8:
+                    return zipTile(out, left, right, size, GE_F);
+                case 9:
+                    return zipTile(out, left, right, size, AND_F);
+                default:
+                    return zipTile(out, left, right, size, OR_F);
+            }
+        }
+
+        static_assert(MAP_TILE % reductions::BLOCK == 0, "tiles must not split the blocks of a SUM or PROD");
+
+        // Running reduction over the mapped elements, in the order of the reduceVector kernels: tiles cover whole
+        // blocks of SUM and PROD, MAX and ARGMAX continue the scan of the previous tiles.
+        class Reduction {
+
+        public:
+
+            explicit Reduction(const OpCode &code) : code_(code) {}
+
+            void add(const SCALAR *values, const std::size_t &size) {
+                using
+                enum OpCode;
+                if (size == 0) {
+                    return;
+                }
+                if ((count_ == 0) && (code_ != sum_vec) && (code_ != prod_vec)) {
+                    value_ = values[0];
+                }
+                std::size_t found{size};
+                SCALAR blocks[MAP_TILE / reductions::BLOCK];
+                switch (code_) {
+                    case sum_vec:
+                        vectorMath::sumBlocks(values, blocks, size);
+                        for (std::size_t k{0}; k * reductions::BLOCK < size; ++k) {
+                            sum_.add(blocks[k]);
+                        }
+                        break;
+                    case prod_vec:
+                        vectorMath::prodBlocks(values, blocks, size);
+                        for (std::size_t k{0}; k * reductions::BLOCK < size; ++k) {
+                            product_.add(blocks[k]);
+                        }
+                        break;
+                    case max_vec:
+                    case argmax_vec:
+                        found = vectorMath::scanMax(values, size, value_);
+                        break;
+                    default:
+                        found = vectorMath::scanMin(values, size, value_);
+                }
+                if (found < size) {
+                    found_ = count_ + found;
+                }
+                count_ += size;
+            }
+
+            SCALAR result() {
+                using
+                enum OpCode;
+                switch (code_) {
+                    case sum_vec:
+                        return sum_.result();
+                    case prod_vec:
+                        return product_.result();
+                    case argmax_vec:
+                    case argmin_vec:
+                        return static_cast<SCALAR>(found_);
+                    default:
+                        return value_;
+                }
+            }
+
+        private:
+
+            OpCode code_;
+
+            reductions::Pairwise<decltype(kernels::PLUS_F)> sum_{kernels::PLUS_F, 0.0};
+
+            reductions::Pairwise<decltype(kernels::MUL_F)> product_{kernels::MUL_F, 1.0};
+
+            SCALAR value_{0.0};
+
+            std::size_t found_{0};
+
+            std::size_t count_{0};
+
+        };
+
+        // Streams the vector (both vectors for zip) through a tile buffer, the mapped vector is never written to
+        // the stacks.
+        template<bool zip>
+        void mapReduce(CalcStacks &stacks, const MapStep *steps, const std::size_t &num) {
+            assert(stacks.vectorSizes().size() >= (zip ? 2 : 1));
+            const std::size_t size = stacks.vectorSizes().back();
+            const SCALAR *right = stacks.vectors().data() + stacks.vectors().size() - size;
+            const SCALAR *left = zip ? right - size : nullptr;
+            Reduction reduction(steps[num - 1].code);
+            std::array<SCALAR, MAP_TILE> tile;
+            for (std::size_t begin{0}; begin < size; begin += MAP_TILE) {
+                const std::size_t n = std::min(MAP_TILE, size - begin);
+                if (zip) {
+                    zipStep(tile.data(), left + begin, right + begin, n, steps[0].code);
+                }
+                else {
+                    std::copy_n(right + begin, n, tile.data());
+                }
+                for (std::size_t s{zip ? 1UL : 0UL}; s + 1 < num; ++s) {
+                    mapStep(tile.data(), n, steps[s]);
+                }
+                reduction.add(tile.data(), n);
+            }
+            const SCALAR result = reduction.result();
+            const std::size_t operands = zip ? 2 : 1;
+            stacks.vectors().resize(stacks.vectors().size() - operands * size);
+            stacks.vectorSizes().resize(stacks.vectorSizes().size() - operands);
+            stacks.pushScalar(result);
+        }
+
+        // Batches combine the vectors and map them in place, then reduce each lane with the reduceVector kernels
+        template<bool zip>
+        void mapReduce(BatchStacks &stacks, const MapStep *steps, const std::size_t &num) {
+            using namespace operatorsCalc;
+            using namespace functionsReal;
+            using namespace kernels;
+            if (zip) {
+                switch ((static_cast<std::size_t>(steps[0].code) - static_cast<std::size_t>(OpCode::plus_sc_sc)) / 4) {
+                    case 0:
+                        binary::vecVec(stacks, PLUS_F);
+                        break;
+                    case 1:
+                        binary::vecVec(stacks, MINUS_F);
+                        break;
+                    case 2:
+                        binary::vecVec(stacks, MUL_F);
+                        break;
+                    case 3:
+                        binary::vecVec(stacks, DIV_F);
+                        break;
+                    case 4:
+                        binary::powVecVec(stacks);
+                        break;
+                    case 5:
+                        binary::vecVec(stacks, LT_F);
+                        break;
+                    case 6:
+                        binary::vecVec(stacks, GT_F);
+                        break;
+                    case 7:
+                        binary::vecVec(stacks, LE_F);
+                        break;
+                    case 8:
+                        binary::vecVec(stacks, GE_F);
+                        break;
+                    case 9:
+                        binary::vecVec(stacks, AND_F);
+                        break;
+                    default:
+                        binary::vecVec(stacks, OR_F);
+                }
+            }
+            const std::size_t first = zip ? 1 : 0;
+            mapLoop(stacks, steps + first, num - 1 - first);
+            switch (steps[num - 1].code) {
+                case OpCode::sum_vec:
+                    reduceVector::sum(stacks);
+                    break;
+                case OpCode::prod_vec:
+                    reduceVector::prod(stacks);
+                    break;
+                case OpCode::max_vec:
+                    reduceVector::max(stacks);
+                    break;
+                case OpCode::min_vec:
+                    reduceVector::min(stacks);
+                    break;
+                case OpCode::argmax_vec:
+                    reduceVector::argmax(stacks);
+                    break;
+                default:
+                    reduceVector::argmin(stacks);
+            }
+        }
+
+    }
+
+    Instruction compileInstruction(const CallSignature &signature) {
+        using
+        enum CallSignature::Kind;
+        const std::size_t is_vec_left = signature.left_t == CType::vector ? 1 : 0;
+        const std::size_t is_vec_right = signature.right_t == CType::vector ? 1 : 0;
+        const Symbol &symbol = signature.symbol;
+        Instruction instruction;
+        instruction.size = static_cast<std::uint32_t>(signature.num_args);
+        switch (signature.kind) {
+            case unary:
+                instruction.code = offset(symbol == Symbol::not_ ? OpCode::not_sc : OpCode::neg_sc, is_vec_left);
+                break;
+            case binary:
+                instruction.code = offset(BINARY_BLOCKS[operatorIndex(symbol)], 2 * is_vec_left + is_vec_right);
+                break;
+            case scalar_function:
+                instruction.code = offset(FUNCTION_PAIRS[scalarFunctionIndex(symbol)], is_vec_left);
+                break;
+            case reduce_vector:
+                instruction.code = REDUCE_VECTOR[reduceFunctionIndex(symbol)];
+                break;
+            case reduce_arguments:
+                instruction.code = REDUCE_ARGUMENTS[reduceFunctionIndex(symbol)];
+                break;
+            default:
+                assert(false);
+        }
+        return instruction;
+    }
+
+    void ByteCode::pushScalar(const SCALAR &value) {
+        Instruction instruction{OpCode::push_scalar, 0};
+        instruction.scalar = value;
+        code_.push_back(instruction);
+    }
+
+    void ByteCode::pushVector(const VECTOR &value) {
+        Instruction instruction{OpCode::push_vector, static_cast<std::uint32_t>(value.size())};
+        instruction.offset = vector_pool_.size();
+        vector_pool_.insert(vector_pool_.end(), value.begin(), value.end());
+        code_.push_back(instruction);
+    }
+
+    void ByteCode::pushDate(const DATE &value) {
+        Instruction instruction{OpCode::push_date, 0};
+        instruction.date = value;
+        code_.push_back(instruction);
+    }
+
+    void ByteCode::pushDateList(const DATE_LIST &value) {
+        Instruction instruction{OpCode::push_date_list, static_cast<std::uint32_t>(value.size())};
+        instruction.offset = date_list_pool_.size();
+        date_list_pool_.insert(date_list_pool_.end(), value.begin(), value.end());
+        code_.push_back(instruction);
+    }
+
+    void ByteCode::loadScalar(const Parameters &parameters, const std::size_t &slot) {
+        assert((parameters_ == nullptr) || (parameters_ == &parameters));
+        parameters_ = &parameters;
+        Instruction instruction{OpCode::load_scalar, 0};
+        instruction.offset = slot;
+        code_.push_back(instruction);
+    }
+
+    void ByteCode::loadVector(const Parameters &parameters, const std::size_t &slot) {
+        assert((parameters_ == nullptr) || (parameters_ == &parameters));
+        parameters_ = &parameters;
+        Instruction instruction{OpCode::load_vector, static_cast<std::uint32_t>(parameters.vector(slot).size())};
+        instruction.offset = slot;
+        code_.push_back(instruction);
+    }
+
+    std::size_t ByteCode::storeScalar() {
+        Instruction instruction{OpCode::store_scalar, 0};
+        instruction.offset = local_scalars_++;
+        code_.push_back(instruction);
+        return instruction.offset;
+    }
+
+    std::size_t ByteCode::storeVector(const std::size_t &size) {
+        Instruction instruction{OpCode::store_vector, static_cast<std::uint32_t>(size)};
+        instruction.offset = local_vectors_;
+        local_vectors_ += size;
+        code_.push_back(instruction);
+        return instruction.offset;
+    }
+
+    void ByteCode::fetchScalar(const std::size_t &slot) {
+        assert(slot < local_scalars_);
+        Instruction instruction{OpCode::fetch_scalar, 0};
+        instruction.offset = slot;
+        code_.push_back(instruction);
+    }
+
+    void ByteCode::fetchVector(const std::size_t &slot, const std::size_t &size) {
+        assert(slot + size <= local_vectors_);
+        Instruction instruction{OpCode::fetch_vector, static_cast<std::uint32_t>(size)};
+        instruction.offset = slot;
+        code_.push_back(instruction);
+    }
+
+    void ByteCode::mapVector(const OpCode &code, const std::vector<MapStep> &steps) {
+        assert((OpCode::map_vec <= code) && (code <= OpCode::zip_reduce_vec));
+        Instruction instruction{code, static_cast<std::uint32_t>(steps.size())};
+        instruction.offset = map_pool_.size();
+        map_pool_.insert(map_pool_.end(), steps.begin(), steps.end());
+        code_.push_back(instruction);
+    }
+
+    std::size_t ByteCode::addLocalScalar() { return local_scalars_++; }
+
+    std::size_t ByteCode::addLocalVector(const std::size_t &size) {
+        const std::size_t slot = local_vectors_;
+        local_vectors_ += size;
+        return slot;
+    }
+
+    void ByteCode::declareLocals(const std::size_t &scalars, const std::size_t &vectors) {
+        local_scalars_ = std::max(local_scalars_, scalars);
+        local_vectors_ = std::max(local_vectors_, vectors);
+    }
+
+    void ByteCode::assignScalar(const std::size_t &slot) {
+        assert(slot < local_scalars_);
+        Instruction instruction{OpCode::assign_scalar, 0};
+        instruction.offset = slot;
+        code_.push_back(instruction);
+    }
+
+    void ByteCode::assignVector(const std::size_t &slot, const std::size_t &size) {
+        assert(slot + size <= local_vectors_);
+        Instruction instruction{OpCode::assign_vector, static_cast<std::uint32_t>(size)};
+        instruction.offset = slot;
+        code_.push_back(instruction);
+    }
+
+    std::size_t ByteCode::jump() {
+        code_.emplace_back(OpCode::jump, 0);
+        return code_.size() - 1;
+    }
+
+    std::size_t ByteCode::jumpIfZero() {
+        code_.emplace_back(OpCode::jump_if_zero, 0);
+        return code_.size() - 1;
+    }
+
+    std::size_t ByteCode::jumpElse() {
+        code_.emplace_back(OpCode::jump_else, 0);
+        return code_.size() - 1;
+    }
+
+    std::size_t ByteCode::jumpUnlessDate(const DATE &date) {
+        Instruction instruction{OpCode::jump_unless_date, 0};
+        instruction.date = date;
+        code_.push_back(instruction);
+        return code_.size() - 1;
+    }
+
+    void ByteCode::setTarget(const std::size_t &jump, const std::size_t &target) {
+        assert((jump < code_.size()) && (target <= code_.size()));
+        assert((OpCode::jump <= code_[jump].code) && (code_[jump].code <= OpCode::jump_unless_date));
+        code_[jump].size = static_cast<std::uint32_t>(target);
+    }
+
+    void ByteCode::endIf() { code_.emplace_back(OpCode::end_if, 0); }
+
+    void ByteCode::terminate() { code_.emplace_back(OpCode::terminate, 0); }
+
+    void ByteCode::push_back(const Instruction &instruction, const ByteCode &from) {
+        const auto begin = static_cast<std::ptrdiff_t>(instruction.offset);
+        const auto end = begin + static_cast<std::ptrdiff_t>(instruction.size);
+        if (instruction.code == OpCode::push_vector) {
+            pushVector(VECTOR(from.vector_pool_.begin() + begin, from.vector_pool_.begin() + end));
+        }
+        else if (instruction.code == OpCode::push_date_list) {
+            pushDateList(DATE_LIST(from.date_list_pool_.begin() + begin, from.date_list_pool_.begin() + end));
+        }
+        else if (OpCode::map_vec <= instruction.code) {
+            mapVector(instruction.code,
+                      std::vector<MapStep>(from.map_pool_.begin() + begin, from.map_pool_.begin() + end));
+        }
+        else {
+            // instructions referring to locals are copied along with all locals of from
+            if ((OpCode::store_scalar <= instruction.code) && (instruction.code <= OpCode::fetch_vector)) {
+                local_scalars_ = std::max(local_scalars_, from.local_scalars_);
+                local_vectors_ = std::max(local_vectors_, from.local_vectors_);
+            }
+            if ((instruction.code == OpCode::load_scalar) || (instruction.code == OpCode::load_vector) ||
+                ((OpCode::plus_sc_load <= instruction.code) && (instruction.code <= OpCode::pow_sc_load))) {
+                assert((parameters_ == nullptr) || (parameters_ == from.parameters_));
+                parameters_ = from.parameters_;
+            }
+            code_.push_back(instruction);
+        }
+    }
+
+    void ByteCode::truncate(const std::size_t &size) {
+        assert(size <= code_.size());
+        code_.resize(size);
+    }
+
+    void ByteCode::operator()(CalcStacks &stacks) const { execute(stacks, 0); }
+
+    bool ByteCode::operator()(CalcStacks &stacks, const DATE &date) const { return execute(stacks, date); }
+
+    void ByteCode::operator()(BatchStacks &stacks) const { execute(stacks, 0); }
+
+    bool ByteCode::operator()(BatchStacks &stacks, const DATE &date) const { return execute(stacks, date); }
+
+    template<class Stacks>
+    bool ByteCode::execute(Stacks &stacks, const DATE &date) const {
+        using namespace operatorsCalc;
+        using namespace functionsReal;
+        using namespace kernels;
+        if ((local_scalars_ > 0) || (local_vectors_ > 0)) {
+            stacks.reserveLocals(local_scalars_, local_vectors_);
+        }
+        for (std::size_t next{0}; next < code_.size(); ++next) {
+            const Instruction &instruction = code_[next];
+            switch (instruction.code) {
+                using
+                enum OpCode;
+                case push_scalar:
+                    stacks.pushScalar(instruction.scalar);
+                    break;
+                case push_vector:
+                    stacks.pushVector(vector_pool_.data() + instruction.offset, instruction.size);
+                    break;
+                case push_date:
+                    stacks.dates().push_back(instruction.date);
+                    break;
+                case push_date_list:
+                    stacks.pushDateList(date_list_pool_.data() + instruction.offset, instruction.size);
+                    break;
+                case load_scalar:
+                    stacks.pushScalar(parameters_->scalar(instruction.offset));
+                    break;
+                case load_vector:
+                    stacks.pushVector(parameters_->vector(instruction.offset).data(), instruction.size);
+                    break;
+                case store_scalar:
+                    stacks.storeScalar(instruction.offset);
+                    break;
+                case store_vector:
+                    stacks.storeVector(instruction.offset, instruction.size);
+                    break;
+                case fetch_scalar:
+                    stacks.fetchScalar(instruction.offset);
+                    break;
+                case fetch_vector:
+                    stacks.fetchVector(instruction.offset, instruction.size);
+                    break;
+                case assign_scalar:
+                    stacks.assignScalar(instruction.offset);
+                    break;
+                case assign_vector:
+                    stacks.assignVector(instruction.offset, instruction.size);
+                    break;
+                case jump:
+                    // the loop increments next
+                    next = static_cast<std::size_t>(instruction.size) - 1;
+                    break;
+                case jump_if_zero:
+                    if constexpr (std::is_same_v<Stacks, CalcStacks>) {
+                        const SCALAR condition = stacks.scalars().back();
+                        stacks.scalars().pop_back();
+                        if (condition == 0.0) {
+                            next = static_cast<std::size_t>(instruction.size) - 1;
+                        }
+                    }
+                    else if (stacks.maskIf()) {
+                        next = static_cast<std::size_t>(instruction.size) - 1;
+                    }
+                    break;
+                case jump_else:
+                    if constexpr (std::is_same_v<Stacks, CalcStacks>) {
+                        next = static_cast<std::size_t>(instruction.size) - 1;
+                    }
+                    else if (stacks.maskElse()) {
+                        next = static_cast<std::size_t>(instruction.size) - 1;
+                    }
+                    break;
+                case jump_unless_date:
+                    if (instruction.date != date) {
+                        next = static_cast<std::size_t>(instruction.size) - 1;
+                    }
+                    break;
+                case end_if:
+                    if constexpr (std::is_same_v<Stacks, BatchStacks>) {
+                        stacks.endIf();
+                    }
+                    break;
+                case terminate:
+                    if constexpr (std::is_same_v<Stacks, CalcStacks>) {
+                        return false;
+                    }
+                    else if (stacks.terminateLanes()) {
+                        return false;
+                    }
+                    break;
+                case append:
+                    VectorAppend(instruction.size)(stacks);
+                    break;
+                case neg_sc:
+                    unary::scMinus(stacks);
+                    break;
+                case neg_vec:
+                    unary::vecMinus(stacks);
+                    break;
+                case not_sc:
+                    unary::scNot(stacks);
+                    break;
+                case not_vec:
+                    unary::vecNot(stacks);
+                    break;
+                case plus_sc_sc:
+                    binary::scSc(stacks, PLUS_F);
+                    break;
+                case plus_sc_vec:
+                    binary::scVec(stacks, PLUS_F);
+                    break;
+                case plus_vec_sc:
+                    binary::vecSc(stacks, PLUS_F);
+                    break;
+                case plus_vec_vec:
+                    binary::vecVec(stacks, PLUS_F);
+                    break;
+                case minus_sc_sc:
+                    binary::scSc(stacks, MINUS_F);
+                    break;
+                case minus_sc_vec:
+                    binary::scVec(stacks, MINUS_F);
+                    break;
+                case minus_vec_sc:
+                    binary::vecSc(stacks, MINUS_F);
+                    break;
+                case minus_vec_vec:
+                    binary::vecVec(stacks, MINUS_F);
+                    break;
+                case mul_sc_sc:
+                    binary::scSc(stacks, MUL_F);
+                    break;
+                case mul_sc_vec:
+                    binary::scVec(stacks, MUL_F);
+                    break;
+                case mul_vec_sc:
+                    binary::vecSc(stacks, MUL_F);
+                    break;
+                case mul_vec_vec:
+                    binary::vecVec(stacks, MUL_F);
+                    break;
+                case div_sc_sc:
+                    binary::scSc(stacks, DIV_F);
+                    break;
+                case div_sc_vec:
+                    binary::scVec(stacks, DIV_F);
+                    break;
+                case div_vec_sc:
+                    binary::vecSc(stacks, DIV_F);
+                    break;
+                case div_vec_vec:
+                    binary::vecVec(stacks, DIV_F);
+                    break;
+                case pow_sc_sc:
+                    binary::scSc(stacks, POW_F);
+                    break;
+                case pow_sc_vec:
+                    binary::powScVec(stacks);
+                    break;
+                case pow_vec_sc:
+                    binary::powVecSc(stacks);
+                    break;
+                case pow_vec_vec:
+                    binary::powVecVec(stacks);
+                    break;
+                case lt_sc_sc:
+                    binary::scSc(stacks, LT_F);
+                    break;
+                case lt_sc_vec:
+                    binary::scVec(stacks, LT_F);
+                    break;
+                case lt_vec_sc:
+                    binary::vecSc(stacks, LT_F);
+                    break;
+                case lt_vec_vec:
+                    binary::vecVec(stacks, LT_F);
+                    break;
+                case gt_sc_sc:
+                    binary::scSc(stacks, GT_F);
+                    break;
+                case gt_sc_vec:
+                    binary::scVec(stacks, GT_F);
+                    break;
+                case gt_vec_sc:
+                    binary::vecSc(stacks, GT_F);
+                    break;
+                case gt_vec_vec:
+                    binary::vecVec(stacks, GT_F);
+                    break;
+                case le_sc_sc:
+                    binary::scSc(stacks, LE_F);
+                    break;
+                case le_sc_vec:
+                    binary::scVec(stacks, LE_F);
+                    break;
+                case le_vec_sc:
+                    binary::vecSc(stacks, LE_F);
+                    break;
+                case le_vec_vec:
+                    binary::vecVec(stacks, LE_F);
+                    break;
+                case ge_sc_sc:
+                    binary::scSc(stacks, GE_F);
+                    break;
+                case ge_sc_vec:
+                    binary::scVec(stacks, GE_F);
+                    break;
+                case ge_vec_sc:
+                    binary::vecSc(stacks, GE_F);
+                    break;
+                case ge_vec_vec:
+                    binary::vecVec(stacks, GE_F);
+                    break;
+                case and_sc_sc:
+                    binary::scSc(stacks, AND_F);
+                    break;
+                case and_sc_vec:
+                    binary::scVec(stacks, AND_F);
+                    break;
+                case and_vec_sc:
+                    binary::vecSc(stacks, AND_F);
+                    break;
+                case and_vec_vec:
+                    binary::vecVec(stacks, AND_F);
+                    break;
+                case or_sc_sc:
+                    binary::scSc(stacks, OR_F);
+                    break;
+                case or_sc_vec:
+                    binary::scVec(stacks, OR_F);
+                    break;
+                case or_vec_sc:
+                    binary::vecSc(stacks, OR_F);
+                    break;
+                case or_vec_vec:
+                    binary::vecVec(stacks, OR_F);
+                    break;
+                case exp_sc:
+                    scalar::calculateScalar(stacks, EXP_F);
+                    break;
+                case exp_vec:
+                    scalar::applyVectorKernel(stacks, vectorMath::exp);
+                    break;
+                case log_sc:
+                    scalar::calculateScalar(stacks, LOG_F);
+                    break;
+                case log_vec:
+                    scalar::applyVectorKernel(stacks, vectorMath::log);
+                    break;
+                case abs_sc:
+                    scalar::calculateScalar(stacks, ABS_F);
+                    break;
+                case abs_vec:
+                    scalar::calculateVector(stacks, ABS_F);
+                    break;
+                case sqrt_sc:
+                    scalar::calculateScalar(stacks, SQRT_F);
+                    break;
+                case sqrt_vec:
+                    scalar::applyVectorKernel(stacks, vectorMath::sqrt);
+                    break;
+                case square_sc:
+                    scalar::calculateScalar(stacks, SQUARE_F);
+                    break;
+                case square_vec:
+                    scalar::calculateVector(stacks, SQUARE_F);
+                    break;
+                case sum_vec:
+                    reduceVector::sum(stacks);
+                    break;
+                case prod_vec:
+                    reduceVector::prod(stacks);
+                    break;
+                case max_vec:
+                    reduceVector::max(stacks);
+                    break;
+                case min_vec:
+                    reduceVector::min(stacks);
+                    break;
+                case argmax_vec:
+                    reduceVector::argmax(stacks);
+                    break;
+                case argmin_vec:
+                    reduceVector::argmin(stacks);
+                    break;
+                case len_vec:
+                    reduceVector::length(stacks);
+                    break;
+                case sum_args:
+                    reduceArguments::accumulate(stacks, PLUS_F, 0.0, instruction.size);
+                    break;
+                case prod_args:
+                    reduceArguments::accumulate(stacks, MUL_F, 1.0, instruction.size);
+                    break;
+                case max_args:
+                    reduceArguments::minmax(stacks, GREATER_F, instruction.size);
+                    break;
+                case min_args:
+                    reduceArguments::minmax(stacks, LESS_F, instruction.size);
+                    break;
+                case argmax_args:
+                    reduceArguments::argMaxScalars(stacks, instruction.size);
+                    break;
+                case argmin_args:
+                    reduceArguments::argMinScalars(stacks, instruction.size);
+                    break;
+                case plus_sc_imm:
+                    binary::scImm(stacks, instruction.scalar, PLUS_F);
+                    break;
+                case minus_sc_imm:
+                    binary::scImm(stacks, instruction.scalar, MINUS_F);
+                    break;
+                case mul_sc_imm:
+                    binary::scImm(stacks, instruction.scalar, MUL_F);
+                    break;
+                case div_sc_imm:
+                    binary::scImm(stacks, instruction.scalar, DIV_F);
+                    break;
+                case pow_sc_imm:
+                    binary::scImm(stacks, instruction.scalar, POW_F);
+                    break;
+                case plus_imm_sc:
+                    binary::immSc(stacks, instruction.scalar, PLUS_F);
+                    break;
+                case minus_imm_sc:
+                    binary::immSc(stacks, instruction.scalar, MINUS_F);
+                    break;
+                case mul_imm_sc:
+                    binary::immSc(stacks, instruction.scalar, MUL_F);
+                    break;
+                case div_imm_sc:
+                    binary::immSc(stacks, instruction.scalar, DIV_F);
+                    break;
+                case pow_imm_sc:
+                    binary::immSc(stacks, instruction.scalar, POW_F);
+                    break;
+                case plus_sc_load:
+                    binary::scImm(stacks, parameters_->scalar(instruction.offset), PLUS_F);
+                    break;
+                case minus_sc_load:
+                    binary::scImm(stacks, parameters_->scalar(instruction.offset), MINUS_F);
+                    break;
+                case mul_sc_load:
+                    binary::scImm(stacks, parameters_->scalar(instruction.offset), MUL_F);
+                    break;
+                case div_sc_load:
+                    binary::scImm(stacks, parameters_->scalar(instruction.offset), DIV_F);
+                    break;
+                case pow_sc_load:
+                    binary::scImm(stacks, parameters_->scalar(instruction.offset), POW_F);
+                    break;
+                case mul_add_sc:
+                    binary::mulAdd(stacks);
+                    break;
+                case mul_add_imm:
+                    binary::mulAddImm(stacks, instruction.scalar);
+                    break;
+                case max_imm:
+                    binary::scImm(stacks, instruction.scalar, MAX_F);
+                    break;
+                case min_imm:
+                    binary::scImm(stacks, instruction.scalar, MIN_F);
+                    break;
+                case call_imm:
+                    binary::scImm(stacks, instruction.scalar, CALL_F);
+                    break;
+                case map_vec:
+                    mapLoop(stacks, map_pool_.data() + instruction.offset, instruction.size);
+                    break;
+                case map_reduce_vec:
+                    mapReduce<false>(stacks, map_pool_.data() + instruction.offset, instruction.size);
+                    break;
+                case zip_reduce_vec:
+                    mapReduce<true>(stacks, map_pool_.data() + instruction.offset, instruction.size);
+                    break;
+                default:
+                    assert(false);
+            }
+        }
+        return true;
+    }
+
+}
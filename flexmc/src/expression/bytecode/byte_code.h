@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector>
+
+#include "calc_types.h"
+#include "expression_stacks.h"
+#include "operation_compiler.h"
+#include "op_codes.h"
+#include "parameters.h"
+
+
+namespace flexMC {
+
+    // Flat alternative to Expression: instead of one std::function per postfix node, the expression is stored as a
+    // contiguous stream of instructions which is run by a single dispatch loop.
+    class ByteCode {
+
+    public:
+
+        void push_back(const Instruction &instruction) { code_.push_back(instruction); }
+
+        // appends an instruction of another ByteCode, literals referenced in its pools are copied
+        void push_back(const Instruction &instruction, const ByteCode &from);
+
+        // drops the instructions from size on, the pools are left untouched
+        void truncate(const std::size_t &size);
+
+        void pushScalar(const SCALAR &value);
+
+        void pushVector(const VECTOR &value);
+
+        void pushDate(const DATE &value);
+
+        void pushDateList(const DATE_LIST &value);
+
+        // reads the parameter at evaluation time, all parameters of a ByteCode belong to the same Parameters
+        void loadScalar(const Parameters &parameters, const std::size_t &slot);
+
+        void loadVector(const Parameters &parameters, const std::size_t &slot);
+
+        // copies the value on top of the stacks into a new local slot and returns the slot
+        std::size_t storeScalar();
+
+        std::size_t storeVector(const std::size_t &size);
+
+        void fetchScalar(const std::size_t &slot);
+
+        void fetchVector(const std::size_t &slot, const std::size_t &size);
+
+        // map_vec, map_reduce_vec or zip_reduce_vec over the steps, see fuseVectorLoops
+        void mapVector(const OpCode &code, const std::vector<MapStep> &steps);
+
+        // new local slots without a store, e.g. for the variables of a script
+        std::size_t addLocalScalar();
+
+        std::size_t addLocalVector(const std::size_t &size);
+
+        // makes the first scalars and vectors local slots addressable, for code which is appended to a ByteCode
+        // owning them
+        void declareLocals(const std::size_t &scalars, const std::size_t &vectors);
+
+        void assignScalar(const std::size_t &slot);
+
+        void assignVector(const std::size_t &slot, const std::size_t &size);
+
+        // The jumps return their index, the target is set by setTarget once it is known
+        std::size_t jump();
+
+        std::size_t jumpIfZero();
+
+        std::size_t jumpElse();
+
+        std::size_t jumpUnlessDate(const DATE &date);
+
+        void setTarget(const std::size_t &jump, const std::size_t &target);
+
+        void endIf();
+
+        void terminate();
+
+        void operator()(CalcStacks &stacks) const;
+
+        // Evaluates a script compiled by compileScript on date, statements scheduled on other dates are skipped.
+        // Returns false if the path was terminated.
+        bool operator()(CalcStacks &stacks, const DATE &date) const;
+
+        // Evaluates all lanes of the batch at once, each instruction is dispatched once per batch instead of per path
+        void operator()(BatchStacks &stacks) const;
+
+        // Evaluates a script on all lanes of the batch. IF blocks on which the lanes disagree run both branches under
+        // a lane mask, see BatchStacks::maskIf. Returns false once all lanes are terminated.
+        bool operator()(BatchStacks &stacks, const DATE &date) const;
+
+        std::size_t size() const { return code_.size(); }
+
+        const std::vector<Instruction> &instructions() const { return code_; }
+
+        const std::vector<SCALAR> &vectorPool() const { return vector_pool_; }
+
+        const std::vector<DATE> &dateListPool() const { return date_list_pool_; }
+
+        const std::vector<MapStep> &mapPool() const { return map_pool_; }
+
+        const Parameters *parameters() const { return parameters_; }
+
+    private:
+
+        template<class Stacks>
+        bool execute(Stacks &stacks, const DATE &date) const;
+
+        std::vector<Instruction> code_;
+
+        std::vector<SCALAR> vector_pool_;
+
+        std::vector<DATE> date_list_pool_;
+
+        std::vector<MapStep> map_pool_;
+
+        const Parameters *parameters_{nullptr};
+
+        std::size_t local_scalars_{0};
+
+        std::size_t local_vectors_{0};
+
+    };
+
+    Instruction compileInstruction(const CallSignature &signature);
+
+}
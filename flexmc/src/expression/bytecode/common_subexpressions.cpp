@@ -0,0 +1,189 @@
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+
+#include "common_subexpressions.h"
+
+
+namespace flexMC {
+
+    namespace {
+
+        // Identifies a subtree: two subtrees are the same if their root instructions are the same and their children
+        // are the same subtrees.
+        struct NodeKey {
+
+            OpCode code;
+
+            std::uint32_t size;
+
+            // bits of the immediate, the id of the literal for vectors and date lists
+            std::uint64_t immediate;
+
+            std::vector<std::size_t> children;
+
+            bool operator==(const NodeKey &) const = default;
+
+        };
+
+        struct NodeHash {
+            std::size_t operator()(const NodeKey &key) const {
+                std::size_t hash = std::hash<std::uint64_t>{}(key.immediate);
+                auto combine = [&hash](const std::size_t &value) {
+                    hash ^= value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+                };
+                combine(static_cast<std::size_t>(key.code));
+                combine(key.size);
+                for (const auto &child: key.children) {
+                    combine(child);
+                }
+                return hash;
+            }
+        };
+
+        struct Node {
+
+            Instruction instruction;
+
+            // the ByteCode holding the literals of instruction
+            const ByteCode *from;
+
+            std::vector<std::size_t> children;
+
+            // number of elements of the result
+            std::size_t size;
+
+            // number of parents plus the number of statements it is the result of
+            std::size_t uses{0};
+
+        };
+
+        class SubtreeTable {
+
+        public:
+
+            std::size_t insert(const Instruction &instruction,
+                               const ByteCode &from,
+                               const std::vector<std::size_t> &children) {
+                NodeKey key{instruction.code, instruction.size, immediate(instruction, from), children};
+                const auto found = ids_.find(key);
+                if (found != ids_.end()) {
+                    return found->second;
+                }
+                std::size_t largest{0};
+                for (const auto &child: children) {
+                    largest = std::max(largest, nodes_[child].size);
+                    ++nodes_[child].uses;
+                }
+                nodes_.push_back({instruction, &from, children, resultSize(instruction, largest)});
+                ids_.emplace(std::move(key), nodes_.size() - 1);
+                return nodes_.size() - 1;
+            }
+
+            Node &operator[](const std::size_t &id) { return nodes_[id]; }
+
+            std::size_t size() const { return nodes_.size(); }
+
+        private:
+
+            std::uint64_t immediate(const Instruction &instruction, const ByteCode &from) {
+                const auto begin = static_cast<std::ptrdiff_t>(instruction.offset);
+                const auto end = begin + static_cast<std::ptrdiff_t>(instruction.size);
+                if (instruction.code == OpCode::push_vector) {
+                    const VECTOR literal(from.vectorPool().begin() + begin, from.vectorPool().begin() + end);
+                    return vector_literals_.try_emplace(literal, vector_literals_.size()).first->second;
+                }
+                if (instruction.code == OpCode::push_date_list) {
+                    const DATE_LIST literal(from.dateListPool().begin() + begin, from.dateListPool().begin() + end);
+                    return date_list_literals_.try_emplace(literal, date_list_literals_.size()).first->second;
+                }
+                std::uint64_t bits;
+                static_assert(sizeof(bits) == sizeof(instruction.offset));
+                std::memcpy(&bits, &instruction.offset, sizeof(bits));
+                return bits;
+            }
+
+            std::vector<Node> nodes_;
+
+            std::unordered_map<NodeKey, std::size_t, NodeHash> ids_;
+
+            std::map<VECTOR, std::size_t> vector_literals_;
+
+            std::map<DATE_LIST, std::size_t> date_list_literals_;
+
+        };
+
+        class Emitter {
+
+        public:
+
+            explicit Emitter(SubtreeTable &table) : table_(table), locals_(table.size(), NOT_STORED) {}
+
+            void emit(const std::size_t &id) {
+                const Node &node = table_[id];
+                const CType type = resultType(node.instruction.code);
+                if (locals_[id] != NOT_STORED) {
+                    if (type == CType::scalar) {
+                        code_.fetchScalar(locals_[id]);
+                    }
+                    else {
+                        code_.fetchVector(locals_[id], node.size);
+                    }
+                    return;
+                }
+                for (const auto &child: node.children) {
+                    emit(child);
+                }
+                code_.push_back(node.instruction, *node.from);
+                // leaves are as cheap as fetching them
+                if ((node.uses > 1) && !node.children.empty()) {
+                    assert((type == CType::scalar) || (type == CType::vector));
+                    locals_[id] = type == CType::scalar ? code_.storeScalar() : code_.storeVector(node.size);
+                }
+            }
+
+            ByteCode &code() { return code_; }
+
+        private:
+
+            static constexpr std::size_t NOT_STORED = static_cast<std::size_t>(-1);
+
+            SubtreeTable &table_;
+
+            std::vector<std::size_t> locals_;
+
+            ByteCode code_;
+
+        };
+
+    }
+
+    ByteCode eliminateCommonSubexpressions(const std::vector<ByteCode> &statements) {
+        SubtreeTable table;
+        std::vector<std::size_t> roots;
+        for (const ByteCode &statement: statements) {
+            std::vector<std::size_t> ids;
+            for (const Instruction &instruction: statement.instructions()) {
+                const std::size_t num_operands = numOperands(instruction);
+                assert(ids.size() >= num_operands);
+                const auto first = ids.end() - static_cast<std::ptrdiff_t>(num_operands);
+                const std::vector<std::size_t> children(first, ids.end());
+                ids.erase(first, ids.end());
+                ids.push_back(table.insert(instruction, statement, children));
+            }
+            assert(ids.size() == 1);
+            ++table[ids.back()].uses;
+            roots.push_back(ids.back());
+        }
+
+        Emitter emitter(table);
+        for (const auto &root: roots) {
+            emitter.emit(root);
+        }
+        return std::move(emitter.code());
+    }
+
+}
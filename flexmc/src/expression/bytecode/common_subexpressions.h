@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    // Merges the byte code of the statements of a script into one ByteCode, which leaves the result of every statement
+    // on the stacks in order. Identical subtrees are found by hashing the postfix subtrees of all statements. Those
+    // occurring more than once (other than numbers, literals and parameters) are computed on their first occurrence,
+    // stored into a local slot and fetched afterwards.
+    ByteCode eliminateCommonSubexpressions(const std::vector<ByteCode> &statements);
+
+}
@@ -0,0 +1,86 @@
+#include <cassert>
+#include <algorithm>
+#include <iterator>
+
+#include "constant_folding.h"
+
+
+namespace flexMC {
+
+    namespace {
+
+        // A value on the stacks during folding: the instructions computing it start at begin
+        struct Entry {
+            std::size_t begin;
+            bool constant;
+            // number of elements, 1 for scalars and dates
+            std::size_t size;
+        };
+
+        bool isPush(const OpCode &code) {
+            using
+            enum OpCode;
+            return (code == push_scalar) || (code == push_vector) || (code == push_date) || (code == push_date_list);
+        }
+
+        // evaluates the instructions from begin on, which leave exactly one value on the stacks
+        void evaluateTail(ByteCode &code, const std::size_t &begin, const CType &type) {
+            ByteCode tail;
+            for (std::size_t i{begin}; i < code.size(); ++i) {
+                tail.push_back(code.instructions()[i], code);
+            }
+            CalcStacks stacks(tail.size(), tail.size(), 0, 0);
+            tail(stacks);
+            code.truncate(begin);
+            if (type == CType::scalar) {
+                code.pushScalar(stacks.scalars().back());
+            }
+            else {
+                assert(type == CType::vector);
+                code.pushVector(stacks.vectorResult());
+            }
+        }
+
+    }
+
+    ByteCode foldConstants(const ByteCode &code) {
+        ByteCode folded;
+        std::vector<Entry> entries;
+
+        for (const Instruction &instruction: code.instructions()) {
+            const std::size_t num_operands = numOperands(instruction);
+            assert(entries.size() >= num_operands);
+            const auto first = entries.end() - static_cast<std::ptrdiff_t>(num_operands);
+            const std::vector<Entry> operands(first, entries.end());
+            entries.erase(first, entries.end());
+
+            const std::size_t begin = operands.empty() ? folded.size() : operands.front().begin;
+            // parameters take no operands but are not constant
+            const bool constant = isPush(instruction.code) ||
+                                  (!operands.empty() &&
+                                   std::ranges::all_of(operands, [](const Entry &e) { return e.constant; }));
+            const std::size_t largest = operands.empty() ? 0 : std::ranges::max(operands, {}, &Entry::size).size;
+            const std::size_t size = resultSize(instruction, largest);
+
+            if (instruction.code == OpCode::len_vec) {
+                folded.truncate(begin);
+                folded.pushScalar(static_cast<SCALAR>(operands.front().size));
+                entries.push_back({begin, true, 1});
+                continue;
+            }
+            folded.push_back(instruction, code);
+            if (constant && !isPush(instruction.code)) {
+                evaluateTail(folded, begin, resultType(instruction.code));
+            }
+            entries.push_back({begin, constant, size});
+        }
+
+        // truncating leaves unreferenced literals behind in the pools
+        ByteCode out;
+        for (const Instruction &instruction: folded.instructions()) {
+            out.push_back(instruction, folded);
+        }
+        return out;
+    }
+
+}
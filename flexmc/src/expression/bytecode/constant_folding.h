@@ -0,0 +1,13 @@
+#pragma once
+
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    // Collapses every subtree whose operands are all literals (numbers, vector literals and static variables) into a
+    // single push of its value, and LEN of any vector into a number since its size is known at compile time.
+    // Parameters are not constant.
+    ByteCode foldConstants(const ByteCode &code);
+
+}
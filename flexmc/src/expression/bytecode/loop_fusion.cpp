@@ -0,0 +1,188 @@
+#include <cassert>
+#include <optional>
+
+#include "loop_fusion.h"
+
+
+namespace flexMC {
+
+    namespace {
+
+        // A value on the stacks during fusion, computed by the instructions [begin, begin of the next entry). If the
+        // value is the result of element-wise steps, source is the range computing the vector (two vectors if zip)
+        // the steps start from. steps is empty for every other value.
+        struct Entry {
+
+            std::size_t begin;
+
+            std::size_t source_begin{0};
+
+            std::size_t source_end{0};
+
+            std::vector<MapStep> steps;
+
+            // steps start with an <op>_vec_vec step over two vectors
+            bool zip{false};
+
+        };
+
+        bool isElementWise(const OpCode &code) {
+            return (code == OpCode::neg_vec) || (code == OpCode::not_vec) ||
+                   (isFunction(code) && isVectorFunction(code));
+        }
+
+        // reductions with a streaming kernel, LEN is folded to a number before
+        bool isStreamingReduction(const OpCode &code) {
+            return isReduceVector(code) && (code != OpCode::len_vec);
+        }
+
+        class LoopFuser {
+
+        public:
+
+            explicit LoopFuser(const ByteCode &code) : code_(code) {}
+
+            ByteCode fuse() {
+                for (const Instruction &instruction: code_.instructions()) {
+                    if (!fuseStep(instruction) && !fuseReduction(instruction)) {
+                        push(instruction);
+                    }
+                }
+                // copy to drop the steps of chains that were extended afterwards from the map pool
+                ByteCode out;
+                for (const Instruction &instruction: fused_.instructions()) {
+                    out.push_back(instruction, fused_);
+                }
+                return out;
+            }
+
+        private:
+
+            std::size_t end(const std::size_t &index) const {
+                return index + 1 < entries_.size() ? entries_[index + 1].begin : fused_.size();
+            }
+
+            bool isNumber(const std::size_t &index) const {
+                return (end(index) == entries_[index].begin + 1) &&
+                       (fused_.instructions()[entries_[index].begin].code == OpCode::push_scalar);
+            }
+
+            // pops the operands of instruction and returns the begin of the first one
+            std::size_t popOperands(const Instruction &instruction) {
+                const std::size_t num = numOperands(instruction);
+                assert(entries_.size() >= num);
+                const std::size_t begin = (num == 0) ? fused_.size() : entries_[entries_.size() - num].begin;
+                entries_.resize(entries_.size() - num);
+                return begin;
+            }
+
+            void push(const Instruction &instruction) {
+                const std::size_t n = entries_.size();
+                Entry entry{popOperands(instruction), 0, 0, {}, false};
+                fused_.push_back(instruction, code_);
+                // a vector operator may start the steps of a reduction
+                if (isBinary(instruction.code) && (binaryVariant(instruction.code) == 3)) {
+                    entry = {entry.begin, entry.begin, fused_.size() - 1, {{instruction.code, 0.0}}, true};
+                }
+                entries_.push_back(entry);
+                assert(entries_.size() == n + 1 - numOperands(instruction));
+            }
+
+            // the step applied by instruction and the position of the vector it applies to, if it is element-wise
+            std::optional<std::pair<MapStep, std::size_t>> step(const Instruction &instruction) const {
+                const std::size_t n = entries_.size();
+                if (isElementWise(instruction.code) && (n >= 1)) {
+                    return std::pair{MapStep{instruction.code, 0.0}, n - 1};
+                }
+                if (!isBinary(instruction.code) || (n < 2)) {
+                    return std::nullopt;
+                }
+                const std::size_t variant = binaryVariant(instruction.code);
+                if ((variant == 1) && isNumber(n - 2)) {
+                    const SCALAR left = fused_.instructions()[entries_[n - 2].begin].scalar;
+                    return std::pair{MapStep{instruction.code, left}, n - 1};
+                }
+                if ((variant == 2) && isNumber(n - 1)) {
+                    const SCALAR right = fused_.instructions()[entries_[n - 1].begin].scalar;
+                    return std::pair{MapStep{instruction.code, right}, n - 2};
+                }
+                return std::nullopt;
+            }
+
+            // replaces the code of the operands of the last instruction by source, followed by the instructions
+            // applying steps to it
+            void emit(const std::size_t &begin, const Entry &operand, const std::vector<MapStep> &steps,
+                      const OpCode &reduction) {
+                const std::vector<Instruction> source(
+                    fused_.instructions().begin() + static_cast<std::ptrdiff_t>(operand.source_begin),
+                    fused_.instructions().begin() + static_cast<std::ptrdiff_t>(operand.source_end));
+                fused_.truncate(begin);
+                for (const Instruction &instruction: source) {
+                    fused_.push_back(instruction);
+                }
+                if (reduction != OpCode::map_vec) {
+                    fused_.mapVector(operand.zip ? OpCode::zip_reduce_vec : OpCode::map_reduce_vec, steps);
+                    return;
+                }
+                // vectors are combined before the loop
+                if (operand.zip) {
+                    fused_.push_back(Instruction{steps.front().code, 0});
+                }
+                assert(steps.size() - (operand.zip ? 1 : 0) > 1);
+                fused_.mapVector(OpCode::map_vec, std::vector<MapStep>(steps.begin() + (operand.zip ? 1 : 0),
+                                                                       steps.end()));
+            }
+
+            bool fuseStep(const Instruction &instruction) {
+                const auto found = step(instruction);
+                if (!found.has_value()) {
+                    return false;
+                }
+                const auto &[new_step, vector] = *found;
+                Entry operand = entries_[vector];
+                std::vector<MapStep> steps = operand.steps;
+                steps.push_back(new_step);
+                if (steps.size() == (operand.zip ? 2 : 1)) {
+                    // first step of a possible chain, kept as it is
+                    if (!operand.zip) {
+                        operand.source_begin = operand.begin;
+                        operand.source_end = end(vector);
+                    }
+                    const std::size_t begin = entries_[entries_.size() - numOperands(instruction)].begin;
+                    push(instruction);
+                    entries_.back() = {begin, operand.source_begin, operand.source_end, steps, operand.zip};
+                    return true;
+                }
+                const std::size_t begin = popOperands(instruction);
+                const std::size_t source_size = operand.source_end - operand.source_begin;
+                emit(begin, operand, steps, OpCode::map_vec);
+                entries_.push_back({begin, begin, begin + source_size, steps, operand.zip});
+                return true;
+            }
+
+            bool fuseReduction(const Instruction &instruction) {
+                if (!isStreamingReduction(instruction.code) || entries_.empty() || entries_.back().steps.empty()) {
+                    return false;
+                }
+                const Entry operand = entries_.back();
+                const std::size_t begin = popOperands(instruction);
+                std::vector<MapStep> steps = operand.steps;
+                steps.push_back({instruction.code, 0.0});
+                emit(begin, operand, steps, instruction.code);
+                entries_.push_back({begin, 0, 0, {}, false});
+                return true;
+            }
+
+            const ByteCode &code_;
+
+            ByteCode fused_;
+
+            std::vector<Entry> entries_;
+
+        };
+
+    }
+
+    ByteCode fuseVectorLoops(const ByteCode &code) { return LoopFuser(code).fuse(); }
+
+}
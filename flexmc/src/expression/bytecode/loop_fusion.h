@@ -0,0 +1,14 @@
+#pragma once
+
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    // Replaces every maximal chain of at least two element-wise operations on one vector (prefix minus, vector
+    // functions and binary operators with a number) by a single map_vec instruction, which runs the chain in one
+    // pass over the vector instead of one pass per operation. Reductions (but LEN) over a chain or over an operator
+    // on two vectors become map_reduce_vec and zip_reduce_vec, which never write the mapped vector.
+    ByteCode fuseVectorLoops(const ByteCode &code);
+
+}
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "calc_types.h"
+
+
+namespace flexMC {
+
+    // Binary operators are laid out as blocks of four in the order <left><right>: sc_sc, sc_vec, vec_sc, vec_vec.
+    // Functions taking a scalar or a vector are laid out as pairs: sc, vec.
+    // The compiler relies on this layout when it translates a CallSignature into an OpCode.
+    enum class OpCode : std::uint8_t {
+        // operands
+        push_scalar,
+        push_vector,
+        push_date,
+        push_date_list,
+        append,
+
+        // parameters, the slot is Instruction::offset
+        load_scalar,
+        load_vector,
+
+        // values shared between statements, the local slot is Instruction::offset. Stores leave the value in place.
+        store_scalar,
+        store_vector,
+        fetch_scalar,
+        fetch_vector,
+
+        // script control flow, see compileScript. Assignments move the value on top of the stacks into the local slot
+        // Instruction::offset. The target of a jump is the instruction index Instruction::size.
+        assign_scalar,
+        assign_vector,
+        jump,
+        // takes the scalar condition of an IF
+        jump_if_zero,
+        // the end of the IF branch, jumps over the ELSE branch
+        jump_else,
+        // jumps unless the script is evaluated on Instruction::date
+        jump_unless_date,
+        // the end of an IF or ELSE branch, only path batches act on it (see BatchStacks::endIf)
+        end_if,
+        terminate,
+
+        // prefix minus and NOT
+        neg_sc,
+        neg_vec,
+        not_sc,
+        not_vec,
+
+        // binary operators
+        plus_sc_sc,
+        plus_sc_vec,
+        plus_vec_sc,
+        plus_vec_vec,
+        minus_sc_sc,
+        minus_sc_vec,
+        minus_vec_sc,
+        minus_vec_vec,
+        mul_sc_sc,
+        mul_sc_vec,
+        mul_vec_sc,
+        mul_vec_vec,
+        div_sc_sc,
+        div_sc_vec,
+        div_vec_sc,
+        div_vec_vec,
+        pow_sc_sc,
+        pow_sc_vec,
+        pow_vec_sc,
+        pow_vec_vec,
+        // comparisons and logical operators, masks of 1.0 and 0.0
+        lt_sc_sc,
+        lt_sc_vec,
+        lt_vec_sc,
+        lt_vec_vec,
+        gt_sc_sc,
+        gt_sc_vec,
+        gt_vec_sc,
+        gt_vec_vec,
+        le_sc_sc,
+        le_sc_vec,
+        le_vec_sc,
+        le_vec_vec,
+        ge_sc_sc,
+        ge_sc_vec,
+        ge_vec_sc,
+        ge_vec_vec,
+        and_sc_sc,
+        and_sc_vec,
+        and_vec_sc,
+        and_vec_vec,
+        or_sc_sc,
+        or_sc_vec,
+        or_vec_sc,
+        or_vec_vec,
+
+        // functionsReal::scalar
+        exp_sc,
+        exp_vec,
+        log_sc,
+        log_vec,
+        abs_sc,
+        abs_vec,
+        sqrt_sc,
+        sqrt_vec,
+        square_sc,
+        square_vec,
+
+        // functionsReal::reduceVector
+        sum_vec,
+        prod_vec,
+        max_vec,
+        min_vec,
+        argmax_vec,
+        argmin_vec,
+        len_vec,
+
+        // functionsReal::reduceArguments, the number of arguments is Instruction::size
+        sum_args,
+        prod_args,
+        max_args,
+        min_args,
+        argmax_args,
+        argmin_args,
+
+        // superinstructions produced by fuseInstructions, blocks of five in the order plus, minus, mul, div, pow
+        // <op>_sc_imm: the right operand is Instruction::scalar
+        plus_sc_imm,
+        minus_sc_imm,
+        mul_sc_imm,
+        div_sc_imm,
+        pow_sc_imm,
+        // <op>_imm_sc: the left operand is Instruction::scalar
+        plus_imm_sc,
+        minus_imm_sc,
+        mul_imm_sc,
+        div_imm_sc,
+        pow_imm_sc,
+        // <op>_sc_load: the right operand is the parameter in slot Instruction::offset
+        plus_sc_load,
+        minus_sc_load,
+        mul_sc_load,
+        div_sc_load,
+        pow_sc_load,
+        // c + a * b
+        mul_add_sc,
+        // a * b + Instruction::scalar
+        mul_add_imm,
+        // MAX(x, Instruction::scalar), MIN(x, Instruction::scalar)
+        max_imm,
+        min_imm,
+        // MAX(x - Instruction::scalar, 0)
+        call_imm,
+
+        // element-wise loop produced by fuseVectorLoops: applies the Instruction::size steps starting at
+        // Instruction::offset in the map pool to every element of the vector in one pass
+        map_vec,
+        // reduction over an element-wise loop without writing the mapped vector, the last step is the reduction
+        // (sum_vec to argmin_vec). zip_reduce_vec starts with an <op>_vec_vec step over the two vectors on top.
+        map_reduce_vec,
+        zip_reduce_vec,
+    };
+
+    // Instructions carry their immediate inline. Vector and date list literals are stored in the constant pools of
+    // the ByteCode and referenced by offset and size.
+    struct Instruction {
+
+        Instruction() = default;
+
+        Instruction(const OpCode &op_code, const std::uint32_t &num) : code(op_code), size(num) {}
+
+        OpCode code{OpCode::push_scalar};
+
+        // number of arguments or number of elements
+        std::uint32_t size{0};
+
+        union {
+            SCALAR scalar{0.0};
+            DATE date;
+            std::size_t offset;
+        };
+
+    };
+
+    static_assert(sizeof(Instruction) == 16, "Instructions are expected to be two words wide");
+
+    // One step of a map_vec loop: neg_vec, not_vec, a vector function or a binary operator with the scalar operand
+    // given by scalar, <op>_sc_vec if it is the left operand and <op>_vec_sc if it is the right one. See map_reduce_vec
+    // and zip_reduce_vec for the first and last steps of fused reductions.
+    struct MapStep {
+
+        OpCode code{OpCode::neg_vec};
+
+        SCALAR scalar{0.0};
+
+    };
+
+    inline bool isBinary(const OpCode &code) { return (OpCode::plus_sc_sc <= code) && (code <= OpCode::or_vec_vec); }
+
+    // the binary operators with superinstructions, plus to pow
+    inline bool isArithmetic(const OpCode &code) {
+        return (OpCode::plus_sc_sc <= code) && (code <= OpCode::pow_vec_vec);
+    }
+
+    inline bool isFunction(const OpCode &code) { return (OpCode::exp_sc <= code) && (code <= OpCode::square_vec); }
+
+    inline bool isReduceVector(const OpCode &code) { return (OpCode::sum_vec <= code) && (code <= OpCode::len_vec); }
+
+    inline bool isReduceArguments(const OpCode &code) {
+        return (OpCode::sum_args <= code) && (code <= OpCode::argmin_args);
+    }
+
+    // position in the block of four <left><right> variants of a binary operator
+    inline std::size_t binaryVariant(const OpCode &code) {
+        return (static_cast<std::size_t>(code) - static_cast<std::size_t>(OpCode::plus_sc_sc)) % 4;
+    }
+
+    // the four variants of **
+    inline bool isPow(const OpCode &code) { return (OpCode::pow_sc_sc <= code) && (code <= OpCode::pow_vec_vec); }
+
+    inline bool isVectorFunction(const OpCode &code) {
+        return ((static_cast<std::size_t>(code) - static_cast<std::size_t>(OpCode::exp_sc)) % 2) == 1;
+    }
+
+    // assignments, jumps and terminate of compileScript
+    inline bool isControlFlow(const OpCode &code) {
+        return (OpCode::assign_scalar <= code) && (code <= OpCode::terminate);
+    }
+
+    // scalar superinstructions
+    inline bool isFused(const OpCode &code) { return (OpCode::plus_sc_imm <= code) && (code <= OpCode::call_imm); }
+
+    // number of values an instruction takes from the stacks, counted over all types
+    inline std::size_t numOperands(const Instruction &instruction) {
+        using
+        enum OpCode;
+        const OpCode code = instruction.code;
+        if ((code == append) || isReduceArguments(code)) {
+            return instruction.size;
+        }
+        if ((code == store_scalar) || (code == store_vector) || (code == assign_scalar) || (code == assign_vector) ||
+            (code == jump_if_zero)) {
+            return 1;
+        }
+        if (code == mul_add_sc) {
+            return 3;
+        }
+        if ((code == mul_add_imm) || (code == zip_reduce_vec)) {
+            return 2;
+        }
+        if (isFused(code)) {
+            return 1;
+        }
+        if (isBinary(code)) {
+            return 2;
+        }
+        if ((code == neg_sc) || (code == neg_vec) || (code == not_sc) || (code == not_vec) || (code == map_vec) ||
+            (code == map_reduce_vec) || isFunction(code) || isReduceVector(code)) {
+            return 1;
+        }
+        return 0;
+    }
+
+    inline CType resultType(const OpCode &code) {
+        using
+        enum OpCode;
+        if ((code == push_scalar) || (code == load_scalar) || (code == store_scalar) || (code == fetch_scalar) ||
+            (code == neg_sc) || (code == not_sc) || isFused(code) || isReduceVector(code) || isReduceArguments(code) ||
+            (code == map_reduce_vec) || (code == zip_reduce_vec)) {
+            return CType::scalar;
+        }
+        if (isBinary(code)) {
+            return binaryVariant(code) == 0 ? CType::scalar : CType::vector;
+        }
+        if (isFunction(code)) {
+            return isVectorFunction(code) ? CType::vector : CType::scalar;
+        }
+        if (code == push_date) {
+            return CType::date;
+        }
+        if (code == push_date_list) {
+            return CType::date_list;
+        }
+        return CType::vector;
+    }
+
+    // number of elements of the result, largest_operand is the largest number of elements of the operands
+    inline std::size_t resultSize(const Instruction &instruction, const std::size_t &largest_operand) {
+        using
+        enum OpCode;
+        switch (instruction.code) {
+            case push_vector:
+            case push_date_list:
+            case load_vector:
+            case store_vector:
+            case fetch_vector:
+            case append:
+                return instruction.size;
+            default:
+                return resultType(instruction.code) == CType::vector ? largest_operand : 1;
+        }
+    }
+
+}
@@ -0,0 +1,109 @@
+#include <cassert>
+
+#include "peephole.h"
+
+
+namespace flexMC {
+
+    namespace {
+
+        // position of a binary operator in plus, minus, mul, div, pow
+        std::size_t operatorIndex(const OpCode &code) {
+            return (static_cast<std::size_t>(code) - static_cast<std::size_t>(OpCode::plus_sc_sc)) / 4;
+        }
+
+        OpCode offset(const OpCode &base, const std::size_t &by) {
+            return static_cast<OpCode>(static_cast<std::size_t>(base) + by);
+        }
+
+        bool isScalarBinary(const OpCode &code) { return isArithmetic(code) && (binaryVariant(code) == 0); }
+
+        bool isScalarLoad(const OpCode &code) { return (OpCode::plus_sc_load <= code) && (code <= OpCode::pow_sc_load); }
+
+        Instruction withScalar(const OpCode &code, const SCALAR &value) {
+            Instruction instruction{code, 0};
+            instruction.scalar = value;
+            return instruction;
+        }
+
+        Instruction withSlot(const OpCode &code, const std::size_t &slot) {
+            Instruction instruction{code, 0};
+            instruction.offset = slot;
+            return instruction;
+        }
+
+        void replaceTail(ByteCode &code, const std::size_t &num, const Instruction &fused) {
+            code.truncate(code.size() - num);
+            code.push_back(fused);
+        }
+
+        // The instruction before the last one computes the last operand of the last instruction, since every
+        // instruction leaves exactly one value. Returns whether the tail was rewritten.
+        bool fuseTail(ByteCode &code) {
+            using
+            enum OpCode;
+            const std::vector<Instruction> &instructions = code.instructions();
+            const std::size_t n = instructions.size();
+            if (n < 2) {
+                return false;
+            }
+            const Instruction last = instructions[n - 1];
+            const Instruction previous = instructions[n - 2];
+
+            if ((last.code == plus_sc_sc) && (previous.code == mul_sc_sc)) {
+                replaceTail(code, 2, {mul_add_sc, 0});
+                return true;
+            }
+            if ((last.code == plus_sc_imm) && (previous.code == mul_sc_sc)) {
+                replaceTail(code, 2, withScalar(mul_add_imm, last.scalar));
+                return true;
+            }
+            if (isScalarBinary(last.code) && (previous.code == push_scalar)) {
+                replaceTail(code, 2, withScalar(offset(plus_sc_imm, operatorIndex(last.code)), previous.scalar));
+                return true;
+            }
+            if (isScalarBinary(last.code) && (previous.code == load_scalar)) {
+                replaceTail(code, 2, withSlot(offset(plus_sc_load, operatorIndex(last.code)), previous.offset));
+                return true;
+            }
+            if ((n >= 3) && isScalarBinary(last.code) && (previous.code == fetch_scalar) &&
+                (instructions[n - 3].code == push_scalar)) {
+                const SCALAR left = instructions[n - 3].scalar;
+                code.truncate(n - 3);
+                code.push_back(previous);
+                code.push_back(withScalar(offset(plus_imm_sc, operatorIndex(last.code)), left));
+                return true;
+            }
+            if (isScalarLoad(last.code) && (previous.code == push_scalar)) {
+                const std::size_t op = static_cast<std::size_t>(last.code) - static_cast<std::size_t>(plus_sc_load);
+                code.truncate(n - 2);
+                code.push_back(withSlot(load_scalar, last.offset));
+                code.push_back(withScalar(offset(plus_imm_sc, op), previous.scalar));
+                return true;
+            }
+            if (((last.code == max_args) || (last.code == min_args)) && (last.size == 2) &&
+                (previous.code == push_scalar)) {
+                replaceTail(code, 2, withScalar(last.code == max_args ? max_imm : min_imm, previous.scalar));
+                return true;
+            }
+            if ((last.code == max_imm) && (last.scalar == 0.0) && (previous.code == minus_sc_imm)) {
+                replaceTail(code, 2, withScalar(call_imm, previous.scalar));
+                return true;
+            }
+            return false;
+        }
+
+    }
+
+    ByteCode fuseInstructions(const ByteCode &code) {
+        ByteCode fused;
+        for (const Instruction &instruction: code.instructions()) {
+            fused.push_back(instruction, code);
+            while (fuseTail(fused)) {
+                // a fused instruction may complete a longer pattern
+            }
+        }
+        return fused;
+    }
+
+}
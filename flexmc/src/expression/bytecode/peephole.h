@@ -0,0 +1,12 @@
+#pragma once
+
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    // Peephole stage run after compileExpression: replaces frequent instruction sequences by one superinstruction,
+    // e.g. a binary operator with a number or a parameter operand, c + a * b and MAX(x - k, 0).
+    ByteCode fuseInstructions(const ByteCode &code);
+
+}
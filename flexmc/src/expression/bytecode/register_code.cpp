@@ -0,0 +1,510 @@
+#include <cassert>
+#include <algorithm>
+#include <iterator>
+
+#include "operators_calc.h"
+#include "functions_real.h"
+#include "kernels.h"
+#include "vector_math.h"
+#include "register_code.h"
+
+
+namespace flexMC {
+
+    namespace {
+
+        struct Slot {
+            // where the value currently is
+            std::uint32_t at;
+            // number of elements, 1 for scalars and dates
+            std::uint32_t size;
+            // where the value goes when it is computed, i.e. the stack position resolved to an offset
+            std::uint32_t temp;
+        };
+
+        // Stack of slots of one type during lowering, temporaries are allocated behind base
+        class SlotStack {
+
+        public:
+
+            explicit SlotStack(const std::size_t &base) : base_(static_cast<std::uint32_t>(base)), end_max_(base_) {}
+
+            void pushConstant(const std::size_t &at, const std::size_t &size) {
+                push(static_cast<std::uint32_t>(at), static_cast<std::uint32_t>(size));
+            }
+
+            const Slot &pushTemp(const std::size_t &size) {
+                push(nextTemp(), static_cast<std::uint32_t>(size));
+                return slots_.back();
+            }
+
+            Slot pop() {
+                assert(!slots_.empty());
+                const Slot back = slots_.back();
+                slots_.pop_back();
+                return back;
+            }
+
+            Slot &fromBack(const std::size_t &i) { return slots_[slots_.size() - 1 - i]; }
+
+            std::size_t size() const { return slots_.size(); }
+
+            std::size_t temps() const { return end_max_ - base_; }
+
+        private:
+
+            std::uint32_t nextTemp() const { return slots_.empty() ? base_ : slots_.back().temp + slots_.back().size; }
+
+            void push(const std::uint32_t &at, const std::uint32_t &size) {
+                const std::uint32_t temp = nextTemp();
+                slots_.push_back({at, size, temp});
+                end_max_ = std::max<std::uint32_t>(end_max_, temp + size);
+            }
+
+            const std::uint32_t base_;
+
+            std::uint32_t end_max_;
+
+            std::vector<Slot> slots_;
+
+        };
+
+        RegisterInstruction makeInstruction(const OpCode &code,
+                                            const std::size_t &size,
+                                            const std::uint32_t &out,
+                                            const std::uint32_t &left,
+                                            const std::uint32_t &right = 0) {
+            RegisterInstruction instruction;
+            instruction.code = code;
+            instruction.size = static_cast<std::uint32_t>(size);
+            instruction.out = out;
+            instruction.left = left;
+            instruction.right = right;
+            return instruction;
+        }
+
+    }
+
+    bool RegisterCode::isLowerable(const ByteCode &code) {
+        using
+        enum OpCode;
+        return std::ranges::all_of(code.instructions(), [](const Instruction &instruction) {
+            const OpCode op = instruction.code;
+            return (op == push_scalar) || (op == push_vector) || (op == push_date) || (op == push_date_list) ||
+                   (op == load_scalar) || (op == load_vector) || (op == append) || isReduceArguments(op) ||
+                   (op == neg_sc) || (op == not_sc) || (op == neg_vec) || (op == not_vec) || isFunction(op) ||
+                   isBinary(op) || isReduceVector(op);
+        });
+    }
+
+    RegisterCode::RegisterCode(const ByteCode &code) {
+        using
+        enum OpCode;
+
+        if (!isLowerable(code)) {
+            return;
+        }
+
+        for (const Instruction &instruction: code.instructions()) {
+            if (instruction.code == push_scalar) {
+                scalar_constants_.push_back(instruction.scalar);
+            }
+            else if (instruction.code == push_date) {
+                date_constants_.push_back(instruction.date);
+            }
+        }
+        vector_constants_ = code.vectorPool();
+        parameters_ = code.parameters();
+        date_list_constants_ = code.dateListPool();
+
+        SlotStack scalars(scalar_constants_.size());
+        SlotStack vectors(vector_constants_.size());
+        SlotStack dates(date_constants_.size());
+        SlotStack date_lists(date_list_constants_.size());
+        std::size_t next_scalar_constant{0};
+        std::size_t next_date_constant{0};
+
+        // numbers and static variables are referenced where they are, except for the arguments of operations
+        // reading a contiguous range of scalars
+        auto materializeScalars = [this, &scalars](const std::size_t &num) {
+            for (std::size_t i{0}; i < num; ++i) {
+                Slot &slot = scalars.fromBack(i);
+                if (slot.at != slot.temp) {
+                    RegisterInstruction load = makeInstruction(push_scalar, 1, slot.temp, slot.at);
+                    load.scalar = scalar_constants_[slot.at];
+                    code_.push_back(load);
+                    slot.at = slot.temp;
+                }
+            }
+        };
+
+        for (const Instruction &instruction: code.instructions()) {
+            const OpCode op = instruction.code;
+            if (op == push_scalar) {
+                scalars.pushConstant(next_scalar_constant++, 1);
+            }
+            else if (op == push_vector) {
+                vectors.pushConstant(instruction.offset, instruction.size);
+            }
+            else if (op == push_date) {
+                dates.pushConstant(next_date_constant++, 1);
+            }
+            else if (op == push_date_list) {
+                date_lists.pushConstant(instruction.offset, instruction.size);
+            }
+            else if (op == load_scalar) {
+                const Slot &out = scalars.pushTemp(1);
+                code_.push_back(makeInstruction(op, 1, out.temp, static_cast<std::uint32_t>(instruction.offset)));
+            }
+            else if (op == load_vector) {
+                const Slot &out = vectors.pushTemp(instruction.size);
+                code_.push_back(makeInstruction(op, instruction.size, out.temp,
+                                                static_cast<std::uint32_t>(instruction.offset)));
+            }
+            else if ((op == append) || isReduceArguments(op)) {
+                assert(scalars.size() >= instruction.size);
+                materializeScalars(instruction.size);
+                const std::uint32_t first = scalars.fromBack(instruction.size - 1).temp;
+                for (std::size_t i{0}; i < instruction.size; ++i) {
+                    scalars.pop();
+                }
+                const Slot &out = op == append ? vectors.pushTemp(instruction.size) : scalars.pushTemp(1);
+                code_.push_back(makeInstruction(op, instruction.size, out.temp, first));
+            }
+            else if ((op == neg_sc) || (op == not_sc) || (isFunction(op) && !isVectorFunction(op))) {
+                const Slot arg = scalars.pop();
+                const Slot &out = scalars.pushTemp(1);
+                code_.push_back(makeInstruction(op, 1, out.temp, arg.at));
+            }
+            else if ((op == neg_vec) || (op == not_vec) || isFunction(op)) {
+                const Slot arg = vectors.pop();
+                const Slot &out = vectors.pushTemp(arg.size);
+                code_.push_back(makeInstruction(op, arg.size, out.temp, arg.at));
+            }
+            else if (isBinary(op)) {
+                const std::size_t variant = binaryVariant(op);
+                const Slot right = variant % 2 == 1 ? vectors.pop() : scalars.pop();
+                const Slot left = variant >= 2 ? vectors.pop() : scalars.pop();
+                const std::size_t size = std::max<std::size_t>(left.size, right.size);
+                const Slot &out = variant == 0 ? scalars.pushTemp(1) : vectors.pushTemp(size);
+                code_.push_back(makeInstruction(op, variant == 0 ? 1 : size, out.temp, left.at, right.at));
+            }
+            else if (isReduceVector(op)) {
+                const Slot arg = vectors.pop();
+                const Slot &out = scalars.pushTemp(1);
+                code_.push_back(makeInstruction(op, arg.size, out.temp, arg.at));
+            }
+            else {
+                assert(false);
+            }
+        }
+
+        // the result is moved to the first temporary slot of its type if it is a constant
+        auto makeResult = [this](SlotStack &stack, const CType &type, const OpCode &move) {
+            if ((stack.size() == 0) || (result_t_ != CType::undefined)) {
+                return;
+            }
+            Slot &slot = stack.fromBack(0);
+            if (slot.at != slot.temp) {
+                RegisterInstruction load = makeInstruction(move, slot.size, slot.temp, slot.at);
+                if (move == push_scalar) {
+                    load.scalar = scalar_constants_[slot.at];
+                }
+                else if (move == push_date) {
+                    load.date = date_constants_[slot.at];
+                }
+                code_.push_back(load);
+                slot.at = slot.temp;
+            }
+            result_t_ = type;
+            result_slot_ = slot.temp;
+            result_size_ = slot.size;
+        };
+        makeResult(scalars, CType::scalar, push_scalar);
+        makeResult(vectors, CType::vector, push_vector);
+        makeResult(dates, CType::date, push_date);
+        makeResult(date_lists, CType::date_list, push_date_list);
+
+        scalar_temps_ = scalars.temps();
+        vector_temps_ = vectors.temps();
+        date_temps_ = dates.temps();
+        date_list_temps_ = date_lists.temps();
+    }
+
+    Registers RegisterCode::makeRegisters() const {
+        Registers registers(scalar_constants_.size() + scalar_temps_,
+                            vector_constants_.size() + vector_temps_,
+                            date_constants_.size() + date_temps_,
+                            date_list_constants_.size() + date_list_temps_);
+        std::ranges::copy(scalar_constants_, registers.scalars().begin());
+        std::ranges::copy(vector_constants_, registers.vectors().begin());
+        std::ranges::copy(date_constants_, registers.dates().begin());
+        std::ranges::copy(date_list_constants_, registers.datesLists().begin());
+        return registers;
+    }
+
+    VECTOR RegisterCode::vectorResult(const Registers &registers) const {
+        const auto begin = registers.vectors().begin() + static_cast<std::ptrdiff_t>(result_slot_);
+        return {begin, begin + static_cast<std::ptrdiff_t>(result_size_)};
+    }
+
+    DATE_LIST RegisterCode::dateListResult(const Registers &registers) const {
+        const auto begin = registers.datesLists().begin() + static_cast<std::ptrdiff_t>(result_slot_);
+        return {begin, begin + static_cast<std::ptrdiff_t>(result_size_)};
+    }
+
+    void RegisterCode::operator()(Registers &registers) const {
+        using namespace operatorsCalc;
+        using namespace functionsReal;
+        using namespace kernels;
+        SCALAR *s = registers.scalars().data();
+        SCALAR *v = registers.vectors().data();
+        DATE *d = registers.dates().data();
+        DATE *d_l = registers.datesLists().data();
+        for (const RegisterInstruction &ins: code_) {
+            switch (ins.code) {
+                using
+                enum OpCode;
+                case push_scalar:
+                    s[ins.out] = ins.scalar;
+                    break;
+                case push_vector:
+                    std::copy_n(v + ins.left, ins.size, v + ins.out);
+                    break;
+                case push_date:
+                    d[ins.out] = ins.date;
+                    break;
+                case push_date_list:
+                    std::copy_n(d_l + ins.left, ins.size, d_l + ins.out);
+                    break;
+                case load_scalar:
+                    s[ins.out] = parameters_->scalar(ins.left);
+                    break;
+                case load_vector:
+                    std::copy_n(parameters_->vector(ins.left).begin(), ins.size, v + ins.out);
+                    break;
+                case append:
+                    std::copy_n(s + ins.left, ins.size, v + ins.out);
+                    break;
+                case neg_sc:
+                    s[ins.out] = -s[ins.left];
+                    break;
+                case neg_vec:
+                    scalar::calculateVector(v + ins.left, v + ins.out, ins.size, NEG_F);
+                    break;
+                case not_sc:
+                    s[ins.out] = NOT_F(s[ins.left]);
+                    break;
+                case not_vec:
+                    scalar::calculateVector(v + ins.left, v + ins.out, ins.size, NOT_F);
+                    break;
+                case plus_sc_sc:
+                    s[ins.out] = PLUS_F(s[ins.left], s[ins.right]);
+                    break;
+                case plus_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, PLUS_F);
+                    break;
+                case plus_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, PLUS_F);
+                    break;
+                case plus_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, PLUS_F);
+                    break;
+                case minus_sc_sc:
+                    s[ins.out] = MINUS_F(s[ins.left], s[ins.right]);
+                    break;
+                case minus_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, MINUS_F);
+                    break;
+                case minus_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, MINUS_F);
+                    break;
+                case minus_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, MINUS_F);
+                    break;
+                case mul_sc_sc:
+                    s[ins.out] = MUL_F(s[ins.left], s[ins.right]);
+                    break;
+                case mul_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, MUL_F);
+                    break;
+                case mul_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, MUL_F);
+                    break;
+                case mul_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, MUL_F);
+                    break;
+                case div_sc_sc:
+                    s[ins.out] = DIV_F(s[ins.left], s[ins.right]);
+                    break;
+                case div_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, DIV_F);
+                    break;
+                case div_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, DIV_F);
+                    break;
+                case div_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, DIV_F);
+                    break;
+                case pow_sc_sc:
+                    s[ins.out] = POW_F(s[ins.left], s[ins.right]);
+                    break;
+                case pow_sc_vec:
+                    vectorMath::pow(s[ins.left], v + ins.right, v + ins.out, ins.size);
+                    break;
+                case pow_vec_sc:
+                    vectorMath::pow(v + ins.left, s[ins.right], v + ins.out, ins.size);
+                    break;
+                case pow_vec_vec:
+                    vectorMath::pow(v + ins.left, v + ins.right, v + ins.out, ins.size);
+                    break;
+                case lt_sc_sc:
+                    s[ins.out] = LT_F(s[ins.left], s[ins.right]);
+                    break;
+                case lt_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, LT_F);
+                    break;
+                case lt_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, LT_F);
+                    break;
+                case lt_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, LT_F);
+                    break;
+                case gt_sc_sc:
+                    s[ins.out] = GT_F(s[ins.left], s[ins.right]);
+                    break;
+                case gt_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, GT_F);
+                    break;
+                case gt_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, GT_F);
+                    break;
+                case gt_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, GT_F);
+                    break;
+                case le_sc_sc:
+                    s[ins.out] = LE_F(s[ins.left], s[ins.right]);
+                    break;
+                case le_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, LE_F);
+                    break;
+                case le_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, LE_F);
+                    break;
+                case le_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, LE_F);
+                    break;
+                case ge_sc_sc:
+                    s[ins.out] = GE_F(s[ins.left], s[ins.right]);
+                    break;
+                case ge_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, GE_F);
+                    break;
+                case ge_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, GE_F);
+                    break;
+                case ge_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, GE_F);
+                    break;
+                case and_sc_sc:
+                    s[ins.out] = AND_F(s[ins.left], s[ins.right]);
+                    break;
+                case and_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, AND_F);
+                    break;
+                case and_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, AND_F);
+                    break;
+                case and_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, AND_F);
+                    break;
+                case or_sc_sc:
+                    s[ins.out] = OR_F(s[ins.left], s[ins.right]);
+                    break;
+                case or_sc_vec:
+                    binary::scVec(s[ins.left], v + ins.right, v + ins.out, ins.size, OR_F);
+                    break;
+                case or_vec_sc:
+                    binary::vecSc(v + ins.left, s[ins.right], v + ins.out, ins.size, OR_F);
+                    break;
+                case or_vec_vec:
+                    binary::vecVec(v + ins.left, v + ins.right, v + ins.out, ins.size, OR_F);
+                    break;
+                case exp_sc:
+                    s[ins.out] = EXP_F(s[ins.left]);
+                    break;
+                case exp_vec:
+                    vectorMath::exp(v + ins.left, v + ins.out, ins.size);
+                    break;
+                case log_sc:
+                    s[ins.out] = LOG_F(s[ins.left]);
+                    break;
+                case log_vec:
+                    vectorMath::log(v + ins.left, v + ins.out, ins.size);
+                    break;
+                case abs_sc:
+                    s[ins.out] = ABS_F(s[ins.left]);
+                    break;
+                case abs_vec:
+                    scalar::calculateVector(v + ins.left, v + ins.out, ins.size, ABS_F);
+                    break;
+                case sqrt_sc:
+                    s[ins.out] = SQRT_F(s[ins.left]);
+                    break;
+                case sqrt_vec:
+                    vectorMath::sqrt(v + ins.left, v + ins.out, ins.size);
+                    break;
+                case square_sc:
+                    s[ins.out] = SQUARE_F(s[ins.left]);
+                    break;
+                case square_vec:
+                    scalar::calculateVector(v + ins.left, v + ins.out, ins.size, SQUARE_F);
+                    break;
+                case sum_vec:
+                    s[ins.out] = vectorMath::sum(v + ins.left, ins.size);
+                    break;
+                case prod_vec:
+                    s[ins.out] = vectorMath::prod(v + ins.left, ins.size);
+                    break;
+                case max_vec:
+                    s[ins.out] = v[ins.left + vectorMath::argmax(v + ins.left, ins.size)];
+                    break;
+                case min_vec:
+                    s[ins.out] = v[ins.left + vectorMath::argmin(v + ins.left, ins.size)];
+                    break;
+                case argmax_vec:
+                    s[ins.out] = static_cast<double>(vectorMath::argmax(v + ins.left, ins.size));
+                    break;
+                case argmin_vec:
+                    s[ins.out] = static_cast<double>(vectorMath::argmin(v + ins.left, ins.size));
+                    break;
+                case len_vec:
+                    s[ins.out] = static_cast<double>(ins.size);
+                    break;
+                case sum_args:
+                    s[ins.out] = reduceArguments::accumulateArguments(s + ins.left, ins.size, PLUS_F, 0.0);
+                    break;
+                case prod_args:
+                    s[ins.out] = reduceArguments::accumulateArguments(s + ins.left, ins.size, MUL_F, 1.0);
+                    break;
+                case max_args:
+                    s[ins.out] = reduceArguments::pickArguments(s + ins.left, ins.size, GREATER_F);
+                    break;
+                case min_args:
+                    s[ins.out] = reduceArguments::pickArguments(s + ins.left, ins.size, LESS_F);
+                    break;
+                case argmax_args:
+                    s[ins.out] = static_cast<double>(
+                        std::distance(s + ins.left, std::max_element(s + ins.left, s + ins.left + ins.size)));
+                    break;
+                case argmin_args:
+                    s[ins.out] = static_cast<double>(
+                        std::distance(s + ins.left, std::min_element(s + ins.left, s + ins.left + ins.size)));
+                    break;
+                default:
+                    assert(false);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "calc_types.h"
+#include "op_codes.h"
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    // Three address instruction over fixed slots. For vectors and date lists the slots are offsets into the flat
+    // vector and date list registers, size is their number of elements (or the number of arguments of a reduction).
+    // Parameter loads read the parameter slot left.
+    struct RegisterInstruction {
+
+        OpCode code{OpCode::push_scalar};
+
+        std::uint32_t size{0};
+
+        std::uint32_t out{0};
+
+        std::uint32_t left{0};
+
+        std::uint32_t right{0};
+
+        union {
+            SCALAR scalar{0.0};
+            DATE date;
+        };
+
+    };
+
+    // Register file of a RegisterCode. Constants (numbers and static variables) occupy the leading slots, they are
+    // loaded once when the registers are created and never overwritten. The temporaries follow.
+    class Registers {
+
+    public:
+
+        Registers(const std::size_t &s_size, const std::size_t &v_size, const std::size_t &d_size,
+                  const std::size_t &d_l_size) : scalars_(s_size), vectors_(v_size), dates_(d_size),
+                                                 date_lists_(d_l_size) {}
+
+        inline std::vector<SCALAR> &scalars() { return scalars_; };
+
+        inline const std::vector<SCALAR> &scalars() const { return scalars_; };
+
+        inline std::vector<SCALAR> &vectors() { return vectors_; };
+
+        inline const std::vector<SCALAR> &vectors() const { return vectors_; };
+
+        inline std::vector<DATE> &dates() { return dates_; };
+
+        inline const std::vector<DATE> &dates() const { return dates_; };
+
+        inline std::vector<DATE> &datesLists() { return date_lists_; };
+
+        inline const std::vector<DATE> &datesLists() const { return date_lists_; };
+
+    private:
+
+        std::vector<SCALAR> scalars_;
+
+        std::vector<SCALAR> vectors_;
+
+        std::vector<DATE> dates_;
+
+        std::vector<DATE> date_lists_;
+
+    };
+
+    // Register based alternative to ByteCode. Stack positions are resolved at compile time (the stack depth at every
+    // instruction is known), such that kernels read and write known offsets instead of pushing and popping.
+    class RegisterCode {
+
+    public:
+
+        RegisterCode() = default;
+
+        // code must be lowerable (see isLowerable), otherwise the RegisterCode stays empty with an undefined
+        // resultType and must not be evaluated
+        explicit RegisterCode(const ByteCode &code);
+
+        // whether every instruction has a register form, which holds for the ByteCode of compileExpression. Locals,
+        // assignments, jumps and the instructions fused by fuseInstructions and fuseVectorLoops have none.
+        static bool isLowerable(const ByteCode &code);
+
+        void operator()(Registers &registers) const;
+
+        // Sized registers with the constants loaded, one per thread evaluating this code
+        Registers makeRegisters() const;
+
+        CType resultType() const { return result_t_; }
+
+        // number of elements of a vector or date list result
+        std::size_t resultSize() const { return result_size_; }
+
+        SCALAR scalarResult(const Registers &registers) const { return registers.scalars()[result_slot_]; }
+
+        VECTOR vectorResult(const Registers &registers) const;
+
+        DATE dateResult(const Registers &registers) const { return registers.dates()[result_slot_]; }
+
+        DATE_LIST dateListResult(const Registers &registers) const;
+
+        std::size_t size() const { return code_.size(); }
+
+        const std::vector<RegisterInstruction> &instructions() const { return code_; }
+
+    private:
+
+        std::vector<RegisterInstruction> code_;
+
+        const Parameters *parameters_{nullptr};
+
+        std::size_t scalar_temps_{0};
+
+        std::size_t vector_temps_{0};
+
+        std::size_t date_temps_{0};
+
+        std::size_t date_list_temps_{0};
+
+        std::vector<SCALAR> scalar_constants_;
+
+        std::vector<SCALAR> vector_constants_;
+
+        std::vector<DATE> date_constants_;
+
+        std::vector<DATE> date_list_constants_;
+
+        CType result_t_{CType::undefined};
+
+        std::size_t result_slot_{0};
+
+        std::size_t result_size_{0};
+
+    };
+
+}
\ No newline at end of file
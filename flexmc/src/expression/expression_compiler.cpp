@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <ranges>
 #include <stdexcept>
 
 #include "operand.h"
 #include "operation_compiler.h"
+#include "constant_folding.h"
+#include "common_subexpressions.h"
+#include "peephole.h"
+#include "loop_fusion.h"
 #include "expression_compiler.h"
 
 namespace flexMC {
@@ -23,7 +29,9 @@ namespace flexMC {
                 report.setError("Could not compile expression up to its return type", 0, 0);
                 return std::make_pair(report, CompileReport(undefined, 0, 0));
             }
-            CompileReport c_rep{operands.typesBack(), operands.maxSize(scalar), operands.maxSize(vector)};
+            const CType ret_type = operands.typesBack();
+            const std::size_t ret_size = (ret_type == vector) || (ret_type == date_list) ? operands.sizesBack() : 1;
+            CompileReport c_rep{ret_type, operands.maxSize(scalar), operands.maxSize(vector), ret_size};
             return std::make_pair(report, c_rep);
         }
     }
@@ -34,7 +42,8 @@ namespace flexMC {
                              Operands &operands,
                              Expression &expression,
                              StaticVStorage &storage,
-                             MaybeError &report) {
+                             MaybeError &report,
+                             const LocalVariables *) {
             const auto [s_v_static, optional_v_static] = StaticVCompiler::tryCompile(tok.value, operands, storage);
             if (s_v_static == StaticVCompiler::Status::found) {
                 expression.push_back(optional_v_static.value());
@@ -44,53 +53,174 @@ namespace flexMC {
             }
         }
 
-    }
-
-    std::pair<MaybeError, CompileReport> compileExpression(const std::vector<Token> &post_fix,
-                                                           Expression &expression, StaticVStorage &storage) {
-        Operands operands;
-        MaybeError report;
-        for (const auto &tok: post_fix) {
-            if (report.isError()) {
-                break;
-            }
-            const Token::Type t = tok.type;
-            if (t == Token::Type::num) {
-                const double v = compileNumber(tok, operands, report);
-                if (!report.isError()) {
-                    expression.push_back(compileNumberOperation(v));
+        void compileVariable(const Token &tok,
+                             Operands &operands,
+                             ByteCode &code,
+                             StaticVStorage &storage,
+                             MaybeError &report,
+                             const LocalVariables *locals) {
+            const auto local = locals == nullptr ? LocalVariables::const_iterator() : locals->find(tok.value);
+            if ((locals != nullptr) && (local != locals->end())) {
+                const auto &[type, slot, size] = local->second;
+                if (type == CType::scalar) {
+                    operands.pushType(type);
+                    code.fetchScalar(slot);
                 }
-            }
-            else if (t == Token::Type::id) {
-                compileVariable(tok, operands, expression, storage, report);
-
-            }
-            else if (t == Token::Type::fun) {
-                operands.pushFunc(tok);
-            }
-            else if (t == Token::Type::call_) {
-                Operation function = functionCompiler::compile(tok.context.num_args, operands, report);
-                if (!report.isError()) {
-                    expression.push_back(function);
+                else {
+                    operands.pushArray(type, size);
+                    code.fetchVector(slot, size);
                 }
+                return;
+            }
+            if (StaticVCompiler::tryCompile(tok.value, operands, storage, code) != StaticVCompiler::Status::found) {
+                report.setError("Variable is undefined", tok);
             }
-            else if (t == Token::Type::append_) {
-                const CType elem_t = compileVector(tok.context.num_args, operands, report);
+        }
+
+        void compileNumber(const double &value, Expression &expression) {
+            expression.push_back(compileNumberOperation(value));
+        }
+
+        void compileNumber(const double &value, ByteCode &code) { code.pushScalar(value); }
+
+        void compileCall(const CallSignature &signature, Expression &expression) {
+            expression.push_back(compileOperation(signature));
+        }
+
+        void compileCall(const CallSignature &signature, ByteCode &code) {
+            code.push_back(compileInstruction(signature));
+        }
+
+        void compileAppend(const std::size_t &size, Expression &expression) {
+            expression.push_back(compileVectorOperation(size));
+        }
+
+        void compileAppend(const std::size_t &size, ByteCode &code) {
+            code.push_back({OpCode::append, static_cast<std::uint32_t>(size)});
+        }
+
+        template<class Target>
+        std::pair<MaybeError, CompileReport> compilePostfix(const std::vector<Token> &post_fix,
+                                                            Target &target,
+                                                            StaticVStorage &storage,
+                                                            const LocalVariables *locals = nullptr) {
+            Operands operands;
+            MaybeError report;
+            for (const auto &tok: post_fix) {
                 if (report.isError()) {
-                    report.setPosition(tok.start, 1);
+                    break;
                 }
-                else if (elem_t == CType::scalar) {
-                    expression.push_back(compileVectorOperation(tok.context.num_args));
+                const Token::Type t = tok.type;
+                if (t == Token::Type::num) {
+                    const double v = flexMC::compileNumber(tok, operands, report);
+                    if (!report.isError()) {
+                        compileNumber(v, target);
+                    }
                 }
-            }
-            else if ((t == Token::Type::op) && !(tok.value == flexMC::PLUS && tok.context.is_prefix)) {
-                Operation op = operatorCompiler::compile(tok, operands, report);
-                if (!report.isError()) {
-                    expression.push_back(op);
+                else if (t == Token::Type::id) {
+                    compileVariable(tok, operands, target, storage, report, locals);
+
+                }
+                else if (t == Token::Type::fun) {
+                    operands.pushFunc(tok);
+                }
+                else if (t == Token::Type::call_) {
+                    const CallSignature function = functionCompiler::resolve(tok.context.num_args, operands, report);
+                    if (!report.isError()) {
+                        compileCall(function, target);
+                    }
                 }
+                else if (t == Token::Type::append_) {
+                    const CType elem_t = compileVector(tok.context.num_args, operands, report);
+                    if (report.isError()) {
+                        report.setPosition(tok.start, 1);
+                    }
+                    else if (elem_t == CType::scalar) {
+                        compileAppend(tok.context.num_args, target);
+                    }
+                }
+                else if ((t == Token::Type::op) && !(tok.value == flexMC::PLUS && tok.context.is_prefix)) {
+                    const CallSignature op = operatorCompiler::resolve(tok, operands, report);
+                    if (!report.isError()) {
+                        compileCall(op, target);
+                    }
+                }
+            }
+            return makeReport(report, operands);
+        }
+
+    }
+
+    std::pair<MaybeError, CompileReport> compileExpression(const std::vector<Token> &post_fix,
+                                                           Expression &expression, StaticVStorage &storage) {
+        return compilePostfix(post_fix, expression, storage);
+    }
+
+    std::pair<MaybeError, CompileReport> compileExpression(const std::vector<Token> &post_fix,
+                                                           ByteCode &code, StaticVStorage &storage) {
+        ByteCode unfolded;
+        auto [report, compile_report] = compilePostfix(post_fix, unfolded, storage);
+        if (!report.isError()) {
+            code = foldConstants(unfolded);
+        }
+        return {report, compile_report};
+    }
+
+    std::pair<MaybeError, CompileReport> compileExpression(const std::vector<Token> &post_fix,
+                                                           ByteCode &code, StaticVStorage &storage,
+                                                           const LocalVariables &locals) {
+        ByteCode unfolded;
+        std::size_t scalars{0};
+        std::size_t vectors{0};
+        for (const auto &[type, slot, size]: locals | std::views::values) {
+            if (type == CType::scalar) {
+                scalars = std::max(scalars, slot + 1);
             }
+            else {
+                vectors = std::max(vectors, slot + size);
+            }
+        }
+        unfolded.declareLocals(scalars, vectors);
+        auto [report, compile_report] = compilePostfix(post_fix, unfolded, storage, &locals);
+        if (!report.isError()) {
+            code = foldConstants(unfolded);
+        }
+        return {report, compile_report};
+    }
+
+    std::pair<MaybeError, std::vector<CompileReport>>
+    compileStatements(const std::vector<std::vector<Token>> &post_fixes, ByteCode &code, StaticVStorage &storage) {
+        std::vector<ByteCode> statements(post_fixes.size());
+        std::vector<CompileReport> compile_reports;
+        for (std::size_t i{0}; i < post_fixes.size(); ++i) {
+            auto [report, compile_report] = compileExpression(post_fixes[i], statements[i], storage);
+            if (report.isError()) {
+                return {report, compile_reports};
+            }
+            compile_reports.push_back(compile_report);
+        }
+        code = fuseInstructions(fuseVectorLoops(eliminateCommonSubexpressions(statements)));
+        return {MaybeError(), compile_reports};
+    }
+
+    std::pair<MaybeError, CompileReport> compileExpression(const std::vector<Token> &post_fix,
+                                                           RegisterCode &code, StaticVStorage &storage) {
+        ByteCode byte_code;
+        auto [report, compile_report] = compileExpression(post_fix, byte_code, storage);
+        if (!report.isError()) {
+            code = RegisterCode(byte_code);
+        }
+        return {report, compile_report};
+    }
+
+    std::pair<MaybeError, CompileReport> compileExpression(const std::vector<Token> &post_fix,
+                                                           JitCode &code, StaticVStorage &storage) {
+        ByteCode byte_code;
+        auto [report, compile_report] = compileExpression(post_fix, byte_code, storage);
+        if (!report.isError()) {
+            code = JitCode(fuseInstructions(byte_code));
         }
-        return makeReport(report, operands);
+        return {report, compile_report};
     }
 
-}
\ No newline at end of file
+}
@@ -8,6 +8,9 @@
 #include "language_error.h"
 #include "static_variables.h"
 #include "expression_stacks.h"
+#include "byte_code.h"
+#include "register_code.h"
+#include "jit_code.h"
 
 
 namespace flexMC {
@@ -29,7 +32,9 @@ namespace flexMC {
     struct CompileReport {
         CompileReport(const CType &ret_t,
                       const std::size_t &max_s,
-                      const std::size_t &max_v) : ret_type(ret_t), max_scalar(max_s), max_vector(max_v) {}
+                      const std::size_t &max_v,
+                      const std::size_t &ret_s = 1) :
+            ret_type(ret_t), max_scalar(max_s), max_vector(max_v), ret_size(ret_s) {}
 
         const CType ret_type;
 
@@ -37,10 +42,48 @@ namespace flexMC {
 
         const std::size_t max_vector;
 
+        // number of elements of a vector or date list result
+        const std::size_t ret_size;
+
+    };
+
+    // A variable assigned by a script, it lives in the local slot of the script's ByteCode, see compileScript
+    struct LocalVariable {
+        CType type;
+        std::size_t slot;
+        // number of elements, 1 for scalars
+        std::size_t size;
     };
 
+    using LocalVariables = StringMap<LocalVariable>;
+
     // coupling this function with StaticVStorage??
     std::pair<MaybeError, CompileReport>
     compileExpression(const std::vector<Token> &post_fix, Expression &expression, StaticVStorage &storage);
 
+    // Constant subtrees are folded, see foldConstants
+    std::pair<MaybeError, CompileReport>
+    compileExpression(const std::vector<Token> &post_fix, ByteCode &code, StaticVStorage &storage);
+
+    // Identifiers are looked up in locals before the storage, the code is meant to be appended to the ByteCode owning
+    // the local slots
+    std::pair<MaybeError, CompileReport>
+    compileExpression(const std::vector<Token> &post_fix, ByteCode &code, StaticVStorage &storage,
+                      const LocalVariables &locals);
+
+    // Compiles the expressions of the statements of a script into one ByteCode, which leaves their results on the stacks
+    // in order. Subexpressions shared between the statements are computed once per evaluation, chains of element-wise
+    // vector operations run in one loop and frequent instruction sequences are fused, see fuseVectorLoops and
+    // fuseInstructions.
+    std::pair<MaybeError, std::vector<CompileReport>>
+    compileStatements(const std::vector<std::vector<Token>> &post_fixes, ByteCode &code, StaticVStorage &storage);
+
+    // Compiles to ByteCode first and lowers the result to fixed slots
+    std::pair<MaybeError, CompileReport>
+    compileExpression(const std::vector<Token> &post_fix, RegisterCode &code, StaticVStorage &storage);
+
+    // Compiles to fused ByteCode first and translates scalar expressions to machine code, see JitCode
+    std::pair<MaybeError, CompileReport>
+    compileExpression(const std::vector<Token> &post_fix, JitCode &code, StaticVStorage &storage);
+
 }
\ No newline at end of file
@@ -19,6 +19,30 @@ namespace flexMC {
             error
         };
 
+        // the infix and the position of the next token in it
+        struct Cursor {
+            std::span<const Token> infix;
+            std::size_t pos{0};
+
+            [[nodiscard]] const Token &next() const { return infix[pos]; }
+
+            [[nodiscard]] const Token &at(const PostfixNode &node) const { return infix[node.token]; }
+        };
+
+        PostfixNode makeNode(const Token &tok, const std::size_t &at) {
+            return {static_cast<std::uint32_t>(at),
+                    static_cast<std::uint32_t>(tok.context.num_args),
+                    tok.type,
+                    tok.context.precedence,
+                    tok.context.is_prefix,
+                    tok.context.is_infix};
+        }
+
+        // call_, append_ and index_ bind like a function call
+        PostfixNode makeInsertedNode(const Token::Type &t, const std::size_t &num_args, const std::size_t &at) {
+            return {static_cast<std::uint32_t>(at), static_cast<std::uint32_t>(num_args), t, 10, false, false};
+        }
+
         bool isSpace(const Token::Type &t) { return ((t == Token::Type::wsp) || (t == Token::Type::tab)); }
 
         bool isOperand(const Token::Type &t) {
@@ -31,13 +55,14 @@ namespace flexMC {
             return (tok.type == op && tok.context.maybe_prefix) || (tok.type == lparen);
         }
 
-        State terminate(const Token &tok,
-                        std::vector<Token> &postfix,
-                        std::vector<Token> &operators,
+        State terminate(const Cursor &cursor,
+                        std::vector<PostfixNode> &postfix,
+                        std::vector<PostfixNode> &operators,
                         MaybeError &report) {
             while (!operators.empty()) {
-                Token op = operators.back();
+                const PostfixNode &op = operators.back();
                 if ((op.type == Token::Type::lparen) || (op.type == Token::Type::lbracket)) {
+                    const Token &tok = cursor.next();
                     auto msg = fmt::format(R"(Unmatched parenthesis "(" or bracket "[", got "{}" ({}))",
                                            tok.value,
                                            tok.type2String());
@@ -50,37 +75,38 @@ namespace flexMC {
             return State::end;
         }
 
-        State noArgsOrError(const Token &tok, const std::vector<Token> &operators, MaybeError &report) {
+        State noArgsOrError(const Cursor &cursor, const std::vector<PostfixNode> &operators, MaybeError &report) {
             std::stringstream error_msg("");
             if (operators.empty()) {
                 error_msg << R"_(Expected empty function argument list "()" )_";
             }
             else if (operators.back().type != Token::Type::lparen) {
+                const Token &op = cursor.at(operators.back());
                 error_msg << fmt::format(R"_(Expected left parenthesis "()", got "{})" ({}) )_",
-                                         operators.back().value,
-                                         operators.back().type2String());
+                                         op.value,
+                                         op.type2String());
             }
-            else if (!operators.back().context.is_infix) {
+            else if (!operators.back().is_infix) {
                 error_msg << R"_(Empty parentheses "()" not allowed other than for an empty function argument list)_";
             }
-            else if (operators.back().context.num_args > 0) {
+            else if (operators.back().num_args > 0) {
                 error_msg << R"_(Unexpected comma encountered within empty parentheses "()")_";
             }
             if (!error_msg.str().empty()) {
-                report.setError(error_msg.str(), tok);
+                report.setError(error_msg.str(), cursor.next());
                 return State::error;
             }
             return State::have_operand;
         }
 
-        State incrementArgsCount(const Token &tok,
-                                 std::vector<Token> &postfix,
-                                 std::vector<Token> &operators,
+        State incrementArgsCount(const Cursor &cursor,
+                                 std::vector<PostfixNode> &postfix,
+                                 std::vector<PostfixNode> &operators,
                                  MaybeError &report) {
             std::string msg = R"_(Unmatched parenthesis or bracket: ")" or "]")_";
             msg += R"( or badly placed comma ",")";
             if (operators.empty()) {
-                report.setError(msg, tok);
+                report.setError(msg, cursor.next());
                 return State::error;
             }
             Token::Type operator_t = operators.back().type;
@@ -88,111 +114,112 @@ namespace flexMC {
                 postfix.push_back(operators.back());
                 operators.pop_back();
                 if (operators.empty()) {
-                    report.setError(msg, tok);
+                    report.setError(msg, cursor.next());
                     return State::error;
                 }
                 operator_t = operators.back().type;
             }
-            operators.back().context.num_args += 1;
+            operators.back().num_args += 1;
             return State::want_operand;
         }
 
-        State consumeParentheses(const Token &tok,
-                                 std::vector<Token> &postfix,
-                                 std::vector<Token> &operators,
+        State consumeParentheses(const Cursor &cursor,
+                                 std::vector<PostfixNode> &postfix,
+                                 std::vector<PostfixNode> &operators,
                                  MaybeError &report) {
             auto msg = R"_(Unmatched parenthesis ")")_";
             if (operators.empty()) {
-                report.setError(msg, tok);
+                report.setError(msg, cursor.next());
                 return State::error;
             }
             Token::Type operator_t = operators.back().type;
             while (operator_t != Token::Type::lparen) {
                 if (operator_t == Token::Type::lbracket) {
                     report.setError(R"_(While parsing parenthesis ")": Unexpected bracket encountered)_",
-                                    operators.back());
+                                    cursor.at(operators.back()));
                     return State::error;
                 }
                 postfix.push_back(operators.back());
                 operators.pop_back();
                 if (operators.empty()) {
-                    report.setError(msg, tok);
+                    report.setError(msg, cursor.next());
                     return State::error;
                 }
                 operator_t = operators.back().type;
             }
-            Token l_paren = operators.back();
-            std::size_t num_args = l_paren.context.num_args + 1;
-            if (l_paren.context.is_infix) {
-                postfix.push_back(Tokens::makeCall(num_args, tok.start));
+            const PostfixNode &l_paren = operators.back();
+            std::size_t num_args = l_paren.num_args + 1;
+            if (l_paren.is_infix) {
+                postfix.push_back(makeInsertedNode(Token::Type::call_, num_args, cursor.pos));
             }
             else if (num_args >= 2) {
-                postfix.push_back(Tokens::makeAppend(num_args, tok.start));
+                postfix.push_back(makeInsertedNode(Token::Type::append_, num_args, cursor.pos));
             }
             operators.pop_back();
             return State::have_operand;
         }
 
-        State consumeBrackets(const Token &tok,
-                              std::vector<Token> &postfix,
-                              std::vector<Token> &operators,
+        State consumeBrackets(const Cursor &cursor,
+                              std::vector<PostfixNode> &postfix,
+                              std::vector<PostfixNode> &operators,
                               MaybeError &report) {
             auto msg = R"(Unmatched bracket "]")";
             if (operators.empty()) {
-                report.setError(msg, tok);
+                report.setError(msg, cursor.next());
                 return State::error;
             }
             Token::Type operator_t = operators.back().type;
             while (operator_t != Token::Type::lbracket) {
                 if (operator_t == Token::Type::lparen) {
                     report.setError(R"(While parsing bracket "]": Unexpected parenthesis encountered)",
-                                    operators.back());
+                                    cursor.at(operators.back()));
                     return State::error;
                 }
                 postfix.push_back(operators.back());
                 operators.pop_back();
                 if (operators.empty()) {
-                    report.setError(msg, tok);
+                    report.setError(msg, cursor.next());
                     return State::error;
                 }
                 operator_t = operators.back().type;
             }
-            if (operators.back().context.num_args > 0) {
+            if (operators.back().num_args > 0) {
                 report.setError("Multiple arguments not allowed for <Vector> subscripting",
-                                operators.back());
+                                cursor.at(operators.back()));
                 return State::error;
 
             }
-            postfix.push_back(Tokens::makeIndex(tok.start));
+            postfix.push_back(makeInsertedNode(Token::Type::index_, 1, cursor.pos));
             operators.pop_back();
             return State::have_operand;
         }
 
-        State pushOperators(Token tok,
-                            std::vector<Token> &postfix,
-                            std::vector<Token> &operators) {
+        State pushOperators(const Cursor &cursor,
+                            std::vector<PostfixNode> &postfix,
+                            std::vector<PostfixNode> &operators) {
+            const ParsingContext &input_c = cursor.next().context;
             while (!operators.empty()) {
-                ParsingContext op_c = operators.back().context;
-                ParsingContext input_c = tok.context;
-                bool higher = op_c.precedence > input_c.precedence;
-                bool barely_higher = (op_c.precedence == input_c.precedence) && input_c.left_associative;
+                const PostfixNode &op = operators.back();
+                bool higher = op.precedence > input_c.precedence;
+                bool barely_higher = (op.precedence == input_c.precedence) && input_c.left_associative;
                 if (higher || barely_higher) {
-                    postfix.push_back(operators.back());
+                    postfix.push_back(op);
                     operators.pop_back();
                 }
                 else {
                     break;
                 }
             }
-            assert(!tok.context.is_prefix);
-            tok.context.is_infix = true;
-            operators.push_back(tok);
+            assert(!input_c.is_prefix);
+            PostfixNode node = makeNode(cursor.next(), cursor.pos);
+            node.is_infix = true;
+            operators.push_back(node);
             return State::want_operand;
         }
 
-        State checkParenthesisAfterFunction(const Token &function, const std::deque<Token> &infix, MaybeError &report) {
+        State checkParenthesisAfterFunction(const Cursor &cursor, MaybeError &report) {
             auto found = false;
-            for (const auto &token: infix) {
+            for (const auto &token: cursor.infix.subspan(cursor.pos + 1)) {
                 if (!isSpace(token.type)) {
                     if (token.type == Token::Type::lparen) {
                         found = true;
@@ -201,22 +228,22 @@ namespace flexMC {
                 }
             }
             if (!found) {
-                report.setError(R"(Expected opening parenthesis "(" after function)", function);
+                report.setError(R"(Expected opening parenthesis "(" after function)", cursor.next());
                 return State::error;
             }
             return State::have_operand;
         }
 
-        State wantOperand(std::deque<Token> &infix,
-                          std::vector<Token> &postfix,
-                          std::vector<Token> &operators,
+        State wantOperand(Cursor &cursor,
+                          std::vector<PostfixNode> &postfix,
+                          std::vector<PostfixNode> &operators,
                           MaybeError &report) {
             using
             enum Token::Type;
 
-            assert(!infix.empty());
+            assert(cursor.pos < cursor.infix.size());
 
-            Token next = infix.front();
+            const Token &next = cursor.next();
             Token::Type t = next.type;
 
             if (t == undefined) {
@@ -231,38 +258,39 @@ namespace flexMC {
             }
 
             if (isSpace(t)) {
-                infix.pop_front();
+                ++cursor.pos;
                 return State::want_operand;
             }
 
             if (isOperand(t)) {
-                postfix.push_back(next);
-                infix.pop_front();
+                postfix.push_back(makeNode(next, cursor.pos));
+                State s = State::have_operand;
                 if (t == fun) {
-                    return checkParenthesisAfterFunction(postfix.back(), infix, report);
+                    s = checkParenthesisAfterFunction(cursor, report);
                 }
-                return State::have_operand;
+                ++cursor.pos;
+                return s;
             }
 
             if (isPrefixOp(next)) {
                 assert(!next.context.is_infix);
-                next.context.is_prefix = true;
+                PostfixNode node = makeNode(next, cursor.pos);
+                node.is_prefix = true;
                 // jump mul/div
                 if ((next.value == PLUS) || (next.value == MINUS)) {
-                    next.context.precedence += 2;
+                    node.precedence += 2;
                 }
-                operators.push_back(next);
-                infix.pop_front();
+                operators.push_back(node);
+                ++cursor.pos;
                 return State::want_operand;
             }
 
             // "()" expected (function with 0 args)
             if (t == rparen) {
-                State s = noArgsOrError(next, operators, report);
+                State s = noArgsOrError(cursor, operators, report);
                 if (s != State::error) {
-                    operators.pop_back();
-                    operators.push_back(Tokens::makeCall(0, 0));
-                    infix.pop_front();
+                    operators.back() = makeInsertedNode(call_, 0, cursor.pos);
+                    ++cursor.pos;
                 }
                 return s;
             }
@@ -276,16 +304,16 @@ namespace flexMC {
             return State::error;
         }
 
-        State haveOperand(std::deque<Token> &infix,
-                          std::vector<Token> &postfix,
-                          std::vector<Token> &operators,
+        State haveOperand(Cursor &cursor,
+                          std::vector<PostfixNode> &postfix,
+                          std::vector<PostfixNode> &operators,
                           MaybeError &report) {
             using
             enum Token::Type;
 
-            assert(!infix.empty());
+            assert(cursor.pos < cursor.infix.size());
 
-            Token next = infix.front();
+            const Token &next = cursor.next();
             Token::Type t = next.type;
 
             if (t == undefined) {
@@ -294,51 +322,52 @@ namespace flexMC {
             }
 
             if (isSpace(t)) {
-                infix.pop_front();
+                ++cursor.pos;
                 return State::have_operand;
             }
 
             if (t == eof) {
-                return terminate(next, postfix, operators, report);
+                return terminate(cursor, postfix, operators, report);
             }
 
             // wiki page shunting yard
             if ((t == lparen) || (t == lbracket)) {
                 assert(!next.context.is_prefix);
                 assert(next.context.maybe_infix);
-                next.context.is_infix = true;
-                operators.push_back(next);
-                infix.pop_front();
+                PostfixNode node = makeNode(next, cursor.pos);
+                node.is_infix = true;
+                operators.push_back(node);
+                ++cursor.pos;
                 return State::want_operand;
             }
 
             if (next.value == COMMA) {
-                State s = incrementArgsCount(next, postfix, operators, report);
+                State s = incrementArgsCount(cursor, postfix, operators, report);
                 if (s == State::want_operand) {
-                    infix.pop_front();
+                    ++cursor.pos;
                 }
                 return s;
             }
 
             if (next.type == rparen) {
-                State s = consumeParentheses(next, postfix, operators, report);
+                State s = consumeParentheses(cursor, postfix, operators, report);
                 if (s == State::have_operand) {
-                    infix.pop_front();
+                    ++cursor.pos;
                 }
                 return s;
             }
 
             if (next.type == rbracket) {
-                State s = consumeBrackets(next, postfix, operators, report);
+                State s = consumeBrackets(cursor, postfix, operators, report);
                 if (s == State::have_operand) {
-                    infix.pop_front();
+                    ++cursor.pos;
                 }
                 return s;
             }
 
             if ((next.type == op) && (next.context.maybe_infix)) {
-                State s = pushOperators(next, postfix, operators);
-                infix.pop_front();
+                State s = pushOperators(cursor, postfix, operators);
+                ++cursor.pos;
                 return s;
             }
 
@@ -353,24 +382,59 @@ namespace flexMC {
         }
     }
 
-    std::pair<MaybeError, std::vector<Token>> infixToPostfix(const std::deque<Token> &infix) {
+    MaybeError infixToPostfix(std::span<const Token> infix,
+                              std::vector<PostfixNode> &postfix,
+                              std::vector<PostfixNode> &operators) {
         assert(!infix.empty());
-        std::deque<Token> infix_(infix);
-        std::vector<Token> out;
-        std::vector<Token> operators;
-        Token first = infix_.front();
+        postfix.clear();
+        operators.clear();
+        postfix.reserve(infix.size());
 
         MaybeError report;
+        Cursor cursor{infix};
 
-        State current = wantOperand(infix_, out, operators, report);
+        State current = wantOperand(cursor, postfix, operators, report);
         while ((current != State::end) && (current != State::error)) {
             if (current == State::want_operand) {
-                current = wantOperand(infix_, out, operators, report);
+                current = wantOperand(cursor, postfix, operators, report);
             }
             else {
-                current = haveOperand(infix_, out, operators, report);
+                current = haveOperand(cursor, postfix, operators, report);
             }
         }
+        return report;
+    }
+
+    Token nodeToken(const PostfixNode &node, std::span<const Token> infix) {
+        using
+        enum Token::Type;
+        const std::size_t at = infix[node.token].start;
+        if (node.type == call_) {
+            return Tokens::makeCall(node.num_args, at);
+        }
+        if (node.type == append_) {
+            return Tokens::makeAppend(node.num_args, at);
+        }
+        if (node.type == index_) {
+            return Tokens::makeIndex(at);
+        }
+        Token tok = infix[node.token];
+        tok.context.num_args = node.num_args;
+        tok.context.precedence = node.precedence;
+        tok.context.is_prefix = node.is_prefix;
+        tok.context.is_infix = node.is_infix;
+        return tok;
+    }
+
+    std::pair<MaybeError, std::vector<Token>> infixToPostfix(std::span<const Token> infix) {
+        std::vector<PostfixNode> nodes;
+        std::vector<PostfixNode> operators;
+        MaybeError report = infixToPostfix(infix, nodes, operators);
+        std::vector<Token> out;
+        out.reserve(nodes.size());
+        for (const auto &node: nodes) {
+            out.push_back(nodeToken(node, infix));
+        }
         return std::make_pair(report, out);
     }
 
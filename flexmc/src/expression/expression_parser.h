@@ -1,7 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
 #include <vector>
-#include <deque>
 
 #include "tokens.h"
 #include "language_error.h"
@@ -9,6 +10,27 @@
 
 namespace flexMC {
 
-    std::pair<MaybeError, std::vector<Token>> infixToPostfix(const std::deque<Token> &infix);
+    // One node of a postfix program: the index of its token in the infix plus the parsing context it got from the
+    // parser. Inserted calls, vector literals and subscripts (call_, append_, index_) have no token of their own and
+    // refer to the closing parenthesis or bracket.
+    struct PostfixNode {
+        std::uint32_t token;
+        std::uint32_t num_args;
+        Token::Type type;
+        std::uint8_t precedence;
+        bool is_prefix;
+        bool is_infix;
+    };
+
+    // Index mode, walks the infix in place and allocates nothing beyond postfix and operators, which are cleared and
+    // can be reused across calls.
+    MaybeError infixToPostfix(std::span<const Token> infix,
+                              std::vector<PostfixNode> &postfix,
+                              std::vector<PostfixNode> &operators);
+
+    // The token of a node with the context set by the parser, valid as long as the infix.
+    Token nodeToken(const PostfixNode &node, std::span<const Token> infix);
+
+    std::pair<MaybeError, std::vector<Token>> infixToPostfix(std::span<const Token> infix);
 
 }
@@ -1,4 +1,6 @@
 #include <cassert>
+#include <algorithm>
+#include <numeric>
 
 #include "expression_stacks.h"
 
@@ -107,6 +109,16 @@ namespace flexMC {
         v_sizes_.push_back(value.size());
     }
 
+    void CalcStacks::pushVector(const SCALAR *begin, const std::size_t &size) {
+        vectors_.insert(vectors_.end(), begin, begin + size);
+        v_sizes_.push_back(size);
+    }
+
+    void CalcStacks::pushDateList(const DATE *begin, const std::size_t &size) {
+        date_lists_.insert(date_lists_.end(), begin, begin + size);
+        d_l_sizes_.push_back(size);
+    }
+
     void CalcStacks::pushDateList(const std::vector<DATE> &value) {
         for (const auto &v: value) {
             date_lists_.push_back(v);
@@ -142,4 +154,351 @@ namespace flexMC {
         d_l_sizes_.pop_back();
     }
 
-}
+    void CalcStacks::reserveLocals(const std::size_t &s_size, const std::size_t &v_size) {
+        if (local_scalars_.size() < s_size) {
+            local_scalars_.resize(s_size);
+        }
+        if (local_vectors_.size() < v_size) {
+            local_vectors_.resize(v_size);
+        }
+    }
+
+    void CalcStacks::storeVector(const std::size_t &offset, const std::size_t &size) {
+        assert((v_sizes_.back() == size) && (offset + size <= local_vectors_.size()));
+        std::copy(vectors_.end() - static_cast<std::ptrdiff_t>(size), vectors_.end(),
+                  local_vectors_.begin() + static_cast<std::ptrdiff_t>(offset));
+    }
+
+    void CalcStacks::fetchVector(const std::size_t &offset, const std::size_t &size) {
+        assert(offset + size <= local_vectors_.size());
+        pushVector(local_vectors_.data() + offset, size);
+    }
+
+    void CalcStacks::assignVector(const std::size_t &offset, const std::size_t &size) {
+        storeVector(offset, size);
+        vectors_.erase(vectors_.end() - static_cast<std::ptrdiff_t>(size), vectors_.end());
+        v_sizes_.pop_back();
+    }
+
+    std::vector<SCALAR> CalcStacks::localVector(const std::size_t &offset, const std::size_t &size) const {
+        assert(offset + size <= local_vectors_.size());
+        const auto begin = local_vectors_.begin() + static_cast<std::ptrdiff_t>(offset);
+        return {begin, begin + static_cast<std::ptrdiff_t>(size)};
+    }
+
+    BatchStacks::BatchStacks(const std::size_t &lanes, const std::size_t &s_size, const std::size_t &v_size,
+                             const std::size_t &d_size, const std::size_t &d_l_size) :
+        lanes_(lanes),
+        num_paths_(lanes),
+        lane_paths_(lanes),
+        path_lanes_(lanes),
+        alive_(lanes, 1.0),
+        active_(lanes, 1.0),
+        branch_(lanes, 0.0),
+        live_(lanes),
+        num_active_(lanes) {
+        assert(lanes > 0);
+        std::iota(lane_paths_.begin(), lane_paths_.end(), 0);
+        std::iota(path_lanes_.begin(), path_lanes_.end(), 0);
+        scalars_.reserve(s_size * lanes);
+        vectors_.reserve(v_size * lanes);
+        dates_.reserve(d_size);
+        date_lists_.reserve(d_l_size);
+    }
+
+    std::size_t BatchStacks::size(const CType &type) const {
+        using
+        enum CType;
+        switch (type) {
+            case scalar:
+                return scalars_.size() / lanes_;
+            case date:
+                return dates_.size();
+            case vector:
+                return vectors_.size() / lanes_;
+            case date_list:
+                return date_lists_.size();
+            default:
+                return 0;
+        }
+    }
+
+    bool BatchStacks::ready() const {
+        std::size_t not_ready{0};
+        not_ready += scalars_.size();
+        not_ready += vectors_.size();
+        not_ready += dates_.size();
+        not_ready += date_lists_.size();
+        not_ready += v_sizes_.size();
+        not_ready += d_l_sizes_.size();
+        return not_ready == 0;
+    }
+
+    void BatchStacks::pushScalar(const SCALAR &value) {
+        scalars_.insert(scalars_.end(), lanes_, value);
+    }
+
+    void BatchStacks::pushScalarLanes(const SCALAR *begin) {
+        scalars_.insert(scalars_.end(), begin, begin + lanes_);
+    }
+
+    void BatchStacks::pushVector(const SCALAR *begin, const std::size_t &size) {
+        for (std::size_t i{0}; i < size; ++i) {
+            vectors_.insert(vectors_.end(), lanes_, begin[i]);
+        }
+        v_sizes_.push_back(size);
+    }
+
+    void BatchStacks::pushDateList(const DATE *begin, const std::size_t &size) {
+        date_lists_.insert(date_lists_.end(), begin, begin + size);
+        d_l_sizes_.push_back(size);
+    }
+
+    std::vector<SCALAR> BatchStacks::scalarResult() const {
+        assert(scalars_.size() == lanes_);
+        return scalars_;
+    }
+
+    VECTOR BatchStacks::vectorResult(const std::size_t &lane) const {
+        assert(v_sizes_.size() == 1);
+        assert(vectors_.size() == v_sizes_.back() * lanes_);
+        assert(lane < lanes_);
+        VECTOR out(v_sizes_.back());
+        for (std::size_t i{0}; i < out.size(); ++i) {
+            out[i] = vectors_[i * lanes_ + lane];
+        }
+        return out;
+    }
+
+    void BatchStacks::popScalarResult() {
+        assert(scalars_.size() == lanes_);
+        scalars_.clear();
+    }
+
+    void BatchStacks::popVectorResult() {
+        assert(v_sizes_.size() == 1);
+        assert(vectors_.size() == v_sizes_.back() * lanes_);
+        vectors_.clear();
+        v_sizes_.pop_back();
+    }
+
+    void BatchStacks::reserveLocals(const std::size_t &s_size, const std::size_t &v_size) {
+        if (local_scalars_.size() < s_size * lanes_) {
+            local_scalars_.resize(s_size * lanes_);
+        }
+        if (local_vectors_.size() < v_size * lanes_) {
+            local_vectors_.resize(v_size * lanes_);
+        }
+        if (lanes_ < num_paths_) {
+            retired_scalars_.resize(std::max(retired_scalars_.size(), s_size * num_paths_));
+            retired_vectors_.resize(std::max(retired_vectors_.size(), v_size * num_paths_));
+        }
+    }
+
+    void BatchStacks::storeScalar(const std::size_t &slot) {
+        std::copy_n(scalarLanes(0), lanes_, local_scalars_.begin() + static_cast<std::ptrdiff_t>(slot * lanes_));
+    }
+
+    void BatchStacks::fetchScalar(const std::size_t &slot) {
+        pushScalarLanes(local_scalars_.data() + slot * lanes_);
+    }
+
+    void BatchStacks::storeVector(const std::size_t &offset, const std::size_t &size) {
+        assert((v_sizes_.back() == size) && ((offset + size) * lanes_ <= local_vectors_.size()));
+        std::copy(vectors_.end() - static_cast<std::ptrdiff_t>(size * lanes_), vectors_.end(),
+                  local_vectors_.begin() + static_cast<std::ptrdiff_t>(offset * lanes_));
+    }
+
+    void BatchStacks::fetchVector(const std::size_t &offset, const std::size_t &size) {
+        assert((offset + size) * lanes_ <= local_vectors_.size());
+        const auto begin = local_vectors_.begin() + static_cast<std::ptrdiff_t>(offset * lanes_);
+        vectors_.insert(vectors_.end(), begin, begin + static_cast<std::ptrdiff_t>(size * lanes_));
+        v_sizes_.push_back(size);
+    }
+
+    namespace {
+
+        // to[l] = mask[l] != 0 ? from[l] : to[l], a select the compiler turns into a vector blend
+        void blend(SCALAR *to, const SCALAR *from, const SCALAR *mask, const std::size_t &lanes) {
+            for (std::size_t l{0}; l < lanes; ++l) {
+                to[l] = mask[l] != 0.0 ? from[l] : to[l];
+            }
+        }
+
+        std::size_t countSet(const SCALAR *mask, const std::size_t &lanes) {
+            std::size_t set{0};
+            for (std::size_t l{0}; l < lanes; ++l) {
+                set += mask[l] != 0.0;
+            }
+            return set;
+        }
+
+    }
+
+    void BatchStacks::assignScalar(const std::size_t &slot) {
+        if (num_active_ == lanes_) {
+            storeScalar(slot);
+        }
+        else {
+            blend(local_scalars_.data() + slot * lanes_, scalarLanes(0), active_.data(), lanes_);
+        }
+        scalars_.erase(scalars_.end() - static_cast<std::ptrdiff_t>(lanes_), scalars_.end());
+    }
+
+    void BatchStacks::assignVector(const std::size_t &offset, const std::size_t &size) {
+        if (num_active_ == lanes_) {
+            storeVector(offset, size);
+        }
+        else {
+            assert((v_sizes_.back() == size) && ((offset + size) * lanes_ <= local_vectors_.size()));
+            const SCALAR *from = vectors_.data() + vectors_.size() - size * lanes_;
+            for (std::size_t i{0}; i < size; ++i) {
+                blend(local_vectors_.data() + (offset + i) * lanes_, from + i * lanes_, active_.data(), lanes_);
+            }
+        }
+        vectors_.erase(vectors_.end() - static_cast<std::ptrdiff_t>(size * lanes_), vectors_.end());
+        v_sizes_.pop_back();
+    }
+
+    void BatchStacks::setLocalScalar(const std::size_t &slot, const SCALAR *values) {
+        assert((slot + 1) * lanes_ <= local_scalars_.size());
+        SCALAR *local = local_scalars_.data() + slot * lanes_;
+        for (std::size_t lane{0}; lane < lanes_; ++lane) {
+            local[lane] = values[lane_paths_[lane]];
+        }
+    }
+
+    std::vector<SCALAR> BatchStacks::localScalar(const std::size_t &slot) const {
+        assert((slot + 1) * lanes_ <= local_scalars_.size());
+        std::vector<SCALAR> out(num_paths_);
+        for (std::size_t path{0}; path < num_paths_; ++path) {
+            const std::size_t lane = path_lanes_[path];
+            out[path] = lane == NO_LANE ? retired_scalars_[slot * num_paths_ + path]
+                                        : local_scalars_[slot * lanes_ + lane];
+        }
+        return out;
+    }
+
+    VECTOR BatchStacks::localVector(const std::size_t &offset, const std::size_t &size,
+                                    const std::size_t &path) const {
+        assert(((offset + size) * lanes_ <= local_vectors_.size()) && (path < num_paths_));
+        const std::size_t lane = path_lanes_[path];
+        VECTOR out(size);
+        for (std::size_t i{0}; i < size; ++i) {
+            out[i] = lane == NO_LANE ? retired_vectors_[(offset + i) * num_paths_ + path]
+                                     : local_vectors_[(offset + i) * lanes_ + lane];
+        }
+        return out;
+    }
+
+    bool BatchStacks::isLive(const std::size_t &path) const {
+        assert(path < num_paths_);
+        return (path_lanes_[path] != NO_LANE) && (alive_[path_lanes_[path]] != 0.0);
+    }
+
+    bool BatchStacks::maskIf() {
+        assert(!divergent_);
+        const SCALAR *condition = scalarLanes(0);
+        std::size_t taken{0};
+        for (std::size_t l{0}; l < lanes_; ++l) {
+            branch_[l] = condition[l] != 0.0 ? 1.0 : 0.0;
+            taken += (active_[l] != 0.0) & (condition[l] != 0.0);
+        }
+        scalars_.erase(scalars_.end() - static_cast<std::ptrdiff_t>(lanes_), scalars_.end());
+        // the whole batch agrees, branch as a single path would
+        if (taken == num_active_) {
+            return false;
+        }
+        if (taken == 0) {
+            return true;
+        }
+        divergent_ = true;
+        for (std::size_t l{0}; l < lanes_; ++l) {
+            active_[l] *= branch_[l];
+        }
+        num_active_ = taken;
+        return false;
+    }
+
+    bool BatchStacks::maskElse() {
+        if (!divergent_) {
+            return true;
+        }
+        for (std::size_t l{0}; l < lanes_; ++l) {
+            active_[l] = alive_[l] * (1.0 - branch_[l]);
+        }
+        num_active_ = countSet(active_.data(), lanes_);
+        return false;
+    }
+
+    void BatchStacks::endIf() {
+        if (divergent_) {
+            divergent_ = false;
+            active_ = alive_;
+            num_active_ = live_;
+        }
+    }
+
+    bool BatchStacks::terminateLanes() {
+        for (std::size_t l{0}; l < lanes_; ++l) {
+            alive_[l] *= 1.0 - active_[l];
+        }
+        live_ -= num_active_;
+        std::fill(active_.begin(), active_.end(), 0.0);
+        num_active_ = 0;
+        if (live_ == 0) {
+            divergent_ = false;
+            return true;
+        }
+        if (static_cast<SCALAR>(live_) < compaction_threshold_ * static_cast<SCALAR>(lanes_)) {
+            compact();
+        }
+        return false;
+    }
+
+    void BatchStacks::compact() {
+        // TERMINATE is a statement of its own, nothing is left on the stacks
+        assert(scalars_.empty() && vectors_.empty() && (live_ > 0));
+        const std::size_t scalar_slots = local_scalars_.size() / lanes_;
+        const std::size_t vector_slots = local_vectors_.size() / lanes_;
+        retired_scalars_.resize(std::max(retired_scalars_.size(), scalar_slots * num_paths_));
+        retired_vectors_.resize(std::max(retired_vectors_.size(), vector_slots * num_paths_));
+
+        std::vector<std::size_t> keep;
+        keep.reserve(live_);
+        for (std::size_t lane{0}; lane < lanes_; ++lane) {
+            const std::size_t path = lane_paths_[lane];
+            if (alive_[lane] != 0.0) {
+                path_lanes_[path] = keep.size();
+                keep.push_back(lane);
+                continue;
+            }
+            for (std::size_t slot{0}; slot < scalar_slots; ++slot) {
+                retired_scalars_[slot * num_paths_ + path] = local_scalars_[slot * lanes_ + lane];
+            }
+            for (std::size_t slot{0}; slot < vector_slots; ++slot) {
+                retired_vectors_[slot * num_paths_ + path] = local_vectors_[slot * lanes_ + lane];
+            }
+            path_lanes_[path] = NO_LANE;
+        }
+
+        // moves the kept lanes of every slot to the front, in place as no value moves to a higher index
+        const auto pack = [&keep, this]<class T>(std::vector<T> &values) {
+            const std::size_t slots = values.size() / lanes_;
+            for (std::size_t slot{0}; slot < slots; ++slot) {
+                for (std::size_t i{0}; i < keep.size(); ++i) {
+                    values[slot * keep.size() + i] = values[slot * lanes_ + keep[i]];
+                }
+            }
+            values.resize(slots * keep.size());
+        };
+        pack(local_scalars_);
+        pack(local_vectors_);
+        pack(lane_paths_);
+        pack(alive_);
+        pack(active_);
+        pack(branch_);
+        lanes_ = keep.size();
+    }
+
+}
\ No newline at end of file
@@ -27,7 +27,7 @@ namespace flexMC {
 
         void pushFunc(const Token &token) { functions_.push_back(token); }
 
-        Token funcsBack() const { return functions_.back(); }
+        const Token &funcsBack() const { return functions_.back(); }
 
         void popFunc() { functions_.pop_back(); }
 
@@ -86,10 +86,16 @@ namespace flexMC {
 
         inline const std::vector<std::size_t> &dateListSizes() const { return d_l_sizes_; };
 
+        inline void pushScalar(const SCALAR &value) { scalars_.push_back(value); }
+
         void pushVector(const std::vector<SCALAR> &value);
 
+        void pushVector(const SCALAR *begin, const std::size_t &size);
+
         void pushDateList(const std::vector<DATE> &value);
 
+        void pushDateList(const DATE *begin, const std::size_t &size);
+
         std::vector<SCALAR> vectorResult() const;
 
         std::vector<DATE> dateListResult() const;
@@ -102,6 +108,30 @@ namespace flexMC {
 
         std::size_t size(const CType &type) const;
 
+        // Locals hold values shared between the statements of a script (see eliminateCommonSubexpressions). They are
+        // not part of the stacks and only grow.
+        void reserveLocals(const std::size_t &s_size, const std::size_t &v_size);
+
+        inline void storeScalar(const std::size_t &slot) { local_scalars_[slot] = scalars_.back(); }
+
+        inline void fetchScalar(const std::size_t &slot) { scalars_.push_back(local_scalars_[slot]); }
+
+        void storeVector(const std::size_t &offset, const std::size_t &size);
+
+        void fetchVector(const std::size_t &offset, const std::size_t &size);
+
+        // Variables of a script (see compileScript) are locals as well, an assignment stores and pops the value
+        inline void assignScalar(const std::size_t &slot) {
+            local_scalars_[slot] = scalars_.back();
+            scalars_.pop_back();
+        }
+
+        void assignVector(const std::size_t &offset, const std::size_t &size);
+
+        inline SCALAR localScalar(const std::size_t &slot) const { return local_scalars_[slot]; }
+
+        std::vector<SCALAR> localVector(const std::size_t &offset, const std::size_t &size) const;
+
     private:
 
         std::vector<SCALAR> scalars_;
@@ -116,6 +146,182 @@ namespace flexMC {
 
         std::vector<std::size_t> d_l_sizes_;
 
+        std::vector<SCALAR> local_scalars_;
+
+        std::vector<SCALAR> local_vectors_;
+
+    };
+
+    // Struct of arrays version of CalcStacks evaluating one expression on a batch of paths at once. Every scalar and
+    // every vector element occupies lanes() consecutive values, one per path. Dates and date lists are the same on all
+    // paths and are stored once, as in CalcStacks.
+    class BatchStacks {
+
+    public:
+
+        BatchStacks(const std::size_t &lanes, const std::size_t &s_size, const std::size_t &v_size,
+                    const std::size_t &d_size, const std::size_t &d_l_size);
+
+        // the lanes evaluated, fewer than paths() once terminated paths were compacted away (see terminateLanes)
+        inline std::size_t lanes() const { return lanes_; }
+
+        // the paths the batch was created with
+        inline std::size_t paths() const { return num_paths_; }
+
+        inline std::vector<SCALAR> &scalars() { return scalars_; };
+
+        inline const std::vector<SCALAR> &scalars() const { return scalars_; };
+
+        inline std::vector<SCALAR> &vectors() { return vectors_; };
+
+        inline const std::vector<SCALAR> &vectors() const { return vectors_; };
+
+        inline std::vector<DATE> &dates() { return dates_; };
+
+        inline const std::vector<DATE> &dates() const { return dates_; };
+
+        inline std::vector<DATE> &datesLists() { return date_lists_; };
+
+        inline const std::vector<DATE> &datesLists() const { return date_lists_; };
+
+        // number of elements per vector, not multiplied by lanes()
+        inline std::vector<std::size_t> &vectorSizes() { return v_sizes_; };
+
+        inline const std::vector<std::size_t> &vectorSizes() const { return v_sizes_; };
+
+        inline std::vector<std::size_t> &dateListSizes() { return d_l_sizes_; };
+
+        inline const std::vector<std::size_t> &dateListSizes() const { return d_l_sizes_; };
+
+        // broadcasts value to all lanes
+        void pushScalar(const SCALAR &value);
+
+        // pushes one value per lane
+        void pushScalarLanes(const SCALAR *begin);
+
+        void pushVector(const SCALAR *begin, const std::size_t &size);
+
+        void pushDateList(const DATE *begin, const std::size_t &size);
+
+        // the lanes of the scalar at position i from the top of the stack
+        inline SCALAR *scalarLanes(const std::size_t &i) { return scalars_.data() + scalars_.size() - (i + 1) * lanes_; }
+
+        std::vector<SCALAR> scalarResult() const;
+
+        VECTOR vectorResult(const std::size_t &lane) const;
+
+        void popScalarResult();
+
+        void popVectorResult();
+
+        bool ready() const;
+
+        // number of slots, i.e. values per lane
+        std::size_t size(const CType &type) const;
+
+        // locals as in CalcStacks, with lanes() values per slot and per vector element
+        void reserveLocals(const std::size_t &s_size, const std::size_t &v_size);
+
+        void storeScalar(const std::size_t &slot);
+
+        void fetchScalar(const std::size_t &slot);
+
+        void storeVector(const std::size_t &offset, const std::size_t &size);
+
+        void fetchVector(const std::size_t &offset, const std::size_t &size);
+
+        // assignments only change the active lanes
+        void assignScalar(const std::size_t &slot);
+
+        void assignVector(const std::size_t &offset, const std::size_t &size);
+
+        // Locals by path rather than by lane. Paths which were compacted away keep the values they had when they were
+        // terminated.
+
+        // sets a local of all live paths from one value per path, e.g. the inputs of a script
+        void setLocalScalar(const std::size_t &slot, const SCALAR *values);
+
+        std::vector<SCALAR> localScalar(const std::size_t &slot) const;
+
+        VECTOR localVector(const std::size_t &offset, const std::size_t &size, const std::size_t &path) const;
+
+        // Predicated IF/ELSE blocks of a script. The active lanes are the live lanes taking the current branch. If they
+        // agree on the condition of an IF the whole batch branches, otherwise both branches run with the lanes of the
+        // other branch masked out. Blocks do not nest, outside of a block the active lanes are the live ones.
+
+        // takes the condition, true if no active lane takes the IF branch and the batch jumps to the ELSE branch
+        bool maskIf();
+
+        // at the end of the IF branch, true if no lane takes the ELSE branch and the batch jumps over it
+        bool maskElse();
+
+        void endIf();
+
+        // Terminates the active lanes, true if no lane is left. Once fewer than the compaction threshold times lanes()
+        // lanes are live, the live lanes are packed into the first lanes and the batch is narrowed to them, so that
+        // the cost of an evaluation follows the number of live paths.
+        bool terminateLanes();
+
+        // a fraction of lanes(), 0 never compacts
+        inline void setCompactionThreshold(const SCALAR &fraction) { compaction_threshold_ = fraction; }
+
+        // the paths which are not terminated
+        inline std::size_t live() const { return live_; }
+
+        bool isLive(const std::size_t &path) const;
+
+    private:
+
+        void compact();
+
+        std::size_t lanes_;
+
+        std::size_t num_paths_;
+
+        // the path evaluated in each lane and the lane of each path, NO_LANE once compacted away
+        std::vector<std::size_t> lane_paths_;
+
+        std::vector<std::size_t> path_lanes_;
+
+        static constexpr std::size_t NO_LANE{static_cast<std::size_t>(-1)};
+
+        SCALAR compaction_threshold_{0.5};
+
+        // 1.0 or 0.0 per lane
+        std::vector<SCALAR> alive_;
+
+        std::vector<SCALAR> active_;
+
+        // the condition of the open IF
+        std::vector<SCALAR> branch_;
+
+        std::size_t live_;
+
+        std::size_t num_active_;
+
+        bool divergent_{false};
+
+        std::vector<SCALAR> scalars_;
+
+        std::vector<SCALAR> vectors_;
+
+        std::vector<DATE> dates_;
+
+        std::vector<DATE> date_lists_;
+
+        std::vector<std::size_t> v_sizes_;
+
+        std::vector<std::size_t> d_l_sizes_;
+
+        std::vector<SCALAR> local_scalars_;
+
+        std::vector<SCALAR> local_vectors_;
+
+        // the locals of the compacted paths, laid out as the locals with paths() values per slot
+        std::vector<SCALAR> retired_scalars_;
+
+        std::vector<SCALAR> retired_vectors_;
+
     };
 
     class Operation {
@@ -0,0 +1,480 @@
+#include <cassert>
+#include <cstring>
+#include <bit>
+#include <optional>
+#include <utility>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#include <sys/mman.h>
+#define FLEXMC_JIT
+#endif
+
+#include "jit_code.h"
+#include "kernels.h"
+
+
+namespace flexMC {
+
+#if defined(FLEXMC_JIT)
+
+    namespace {
+
+        SCALAR expCall(SCALAR value) { return kernels::EXP_F(value); }
+
+        SCALAR logCall(SCALAR value) { return kernels::LOG_F(value); }
+
+        SCALAR powCall(SCALAR left, SCALAR right) { return kernels::POW_F(left, right); }
+
+        // xmm0 to xmm13 hold the stack, xmm14 and xmm15 are scratch
+        constexpr unsigned MAX_DEPTH = 14;
+
+        constexpr unsigned SCRATCH = 14;
+
+        constexpr unsigned INDEX = 15;
+
+        // general purpose registers
+        constexpr unsigned RSP = 4;
+
+        // callee saved, holding the constants and parameters pointers across calls
+        constexpr unsigned RBX = 3;
+
+        constexpr unsigned R12 = 12;
+
+        // opcodes after the F2 (scalar double) or 66 (packed double) prefix and 0F
+        enum class Sse : std::uint8_t {
+            movsd_load = 0x10,
+            movsd_store = 0x11,
+            sqrtsd = 0x51,
+            addsd = 0x58,
+            mulsd = 0x59,
+            subsd = 0x5C,
+            minsd = 0x5D,
+            divsd = 0x5E,
+            maxsd = 0x5F,
+            // 66 prefix
+            movapd = 0x28,
+            ucomisd = 0x2E,
+            andpd = 0x54,
+            xorpd = 0x57
+        };
+
+        // plus, minus, mul, div in the order of the binary opcode blocks, pow is a call
+        constexpr Sse ARITHMETIC[4] = {Sse::addsd, Sse::subsd, Sse::mulsd, Sse::divsd};
+
+        std::uint8_t prefix(const Sse &op) {
+            return (op == Sse::movapd) || (op == Sse::ucomisd) || (op == Sse::andpd) || (op == Sse::xorpd) ? 0x66
+                                                                                                            : 0xF2;
+        }
+
+        // operand of a binary instruction: a stack register, a literal or a parameter
+        struct Operand {
+
+            enum Kind {
+                reg,
+                constant,
+                parameter
+            };
+
+            Kind kind;
+
+            unsigned index;
+
+        };
+
+        class Assembler {
+
+        public:
+
+            explicit Assembler(const std::size_t &local_scalars) :
+                spill_(0), locals_(8 * MAX_DEPTH),
+                frame_(((8 * (MAX_DEPTH + local_scalars) + 15) / 16) * 16 + 8) {
+                // push rbx, push r12, mov rbx, rdi, mov r12, rsi, sub rsp, frame
+                bytes({0x53, 0x41, 0x54, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4, 0x48, 0x81, 0xEC});
+                int32(static_cast<std::int32_t>(frame_));
+            }
+
+            void finish() {
+                // add rsp, frame, pop r12, pop rbx, ret
+                bytes({0x48, 0x81, 0xC4});
+                int32(static_cast<std::int32_t>(frame_));
+                bytes({0x41, 0x5C, 0x5B, 0xC3});
+            }
+
+            const std::vector<std::uint8_t> &code() const { return code_; }
+
+            void rr(const Sse &op, const unsigned &reg, const unsigned &rm) {
+                if ((op == Sse::movapd) && (reg == rm)) {
+                    return;
+                }
+                byte(prefix(op));
+                rex(false, reg, rm);
+                bytes({0x0F, static_cast<std::uint8_t>(op), static_cast<std::uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7))});
+            }
+
+            void rm(const Sse &op, const unsigned &reg, const unsigned &base, const std::size_t &displacement) {
+                byte(prefix(op));
+                rex(false, reg, base);
+                bytes({0x0F, static_cast<std::uint8_t>(op), static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7))});
+                if ((base & 7) == RSP) {
+                    byte(0x24);
+                }
+                int32(static_cast<std::int32_t>(displacement));
+            }
+
+            // op reg, operand
+            void operand(const Sse &op, const unsigned &reg, const Operand &source) {
+                switch (source.kind) {
+                    case Operand::reg:
+                        rr(op, reg, source.index);
+                        break;
+                    case Operand::constant:
+                        rm(op, reg, RBX, 8 * source.index);
+                        break;
+                    default:
+                        rm(op, reg, R12, 8 * source.index);
+                }
+            }
+
+            void storeLocal(const unsigned &reg, const std::size_t &slot) { rm(Sse::movsd_store, reg, RSP, locals_ + 8 * slot); }
+
+            void fetchLocal(const unsigned &reg, const std::size_t &slot) { rm(Sse::movsd_load, reg, RSP, locals_ + 8 * slot); }
+
+            // result = function(arguments) into xmm dest, the registers below dest are live and saved across the call
+            void call(const void *function, const unsigned &dest, const Operand &left,
+                      const std::optional<Operand> &right) {
+                for (unsigned r{0}; r < dest; ++r) {
+                    rm(Sse::movsd_store, r, RSP, spill_ + 8 * r);
+                }
+                // xmm0 first unless it holds the right argument
+                if (right.has_value() && (right->kind == Operand::reg) && (right->index == 0)) {
+                    load(1, *right);
+                    load(0, left);
+                }
+                else {
+                    load(0, left);
+                    if (right.has_value()) {
+                        load(1, *right);
+                    }
+                }
+                // mov rax, imm64, call rax
+                bytes({0x48, 0xB8});
+                std::uint64_t address = std::bit_cast<std::uint64_t>(function);
+                for (int i{0}; i < 8; ++i) {
+                    byte(static_cast<std::uint8_t>(address >> (8 * i)));
+                }
+                bytes({0xFF, 0xD0});
+                rr(Sse::movapd, dest, 0);
+                for (unsigned r{0}; r < dest; ++r) {
+                    rm(Sse::movsd_load, r, RSP, spill_ + 8 * r);
+                }
+            }
+
+            void load(const unsigned &reg, const Operand &source) {
+                operand(source.kind == Operand::reg ? Sse::movapd : Sse::movsd_load, reg, source);
+            }
+
+            // jbe over the instructions emitted by body
+            template<class Body>
+            void skipIfBelowOrEqual(Body body) {
+                bytes({0x76, 0x00});
+                const std::size_t start = code_.size();
+                body();
+                assert(code_.size() - start < 128);
+                code_[start - 1] = static_cast<std::uint8_t>(code_.size() - start);
+            }
+
+        private:
+
+            void byte(const std::uint8_t &value) { code_.push_back(value); }
+
+            void bytes(std::initializer_list<std::uint8_t> values) { code_.insert(code_.end(), values); }
+
+            void int32(const std::int32_t &value) {
+                for (int i{0}; i < 4; ++i) {
+                    byte(static_cast<std::uint8_t>(static_cast<std::uint32_t>(value) >> (8 * i)));
+                }
+            }
+
+            void rex(const bool &wide, const unsigned &reg, const unsigned &base) {
+                const auto value = static_cast<std::uint8_t>(0x40 | (wide << 3) | ((reg >> 3) << 2) | (base >> 3));
+                if (value != 0x40) {
+                    byte(value);
+                }
+            }
+
+            std::vector<std::uint8_t> code_;
+
+            const std::size_t spill_;
+
+            const std::size_t locals_;
+
+            const std::size_t frame_;
+
+        };
+
+        class Translator {
+
+        public:
+
+            Translator(const ByteCode &code, std::vector<SCALAR> &constants) :
+                code_(code), constants_(constants), assembler_(localScalars(code)) {}
+
+            // machine code returning the scalar result, empty if an instruction is not supported
+            std::vector<std::uint8_t> translate() {
+                for (const Instruction &instruction: code_.instructions()) {
+                    if (!emit(instruction) || (depth_ > MAX_DEPTH)) {
+                        return {};
+                    }
+                }
+                if (depth_ != 1) {
+                    return {};
+                }
+                assembler_.finish();
+                return assembler_.code();
+            }
+
+        private:
+
+            static std::size_t localScalars(const ByteCode &code) {
+                std::size_t count{0};
+                for (const Instruction &instruction: code.instructions()) {
+                    if (instruction.code == OpCode::store_scalar) {
+                        count = std::max<std::size_t>(count, instruction.offset + 1);
+                    }
+                }
+                return count;
+            }
+
+            Operand constant(const SCALAR &value) {
+                constants_.push_back(value);
+                return {Operand::constant, static_cast<unsigned>(constants_.size() - 1)};
+            }
+
+            Operand top(const unsigned &below = 0) const { return {Operand::reg, depth_ - 1 - below}; }
+
+            // left op right into the register dest (where left is, unless it is not a register)
+            void binary(const std::size_t &op, const unsigned &dest, const Operand &left, const Operand &right) {
+                if (op == 4) {
+                    assembler_.call(reinterpret_cast<const void *>(&powCall), dest, left, right);
+                }
+                else if ((left.kind == Operand::reg) && (left.index == dest)) {
+                    assembler_.operand(ARITHMETIC[op], dest, right);
+                }
+                else {
+                    assembler_.load(SCRATCH, left);
+                    assembler_.operand(ARITHMETIC[op], SCRATCH, right);
+                    assembler_.rr(Sse::movapd, dest, SCRATCH);
+                }
+            }
+
+            // as reduceArguments::accumulate, from the last argument to the first
+            void accumulate(const Sse &op, const SCALAR &init, const unsigned &num) {
+                assembler_.load(SCRATCH, constant(init));
+                for (unsigned i{0}; i < num; ++i) {
+                    assembler_.rr(op, SCRATCH, depth_ - 1 - i);
+                }
+                depth_ -= num - 1;
+                assembler_.rr(Sse::movapd, depth_ - 1, SCRATCH);
+            }
+
+            // as reduceArguments::minmax, the found value moves from the last argument to the first
+            void minmax(const Sse &op, const unsigned &num) {
+                for (unsigned i{1}; i < num; ++i) {
+                    assembler_.rr(op, depth_ - 1 - i, depth_ - i);
+                }
+                depth_ -= num - 1;
+            }
+
+            // first index of the largest (smallest) argument, as std::max_element (std::min_element)
+            void argument(const bool &largest, const unsigned &num) {
+                const unsigned first = depth_ - num;
+                assembler_.rr(Sse::movapd, SCRATCH, first);
+                assembler_.load(INDEX, constant(0.0));
+                for (unsigned i{1}; i < num; ++i) {
+                    const Operand index = constant(static_cast<SCALAR>(i));
+                    // ucomisd sets "above" only for ordered operands, like operator< in the algorithms
+                    largest ? assembler_.rr(Sse::ucomisd, first + i, SCRATCH)
+                            : assembler_.rr(Sse::ucomisd, SCRATCH, first + i);
+                    assembler_.skipIfBelowOrEqual([&]() {
+                        assembler_.rr(Sse::movapd, SCRATCH, first + i);
+                        assembler_.load(INDEX, index);
+                    });
+                }
+                depth_ = first + 1;
+                assembler_.rr(Sse::movapd, first, INDEX);
+            }
+
+            bool emit(const Instruction &instruction) {
+                using
+                enum OpCode;
+                const OpCode code = instruction.code;
+                const auto num = static_cast<unsigned>(instruction.size);
+                switch (code) {
+                    case push_scalar:
+                        assembler_.load(depth_++, constant(instruction.scalar));
+                        return true;
+                    case load_scalar:
+                        assembler_.load(depth_++, {Operand::parameter, static_cast<unsigned>(instruction.offset)});
+                        return true;
+                    case store_scalar:
+                        assembler_.storeLocal(depth_ - 1, instruction.offset);
+                        return true;
+                    case fetch_scalar:
+                        assembler_.fetchLocal(depth_++, instruction.offset);
+                        return true;
+                    case neg_sc:
+                        assembler_.load(SCRATCH, constant(std::bit_cast<SCALAR>(0x8000000000000000ULL)));
+                        assembler_.rr(Sse::xorpd, depth_ - 1, SCRATCH);
+                        return true;
+                    case abs_sc:
+                        assembler_.load(SCRATCH, constant(std::bit_cast<SCALAR>(0x7FFFFFFFFFFFFFFFULL)));
+                        assembler_.rr(Sse::andpd, depth_ - 1, SCRATCH);
+                        return true;
+                    case sqrt_sc:
+                        assembler_.rr(Sse::sqrtsd, depth_ - 1, depth_ - 1);
+                        return true;
+                    case square_sc:
+                        assembler_.rr(Sse::mulsd, depth_ - 1, depth_ - 1);
+                        return true;
+                    case exp_sc:
+                    case log_sc:
+                        assembler_.call(code == exp_sc ? reinterpret_cast<const void *>(&expCall)
+                                                       : reinterpret_cast<const void *>(&logCall),
+                                        depth_ - 1, top(), std::nullopt);
+                        return true;
+                    case sum_args:
+                        accumulate(Sse::addsd, 0.0, num);
+                        return true;
+                    case prod_args:
+                        accumulate(Sse::mulsd, 1.0, num);
+                        return true;
+                    case max_args:
+                        minmax(Sse::maxsd, num);
+                        return true;
+                    case min_args:
+                        minmax(Sse::minsd, num);
+                        return true;
+                    case argmax_args:
+                        argument(true, num);
+                        return true;
+                    case argmin_args:
+                        argument(false, num);
+                        return true;
+                    case mul_add_sc:
+                        assembler_.rr(Sse::mulsd, depth_ - 2, depth_ - 1);
+                        assembler_.rr(Sse::addsd, depth_ - 3, depth_ - 2);
+                        depth_ -= 2;
+                        return true;
+                    case mul_add_imm:
+                        assembler_.rr(Sse::mulsd, depth_ - 2, depth_ - 1);
+                        assembler_.operand(Sse::addsd, depth_ - 2, constant(instruction.scalar));
+                        --depth_;
+                        return true;
+                    case max_imm:
+                    case min_imm:
+                        assembler_.operand(code == max_imm ? Sse::maxsd : Sse::minsd, depth_ - 1,
+                                           constant(instruction.scalar));
+                        return true;
+                    case call_imm:
+                        // MAX(x - c, 0), maxsd returns the second operand unless the first is greater
+                        assembler_.operand(Sse::subsd, depth_ - 1, constant(instruction.scalar));
+                        assembler_.rr(Sse::xorpd, SCRATCH, SCRATCH);
+                        assembler_.rr(Sse::maxsd, depth_ - 1, SCRATCH);
+                        return true;
+                    default:
+                        break;
+                }
+                if (isArithmetic(code) && (binaryVariant(code) == 0)) {
+                    const std::size_t op = (static_cast<std::size_t>(code) - static_cast<std::size_t>(plus_sc_sc)) / 4;
+                    binary(op, depth_ - 2, top(1), top());
+                    --depth_;
+                    return true;
+                }
+                if ((plus_sc_imm <= code) && (code <= pow_sc_imm)) {
+                    const std::size_t op = static_cast<std::size_t>(code) - static_cast<std::size_t>(plus_sc_imm);
+                    binary(op, depth_ - 1, top(), constant(instruction.scalar));
+                    return true;
+                }
+                if ((plus_imm_sc <= code) && (code <= pow_imm_sc)) {
+                    const std::size_t op = static_cast<std::size_t>(code) - static_cast<std::size_t>(plus_imm_sc);
+                    binary(op, depth_ - 1, constant(instruction.scalar), top());
+                    return true;
+                }
+                if ((plus_sc_load <= code) && (code <= pow_sc_load)) {
+                    const std::size_t op = static_cast<std::size_t>(code) - static_cast<std::size_t>(plus_sc_load);
+                    binary(op, depth_ - 1, top(), {Operand::parameter, static_cast<unsigned>(instruction.offset)});
+                    return true;
+                }
+                // vectors, dates, their functions and the comparisons
+                return false;
+            }
+
+            const ByteCode &code_;
+
+            std::vector<SCALAR> &constants_;
+
+            Assembler assembler_;
+
+            unsigned depth_{0};
+
+        };
+
+    }
+
+    JitCode::JitCode(const ByteCode &code) : code_(code) {
+        const std::vector<std::uint8_t> machine_code = Translator(code_, constants_).translate();
+        if (machine_code.empty()) {
+            constants_.clear();
+            return;
+        }
+        void *memory = mmap(nullptr, machine_code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return;
+        }
+        std::memcpy(memory, machine_code.data(), machine_code.size());
+        if (mprotect(memory, machine_code.size(), PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, machine_code.size());
+            return;
+        }
+        memory_ = memory;
+        memory_size_ = machine_code.size();
+        function_ = reinterpret_cast<Function>(memory_);
+    }
+
+    void JitCode::release() {
+        if (memory_ != nullptr) {
+            munmap(memory_, memory_size_);
+        }
+        memory_ = nullptr;
+        memory_size_ = 0;
+        function_ = nullptr;
+    }
+
+#else
+
+    JitCode::JitCode(const ByteCode &code) : code_(code) {}
+
+    void JitCode::release() {}
+
+#endif
+
+    JitCode::JitCode(JitCode &&other) noexcept: code_(std::move(other.code_)), constants_(std::move(other.constants_)),
+                                                memory_(std::exchange(other.memory_, nullptr)),
+                                                memory_size_(std::exchange(other.memory_size_, 0)),
+                                                function_(std::exchange(other.function_, nullptr)) {}
+
+    JitCode &JitCode::operator=(JitCode &&other) noexcept {
+        if (this != &other) {
+            release();
+            code_ = std::move(other.code_);
+            constants_ = std::move(other.constants_);
+            memory_ = std::exchange(other.memory_, nullptr);
+            memory_size_ = std::exchange(other.memory_size_, 0);
+            function_ = std::exchange(other.function_, nullptr);
+        }
+        return *this;
+    }
+
+    JitCode::~JitCode() { release(); }
+
+}
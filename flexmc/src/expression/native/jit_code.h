@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "calc_types.h"
+#include "expression_stacks.h"
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    // Scalar expressions translated into x86-64 machine code when the code is created. The stack positions are held
+    // in the SSE registers, EXP, LOG and POW call the kernels. Expressions with vectors or dates, deeper than the
+    // register stack or compiled on other targets keep running on the ByteCode they were created from.
+    class JitCode {
+
+    public:
+
+        JitCode() = default;
+
+        explicit JitCode(const ByteCode &code);
+
+        JitCode(const JitCode &) = delete;
+
+        JitCode &operator=(const JitCode &) = delete;
+
+        JitCode(JitCode &&other) noexcept;
+
+        JitCode &operator=(JitCode &&other) noexcept;
+
+        ~JitCode();
+
+        void operator()(CalcStacks &stacks) const {
+            if (function_ == nullptr) {
+                code_(stacks);
+                return;
+            }
+            const SCALAR *parameters = (code_.parameters() == nullptr) ? nullptr : code_.parameters()->scalars();
+            stacks.scalars().push_back(function_(constants_.data(), parameters));
+        }
+
+        // false if the expression falls back to the ByteCode
+        bool isNative() const { return function_ != nullptr; }
+
+        const ByteCode &byteCode() const { return code_; }
+
+    private:
+
+        using Function = SCALAR (*)(const SCALAR *constants, const SCALAR *parameters);
+
+        void release();
+
+        ByteCode code_;
+
+        // literals and masks read by the machine code
+        std::vector<SCALAR> constants_;
+
+        void *memory_{nullptr};
+
+        std::size_t memory_size_{0};
+
+        Function function_{nullptr};
+
+    };
+
+}
@@ -0,0 +1,78 @@
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+#include <fmt/format.h>
+
+#include "native_library.h"
+
+
+namespace flexMC {
+
+    NativeLibrary::NativeLibrary(NativeLibrary &&other) noexcept: handle_(other.handle_) {
+        other.handle_ = nullptr;
+    }
+
+    NativeLibrary &NativeLibrary::operator=(NativeLibrary &&other) noexcept {
+        if (this != &other) {
+            close();
+            handle_ = other.handle_;
+            other.handle_ = nullptr;
+        }
+        return *this;
+    }
+
+    NativeLibrary::~NativeLibrary() { close(); }
+
+#if defined(_WIN32)
+
+    MaybeError NativeLibrary::open(const std::string &path) {
+        MaybeError report;
+        report.setMessage(fmt::format(R"(Cannot load "{}": native scripts are not supported on Windows)", path));
+        return report;
+    }
+
+    std::pair<MaybeError, NativeFunction> NativeLibrary::function(const std::string &name) const {
+        MaybeError report;
+        report.setMessage(fmt::format(R"(Cannot find "{}": native scripts are not supported on Windows)", name));
+        return {report, nullptr};
+    }
+
+    void NativeLibrary::close() {}
+
+#else
+
+    MaybeError NativeLibrary::open(const std::string &path) {
+        close();
+        MaybeError report;
+        handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle_ == nullptr) {
+            report.setMessage(fmt::format(R"(Cannot load "{}": {})", path, dlerror()));
+        }
+        return report;
+    }
+
+    std::pair<MaybeError, NativeFunction> NativeLibrary::function(const std::string &name) const {
+        MaybeError report;
+        if (handle_ == nullptr) {
+            report.setMessage(fmt::format(R"(Cannot find "{}": no library loaded)", name));
+            return {report, nullptr};
+        }
+        void *symbol = dlsym(handle_, name.c_str());
+        if (symbol == nullptr) {
+            report.setMessage(fmt::format(R"(Cannot find "{}": {})", name, dlerror()));
+            return {report, nullptr};
+        }
+        return {report, reinterpret_cast<NativeFunction>(symbol)};
+    }
+
+    void NativeLibrary::close() {
+        if (handle_ != nullptr) {
+            dlclose(handle_);
+            handle_ = nullptr;
+        }
+    }
+
+#endif
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include "language_error.h"
+#include "expression_stacks.h"
+#include "parameters.h"
+#include "vector_math.h"
+
+
+namespace flexMC {
+
+    // Signature of the functions emitted by transpile, called with vectorMath::kernels() so that modules do not link to
+    // the library
+    using NativeFunction = void (*)(CalcStacks &stacks, const Parameters &parameters,
+                                    const vectorMath::Kernels &vector_kernels);
+
+    // Shared object built from transpiled scripts, loaded with dlopen
+    class NativeLibrary {
+
+    public:
+
+        NativeLibrary() = default;
+
+        NativeLibrary(const NativeLibrary &) = delete;
+
+        NativeLibrary &operator=(const NativeLibrary &) = delete;
+
+        NativeLibrary(NativeLibrary &&other) noexcept;
+
+        NativeLibrary &operator=(NativeLibrary &&other) noexcept;
+
+        ~NativeLibrary();
+
+        MaybeError open(const std::string &path);
+
+        std::pair<MaybeError, NativeFunction> function(const std::string &name) const;
+
+    private:
+
+        void close();
+
+        void *handle_{nullptr};
+
+    };
+
+}
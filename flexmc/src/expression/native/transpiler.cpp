@@ -0,0 +1,520 @@
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <fmt/format.h>
+
+#include "transpiler.h"
+
+
+namespace flexMC {
+
+    namespace {
+
+        constexpr std::array<const char *, 11> OPERATORS{"PLUS_F", "MINUS_F", "MUL_F", "DIV_F", "POW_F", "LT_F", "GT_F",
+                                                         "LE_F", "GE_F", "AND_F", "OR_F"};
+
+        constexpr std::array<const char *, 5> FUNCTIONS{"EXP_F", "LOG_F", "ABS_F", "SQRT_F", "SQUARE_F"};
+
+        std::size_t distance(const OpCode &code, const OpCode &first) {
+            return static_cast<std::size_t>(code) - static_cast<std::size_t>(first);
+        }
+
+        // EXP, LOG and POW of vectors run on the vectorMath kernels as in ByteCode, which differ from libm in the last
+        // bits. The other element functions are exact or the same expressions as in ByteCode.
+        bool isVectorMath(const OpCode &code) {
+            using
+            enum OpCode;
+            return (code == exp_vec) || (code == log_vec) || (isPow(code) && (code != pow_sc_sc));
+        }
+
+        // exact, hexadecimal floating point literals
+        std::string literal(const SCALAR &value) {
+            if (std::isnan(value)) {
+                return "std::numeric_limits<double>::quiet_NaN()";
+            }
+            if (std::isinf(value)) {
+                return value > 0 ? "std::numeric_limits<double>::infinity()"
+                                 : "(-std::numeric_limits<double>::infinity())";
+            }
+            return value < 0 ? fmt::format("({:a})", value) : fmt::format("{:a}", value);
+        }
+
+        template<class T, class Format>
+        std::string join(const std::vector<T> &values, Format format) {
+            std::string out;
+            for (std::size_t i{0}; i < values.size(); ++i) {
+                out += (i == 0 ? "" : ", ") + format(values[i]);
+            }
+            return out;
+        }
+
+        // A value on the stacks during translation, i.e. the variable holding it
+        struct Value {
+
+            CType type;
+
+            std::string name;
+
+            // number of elements of vectors and date lists
+            std::size_t size;
+
+        };
+
+        class Emitter {
+
+        public:
+
+            explicit Emitter(const ByteCode &code) : code_(code) {}
+
+            std::string body() {
+                for (const Instruction &instruction: code_.instructions()) {
+                    emit(instruction);
+                }
+                for (const Value &value: values_) {
+                    pushResult(value);
+                }
+                return body_;
+            }
+
+        private:
+
+            void line(const std::string &text) {
+                body_ += "    ";
+                body_ += text;
+                body_ += "\n";
+            }
+
+            Value pop() {
+                assert(!values_.empty());
+                Value back = values_.back();
+                values_.pop_back();
+                return back;
+            }
+
+            std::vector<Value> popArguments(const std::size_t &num) {
+                assert(values_.size() >= num);
+                std::vector<Value> arguments(values_.end() - static_cast<std::ptrdiff_t>(num), values_.end());
+                values_.resize(values_.size() - num);
+                return arguments;
+            }
+
+            std::string newName(const char *prefix) { return fmt::format("{}{}", prefix, next_++); }
+
+            void scalar(const std::string &expression) {
+                const std::string name = newName("s");
+                line(fmt::format("const double {} = {};", name, expression));
+                values_.push_back({CType::scalar, name, 1});
+            }
+
+            // element is the expression of element i
+            void vector(const std::size_t &size, const std::string &element) {
+                const std::string name = newName("v");
+                line(fmt::format("std::array<double, {}> {};", size, name));
+                line(fmt::format("for (std::size_t i = 0; i < {}; ++i) {{ {}[i] = {}; }}", size, name, element));
+                values_.push_back({CType::vector, name, size});
+            }
+
+            // the vectorMath kernel of code applied to the operands, the scalar operand of pow is given by name
+            void vectorMath(const OpCode &code, const std::string &left, const std::string &right,
+                            const std::size_t &size) {
+                const std::string name = newName("v");
+                line(fmt::format("std::array<double, {}> {};", size, name));
+                mathCall(code, left, right, name, size);
+                values_.push_back({CType::vector, name, size});
+            }
+
+            // the one vector operand of exp_vec and log_vec is left
+            void mathCall(const OpCode &code, const std::string &left, const std::string &right,
+                          const std::string &out, const std::size_t &size) {
+                using
+                enum OpCode;
+                assert(isVectorMath(code));
+                if ((code == exp_vec) || (code == log_vec)) {
+                    line(fmt::format("vector_kernels.{}(std::data({}), {}.data(), {});",
+                                     code == exp_vec ? "exp" : "log", left, out, size));
+                    return;
+                }
+                const std::size_t variant = binaryVariant(code);
+                line(fmt::format("vector_kernels.{}({}, {}, {}.data(), {});",
+                                 variant == 1 ? "powScVec" : (variant == 2 ? "powVecSc" : "powVecVec"),
+                                 variant == 1 ? "&" + left : fmt::format("std::data({})", left),
+                                 variant == 2 ? "&" + right : fmt::format("std::data({})", right), out, size));
+            }
+
+            // the element-wise steps are chained into one expression, a vectorMath step materialises the elements so
+            // far into array and runs over it in place
+            std::string applyStep(const MapStep &step, const std::string &element, std::string &array,
+                                  const std::size_t &size) {
+                if (!isVectorMath(step.code)) {
+                    return mapStep(step, element);
+                }
+                if (element != fmt::format("{}[i]", array)) {
+                    array = newName("v");
+                    line(fmt::format("std::array<double, {}> {};", size, array));
+                    line(fmt::format("for (std::size_t i = 0; i < {}; ++i) {{ {}[i] = {}; }}", size, array, element));
+                }
+                // the scalar operand of pow is passed by address
+                std::string scalar;
+                if (isBinary(step.code)) {
+                    scalar = newName("s");
+                    line(fmt::format("const double {} = {};", scalar, literal(step.scalar)));
+                }
+                const bool scalar_left = isBinary(step.code) && (binaryVariant(step.code) == 1);
+                mathCall(step.code, scalar_left ? scalar : array, scalar_left ? array : scalar, array, size);
+                return fmt::format("{}[i]", array);
+            }
+
+            // as reduceArguments::accumulate, from the last argument to the first
+            void accumulate(const std::string &range, const std::size_t &size, const char *f, const SCALAR &init) {
+                const std::string name = newName("s");
+                line(fmt::format("double {} = {};", name, literal(init)));
+                line(fmt::format("for (std::size_t i = {}; i-- > 0;) {{ {} = {}({}, {}[i]); }}", size, name, f, name,
+                                 range));
+                values_.push_back({CType::scalar, name, 1});
+            }
+
+            // SUM and PROD of a vector in the order of reductions.h
+            void reduction(const std::string &range, const std::size_t &size, const char *function) {
+                scalar(fmt::format("flexMC::reductions::{}(std::data({}), {})", function, range, size));
+            }
+
+            // first occurrence, as std::max_element and std::min_element
+            void pick(const std::string &range, const char *algorithm, const bool &index) {
+                const std::string found = fmt::format("std::{}(std::begin({}), std::end({}))", algorithm, range, range);
+                if (index) {
+                    scalar(fmt::format("static_cast<double>(std::distance(std::begin({}), {}))", range, found));
+                }
+                else {
+                    scalar(fmt::format("*{}", found));
+                }
+            }
+
+            // as reduceArguments::minmax, from the last argument to the first
+            void minmax(const std::string &range, const std::size_t &size, const char *compare) {
+                const std::string name = newName("s");
+                line(fmt::format("double {} = {}[{}];", name, range, size - 1));
+                line(fmt::format("for (std::size_t i = {}; i-- > 0;) {{ if ({}({}[i], {})) {{ {} = {}[i]; }} }}",
+                                 size - 1, compare, range, name, name, range));
+                values_.push_back({CType::scalar, name, 1});
+            }
+
+            void emit(const Instruction &instruction) {
+                using
+                enum OpCode;
+                const OpCode code = instruction.code;
+                const auto at = static_cast<std::ptrdiff_t>(instruction.offset);
+                switch (code) {
+                    case push_scalar:
+                        scalar(literal(instruction.scalar));
+                        return;
+                    case push_vector: {
+                        const std::vector<SCALAR> elements(code_.vectorPool().begin() + at,
+                                                           code_.vectorPool().begin() + at + instruction.size);
+                        const std::string name = newName("v");
+                        line(fmt::format("const std::array<double, {}> {}{{{}}};", instruction.size, name,
+                                         join(elements, literal)));
+                        values_.push_back({CType::vector, name, instruction.size});
+                        return;
+                    }
+                    case push_date: {
+                        const std::string name = newName("d");
+                        line(fmt::format("const int {} = {};", name, instruction.date));
+                        values_.push_back({CType::date, name, 1});
+                        return;
+                    }
+                    case push_date_list: {
+                        const std::vector<DATE> elements(code_.dateListPool().begin() + at,
+                                                         code_.dateListPool().begin() + at + instruction.size);
+                        const std::string name = newName("l");
+                        line(fmt::format("const std::array<int, {}> {}{{{}}};", instruction.size, name,
+                                         join(elements, [](const DATE &d) { return std::to_string(d); })));
+                        values_.push_back({CType::date_list, name, instruction.size});
+                        return;
+                    }
+                    case load_scalar:
+                        scalar(fmt::format("parameters.scalar({})", instruction.offset));
+                        return;
+                    case load_vector: {
+                        const std::string name = newName("v");
+                        line(fmt::format("const auto &{} = parameters.vector({});", name, instruction.offset));
+                        values_.push_back({CType::vector, name, instruction.size});
+                        return;
+                    }
+                    case store_scalar:
+                    case store_vector:
+                        locals_[code == store_scalar ? instruction.offset : ~instruction.offset] = values_.back();
+                        return;
+                    case fetch_scalar:
+                    case fetch_vector:
+                        values_.push_back(locals_.at(code == fetch_scalar ? instruction.offset : ~instruction.offset));
+                        return;
+                    case append: {
+                        const std::vector<Value> arguments = popArguments(instruction.size);
+                        const std::string name = newName("v");
+                        line(fmt::format("const std::array<double, {}> {}{{{}}};", instruction.size, name,
+                                         join(arguments, [](const Value &v) { return v.name; })));
+                        values_.push_back({CType::vector, name, instruction.size});
+                        return;
+                    }
+                    case neg_sc:
+                        scalar(fmt::format("NEG_F({})", pop().name));
+                        return;
+                    case neg_vec: {
+                        const Value arg = pop();
+                        vector(arg.size, fmt::format("NEG_F({}[i])", arg.name));
+                        return;
+                    }
+                    case not_sc:
+                        scalar(fmt::format("NOT_F({})", pop().name));
+                        return;
+                    case not_vec: {
+                        const Value arg = pop();
+                        vector(arg.size, fmt::format("NOT_F({}[i])", arg.name));
+                        return;
+                    }
+                    case map_vec:
+                    case map_reduce_vec:
+                    case zip_reduce_vec: {
+                        auto step = code_.mapPool().begin() + at;
+                        auto last = step + instruction.size;
+                        const Value arg = pop();
+                        std::string element = fmt::format("{}[i]", arg.name);
+                        // the array written by the last vectorMath step
+                        std::string array;
+                        if ((code == zip_reduce_vec) && isVectorMath(step->code)) {
+                            vectorMath(step->code, pop().name, arg.name, arg.size);
+                            array = pop().name;
+                            element = fmt::format("{}[i]", array);
+                            ++step;
+                        }
+                        else if (code == zip_reduce_vec) {
+                            element = fmt::format("{}({}[i], {}[i])", OPERATORS[distance(step->code, plus_sc_sc) / 4],
+                                                  pop().name, arg.name);
+                            ++step;
+                        }
+                        if (code != map_vec) {
+                            --last;
+                        }
+                        for (; step != last; ++step) {
+                            element = applyStep(*step, element, array, arg.size);
+                        }
+                        // the reduction runs over a local array
+                        if (element == fmt::format("{}[i]", array)) {
+                            values_.push_back({CType::vector, array, arg.size});
+                        }
+                        else {
+                            vector(arg.size, element);
+                        }
+                        if (code != map_vec) {
+                            const Value mapped = pop();
+                            emitReduce(distance(last->code, sum_vec), mapped.name, mapped.size, false);
+                        }
+                        return;
+                    }
+                    default:
+                        break;
+                }
+                if (isBinary(code) && isVectorMath(code)) {
+                    const Value right = pop();
+                    const Value left = pop();
+                    vectorMath(code, left.name, right.name, std::max(left.size, right.size));
+                }
+                else if (isBinary(code)) {
+                    const char *f = OPERATORS[distance(code, plus_sc_sc) / 4];
+                    const Value right = pop();
+                    const Value left = pop();
+                    switch (binaryVariant(code)) {
+                        case 0:
+                            scalar(fmt::format("{}({}, {})", f, left.name, right.name));
+                            break;
+                        case 1:
+                            vector(right.size, fmt::format("{}({}, {}[i])", f, left.name, right.name));
+                            break;
+                        case 2:
+                            vector(left.size, fmt::format("{}({}[i], {})", f, left.name, right.name));
+                            break;
+                        default:
+                            vector(left.size, fmt::format("{}({}[i], {}[i])", f, left.name, right.name));
+                    }
+                }
+                else if (isFunction(code)) {
+                    const char *f = FUNCTIONS[distance(code, exp_sc) / 2];
+                    const Value arg = pop();
+                    if (isVectorMath(code)) {
+                        vectorMath(code, arg.name, {}, arg.size);
+                    }
+                    else if (isVectorFunction(code)) {
+                        vector(arg.size, fmt::format("{}({}[i])", f, arg.name));
+                    }
+                    else {
+                        scalar(fmt::format("{}({})", f, arg.name));
+                    }
+                }
+                else if (isReduceVector(code)) {
+                    const Value arg = pop();
+                    emitReduce(distance(code, sum_vec), arg.name, arg.size, false);
+                }
+                else if (isReduceArguments(code)) {
+                    const std::vector<Value> arguments = popArguments(instruction.size);
+                    const std::string name = newName("a");
+                    line(fmt::format("const std::array<double, {}> {}{{{}}};", instruction.size, name,
+                                     join(arguments, [](const Value &v) { return v.name; })));
+                    emitReduce(distance(code, sum_args), name, instruction.size, true);
+                }
+                else {
+                    emitFused(instruction);
+                }
+            }
+
+            static std::string mapStep(const MapStep &step, const std::string &element) {
+                if (step.code == OpCode::neg_vec) {
+                    return fmt::format("NEG_F({})", element);
+                }
+                if (step.code == OpCode::not_vec) {
+                    return fmt::format("NOT_F({})", element);
+                }
+                if (isFunction(step.code)) {
+                    return fmt::format("{}({})", FUNCTIONS[distance(step.code, OpCode::exp_sc) / 2], element);
+                }
+                const char *f = OPERATORS[distance(step.code, OpCode::plus_sc_sc) / 4];
+                return binaryVariant(step.code) == 1 ? fmt::format("{}({}, {})", f, literal(step.scalar), element)
+                                                     : fmt::format("{}({}, {})", f, element, literal(step.scalar));
+            }
+
+            // index is the position in sum, prod, max, min, argmax, argmin, len
+            void emitReduce(const std::size_t &index, const std::string &range, const std::size_t &size,
+                            const bool &arguments) {
+                switch (index) {
+                    case 0:
+                        arguments ? accumulate(range, size, "PLUS_F", 0.0) : reduction(range, size, "sum");
+                        break;
+                    case 1:
+                        arguments ? accumulate(range, size, "MUL_F", 1.0) : reduction(range, size, "prod");
+                        break;
+                    case 2:
+                        arguments ? minmax(range, size, "GREATER_F") : pick(range, "max_element", false);
+                        break;
+                    case 3:
+                        arguments ? minmax(range, size, "LESS_F") : pick(range, "min_element", false);
+                        break;
+                    case 4:
+                        pick(range, "max_element", true);
+                        break;
+                    case 5:
+                        pick(range, "min_element", true);
+                        break;
+                    default:
+                        scalar(literal(static_cast<SCALAR>(size)));
+                }
+            }
+
+            void emitFused(const Instruction &instruction) {
+                using
+                enum OpCode;
+                const OpCode code = instruction.code;
+                const std::string immediate = literal(instruction.scalar);
+                if ((plus_sc_imm <= code) && (code <= pow_sc_imm)) {
+                    scalar(fmt::format("{}({}, {})", OPERATORS[distance(code, plus_sc_imm)], pop().name, immediate));
+                }
+                else if ((plus_imm_sc <= code) && (code <= pow_imm_sc)) {
+                    scalar(fmt::format("{}({}, {})", OPERATORS[distance(code, plus_imm_sc)], immediate, pop().name));
+                }
+                else if ((plus_sc_load <= code) && (code <= pow_sc_load)) {
+                    scalar(fmt::format("{}({}, parameters.scalar({}))", OPERATORS[distance(code, plus_sc_load)],
+                                       pop().name, instruction.offset));
+                }
+                else if (code == mul_add_sc) {
+                    const Value b = pop();
+                    const Value a = pop();
+                    scalar(fmt::format("{} + {} * {}", pop().name, a.name, b.name));
+                }
+                else if (code == mul_add_imm) {
+                    const Value b = pop();
+                    scalar(fmt::format("{} * {} + {}", pop().name, b.name, immediate));
+                }
+                else if (code == max_imm) {
+                    scalar(fmt::format("MAX_F({}, {})", pop().name, immediate));
+                }
+                else if (code == min_imm) {
+                    scalar(fmt::format("MIN_F({}, {})", pop().name, immediate));
+                }
+                else {
+                    assert(code == call_imm);
+                    scalar(fmt::format("CALL_F({}, {})", pop().name, immediate));
+                }
+            }
+
+            void pushResult(const Value &value) {
+                switch (value.type) {
+                    case CType::scalar:
+                        line(fmt::format("stacks.scalars().push_back({});", value.name));
+                        break;
+                    case CType::vector:
+                        line(fmt::format("stacks.vectors().insert(stacks.vectors().end(), std::begin({}), std::end({}));",
+                                         value.name, value.name));
+                        line(fmt::format("stacks.vectorSizes().push_back({});", value.size));
+                        break;
+                    case CType::date:
+                        line(fmt::format("stacks.dates().push_back({});", value.name));
+                        break;
+                    default:
+                        line(fmt::format(
+                            "stacks.datesLists().insert(stacks.datesLists().end(), std::begin({}), std::end({}));",
+                            value.name, value.name));
+                        line(fmt::format("stacks.dateListSizes().push_back({});", value.size));
+                }
+            }
+
+            const ByteCode &code_;
+
+            std::string body_;
+
+            std::vector<Value> values_;
+
+            // scalar locals by slot, vector locals by the complement of their offset
+            std::unordered_map<std::size_t, Value> locals_;
+
+            std::size_t next_{0};
+
+        };
+
+    }
+
+    std::string transpilePreamble() {
+        return "// generated by flexmc_transpile\n"
+               "#include <algorithm>\n"
+               "#include <array>\n"
+               "#include <iterator>\n"
+               "#include <limits>\n"
+               "\n"
+               "#include \"expression_stacks.h\"\n"
+               "#include \"parameters.h\"\n"
+               "#include \"kernels.h\"\n"
+               "#include \"reductions.h\"\n"
+               "#include \"vector_math_isa.h\"\n";
+    }
+
+    std::pair<MaybeError, std::string> transpile(const std::string &function_name, const ByteCode &code) {
+        MaybeError report;
+        const auto unsupported = std::ranges::find_if(code.instructions(), [](const Instruction &instruction) {
+            return isControlFlow(instruction.code);
+        });
+        if (unsupported != code.instructions().end()) {
+            report.setMessage(fmt::format("{}: instruction {} is script control flow, which cannot be transpiled",
+                                          function_name, std::distance(code.instructions().begin(), unsupported)));
+            return {report, {}};
+        }
+        std::string out = fmt::format(
+            "\nextern \"C\" void {}(flexMC::CalcStacks &stacks, [[maybe_unused]] const flexMC::Parameters &parameters,\n"
+            "    [[maybe_unused]] const flexMC::vectorMath::Kernels &vector_kernels) {{\n",
+            function_name);
+        out += "    using namespace flexMC::kernels;\n";
+        out += Emitter(code).body();
+        out += "}\n";
+        return {report, out};
+    }
+
+}
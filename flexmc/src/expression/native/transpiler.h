@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "language_error.h"
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    // Translates ByteCode into the C++ source of one straight-line function with the signature of NativeFunction,
+    // which pushes the same results onto the CalcStacks as the ByteCode. Every value becomes a local variable, vectors
+    // become arrays and shared values (see eliminateCommonSubexpressions) are plain variables used twice. EXP, LOG and
+    // POW of vectors call the vectorMath kernels passed as argument, the module references no symbol of the library.
+    // Script control flow (see isControlFlow) is not translated and reported as an error.
+    std::pair<MaybeError, std::string> transpile(const std::string &function_name, const ByteCode &code);
+
+    // includes needed by the functions returned from transpile, once per translation unit
+    std::string transpilePreamble();
+
+}
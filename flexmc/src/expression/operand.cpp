@@ -1,5 +1,6 @@
 #include <cassert>
-#include <stdexcept>
+#include <charconv>
+#include <system_error>
 #include <algorithm>
 #include <iterator>
 
@@ -11,10 +12,12 @@ namespace flexMC {
 
     double compileNumber(const Token &token, Operands &stacks, MaybeError &report) {
         double value_{1.0};
-        try {
-            value_ = std::stod(token.value);
-        } catch (const std::invalid_argument &error) {
-            report.setError(error.what(), token);
+        const auto [end, error] = std::from_chars(token.value.data(), token.value.data() + token.value.size(), value_);
+        if (error == std::errc::result_out_of_range) {
+            report.setError("Number out of range", token);
+        }
+        else if ((error != std::errc()) || (end != token.value.data() + token.value.size())) {
+            report.setError("Invalid number", token);
         }
         if (!report.isError()) {
             stacks.pushType(CType::scalar);
@@ -72,4 +75,15 @@ namespace flexMC {
         stacks.vectorSizes().push_back(size_);
     }
 
-}
+    void VectorAppend::operator()(BatchStacks &stacks) const {
+        // scalar i of the arguments becomes element i of the vector, the lanes stay in place
+        const std::size_t block = size_ * stacks.lanes();
+        assert(stacks.scalars().size() >= block);
+        const auto end = stacks.scalars().end();
+        const auto begin = end - static_cast<std::ptrdiff_t>(block);
+        stacks.vectors().insert(stacks.vectors().end(), begin, end);
+        stacks.scalars().erase(begin, end);
+        stacks.vectorSizes().push_back(size_);
+    }
+
+}
\ No newline at end of file
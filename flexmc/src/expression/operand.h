@@ -28,6 +28,8 @@ namespace flexMC {
 
         void operator()(CalcStacks &stacks) const;
 
+        void operator()(BatchStacks &stacks) const;
+
     private:
 
         const std::size_t size_;
@@ -3,6 +3,7 @@
 #include <fmt/format.h>
 
 #include "functions_real.h"
+#include "reductions.h"
 
 
 namespace flexMC::functionsReal {
@@ -25,75 +26,54 @@ namespace flexMC::functionsReal {
         return arg_type;
     }
 
-    std::string scalar::makeKey(const std::string &symbol, const CType &arg_type) {
-        return symbol + "_" + cType2Str(arg_type);
+    std::function<void(CalcStacks &)> reduceArguments::get(const Symbol &symbol, const std::size_t &size) {
+        assert(symbol != Symbol::len);
+        return FUNCTIONS[reduceFunctionIndex(symbol)](size);
     }
 
-    std::function<void(CalcStacks &)> scalar::get(const std::string_view key) {
-        const auto look_up = functionsReal::scalar::FUNCTIONS.find(key);
-        assert(look_up != FUNCTIONS.end());
-        return look_up->second;
-    }
+    namespace {
+
+        // replaces the top vector of a CalcStacks by reduce(begin, size)
+        template<class reduce_function>
+        void reduceTop(CalcStacks &stacks, reduce_function reduce) {
+            assert(!stacks.vectorSizes().empty());
+            const std::size_t s = stacks.vectorSizes().back();
+            assert(stacks.vectors().size() >= s);
+            const auto begin = stacks.vectors().end() - s;
+            const double res = reduce(stacks.vectors().data() + stacks.vectors().size() - s, s);
+            stacks.vectors().erase(begin, stacks.vectors().end());
+            stacks.vectorSizes().pop_back();
+            stacks.scalars().push_back(res);
+        }
 
-    std::function<void(CalcStacks &)> reduceVector::get(const std::string_view key) {
-        const auto look_up = reduceVector::FUNCTIONS.find(key);
-        assert(look_up != FUNCTIONS.end());
-        return look_up->second;
     }
 
-    std::function<void(CalcStacks &)> reduceArguments::get(const std::string_view key, const std::size_t &size) {
-        const auto look_up = reduceArguments::FUNCTIONS.find(key);
-        assert(look_up != reduceArguments::FUNCTIONS.end());
-        const std::function<void(CalcStacks &, const std::size_t &)> f = look_up->second;
-        return [f, size](CalcStacks &stacks) { return f(stacks, size); };
-    }
+    void reduceVector::sum(CalcStacks &stacks) { reduceTop(stacks, vectorMath::sum); }
+
+    void reduceVector::prod(CalcStacks &stacks) { reduceTop(stacks, vectorMath::prod); }
 
     void reduceVector::max(CalcStacks &stacks) {
-        assert(!stacks.vectorSizes().empty());
-        const std::size_t s = stacks.vectorSizes().back();
-        assert(stacks.vectors().size() >= s);
-        const auto end = stacks.vectors().end();
-        const auto begin = end - s;
-        const auto it = std::max_element(begin, end);
-        stacks.scalars().push_back(*it);
-        stacks.vectors().erase(begin, end);
-        stacks.vectorSizes().pop_back();
+        reduceTop(stacks, [](const SCALAR *begin, const std::size_t &size) {
+            return begin[vectorMath::argmax(begin, size)];
+        });
     }
 
     void reduceVector::min(CalcStacks &stacks) {
-        assert(!stacks.vectorSizes().empty());
-        const std::size_t s = stacks.vectorSizes().back();
-        assert(stacks.vectors().size() >= s);
-        const auto end = stacks.vectors().end();
-        const auto begin = end - s;
-        const auto it = std::min_element(begin, end);
-        stacks.scalars().push_back(*it);
-        stacks.vectors().erase(begin, end);
-        stacks.vectorSizes().pop_back();
+        reduceTop(stacks, [](const SCALAR *begin, const std::size_t &size) {
+            return begin[vectorMath::argmin(begin, size)];
+        });
     }
 
     void reduceVector::argmax(CalcStacks &stacks) {
-        assert(!stacks.vectorSizes().empty());
-        const std::size_t s = stacks.vectorSizes().back();
-        assert(stacks.vectors().size() >= s);
-        const auto end = stacks.vectors().end();
-        const auto begin = end - s;
-        const auto res = std::distance(begin, std::max_element(begin, end));
-        stacks.scalars().push_back(static_cast<double>(res));
-        stacks.vectors().erase(begin, end);
-        stacks.vectorSizes().pop_back();
+        reduceTop(stacks, [](const SCALAR *begin, const std::size_t &size) {
+            return static_cast<double>(vectorMath::argmax(begin, size));
+        });
     }
 
     void reduceVector::argmin(CalcStacks &stacks) {
-        assert(!stacks.vectorSizes().empty());
-        const std::size_t s = stacks.vectorSizes().back();
-        assert(stacks.vectors().size() >= s);
-        const auto end = stacks.vectors().end();
-        const auto begin = end - s;
-        const auto res = std::distance(begin, std::min_element(begin, end));
-        stacks.scalars().push_back(static_cast<double>(res));
-        stacks.vectors().erase(begin, end);
-        stacks.vectorSizes().pop_back();
+        reduceTop(stacks, [](const SCALAR *begin, const std::size_t &size) {
+            return static_cast<double>(vectorMath::argmin(begin, size));
+        });
     }
 
     void reduceVector::length(CalcStacks &stacks) {
@@ -123,4 +103,124 @@ namespace flexMC::functionsReal {
         stacks.scalars().push_back(static_cast<double>(res));
     }
 
+    namespace {
+
+        // Returns the per lane result of reducing the top vector of a BatchStacks with pick, where pick(next, found)
+        // decides whether next replaces the value found so far. Index is true for ARGMIN and ARGMAX.
+        template<class binary_function>
+        void pickVector(BatchStacks &stacks, binary_function pick, const bool &index) {
+            assert(!stacks.vectorSizes().empty());
+            const std::size_t n = stacks.lanes();
+            const std::size_t s = stacks.vectorSizes().back();
+            assert((s > 0) && (stacks.vectors().size() >= s * n));
+            const SCALAR *element = stacks.vectors().data() + stacks.vectors().size() - s * n;
+            std::vector<SCALAR> found(element, element + n);
+            std::vector<SCALAR> found_at(n, 0.0);
+            element += n;
+            for (std::size_t e{1}; e < s; ++e, element += n) {
+                for (std::size_t l{0}; l < n; ++l) {
+                    const bool replace = pick(element[l], found[l]);
+                    found[l] = replace ? element[l] : found[l];
+                    found_at[l] = replace ? static_cast<double>(e) : found_at[l];
+                }
+            }
+            stacks.vectors().resize(stacks.vectors().size() - s * n);
+            stacks.vectorSizes().pop_back();
+            stacks.pushScalarLanes(index ? found_at.data() : found.data());
+        }
+
+        template<class binary_function>
+        void pickArgument(BatchStacks &stacks, binary_function pick, const std::size_t &size) {
+            assert((size > 0) && (stacks.size(CType::scalar) >= size));
+            const std::size_t n = stacks.lanes();
+            std::vector<SCALAR> found(stacks.scalarLanes(size - 1), stacks.scalarLanes(size - 1) + n);
+            std::vector<SCALAR> found_at(n, 0.0);
+            for (std::size_t i{1}; i < size; ++i) {
+                const SCALAR *arg = stacks.scalarLanes(size - 1 - i);
+                for (std::size_t l{0}; l < n; ++l) {
+                    const bool replace = pick(arg[l], found[l]);
+                    found[l] = replace ? arg[l] : found[l];
+                    found_at[l] = replace ? static_cast<double>(i) : found_at[l];
+                }
+            }
+            stacks.scalars().resize(stacks.scalars().size() - size * n);
+            stacks.pushScalarLanes(found_at.data());
+        }
+
+        // Lane by lane in the order of reductions.h, the inner loops run over lanes. Slot k of the pairwise
+        // combination holds the n lanes slots[k * n, (k + 1) * n).
+        template<class binary_function>
+        void reduceLanes(BatchStacks &stacks, binary_function f, const SCALAR &init) {
+            using reductions::ACCUMULATORS;
+            using reductions::BLOCK;
+            assert(!stacks.vectorSizes().empty());
+            const std::size_t n = stacks.lanes();
+            const std::size_t s = stacks.vectorSizes().back();
+            assert(stacks.vectors().size() >= s * n);
+            const SCALAR *element = stacks.vectors().data() + stacks.vectors().size() - s * n;
+            std::vector<SCALAR> partial(ACCUMULATORS * n);
+            std::vector<SCALAR> slots;
+            reductions::PairwiseLevels levels;
+            const auto merge = [&slots, &f, &n](const std::size_t &left, const std::size_t &right) {
+                for (std::size_t l{0}; l < n; ++l) {
+                    slots[left * n + l] = f(slots[left * n + l], slots[right * n + l]);
+                }
+            };
+            for (std::size_t begin{0}; begin < s; begin += BLOCK) {
+                std::fill(partial.begin(), partial.end(), init);
+                for (std::size_t e{begin}; (e < s) && (e < begin + BLOCK); ++e, element += n) {
+                    SCALAR *accumulator = partial.data() + ((e - begin) % ACCUMULATORS) * n;
+                    for (std::size_t l{0}; l < n; ++l) {
+                        accumulator[l] = f(accumulator[l], element[l]);
+                    }
+                }
+                const std::size_t slot = levels.push();
+                slots.resize(std::max(slots.size(), (slot + 1) * n));
+                for (std::size_t l{0}; l < n; ++l) {
+                    slots[slot * n + l] = reductions::combineAccumulators(partial.data() + l, n, f);
+                }
+                levels.collapse(merge);
+            }
+            stacks.vectors().resize(stacks.vectors().size() - s * n);
+            stacks.vectorSizes().pop_back();
+            if (levels.empty()) {
+                stacks.pushScalar(init);
+                return;
+            }
+            levels.fold(merge);
+            stacks.pushScalarLanes(slots.data());
+        }
+
+    }
+
+    void reduceVector::sum(BatchStacks &stacks) { reduceLanes(stacks, kernels::PLUS_F, 0.0); }
+
+    void reduceVector::prod(BatchStacks &stacks) { reduceLanes(stacks, kernels::MUL_F, 1.0); }
+
+    // the strict comparisons keep the first occurrence like std::max_element and std::min_element
+    void reduceVector::max(BatchStacks &stacks) { pickVector(stacks, kernels::GREATER_F, false); }
+
+    void reduceVector::min(BatchStacks &stacks) { pickVector(stacks, kernels::LESS_F, false); }
+
+    void reduceVector::argmax(BatchStacks &stacks) { pickVector(stacks, kernels::GREATER_F, true); }
+
+    void reduceVector::argmin(BatchStacks &stacks) { pickVector(stacks, kernels::LESS_F, true); }
+
+    void reduceVector::length(BatchStacks &stacks) {
+        assert(!stacks.vectorSizes().empty());
+        const std::size_t s = stacks.vectorSizes().back();
+        assert(stacks.vectors().size() >= s * stacks.lanes());
+        stacks.vectors().resize(stacks.vectors().size() - s * stacks.lanes());
+        stacks.vectorSizes().pop_back();
+        stacks.pushScalar(static_cast<double>(s));
+    }
+
+    void reduceArguments::argMaxScalars(BatchStacks &stacks, const std::size_t &size) {
+        pickArgument(stacks, kernels::GREATER_F, size);
+    }
+
+    void reduceArguments::argMinScalars(BatchStacks &stacks, const std::size_t &size) {
+        pickArgument(stacks, kernels::LESS_F, size);
+    }
+
 }
\ No newline at end of file
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <functional>
-#include <numeric>
+#include <utility>
 
 #include "tokens.h"
 #include "calc_types.h"
 #include "language_error.h"
 #include "expression_stacks.h"
+#include "vector_math.h"
+#include "symbols.h"
+#include "kernels.h"
 
 // #include <iostream>
 
@@ -15,29 +20,9 @@ namespace flexMC::functionsReal {
 
     CType compileArgType(const Token &token, const CType &arg_type, MaybeError &report);
 
-    const std::vector<std::string> SYMBOLS_SCALAR{
-        EXP,
-        LOG,
-        ABS,
-        SQRT,
-        SQUARE,
-    };
-
-    const std::vector<std::string> SYMBOLS_REDUCE{
-        SUM,
-        PROD,
-        MAX,
-        MIN,
-        ARGMAX,
-        ARGMIN,
-        LEN,
-    };
-
     namespace scalar {
 
-        std::function<void(CalcStacks &)> get(const std::string_view key);
-
-        std::string makeKey(const std::string &symbol, const CType &arg_type);
+        using Kernel = void (*)(CalcStacks &stacks);
 
         using
         enum CType;
@@ -58,74 +43,93 @@ namespace flexMC::functionsReal {
             std::transform(begin, end, begin, f);
         }
 
-        const StringMap<std::function<void(CalcStacks &)>> FUNCTIONS{
-            {
-                makeKey(flexMC::EXP, scalar),
-                [capture0 = [](const double &val) { return std::exp(val); }](CalcStacks &stacks) {
-                    calculateScalar(stacks, capture0);
-                }
-            },
-            {
-                makeKey(flexMC::EXP, vector),
-                [capture0 = [](const double &val) { return std::exp(val); }](CalcStacks &stacks) {
-                    calculateVector(stacks, capture0);
-                }
-            },
-            {
-                makeKey(flexMC::LOG, scalar),
-                [capture0 = [](const double &val) { return std::log(val); }](CalcStacks &stacks) {
-                    calculateScalar(stacks, capture0);
-                }
-            },
-            {
-                makeKey(flexMC::LOG, vector),
-                [capture0 = [](const double &val) { return std::log(val); }](CalcStacks &stacks) {
-                    calculateVector(stacks, capture0);
-                }
-            },
-            {
-                makeKey(flexMC::ABS, scalar),
-                [capture0 = [](const double &val) { return std::fabs(val); }](CalcStacks &stacks) {
-                    calculateScalar(stacks, capture0);
-                }
-            },
-            {
-                makeKey(flexMC::ABS, vector),
-                [capture0 = [](const double &val) { return std::fabs(val); }](CalcStacks &stacks) {
-                    calculateVector(stacks, capture0);
-                }
-            },
-            {
-                makeKey(flexMC::SQRT, scalar),
-                [capture0 = [](const double &val) { return std::sqrt(val); }](CalcStacks &stacks) {
-                    calculateScalar(stacks, capture0);
-                }
-            },
+        template<class scalar_function>
+        void calculateScalar(BatchStacks &stacks, scalar_function f) {
+            assert(stacks.size(scalar) > 0);
+            SCALAR *arg = stacks.scalarLanes(0);
+            for (std::size_t l{0}; l < stacks.lanes(); ++l) {
+                arg[l] = f(arg[l]);
+            }
+        }
+
+        template<class scalar_function>
+        void calculateVector(BatchStacks &stacks, scalar_function f) {
+            assert(stacks.vectorSizes().size() > 0);
+            const std::size_t block = stacks.vectorSizes().back() * stacks.lanes();
+            assert(stacks.vectors().size() >= block);
+            SCALAR *arg = stacks.vectors().data() + stacks.vectors().size() - block;
+            for (std::size_t i{0}; i < block; ++i) {
+                arg[i] = f(arg[i]);
+            }
+        }
+
+        // array kernels (vectorMath) run in place on the vector on top of the stacks
+        template<class array_function>
+        void applyVectorKernel(CalcStacks &stacks, array_function f) {
+            assert(stacks.vectorSizes().size() > 0);
+            const std::size_t s = stacks.vectorSizes().back();
+            assert(stacks.vectors().size() >= s);
+            SCALAR *arg = stacks.vectors().data() + stacks.vectors().size() - s;
+            f(arg, arg, s);
+        }
+
+        template<class array_function>
+        void applyVectorKernel(BatchStacks &stacks, array_function f) {
+            assert(stacks.vectorSizes().size() > 0);
+            const std::size_t block = stacks.vectorSizes().back() * stacks.lanes();
+            assert(stacks.vectors().size() >= block);
+            SCALAR *arg = stacks.vectors().data() + stacks.vectors().size() - block;
+            f(arg, arg, block);
+        }
+
+        // slot version (RegisterCode), out may alias arg
+        template<class scalar_function>
+        void calculateVector(const SCALAR *arg, SCALAR *out, const std::size_t &size, scalar_function f) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = f(arg[i]);
+            }
+        }
+
+        template<class scalar_function>
+        constexpr std::array<Kernel, 2> elementKernels() {
+            return {
+                [](CalcStacks &stacks) { calculateScalar(stacks, scalar_function{}); },
+                [](CalcStacks &stacks) { calculateVector(stacks, scalar_function{}); },
+            };
+        }
+
+        // indexed by scalarFunctionIndex(symbol), operandIndex(arg_type)
+        constexpr std::array<std::array<Kernel, 2>, NUM_SCALAR_FUNCTIONS> FUNCTIONS{{
             {
-                makeKey(flexMC::SQRT, vector),
-                [capture0 = [](const double &val) { return std::sqrt(val); }](CalcStacks &stacks) {
-                    calculateVector(stacks, capture0);
-                }
+                [](CalcStacks &stacks) { calculateScalar(stacks, kernels::EXP_F); },
+                [](CalcStacks &stacks) { applyVectorKernel(stacks, vectorMath::exp); },
             },
             {
-                makeKey(flexMC::SQUARE, scalar),
-                [capture0 = [](const double &val) { return val * val; }](CalcStacks &stacks) {
-                    calculateScalar(stacks, capture0);
-                }
+                [](CalcStacks &stacks) { calculateScalar(stacks, kernels::LOG_F); },
+                [](CalcStacks &stacks) { applyVectorKernel(stacks, vectorMath::log); },
             },
+            elementKernels<decltype(kernels::ABS_F)>(),
             {
-                makeKey(flexMC::SQUARE, vector),
-                [capture0 = [](const double &val) { return val * val; }](CalcStacks &stacks) {
-                    calculateVector(stacks, capture0);
-                }
+                [](CalcStacks &stacks) { calculateScalar(stacks, kernels::SQRT_F); },
+                [](CalcStacks &stacks) { applyVectorKernel(stacks, vectorMath::sqrt); },
             },
-        };
+            elementKernels<decltype(kernels::SQUARE_F)>(),
+        }};
+
+        constexpr Kernel get(const Symbol &symbol, const CType &arg_type) {
+            return FUNCTIONS[scalarFunctionIndex(symbol)][operandIndex(arg_type)];
+        }
 
     }
 
     namespace reduceVector {
 
-        std::function<void(CalcStacks &)> get(const std::string_view key);
+        using Kernel = void (*)(CalcStacks &stacks);
+
+        // SUM and PROD follow the block and pairwise order of reductions.h
+        void sum(CalcStacks &stacks);
+
+        void prod(CalcStacks &stacks);
 
         void max(CalcStacks &stacks);
 
@@ -137,129 +141,254 @@ namespace flexMC::functionsReal {
 
         void length(CalcStacks &stacks);
 
-        template<class binary_function>
-        void accumulateVector(CalcStacks &stacks,
-                              binary_function f,
-                              double init) {
-            assert(!stacks.vectorSizes().empty());
-            const std::size_t s = stacks.vectorSizes().back();
-            assert(stacks.vectors().size() >= s);
-            const auto end = stacks.vectors().end();
-            const auto begin = end - s;
-            const double res = std::accumulate(begin, end, init, f);
-            stacks.vectors().erase(begin, end);
-            stacks.vectorSizes().pop_back();
-            stacks.scalars().push_back(res);
-        }
+        void sum(BatchStacks &stacks);
 
-        const StringMap<std::function<void(CalcStacks &)>> FUNCTIONS{
-            {
-                flexMC::SUM,
-                [capture0 = [](const double &left, const double &right) { return left + right; }](
-                    CalcStacks &stacks) { accumulateVector(stacks, capture0, 0.0); }
-            },
-            {
-                flexMC::PROD,
-                [capture0 = [](const double &left, const double &right) { return left * right; }](
-                    CalcStacks &stacks) { accumulateVector(stacks, capture0, 1.0); }
-            },
-            {
-                flexMC::MAX,
-                [](CalcStacks &stacks) { max(stacks); }
-            },
-            {
-                flexMC::MIN,
-                [](CalcStacks &stacks) { min(stacks); }
-            },
-            {
-                flexMC::ARGMAX,
-                [](CalcStacks &stacks) { argmax(stacks); }
-            },
-            {
-                flexMC::ARGMIN,
-                [](CalcStacks &stacks) { argmin(stacks); }
-            },
-            {
-                flexMC::LEN,
-                [](CalcStacks &stacks) { length(stacks); }
-            },
+        void prod(BatchStacks &stacks);
+
+        void max(BatchStacks &stacks);
+
+        void min(BatchStacks &stacks);
 
+        void argmax(BatchStacks &stacks);
+
+        void argmin(BatchStacks &stacks);
+
+        void length(BatchStacks &stacks);
+
+        // indexed by reduceFunctionIndex(symbol)
+        constexpr std::array<Kernel, NUM_REDUCE_FUNCTIONS> FUNCTIONS{
+            [](CalcStacks &stacks) { sum(stacks); },
+            [](CalcStacks &stacks) { prod(stacks); },
+            [](CalcStacks &stacks) { max(stacks); },
+            [](CalcStacks &stacks) { min(stacks); },
+            [](CalcStacks &stacks) { argmax(stacks); },
+            [](CalcStacks &stacks) { argmin(stacks); },
+            [](CalcStacks &stacks) { length(stacks); },
         };
 
+        constexpr Kernel get(const Symbol &symbol) { return FUNCTIONS[reduceFunctionIndex(symbol)]; }
+
     }
 
     namespace reduceArguments {
 
-        std::function<void(CalcStacks &)> get(const std::string_view key, const std::size_t &size);
+        std::function<void(CalcStacks &)> get(const Symbol &symbol, const std::size_t &size);
 
         void argMaxScalars(CalcStacks &stacks, const std::size_t &size);
 
         void argMinScalars(CalcStacks &stacks, const std::size_t &size);
 
+        void argMaxScalars(BatchStacks &stacks, const std::size_t &size);
+
+        void argMinScalars(BatchStacks &stacks, const std::size_t &size);
+
+        // argument counts with an unrolled kernel, more arguments are reduced in a loop
+        constexpr std::size_t MAX_UNROLLED{8};
+
+        // The arguments are the slice args[0, size) of the scalar stack, reduced from the last argument to the first.
+        template<std::size_t size, class binary_function>
+        SCALAR accumulateUnrolled(const SCALAR *args, binary_function f, SCALAR init) {
+            [&]<std::size_t... i>(std::index_sequence<i...>) {
+                ((init = f(init, args[size - 1 - i])), ...);
+            }(std::make_index_sequence<size>());
+            return init;
+        }
+
+        // pick(next, found) decides whether next replaces the value found so far
+        template<std::size_t size, class binary_function>
+        SCALAR pickUnrolled(const SCALAR *args, binary_function pick) {
+            SCALAR found = args[size - 1];
+            [&]<std::size_t... i>(std::index_sequence<i...>) {
+                ((found = pick(args[size - 2 - i], found) ? args[size - 2 - i] : found), ...);
+            }(std::make_index_sequence<size - 1>());
+            return found;
+        }
+
+        // unrolled.template operator()<size>() for 0 < size <= MAX_UNROLLED, loop() otherwise
+        template<class unrolled_function, class loop_function>
+        SCALAR dispatchUnrolled(const std::size_t &size, unrolled_function unrolled, loop_function loop) {
+            SCALAR result{0.0};
+            const bool done = [&]<std::size_t... n>(std::index_sequence<n...>) {
+                return ((size == n + 1 ? (result = unrolled.template operator()<n + 1>(), true) : false) || ...);
+            }(std::make_index_sequence<MAX_UNROLLED>());
+            return done ? result : loop();
+        }
+
+        template<class binary_function>
+        SCALAR accumulateLoop(const SCALAR *args, const std::size_t &size, binary_function f, SCALAR init) {
+            for (std::size_t i{size}; i-- > 0;) {
+                init = f(init, args[i]);
+            }
+            return init;
+        }
+
+        // size > 0
+        template<class binary_function>
+        SCALAR pickLoop(const SCALAR *args, const std::size_t &size, binary_function pick) {
+            SCALAR found = args[size - 1];
+            for (std::size_t i{size - 1}; i-- > 0;) {
+                found = pick(args[i], found) ? args[i] : found;
+            }
+            return found;
+        }
+
+        // slice version for a size only known at evaluation (ByteCode, RegisterCode)
+        template<class binary_function>
+        SCALAR accumulateArguments(const SCALAR *args, const std::size_t &size, binary_function f, SCALAR init) {
+            return dispatchUnrolled(size, [&]<std::size_t unrolled>() {
+                return accumulateUnrolled<unrolled>(args, f, init);
+            }, [&]() { return accumulateLoop(args, size, f, init); });
+        }
+
+        // size > 0
+        template<class binary_function>
+        SCALAR pickArguments(const SCALAR *args, const std::size_t &size, binary_function pick) {
+            return dispatchUnrolled(size, [&]<std::size_t unrolled>() {
+                return pickUnrolled<unrolled>(args, pick);
+            }, [&]() { return pickLoop(args, size, pick); });
+        }
+
+        // reduce(args) of the top size scalars replaces them in place
+        template<class slice_function>
+        void replaceArguments(CalcStacks &stacks, const std::size_t &size, slice_function reduce) {
+            assert(stacks.size(CType::scalar) >= size);
+            std::vector<SCALAR> &scalars = stacks.scalars();
+            const std::size_t first = scalars.size() - size;
+            const SCALAR res = reduce(scalars.data() + first);
+            scalars.resize(first + 1);
+            scalars.back() = res;
+        }
+
         template<class binary_function>
         void accumulate(CalcStacks &stacks,
                         binary_function f,
                         double init,
                         const std::size_t &size) {
-            assert(stacks.size(CType::scalar) >= size);
-            for (size_t i{0}; i < size; ++i) {
-                init = f(init, stacks.scalars().back());
-                stacks.scalars().pop_back();
-            }
-            stacks.scalars().push_back(init);
+            replaceArguments(stacks, size, [&](const SCALAR *args) {
+                return accumulateArguments(args, size, f, init);
+            });
         }
 
         template<class binary_function>
         void minmax(CalcStacks &stacks,
                     binary_function f,
                     const std::size_t &size) {
+            assert(size > 0);
+            replaceArguments(stacks, size, [&](const SCALAR *args) { return pickArguments(args, size, f); });
+        }
+
+        // Lanes are reduced in the lanes of the last argument, argument after argument, and moved to the first one
+        template<class binary_function>
+        void accumulate(BatchStacks &stacks,
+                        binary_function f,
+                        double init,
+                        const std::size_t &size) {
             assert(stacks.size(CType::scalar) >= size);
-            double found = stacks.scalars().back();
-            stacks.scalars().pop_back();
+            if (size == 0) {
+                stacks.pushScalar(init);
+                return;
+            }
+            const std::size_t n = stacks.lanes();
+            SCALAR *res = stacks.scalarLanes(0);
+            for (std::size_t l{0}; l < n; ++l) {
+                res[l] = f(init, res[l]);
+            }
             for (size_t i{1}; i < size; ++i) {
-                const double next = stacks.scalars().back();
-                if (f(next, found)) {
-                    found = next;
+                const SCALAR *arg = stacks.scalarLanes(i);
+                for (std::size_t l{0}; l < n; ++l) {
+                    res[l] = f(res[l], arg[l]);
                 }
-                stacks.scalars().pop_back();
             }
-            stacks.scalars().push_back(found);
+            if (size > 1) {
+                std::copy_n(res, n, stacks.scalarLanes(size - 1));
+                stacks.scalars().resize(stacks.scalars().size() - (size - 1) * n);
+            }
         }
 
-        const StringMap<std::function<void(CalcStacks &, const std::size_t &size)>> FUNCTIONS{
-            {
-                flexMC::SUM,
-                [capture0 = [](const double &left, const double &right) { return left + right; }](CalcStacks &stacks,
-                                                                                                  const std::size_t &size) {
-                    accumulate(stacks, capture0, 0.0, size);
+        template<class binary_function>
+        void minmax(BatchStacks &stacks,
+                    binary_function f,
+                    const std::size_t &size) {
+            assert((size > 0) && (stacks.size(CType::scalar) >= size));
+            const std::size_t n = stacks.lanes();
+            SCALAR *res = stacks.scalarLanes(0);
+            for (size_t i{1}; i < size; ++i) {
+                const SCALAR *next = stacks.scalarLanes(i);
+                for (std::size_t l{0}; l < n; ++l) {
+                    res[l] = f(next[l], res[l]) ? next[l] : res[l];
                 }
+            }
+            if (size > 1) {
+                std::copy_n(res, n, stacks.scalarLanes(size - 1));
+                stacks.scalars().resize(stacks.scalars().size() - (size - 1) * n);
+            }
+        }
+
+        using Kernel = void (*)(CalcStacks &stacks);
+
+        // The kernel for size arguments, chosen once when the expression is compiled: the instantiation
+        // unrolled_function{}.template operator()<size>(args) for 0 < size <= MAX_UNROLLED, a closure calling
+        // loop(args, size) otherwise.
+        template<class unrolled_function, class loop_function>
+        std::function<void(CalcStacks &)> selectUnrolled(const std::size_t &size, loop_function loop) {
+            constexpr auto UNROLLED = []<std::size_t... n>(std::index_sequence<n...>) {
+                return std::array<Kernel, MAX_UNROLLED>{
+                    [](CalcStacks &stacks) {
+                        replaceArguments(stacks, n + 1, [](const SCALAR *args) {
+                            return unrolled_function{}.template operator()<n + 1>(args);
+                        });
+                    }...
+                };
+            }(std::make_index_sequence<MAX_UNROLLED>());
+            if ((size > 0) && (size <= MAX_UNROLLED)) {
+                return UNROLLED[size - 1];
+            }
+            return [size, loop](CalcStacks &stacks) {
+                replaceArguments(stacks, size, [&](const SCALAR *args) { return loop(args, size); });
+            };
+        }
+
+        // the kernel of a symbol for a given number of arguments
+        using Factory = std::function<void(CalcStacks &)> (*)(const std::size_t &size);
+
+        // indexed by reduceFunctionIndex(symbol), LEN has no argument version
+        constexpr std::array<Factory, NUM_REDUCE_FUNCTIONS - 1> FUNCTIONS{
+            [](const std::size_t &size) {
+                return selectUnrolled<decltype([]<std::size_t n>(const SCALAR *args) {
+                    return accumulateUnrolled<n>(args, kernels::PLUS_F, 0.0);
+                })>(size, [](const SCALAR *args, const std::size_t &n) {
+                    return accumulateLoop(args, n, kernels::PLUS_F, 0.0);
+                });
             },
-            {
-                flexMC::PROD,
-                [capture0 = [](const double &left, const double &right) { return left * right; }](CalcStacks &stacks,
-                                                                                                  const std::size_t &size) {
-                    accumulate(stacks, capture0, 1.0, size);
-                }
+            [](const std::size_t &size) {
+                return selectUnrolled<decltype([]<std::size_t n>(const SCALAR *args) {
+                    return accumulateUnrolled<n>(args, kernels::MUL_F, 1.0);
+                })>(size, [](const SCALAR *args, const std::size_t &n) {
+                    return accumulateLoop(args, n, kernels::MUL_F, 1.0);
+                });
             },
-            {
-                flexMC::MAX,
-                [capture0 = [](const double &left, const double &right) { return left > right ? true : false; }](
-                    CalcStacks &stacks, const std::size_t &size) { minmax(stacks, capture0, size); }
+            [](const std::size_t &size) {
+                assert(size > 0);
+                return selectUnrolled<decltype([]<std::size_t n>(const SCALAR *args) {
+                    return pickUnrolled<n>(args, kernels::GREATER_F);
+                })>(size, [](const SCALAR *args, const std::size_t &n) {
+                    return pickLoop(args, n, kernels::GREATER_F);
+                });
             },
-            {
-                flexMC::MIN,
-                [capture0 = [](const double &left, const double &right) { return left < right ? true : false; }](
-                    CalcStacks &stacks, const std::size_t &size) { minmax(stacks, capture0, size); }
+            [](const std::size_t &size) {
+                assert(size > 0);
+                return selectUnrolled<decltype([]<std::size_t n>(const SCALAR *args) {
+                    return pickUnrolled<n>(args, kernels::LESS_F);
+                })>(size, [](const SCALAR *args, const std::size_t &n) {
+                    return pickLoop(args, n, kernels::LESS_F);
+                });
             },
-            {
-                flexMC::ARGMAX,
-                [](CalcStacks &stacks, const size_t &size) { argMaxScalars(stacks, size); }
+            [](const std::size_t &size) -> std::function<void(CalcStacks &)> {
+                return [size](CalcStacks &stacks) { argMaxScalars(stacks, size); };
             },
-            {
-                flexMC::ARGMIN,
-                [](CalcStacks &stacks, const size_t &size) { argMinScalars(stacks, size); }
+            [](const std::size_t &size) -> std::function<void(CalcStacks &)> {
+                return [size](CalcStacks &stacks) { argMinScalars(stacks, size); };
             },
-
         };
 
     }
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cmath>
+
+// Element functions shared by the operator tables of operatorsCalc and the ByteCode, RegisterCode and JIT dispatch
+
+
+namespace flexMC::kernels {
+
+    constexpr auto PLUS_F = [](const double &left, const double &right) { return left + right; };
+    constexpr auto MINUS_F = [](const double &left, const double &right) { return left - right; };
+    constexpr auto MUL_F = [](const double &left, const double &right) { return left * right; };
+    constexpr auto DIV_F = [](const double &left, const double &right) { return left / right; };
+    constexpr auto POW_F = [](const double &left, const double &right) { return std::pow(left, right); };
+    // comparisons and logical operators produce 1.0 or 0.0 without a branch, any value but 0.0 is true
+    constexpr auto LT_F = [](const double &left, const double &right) { return static_cast<double>(left < right); };
+    constexpr auto GT_F = [](const double &left, const double &right) { return static_cast<double>(left > right); };
+    constexpr auto LE_F = [](const double &left, const double &right) { return static_cast<double>(left <= right); };
+    constexpr auto GE_F = [](const double &left, const double &right) { return static_cast<double>(left >= right); };
+    constexpr auto AND_F = [](const double &left, const double &right) {
+        return static_cast<double>((left != 0.0) & (right != 0.0));
+    };
+    constexpr auto OR_F = [](const double &left, const double &right) {
+        return static_cast<double>((left != 0.0) | (right != 0.0));
+    };
+    constexpr auto GREATER_F = [](const double &left, const double &right) { return left > right; };
+    constexpr auto LESS_F = [](const double &left, const double &right) { return left < right; };
+
+    // MAX and MIN of two arguments, equal to reduceArguments::minmax with right pushed last
+    constexpr auto MAX_F = [](const double &left, const double &right) { return left > right ? left : right; };
+    constexpr auto MIN_F = [](const double &left, const double &right) { return left < right ? left : right; };
+    // MAX(left - right, 0)
+    constexpr auto CALL_F = [](const double &left, const double &right) {
+        const double diff = left - right;
+        return diff > 0.0 ? diff : 0.0;
+    };
+
+    constexpr auto NEG_F = [](const double &val) { return -val; };
+    constexpr auto NOT_F = [](const double &val) { return static_cast<double>(val == 0.0); };
+    constexpr auto EXP_F = [](const double &val) { return std::exp(val); };
+    constexpr auto LOG_F = [](const double &val) { return std::log(val); };
+    constexpr auto ABS_F = [](const double &val) { return std::fabs(val); };
+    constexpr auto SQRT_F = [](const double &val) { return std::sqrt(val); };
+    constexpr auto SQUARE_F = [](const double &val) { return val * val; };
+
+}
@@ -8,27 +8,56 @@
 #include "operation_compiler.h"
 
 namespace flexMC {
+
+    Operation compileOperation(const CallSignature &signature) {
+        using
+        enum CallSignature::Kind;
+        switch (signature.kind) {
+            case unary:
+                return Operation(operatorsCalc::unary::get(signature.symbol, signature.left_t));
+            case binary:
+                return Operation(operatorsCalc::binary::get(signature.symbol, signature.left_t, signature.right_t));
+            case scalar_function:
+                return Operation(functionsReal::scalar::get(signature.symbol, signature.left_t));
+            case reduce_vector:
+                return Operation(functionsReal::reduceVector::get(signature.symbol));
+            case reduce_arguments:
+                return Operation(functionsReal::reduceArguments::get(signature.symbol, signature.num_args));
+            default:
+                assert(false);
+                return Operation(std::function<void(CalcStacks &)>({}));
+        }
+    }
+
     Operation functionCompiler::compile(const std::size_t &num_args, Operands &stacks, MaybeError &report) {
+        const CallSignature signature = resolve(num_args, stacks, report);
+        if (report.isError()) {
+            return Operation(std::function<void(CalcStacks &)>({}));
+        }
+        return compileOperation(signature);
+    }
+
+    CallSignature functionCompiler::resolve(const std::size_t &num_args, Operands &stacks, MaybeError &report) {
         assert(stacks.fSize() > 0);
         const Token fun = stacks.funcsBack();
 
-        using namespace functionsReal;
-        const auto is_scalar = std::ranges::find(SYMBOLS_SCALAR, fun.value) != SYMBOLS_SCALAR.cend();
-        const auto is_reduce = std::ranges::find(SYMBOLS_REDUCE, fun.value) != SYMBOLS_REDUCE.cend();
+        const Symbol symbol = toSymbol(fun.value);
+        const auto is_scalar = isScalarFunction(symbol);
+        const auto is_reduce = isReduceFunction(symbol);
         assert(is_scalar || is_reduce);
 
         stacks.popFunc();
         if (is_scalar) {
-            return functionCompiler::detail::compileScalar(fun, num_args, stacks, report);
+            return functionCompiler::detail::resolveScalar(fun, num_args, stacks, report);
         }
         if (is_reduce) {
-            return functionCompiler::detail::compileReduce(fun, num_args, stacks, report);
+            return functionCompiler::detail::resolveReduce(fun, num_args, stacks, report);
         }
-        return Operation(std::function<void(CalcStacks &)>{});
+        return {};
     }
 
-    Operation
-    functionCompiler::detail::compileScalar(const Token &function,
+    CallSignature
+    functionCompiler::detail::resolveScalar(const Token &function,
                                             const std::size_t &num_args,
                                             const Operands &stacks,
                                             MaybeError &report) {
@@ -36,19 +65,18 @@ namespace flexMC {
         const CType arg_type = stacks.tSize() > 0 ? stacks.typesBack() : CType::scalar;
         assertNumberOfArgs(function, 1, num_args, arg_type, report);
         if (report.isError()) {
-            return Operation(std::function<void(CalcStacks &)>({}));
+            return {};
         }
         const CType return_type = functionsReal::compileArgType(function, arg_type, report);
         if (report.isError()) {
-            return Operation(std::function<void(CalcStacks &)>({}));
+            return {};
         }
-        const std::string key = functionsReal::scalar::makeKey(function.value, return_type);
-        const std::function<void(CalcStacks &)> call_back = functionsReal::scalar::get(key);
-        return Operation(call_back);
+        return {CallSignature::Kind::scalar_function, toSymbol(function.value), return_type, CType::undefined,
+                num_args};
     }
 
-    Operation
-    functionCompiler::detail::compileReduce(const Token &function,
+    CallSignature
+    functionCompiler::detail::resolveReduce(const Token &function,
                                             const std::size_t &num_args,
                                             Operands &stacks,
                                             MaybeError &report) {
@@ -58,24 +86,24 @@ namespace flexMC {
         const CType dummy_arg_type = stacks.tSize() > 0 ? stacks.typesBack() : scalar;
         assertNumberOfArgs(function, 1, 0, num_args, dummy_arg_type, report);
         if (report.isError()) {
-            return Operation(std::function<void(CalcStacks &)>({}));
+            return {};
         }
         const CType arg_type = functionsReal::compileArgType(function, stacks.typesBack(), report);
         if (report.isError()) {
-            return Operation(std::function<void(CalcStacks &)>({}));
+            return {};
         }
         stacks.popType();
         if (arg_type == scalar) {
             assertNumberOfArgs(function, 2, 0, num_args, arg_type, report);
             if (report.isError()) {
-                return Operation(std::function<void(CalcStacks &)>({}));
+                return {};
             }
             for (size_t i{2}; i <= num_args; ++i) {
                 if (stacks.typesBack() != scalar) {
                     std::string msg = fmt::format(R"(Function "{}" cannot take both <Vector> and <Scalar> arguments)",
                                                   function.value);
                     report.setMessage(msg);
-                    return Operation(std::function<void(CalcStacks &)>({}));
+                    return {};
                 }
                 stacks.popType();
             }
@@ -83,14 +111,15 @@ namespace flexMC {
         else {
             assertNumberOfArgs(function, 1, num_args, arg_type, report);
             if (report.isError()) {
-                return Operation(std::function<void(CalcStacks &)>({}));
+                return {};
             }
         }
         stacks.pushType(scalar);
         if (arg_type == scalar) {
-            return Operation(functionsReal::reduceArguments::get(function.value, num_args));
+            return {CallSignature::Kind::reduce_arguments, toSymbol(function.value), arg_type, CType::undefined,
+                    num_args};
         }
-        return Operation(functionsReal::reduceVector::get(function.value));
+        return {CallSignature::Kind::reduce_vector, toSymbol(function.value), arg_type, CType::undefined, num_args};
     }
 
     void functionCompiler::assertNumberOfArgs(const Token &function,
@@ -131,30 +160,37 @@ namespace flexMC {
     }
 
     Operation operatorCompiler::compile(const Token &token, Operands &stacks, MaybeError &report) {
-        if (token.context.is_infix && operatorsCalc::isBinarySymbol(token.value)) {
-            const std::string key = operatorsCalc::binary::compileArgumentsAndKey(token.value, stacks, report);
+        const CallSignature signature = resolve(token, stacks, report);
+        if (report.isError()) {
+            return Operation(std::function<void(CalcStacks &)>({}));
+        }
+        return compileOperation(signature);
+    }
+
+    CallSignature operatorCompiler::resolve(const Token &token, Operands &stacks, MaybeError &report) {
+        using
+        enum CType;
+        const Symbol symbol = toSymbol(token.value);
+        if (token.context.is_infix && isOperator(symbol)) {
+            const auto [left_t, right_t] = operatorsCalc::binary::compileArguments(token.value, stacks, report);
             if (report.isError()) {
                 report.setPosition(token.start, token.size);
-                return Operation(std::function<void(CalcStacks &)>({}));
+                return {};
             }
-            const std::function<void(CalcStacks &)> call_back = operatorsCalc::binary::get(key);
-            return Operation(call_back);
+            return {CallSignature::Kind::binary, symbol, left_t, right_t, 2};
         }
-        if (token.context.is_prefix && operatorsCalc::isBinarySymbol(token.value)) {
-            // reports error if symbol != MINUS, expression compiler ignores PLUS before
+        if (token.context.is_prefix && (isOperator(symbol) || isPrefixOperator(symbol))) {
+            // reports error unless symbol is MINUS or NOT, expression compiler ignores PLUS before
             const CType t = operatorsCalc::unary::compileArgument(token.value, stacks, report);
             if (report.isError()) {
                 report.setPosition(token.start, token.size);
-                return Operation(std::function<void(CalcStacks &)>({}));
-            }
-            assert(t == CType::scalar || t == CType::vector);
-            if (t == CType::scalar) {
-                return Operation(std::function<void(CalcStacks &)>(operatorsCalc::unary::scMinus));
+                return {};
             }
-            return Operation(std::function<void(CalcStacks &)>(operatorsCalc::unary::vecMinus));
+            assert(t == scalar || t == vector);
+            return {CallSignature::Kind::unary, symbol, t, undefined, 1};
         }
         report.setError("Internal Error: Unknown operator", token.start, 1);
-        return Operation(std::function<void(CalcStacks &)>({}));
+        return {};
     }
 
 }
\ No newline at end of file
@@ -1,27 +1,60 @@
 #pragma once
 
+#include <string>
+
 #include "tokens.h"
 #include "calc_types.h"
 #include "language_error.h"
 #include "expression_stacks.h"
+#include "symbols.h"
 
 namespace flexMC {
 
+    // Outcome of type checking a function call or an operator, independent of the backend (Operation or ByteCode)
+    // that is compiled from it.
+    struct CallSignature {
+
+        enum class Kind {
+            undefined,
+            unary,
+            binary,
+            scalar_function,
+            reduce_vector,
+            reduce_arguments
+        };
+
+        Kind kind{Kind::undefined};
+
+        Symbol symbol{Symbol::undefined};
+
+        // Operand type of unary operators and functions, left operand type of binary operators
+        CType left_t{CType::undefined};
+
+        CType right_t{CType::undefined};
+
+        std::size_t num_args{0};
+
+    };
+
+    Operation compileOperation(const CallSignature &signature);
+
     namespace functionCompiler {
 
         Operation compile(const std::size_t &num_args, Operands &stacks, MaybeError &report);
 
+        CallSignature resolve(const std::size_t &num_args, Operands &stacks, MaybeError &report);
+
         namespace detail {
 
-            Operation compileScalar(const Token &token,
-                                    const std::size_t &num_args,
-                                    const Operands &stacks,
-                                    MaybeError &report);
+            CallSignature resolveScalar(const Token &token,
+                                        const std::size_t &num_args,
+                                        const Operands &stacks,
+                                        MaybeError &report);
 
-            Operation compileReduce(const Token &token,
-                                    const std::size_t &num_args,
-                                    Operands &stacks,
-                                    MaybeError &report);
+            CallSignature resolveReduce(const Token &token,
+                                        const std::size_t &num_args,
+                                        Operands &stacks,
+                                        MaybeError &report);
 
         }
 
@@ -43,7 +76,11 @@ namespace flexMC {
     }
 
     namespace operatorCompiler {
+
         Operation compile(const Token &token, Operands &stacks, MaybeError &report);
+
+        CallSignature resolve(const Token &token, Operands &stacks, MaybeError &report);
+
     }
 
 }
\ No newline at end of file
@@ -7,16 +7,11 @@
 
 namespace flexMC {
 
-    bool operatorsCalc::isBinarySymbol(const std::string &symbol) {
-        auto look_up = std::ranges::find(operatorsCalc::binary::symbols, symbol);
-        return look_up != operatorsCalc::binary::symbols.end();
-    }
-
-    CType operatorsCalc::unary::compileArgument(const std::string &symbol, const Operands &stacks, MaybeError &report) {
+    CType operatorsCalc::unary::compileArgument(const std::string_view &symbol, const Operands &stacks, MaybeError &report) {
         using
         enum CType;
         assert(stacks.tSize() >= 1);
-        if (symbol != flexMC::MINUS) {
+        if ((symbol != flexMC::MINUS) && (symbol != flexMC::NOT)) {
             auto msg = fmt::format(R"(Undefined: trying to compile unary operator for symbol "{}")", symbol);
             report.setMessage(msg);
             return undefined;
@@ -45,11 +40,133 @@ namespace flexMC {
         assert(stacks.vectors().size() >= s);
         const auto end = stacks.vectors().end();
         const auto begin = end - s;
-        std::transform(begin, end, begin, std::negate<double>());
+        std::transform(begin, end, begin, kernels::NEG_F);
+    }
+
+    void operatorsCalc::unary::scMinus(BatchStacks &stacks) {
+        assert(stacks.size(CType::scalar) >= 1);
+        SCALAR *arg = stacks.scalarLanes(0);
+        std::transform(arg, arg + stacks.lanes(), arg, kernels::NEG_F);
+    }
+
+    void operatorsCalc::unary::vecMinus(BatchStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 0);
+        const std::size_t block = stacks.vectorSizes().back() * stacks.lanes();
+        assert(stacks.vectors().size() >= block);
+        const auto end = stacks.vectors().end();
+        std::transform(end - static_cast<std::ptrdiff_t>(block), end, end - static_cast<std::ptrdiff_t>(block),
+                       kernels::NEG_F);
+    }
+
+    void operatorsCalc::unary::scNot(CalcStacks &stacks) {
+        assert(stacks.size(CType::scalar) >= 1);
+        stacks.scalars().back() = kernels::NOT_F(stacks.scalars().back());
     }
 
-    std::string
-    operatorsCalc::binary::compileArgumentsAndKey(const std::string &symbol, Operands &stacks, MaybeError &report) {
+    void operatorsCalc::unary::vecNot(CalcStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 0);
+        const std::size_t s = stacks.vectorSizes().back();
+        assert(stacks.vectors().size() >= s);
+        const auto end = stacks.vectors().end();
+        std::transform(end - static_cast<std::ptrdiff_t>(s), end, end - static_cast<std::ptrdiff_t>(s), kernels::NOT_F);
+    }
+
+    void operatorsCalc::unary::scNot(BatchStacks &stacks) {
+        assert(stacks.size(CType::scalar) >= 1);
+        SCALAR *arg = stacks.scalarLanes(0);
+        std::transform(arg, arg + stacks.lanes(), arg, kernels::NOT_F);
+    }
+
+    void operatorsCalc::unary::vecNot(BatchStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 0);
+        const std::size_t block = stacks.vectorSizes().back() * stacks.lanes();
+        assert(stacks.vectors().size() >= block);
+        const auto end = stacks.vectors().end();
+        std::transform(end - static_cast<std::ptrdiff_t>(block), end, end - static_cast<std::ptrdiff_t>(block),
+                       kernels::NOT_F);
+    }
+
+    operatorsCalc::unary::Kernel operatorsCalc::unary::get(const Symbol &symbol, const CType &type) {
+        assert(isPrefixOperator(symbol));
+        if (symbol == Symbol::not_) {
+            return type == CType::scalar ? static_cast<Kernel>(scNot) : static_cast<Kernel>(vecNot);
+        }
+        return type == CType::scalar ? static_cast<Kernel>(scMinus) : static_cast<Kernel>(vecMinus);
+    }
+
+    void operatorsCalc::binary::powScVec(CalcStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 0);
+        const std::size_t s = stacks.vectorSizes().back();
+        assert(stacks.vectors().size() >= s);
+        SCALAR *right = stacks.vectors().data() + stacks.vectors().size() - s;
+        vectorMath::pow(stacks.scalars().back(), right, right, s);
+        stacks.scalars().pop_back();
+    }
+
+    void operatorsCalc::binary::powVecSc(CalcStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 0);
+        const std::size_t s = stacks.vectorSizes().back();
+        assert(stacks.vectors().size() >= s);
+        SCALAR *left = stacks.vectors().data() + stacks.vectors().size() - s;
+        vectorMath::pow(left, stacks.scalars().back(), left, s);
+        stacks.scalars().pop_back();
+    }
+
+    void operatorsCalc::binary::powVecVec(CalcStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 1);
+        const std::size_t s = stacks.vectorSizes().back();
+        stacks.vectorSizes().pop_back();
+        assert(stacks.vectorSizes().back() == s);
+        assert(stacks.vectors().size() >= s + s);
+        const SCALAR *right = stacks.vectors().data() + stacks.vectors().size() - s;
+        SCALAR *left = stacks.vectors().data() + stacks.vectors().size() - s - s;
+        vectorMath::pow(left, right, left, s);
+        stacks.vectors().resize(stacks.vectors().size() - s);
+    }
+
+    // the scalar operand differs between lanes, each vector element is a lane-wise vector-vector POW
+
+    void operatorsCalc::binary::powScVec(BatchStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 0);
+        const std::size_t n = stacks.lanes();
+        const std::size_t s = stacks.vectorSizes().back();
+        assert(stacks.vectors().size() >= s * n);
+        const SCALAR *left = stacks.scalarLanes(0);
+        SCALAR *right = stacks.vectors().data() + stacks.vectors().size() - s * n;
+        for (std::size_t e{0}; e < s; ++e, right += n) {
+            vectorMath::pow(left, right, right, n);
+        }
+        stacks.scalars().resize(stacks.scalars().size() - n);
+    }
+
+    void operatorsCalc::binary::powVecSc(BatchStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 0);
+        const std::size_t n = stacks.lanes();
+        const std::size_t s = stacks.vectorSizes().back();
+        assert(stacks.vectors().size() >= s * n);
+        const SCALAR *right = stacks.scalarLanes(0);
+        SCALAR *left = stacks.vectors().data() + stacks.vectors().size() - s * n;
+        for (std::size_t e{0}; e < s; ++e, left += n) {
+            vectorMath::pow(left, right, left, n);
+        }
+        stacks.scalars().resize(stacks.scalars().size() - n);
+    }
+
+    void operatorsCalc::binary::powVecVec(BatchStacks &stacks) {
+        assert(stacks.vectorSizes().size() > 1);
+        const std::size_t s = stacks.vectorSizes().back();
+        stacks.vectorSizes().pop_back();
+        assert(stacks.vectorSizes().back() == s);
+        const std::size_t block = s * stacks.lanes();
+        assert(stacks.vectors().size() >= block + block);
+        const SCALAR *right = stacks.vectors().data() + stacks.vectors().size() - block;
+        SCALAR *left = stacks.vectors().data() + stacks.vectors().size() - block - block;
+        vectorMath::pow(left, right, left, block);
+        stacks.vectors().resize(stacks.vectors().size() - block);
+    }
+
+    std::pair<CType, CType>
+    operatorsCalc::binary::compileArguments(const std::string_view &symbol, Operands &stacks, MaybeError &report) {
         using
         enum CType;
         assert(stacks.tSize() >= 2);
@@ -65,13 +182,13 @@ namespace flexMC {
             const std::string t_ = cType2Str(left_t);
             auto msg = fmt::format(R"(Binary operator "{}" does not support left operand type: "{}")", symbol, t_);
             report.setMessage(msg);
-            return "";
+            return {undefined, undefined};
         }
         if ((right_t == date) || (right_t == date_list)) {
             const std::string t_ = cType2Str(right_t);
             auto msg = fmt::format(R"(Binary operator "{}" does not support right operand type: "{}")", symbol, t_);
             report.setMessage(msg);
-            return "";
+            return {undefined, undefined};
         }
 
         if ((left_t == vector) && (right_t == vector)) {
@@ -84,7 +201,7 @@ namespace flexMC {
                     maybe_right_s
                 );
                 report.setMessage(msg);
-                return "";
+                return {undefined, undefined};
             }
             stacks.popType();
             stacks.pushArray(vector, left_s);
@@ -102,20 +219,7 @@ namespace flexMC {
             stacks.popType();
             stacks.pushType(scalar);
         }
-        return makeKey(symbol, left_t, right_t);
-    }
-
-    std::string operatorsCalc::binary::makeKey(
-        const std::string &symbol,
-        const CType &left_t,
-        const CType &right_t) {
-        return symbol + cType2Str(left_t) + cType2Str(right_t);
-    }
-
-    std::function<void(CalcStacks &)> operatorsCalc::binary::get(const std::string &key) {
-        const auto look_up = operatorsCalc::binary::operators.find(key);
-        assert(look_up != operatorsCalc::binary::operators.end());
-        return look_up->second;
+        return {left_t, right_t};
     }
 
 }
\ No newline at end of file
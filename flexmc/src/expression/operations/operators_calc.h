@@ -2,7 +2,8 @@
 
 #include <cassert>
 #include <string>
-#include <unordered_map>
+#include <utility>
+#include <array>
 #include <functional>
 #include <algorithm>
 #include <cmath>
@@ -12,37 +13,44 @@
 #include "calc_types.h"
 #include "language_error.h"
 #include "expression_stacks.h"
+#include "vector_math.h"
+#include "symbols.h"
+#include "kernels.h"
 
 
 namespace flexMC::operatorsCalc {
 
 
-    bool isBinarySymbol(const std::string &symbol);
-
     namespace unary {
 
-        CType compileArgument(const std::string &symbol, const Operands &stacks, MaybeError &report);
+        CType compileArgument(const std::string_view &symbol, const Operands &stacks, MaybeError &report);
 
         void scMinus(CalcStacks &stacks);
 
         void vecMinus(CalcStacks &stacks);
 
-    }
+        void scMinus(BatchStacks &stacks);
 
-    namespace binary {
-        const std::vector<std::string> symbols{
-            flexMC::PLUS,
-            flexMC::MINUS,
-            flexMC::MUL,
-            flexMC::DIV,
-            flexMC::POW,
-        };
+        void vecMinus(BatchStacks &stacks);
+
+        // NOT, 1.0 for 0.0 and 0.0 for everything else
+
+        void scNot(CalcStacks &stacks);
 
-        std::string compileArgumentsAndKey(const std::string &symbol, Operands &stacks, MaybeError &report);
+        void vecNot(CalcStacks &stacks);
 
-        std::function<void(CalcStacks &)> get(const std::string &key);
+        void scNot(BatchStacks &stacks);
 
-        std::string makeKey(const std::string &symbol, const CType &left_t, const CType &right_t);
+        void vecNot(BatchStacks &stacks);
+
+        using Kernel = void (*)(CalcStacks &stacks);
+
+        Kernel get(const Symbol &symbol, const CType &type);
+
+    }
+
+    namespace binary {
+        std::pair<CType, CType> compileArguments(const std::string_view &symbol, Operands &stacks, MaybeError &report);
 
         template<class binary_operator>
         void scSc(CalcStacks &stacks, const binary_operator f) {
@@ -105,111 +113,230 @@ namespace flexMC::operatorsCalc {
             stacks.vectors().erase(right_begin, stacks.vectors().end());
         }
 
-        using
-        enum CType;
-
-        const std::unordered_map<std::string, std::function<void(CalcStacks &)>, SHash, std::equal_to<>> operators = {
-            {
-                makeKey(flexMC::MINUS, scalar, scalar),
-                [capture_0 = [](const double &left, const double &right) { return left - right; }](
-                    CalcStacks &stacks) { binary::scSc(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::MINUS, scalar, vector),
-                [capture_0 = [](const double &left, const double &right) { return left - right; }](
-                    CalcStacks &stacks) { binary::scVec(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::MINUS, vector, scalar),
-                [capture_0 = [](const double &left, const double &right) { return left - right; }](
-                    CalcStacks &stacks) { binary::vecSc(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::MINUS, vector, vector),
-                [capture_0 = [](const double &left, const double &right) { return left - right; }](
-                    CalcStacks &stacks) { binary::vecVec(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::PLUS, scalar, scalar),
-                [capture_0 = [](const double &left, const double &right) { return left + right; }](
-                    CalcStacks &stacks) { binary::scSc(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::PLUS, scalar, vector),
-                [capture_0 = [](const double &left, const double &right) { return left + right; }](
-                    CalcStacks &stacks) { binary::scVec(stacks, capture_0); }
-
-            },
-            {
-                makeKey(flexMC::PLUS, vector, scalar),
-                [capture_0 = [](const double &left, const double &right) { return left + right; }](
-                    CalcStacks &stacks) { binary::vecSc(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::PLUS, vector, vector),
-                [capture_0 = [](const double &left, const double &right) { return left + right; }](
-                    CalcStacks &stacks) { binary::vecVec(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::MUL, scalar, scalar),
-                [capture_0 = [](const double &left, const double &right) { return left * right; }](
-                    CalcStacks &stacks) { binary::scSc(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::MUL, scalar, vector),
-                [capture_0 = [](const double &left, const double &right) { return left * right; }](
-                    CalcStacks &stacks) { binary::scVec(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::MUL, vector, scalar),
-                [capture_0 = [](const double &left, const double &right) { return left * right; }](
-                    CalcStacks &stacks) { binary::vecSc(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::MUL, vector, vector),
-                [capture_0 = [](const double &left, const double &right) { return left * right; }](
-                    CalcStacks &stacks) { binary::vecVec(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::DIV, scalar, scalar),
-                [capture_0 = [](const double &left, const double &right) { return left / right; }](
-                    CalcStacks &stacks) { binary::scSc(stacks, capture_0); }},
-            {
-                makeKey(flexMC::DIV, scalar, vector),
-                [capture_0 = [](const double &left, const double &right) { return left / right; }](
-                    CalcStacks &stacks) { binary::scVec(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::DIV, vector, scalar),
-                [capture_0 = [](const double &left, const double &right) { return left / right; }](
-                    CalcStacks &stacks) { binary::vecSc(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::DIV, vector, vector),
-                [capture_0 = [](const double &left, const double &right) { return left / right; }](
-                    CalcStacks &stacks) { binary::vecVec(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::POW, scalar, scalar),
-                [capture_0 = [](const double &left, const double &right) { return std::pow(left, right); }](
-                    CalcStacks &stacks) { binary::scSc(stacks, capture_0); }},
-            {
-                makeKey(flexMC::POW, scalar, vector),
-                [capture_0 = [](const double &left, const double &right) { return std::pow(left, right); }](
-                    CalcStacks &stacks) { binary::scVec(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::POW, vector, scalar),
-                [capture_0 = [](const double &left, const double &right) { return std::pow(left, right); }](
-                    CalcStacks &stacks) { binary::vecSc(stacks, capture_0); }
-            },
-            {
-                makeKey(flexMC::POW, vector, vector),
-                [capture_0 = [](const double &left, const double &right) { return std::pow(left, right); }](
-                    CalcStacks &stacks) { binary::vecVec(stacks, capture_0); }
+        // BatchStacks versions: each operand is an array of stacks.lanes() values and each vector element as well
+
+        template<class binary_operator>
+        void scSc(BatchStacks &stacks, const binary_operator f) {
+            const std::size_t n = stacks.lanes();
+            assert(stacks.size(CType::scalar) >= 2);
+            const SCALAR *right = stacks.scalarLanes(0);
+            SCALAR *left = stacks.scalarLanes(1);
+            for (std::size_t l{0}; l < n; ++l) {
+                left[l] = f(left[l], right[l]);
+            }
+            stacks.scalars().resize(stacks.scalars().size() - n);
+        }
+
+        template<class binary_operator>
+        void scVec(BatchStacks &stacks, const binary_operator f) {
+            assert(stacks.vectorSizes().size() > 0);
+            const std::size_t n = stacks.lanes();
+            const std::size_t s = stacks.vectorSizes().back();
+            assert(stacks.vectors().size() >= s * n);
+            const SCALAR *left = stacks.scalarLanes(0);
+            SCALAR *right = stacks.vectors().data() + stacks.vectors().size() - s * n;
+            for (std::size_t e{0}; e < s; ++e, right += n) {
+                for (std::size_t l{0}; l < n; ++l) {
+                    right[l] = f(left[l], right[l]);
+                }
+            }
+            stacks.scalars().resize(stacks.scalars().size() - n);
+        }
+
+        template<class binary_operator>
+        void vecSc(BatchStacks &stacks, const binary_operator f) {
+            assert(stacks.vectorSizes().size() > 0);
+            const std::size_t n = stacks.lanes();
+            const std::size_t s = stacks.vectorSizes().back();
+            assert(stacks.vectors().size() >= s * n);
+            const SCALAR *right = stacks.scalarLanes(0);
+            SCALAR *left = stacks.vectors().data() + stacks.vectors().size() - s * n;
+            for (std::size_t e{0}; e < s; ++e, left += n) {
+                for (std::size_t l{0}; l < n; ++l) {
+                    left[l] = f(left[l], right[l]);
+                }
+            }
+            stacks.scalars().resize(stacks.scalars().size() - n);
+        }
+
+        template<class binary_operator>
+        void vecVec(BatchStacks &stacks, binary_operator f) {
+            assert(stacks.vectorSizes().size() > 1);
+            const std::size_t s = stacks.vectorSizes().back();
+            stacks.vectorSizes().pop_back();
+            assert(stacks.vectorSizes().back() == s);
+            const std::size_t block = s * stacks.lanes();
+            assert(stacks.vectors().size() >= block + block);
+            const SCALAR *right = stacks.vectors().data() + stacks.vectors().size() - block;
+            SCALAR *left = stacks.vectors().data() + stacks.vectors().size() - block - block;
+            for (std::size_t i{0}; i < block; ++i) {
+                left[i] = f(left[i], right[i]);
+            }
+            stacks.vectors().resize(stacks.vectors().size() - block);
+        }
+
+        // POW with a vector operand runs the vectorMath kernels
+
+        void powScVec(CalcStacks &stacks);
+
+        void powVecSc(CalcStacks &stacks);
+
+        void powVecVec(CalcStacks &stacks);
+
+        void powScVec(BatchStacks &stacks);
+
+        void powVecSc(BatchStacks &stacks);
+
+        void powVecVec(BatchStacks &stacks);
+
+        // Superinstructions (see fuseInstructions): one of the operands is an immediate
+
+        template<class binary_operator>
+        void scImm(CalcStacks &stacks, const SCALAR &right, const binary_operator f) {
+            SCALAR &left = stacks.scalars().back();
+            left = f(left, right);
+        }
+
+        template<class binary_operator>
+        void immSc(CalcStacks &stacks, const SCALAR &left, const binary_operator f) {
+            SCALAR &right = stacks.scalars().back();
+            right = f(left, right);
+        }
+
+        template<class binary_operator>
+        void scImm(BatchStacks &stacks, const SCALAR &right, const binary_operator f) {
+            SCALAR *left = stacks.scalarLanes(0);
+            for (std::size_t l{0}; l < stacks.lanes(); ++l) {
+                left[l] = f(left[l], right);
+            }
+        }
+
+        template<class binary_operator>
+        void immSc(BatchStacks &stacks, const SCALAR &left, const binary_operator f) {
+            SCALAR *right = stacks.scalarLanes(0);
+            for (std::size_t l{0}; l < stacks.lanes(); ++l) {
+                right[l] = f(left, right[l]);
+            }
+        }
+
+        // c + a * b for the top three scalars c, a, b
+        inline void mulAdd(CalcStacks &stacks) {
+            assert(stacks.scalars().size() >= 3);
+            const SCALAR b = stacks.scalars().back();
+            stacks.scalars().pop_back();
+            const SCALAR a = stacks.scalars().back();
+            stacks.scalars().pop_back();
+            stacks.scalars().back() += a * b;
+        }
+
+        inline void mulAdd(BatchStacks &stacks) {
+            assert(stacks.size(CType::scalar) >= 3);
+            const SCALAR *b = stacks.scalarLanes(0);
+            const SCALAR *a = stacks.scalarLanes(1);
+            SCALAR *c = stacks.scalarLanes(2);
+            for (std::size_t l{0}; l < stacks.lanes(); ++l) {
+                c[l] += a[l] * b[l];
+            }
+            stacks.scalars().resize(stacks.scalars().size() - 2 * stacks.lanes());
+        }
+
+        // a * b + c for the top two scalars a, b and the immediate c
+        inline void mulAddImm(CalcStacks &stacks, const SCALAR &c) {
+            assert(stacks.scalars().size() >= 2);
+            const SCALAR b = stacks.scalars().back();
+            stacks.scalars().pop_back();
+            SCALAR &a = stacks.scalars().back();
+            a = a * b + c;
+        }
+
+        inline void mulAddImm(BatchStacks &stacks, const SCALAR &c) {
+            assert(stacks.size(CType::scalar) >= 2);
+            const SCALAR *b = stacks.scalarLanes(0);
+            SCALAR *a = stacks.scalarLanes(1);
+            for (std::size_t l{0}; l < stacks.lanes(); ++l) {
+                a[l] = a[l] * b[l] + c;
             }
+            stacks.scalars().resize(stacks.scalars().size() - stacks.lanes());
+        }
+
+        // Kernels on fixed slots (RegisterCode): operands are read from and the result is written to known offsets.
+        // out may alias an operand.
+
+        template<class binary_operator>
+        void scVec(const SCALAR &left, const SCALAR *right, SCALAR *out, const std::size_t &size, binary_operator f) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = f(left, right[i]);
+            }
+        }
+
+        template<class binary_operator>
+        void vecSc(const SCALAR *left, const SCALAR &right, SCALAR *out, const std::size_t &size, binary_operator f) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = f(left[i], right);
+            }
+        }
+
+        template<class binary_operator>
+        void vecVec(const SCALAR *left, const SCALAR *right, SCALAR *out, const std::size_t &size, binary_operator f) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = f(left[i], right[i]);
+            }
+        }
+
+        using Kernel = void (*)(CalcStacks &stacks);
+
+        // [left operand is vector][right operand is vector]
+        using OperandKernels = std::array<std::array<Kernel, 2>, 2>;
+
+        template<class binary_operator>
+        constexpr OperandKernels operandKernels() {
+            return {{
+                {
+                    [](CalcStacks &stacks) { binary::scSc(stacks, binary_operator{}); },
+                    [](CalcStacks &stacks) { binary::scVec(stacks, binary_operator{}); },
+                },
+                {
+                    [](CalcStacks &stacks) { binary::vecSc(stacks, binary_operator{}); },
+                    [](CalcStacks &stacks) { binary::vecVec(stacks, binary_operator{}); },
+                },
+            }};
+        }
+
+        // indexed by operatorIndex(symbol), operandIndex(left_t), operandIndex(right_t). The comparisons and the
+        // logical operators cast the condition to 1.0 or 0.0 instead of branching on it.
+        constexpr std::array<OperandKernels, NUM_OPERATORS> OPERATORS{
+            operandKernels<decltype(kernels::PLUS_F)>(),
+            operandKernels<decltype(kernels::MINUS_F)>(),
+            operandKernels<decltype(kernels::MUL_F)>(),
+            operandKernels<decltype(kernels::DIV_F)>(),
+            OperandKernels{{
+                {
+                    [](CalcStacks &stacks) { binary::scSc(stacks, kernels::POW_F); },
+                    [](CalcStacks &stacks) { binary::powScVec(stacks); },
+                },
+                {
+                    [](CalcStacks &stacks) { binary::powVecSc(stacks); },
+                    [](CalcStacks &stacks) { binary::powVecVec(stacks); },
+                },
+            }},
+            operandKernels<decltype(kernels::LT_F)>(),
+            operandKernels<decltype(kernels::GT_F)>(),
+            operandKernels<decltype(kernels::LE_F)>(),
+            operandKernels<decltype(kernels::GE_F)>(),
+            operandKernels<decltype(kernels::AND_F)>(),
+            operandKernels<decltype(kernels::OR_F)>(),
         };
 
+        static_assert(std::ranges::all_of(OPERATORS, [](const OperandKernels &kernels) {
+            return std::ranges::all_of(kernels, [](const auto &row) {
+                return std::ranges::none_of(row, [](const Kernel &kernel) { return kernel == nullptr; });
+            });
+        }), "every operator needs a kernel for all operand types");
+
+        constexpr Kernel get(const Symbol &symbol, const CType &left_t, const CType &right_t) {
+            return OPERATORS[operatorIndex(symbol)][operandIndex(left_t)][operandIndex(right_t)];
+        }
+
     }
 
 
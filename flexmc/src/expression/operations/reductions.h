@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+
+#include "calc_types.h"
+
+// The order in which SUM and PROD of a vector combine its elements. All evaluators (the vectorMath kernels, batches,
+// fused loops and transpiled code) follow it and return the same bits for the same vector.
+//
+// The vector is cut into blocks of BLOCK elements. Within a block, element i goes to the partial result
+// i % ACCUMULATORS and the partial results are combined as a balanced tree; these independent chains are what SIMD
+// registers hold. The block results are combined pairwise, so that the rounding error grows with log2(size / BLOCK)
+// instead of size and does not depend on the instruction set.
+
+
+namespace flexMC::reductions {
+
+    constexpr std::size_t ACCUMULATORS{8};
+
+    constexpr std::size_t BLOCK{128};
+
+    // partial results are partial[j * stride], j < ACCUMULATORS
+    template<class binary_function>
+    SCALAR combineAccumulators(const SCALAR *partial, const std::size_t &stride, binary_function f) {
+        return f(f(f(partial[0], partial[stride]), f(partial[2 * stride], partial[3 * stride])),
+                 f(f(partial[4 * stride], partial[5 * stride]), f(partial[6 * stride], partial[7 * stride])));
+    }
+
+    // at most BLOCK elements
+    template<class binary_function>
+    SCALAR reduceBlock(const SCALAR *in, const std::size_t &size, binary_function f, const SCALAR &init) {
+        SCALAR partial[ACCUMULATORS];
+        std::fill_n(partial, ACCUMULATORS, init);
+        std::size_t i{0};
+        for (; i + ACCUMULATORS <= size; i += ACCUMULATORS) {
+            for (std::size_t j{0}; j < ACCUMULATORS; ++j) {
+                partial[j] = f(partial[j], in[i + j]);
+            }
+        }
+        for (std::size_t j{0}; i + j < size; ++j) {
+            partial[j] = f(partial[j], in[i + j]);
+        }
+        return combineAccumulators(partial, 1, f);
+    }
+
+    // Bookkeeping of the pairwise combination, the block results live in slots owned by the caller. After each block
+    // the two most recent slots covering the same number of blocks are merged (a binary counter), fold() merges the
+    // remaining slots from the last one.
+    class PairwiseLevels {
+
+    public:
+
+        [[nodiscard]] bool empty() const { return size_ == 0; }
+
+        // slot for the next block result
+        std::size_t push() {
+            levels_[size_] = 0;
+            return size_++;
+        }
+
+        // merge(left, right) combines slot right into slot left
+        template<class merge_function>
+        void collapse(merge_function merge) {
+            while ((size_ > 1) && (levels_[size_ - 1] == levels_[size_ - 2])) {
+                merge(size_ - 2, size_ - 1);
+                --size_;
+                ++levels_[size_ - 1];
+            }
+        }
+
+        // leaves the result in slot 0
+        template<class merge_function>
+        void fold(merge_function merge) {
+            for (; size_ > 1; --size_) {
+                merge(size_ - 2, size_ - 1);
+            }
+        }
+
+    private:
+
+        // one slot per bit of the block count
+        static constexpr std::size_t MAX_SLOTS{64};
+
+        unsigned char levels_[MAX_SLOTS]{};
+
+        std::size_t size_{0};
+
+    };
+
+    template<class binary_function>
+    class Pairwise {
+
+    public:
+
+        Pairwise(binary_function f, const SCALAR &init) : f_(f), init_(init) {}
+
+        void add(const SCALAR &block) {
+            slots_[levels_.push()] = block;
+            levels_.collapse([this](const std::size_t &left, const std::size_t &right) {
+                slots_[left] = f_(slots_[left], slots_[right]);
+            });
+        }
+
+        SCALAR result() {
+            if (levels_.empty()) {
+                return init_;
+            }
+            levels_.fold([this](const std::size_t &left, const std::size_t &right) {
+                slots_[left] = f_(slots_[left], slots_[right]);
+            });
+            return slots_[0];
+        }
+
+    private:
+
+        binary_function f_;
+
+        SCALAR init_;
+
+        SCALAR slots_[64];
+
+        PairwiseLevels levels_;
+
+    };
+
+    template<class binary_function>
+    SCALAR reduce(const SCALAR *in, const std::size_t &size, binary_function f, const SCALAR &init) {
+        Pairwise<binary_function> pairwise(f, init);
+        for (std::size_t begin{0}; begin < size; begin += BLOCK) {
+            pairwise.add(reduceBlock(in + begin, std::min(BLOCK, size - begin), f, init));
+        }
+        return pairwise.result();
+    }
+
+    inline SCALAR sum(const SCALAR *in, const std::size_t &size) {
+        return reduce(in, size, [](const SCALAR &left, const SCALAR &right) { return left + right; }, 0.0);
+    }
+
+    inline SCALAR prod(const SCALAR *in, const std::size_t &size) {
+        return reduce(in, size, [](const SCALAR &left, const SCALAR &right) { return left * right; }, 1.0);
+    }
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include "calc_types.h"
+#include "terminals.h"
+
+// Operators and real functions as indices into the compile-time dispatch tables of operatorsCalc, functionsReal and
+// ByteCode. A token is translated once by toSymbol, the tables are then indexed by (symbol, left CType, right CType).
+
+
+namespace flexMC {
+
+    enum class Symbol : std::uint8_t {
+        undefined,
+        // binary operators, in the order of OPERATORS and the OpCode blocks. The comparisons and AND, OR return 1 or 0.
+        plus,
+        minus,
+        mul,
+        div,
+        pow,
+        lt,
+        gt,
+        le,
+        ge,
+        and_,
+        or_,
+        // prefix operator besides minus
+        not_,
+        // functionsReal::scalar
+        exp,
+        log,
+        abs,
+        sqrt,
+        square,
+        // functionsReal::reduceVector, all but len also functionsReal::reduceArguments
+        sum,
+        prod,
+        max,
+        min,
+        argmax,
+        argmin,
+        len,
+    };
+
+    constexpr std::size_t NUM_OPERATORS{11};
+
+    constexpr std::size_t NUM_SCALAR_FUNCTIONS{5};
+
+    constexpr std::size_t NUM_REDUCE_FUNCTIONS{7};
+
+    // the terminal of each symbol
+    constexpr std::array<std::pair<std::string_view, Symbol>, 24> SYMBOL_NAMES{{
+        {PLUS,   Symbol::plus},
+        {MINUS,  Symbol::minus},
+        {MUL,    Symbol::mul},
+        {DIV,    Symbol::div},
+        {POW,    Symbol::pow},
+        {LT,     Symbol::lt},
+        {GT,     Symbol::gt},
+        {LE,     Symbol::le},
+        {GE,     Symbol::ge},
+        {AND,    Symbol::and_},
+        {OR,     Symbol::or_},
+        {NOT,    Symbol::not_},
+        {EXP,    Symbol::exp},
+        {LOG,    Symbol::log},
+        {ABS,    Symbol::abs},
+        {SQRT,   Symbol::sqrt},
+        {SQUARE, Symbol::square},
+        {SUM,    Symbol::sum},
+        {PROD,   Symbol::prod},
+        {MAX,    Symbol::max},
+        {MIN,    Symbol::min},
+        {ARGMAX, Symbol::argmax},
+        {ARGMIN, Symbol::argmin},
+        {LEN,    Symbol::len},
+    }};
+
+    // Symbol::undefined for anything but an operator or a real function
+    constexpr Symbol toSymbol(const std::string_view &value) {
+        for (const auto &[name, symbol]: SYMBOL_NAMES) {
+            if (name == value) {
+                return symbol;
+            }
+        }
+        return Symbol::undefined;
+    }
+
+    constexpr std::size_t symbolIndex(const Symbol &symbol, const Symbol &first, const std::size_t &count) {
+        const auto index = static_cast<std::size_t>(symbol) - static_cast<std::size_t>(first);
+        return index < count ? index : count;
+    }
+
+    constexpr bool isOperator(const Symbol &symbol) {
+        return symbolIndex(symbol, Symbol::plus, NUM_OPERATORS) < NUM_OPERATORS;
+    }
+
+    constexpr bool isPrefixOperator(const Symbol &symbol) {
+        return (symbol == Symbol::minus) || (symbol == Symbol::not_);
+    }
+
+    constexpr bool isScalarFunction(const Symbol &symbol) {
+        return symbolIndex(symbol, Symbol::exp, NUM_SCALAR_FUNCTIONS) < NUM_SCALAR_FUNCTIONS;
+    }
+
+    constexpr bool isReduceFunction(const Symbol &symbol) {
+        return symbolIndex(symbol, Symbol::sum, NUM_REDUCE_FUNCTIONS) < NUM_REDUCE_FUNCTIONS;
+    }
+
+    constexpr std::size_t operatorIndex(const Symbol &symbol) {
+        assert(isOperator(symbol));
+        return symbolIndex(symbol, Symbol::plus, NUM_OPERATORS);
+    }
+
+    constexpr std::size_t scalarFunctionIndex(const Symbol &symbol) {
+        assert(isScalarFunction(symbol));
+        return symbolIndex(symbol, Symbol::exp, NUM_SCALAR_FUNCTIONS);
+    }
+
+    constexpr std::size_t reduceFunctionIndex(const Symbol &symbol) {
+        assert(isReduceFunction(symbol));
+        return symbolIndex(symbol, Symbol::sum, NUM_REDUCE_FUNCTIONS);
+    }
+
+    // The tables only have slots for scalar and vector operands, the type checks reject dates before the look-up
+    constexpr std::size_t operandIndex(const CType &type) {
+        assert((type == CType::scalar) || (type == CType::vector));
+        return type == CType::vector ? 1 : 0;
+    }
+
+    static_assert(toSymbol(POW) == Symbol::pow && toSymbol(LEN) == Symbol::len && toSymbol("x") == Symbol::undefined);
+    static_assert(isOperator(Symbol::pow) && !isOperator(Symbol::exp) && isReduceFunction(Symbol::len));
+    static_assert(isOperator(Symbol::or_) && !isOperator(Symbol::not_) && isPrefixOperator(toSymbol(NOT)));
+
+}
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cmath>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#include "reductions.h"
+#include "vector_math_isa.h"
+#include "vector_math.h"
+
+
+namespace flexMC::vectorMath {
+
+    namespace {
+
+        void expScalar(const SCALAR *in, SCALAR *out, std::size_t size) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = std::exp(in[i]);
+            }
+        }
+
+        void logScalar(const SCALAR *in, SCALAR *out, std::size_t size) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = std::log(in[i]);
+            }
+        }
+
+        void sqrtScalar(const SCALAR *in, SCALAR *out, std::size_t size) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = std::sqrt(in[i]);
+            }
+        }
+
+        template<bool left_vector, bool right_vector>
+        void powScalar(const SCALAR *left, const SCALAR *right, SCALAR *out, std::size_t size) {
+            for (std::size_t i{0}; i < size; ++i) {
+                out[i] = std::pow(left[left_vector ? i : 0], right[right_vector ? i : 0]);
+            }
+        }
+
+        template<bool product>
+        void blocksScalar(const SCALAR *in, SCALAR *out, std::size_t size) {
+            const auto f = [](const SCALAR &left, const SCALAR &right) { return product ? left * right : left + right; };
+            for (std::size_t begin{0}; begin < size; begin += reductions::BLOCK) {
+                out[begin / reductions::BLOCK] = reductions::reduceBlock(
+                        in + begin, std::min(reductions::BLOCK, size - begin), f, product ? 1.0 : 0.0);
+            }
+        }
+
+        template<bool largest>
+        std::size_t scanScalar(const SCALAR *in, std::size_t size, SCALAR *best) {
+            std::size_t found{size};
+            for (std::size_t i{0}; i < size; ++i) {
+                if (largest ? *best < in[i] : in[i] < *best) {
+                    *best = in[i];
+                    found = i;
+                }
+            }
+            return found;
+        }
+
+        constexpr Kernels SCALAR_KERNELS{
+            &expScalar,
+            &logScalar,
+            &sqrtScalar,
+            &powScalar<true, true>,
+            &powScalar<true, false>,
+            &powScalar<false, true>,
+            &blocksScalar<false>,
+            &blocksScalar<true>,
+            &scanScalar<true>,
+            &scanScalar<false>,
+        };
+
+        bool cpuSupports(const Isa &isa) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            __builtin_cpu_init();
+            switch (isa) {
+                case Isa::sse2:
+                    return __builtin_cpu_supports("sse2");
+                case Isa::avx2:
+                    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+                case Isa::avx512:
+                    return __builtin_cpu_supports("avx512f");
+                default:
+                    return true;
+            }
+#elif defined(_MSC_VER) && defined(_M_X64)
+            // CPUID feature bits, and the XCR0 register state the OS saves on context switches
+            int leaf1[4];
+            int leaf7[4];
+            __cpuid(leaf1, 1);
+            __cpuidex(leaf7, 7, 0);
+            const bool xsave = (leaf1[2] & (1 << 27)) != 0;
+            const unsigned long long xcr0 = xsave ? _xgetbv(0) : 0;
+            const bool ymm = (xcr0 & 0x6) == 0x6;
+            const bool zmm = ymm && ((xcr0 & 0xe0) == 0xe0);
+            switch (isa) {
+                case Isa::avx2:
+                    return ymm && ((leaf1[2] & (1 << 28)) != 0) && ((leaf1[2] & (1 << 12)) != 0) &&
+                           ((leaf7[1] & (1 << 5)) != 0);
+                case Isa::avx512:
+                    return zmm && ((leaf7[1] & (1 << 16)) != 0);
+                default:
+                    return true;
+            }
+#else
+            return isa == Isa::scalar;
+#endif
+        }
+
+        const Kernels *kernelsOf(const Isa &isa) {
+            switch (isa) {
+                case Isa::sse2:
+                    return sse2Kernels();
+                case Isa::avx2:
+                    return avx2Kernels();
+                case Isa::avx512:
+                    return avx512Kernels();
+                default:
+                    return &SCALAR_KERNELS;
+            }
+        }
+
+        struct Selection {
+
+            Isa isa;
+
+            const Kernels *kernels;
+
+        };
+
+        Selection best() {
+            for (const Isa isa: {Isa::avx512, Isa::avx2, Isa::sse2}) {
+                if (isAvailable(isa)) {
+                    return {isa, kernelsOf(isa)};
+                }
+            }
+            return {Isa::scalar, &SCALAR_KERNELS};
+        }
+
+        Selection &selection() {
+            static Selection selected{best()};
+            return selected;
+        }
+
+        // blocks are computed in chunks that fit on the stack
+        constexpr std::size_t CHUNK_BLOCKS{64};
+
+        template<class binary_function>
+        SCALAR pairwise(const SCALAR *in, const std::size_t &size,
+                        void (*blocks)(const SCALAR *, SCALAR *, std::size_t), binary_function f, const SCALAR &init) {
+            reductions::Pairwise<binary_function> result(f, init);
+            SCALAR chunk[CHUNK_BLOCKS];
+            for (std::size_t begin{0}; begin < size; begin += CHUNK_BLOCKS * reductions::BLOCK) {
+                const std::size_t length = std::min(CHUNK_BLOCKS * reductions::BLOCK, size - begin);
+                blocks(in + begin, chunk, length);
+                for (std::size_t k{0}; k * reductions::BLOCK < length; ++k) {
+                    result.add(chunk[k]);
+                }
+            }
+            return result.result();
+        }
+
+        template<bool largest>
+        std::size_t firstExtreme(const SCALAR *in, const std::size_t &size) {
+            SCALAR best = in[0];
+            const std::size_t found = (largest ? kernels().scanMax : kernels().scanMin)(in + 1, size - 1, &best);
+            return found == size - 1 ? 0 : found + 1;
+        }
+
+    }
+
+    Isa isa() { return selection().isa; }
+
+    bool isAvailable(const Isa &isa) { return (kernelsOf(isa) != nullptr) && cpuSupports(isa); }
+
+    bool selectIsa(const Isa &isa) {
+        if (!isAvailable(isa)) {
+            return false;
+        }
+        selection() = {isa, kernelsOf(isa)};
+        return true;
+    }
+
+    const Kernels &kernels() { return *selection().kernels; }
+
+    void exp(const SCALAR *in, SCALAR *out, const std::size_t &size) { kernels().exp(in, out, size); }
+
+    void log(const SCALAR *in, SCALAR *out, const std::size_t &size) { kernels().log(in, out, size); }
+
+    void sqrt(const SCALAR *in, SCALAR *out, const std::size_t &size) { kernels().sqrt(in, out, size); }
+
+    void pow(const SCALAR *left, const SCALAR *right, SCALAR *out, const std::size_t &size) {
+        kernels().powVecVec(left, right, out, size);
+    }
+
+    void pow(const SCALAR *left, const SCALAR &right, SCALAR *out, const std::size_t &size) {
+        kernels().powVecSc(left, &right, out, size);
+    }
+
+    void pow(const SCALAR &left, const SCALAR *right, SCALAR *out, const std::size_t &size) {
+        kernels().powScVec(&left, right, out, size);
+    }
+
+    SCALAR sum(const SCALAR *in, const std::size_t &size) {
+        return pairwise(in, size, kernels().sumBlocks, [](const SCALAR &left, const SCALAR &right) {
+            return left + right;
+        }, 0.0);
+    }
+
+    SCALAR prod(const SCALAR *in, const std::size_t &size) {
+        return pairwise(in, size, kernels().prodBlocks, [](const SCALAR &left, const SCALAR &right) {
+            return left * right;
+        }, 1.0);
+    }
+
+    void sumBlocks(const SCALAR *in, SCALAR *out, const std::size_t &size) { kernels().sumBlocks(in, out, size); }
+
+    void prodBlocks(const SCALAR *in, SCALAR *out, const std::size_t &size) { kernels().prodBlocks(in, out, size); }
+
+    std::size_t argmax(const SCALAR *in, const std::size_t &size) { return firstExtreme<true>(in, size); }
+
+    std::size_t argmin(const SCALAR *in, const std::size_t &size) { return firstExtreme<false>(in, size); }
+
+    std::size_t scanMax(const SCALAR *in, const std::size_t &size, SCALAR &best) {
+        return kernels().scanMax(in, size, &best);
+    }
+
+    std::size_t scanMin(const SCALAR *in, const std::size_t &size, SCALAR &best) {
+        return kernels().scanMin(in, size, &best);
+    }
+
+}
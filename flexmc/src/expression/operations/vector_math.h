@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+
+#include "calc_types.h"
+
+// Vectorised EXP, LOG, SQRT, POW and reductions over contiguous arrays. The instruction set (SSE2, AVX2 or AVX-512) is selected
+// at runtime from what the CPU supports, other targets fall back to libm. out may alias an input.
+//
+// Accuracy against libm: EXP, LOG and POW within 2 ulp, SQRT is exact. POW is computed as exp(y * log(x)) with log(x)
+// in double-double precision; lanes with x <= 0, non-finite or huge operands or |y * log(x)| >= 746 are delegated to
+// std::pow.
+//
+// SUM and PROD follow the order of reductions.h on every instruction set, ARGMAX and ARGMIN return the same index as
+// std::max_element and std::min_element.
+
+
+namespace flexMC::vectorMath {
+
+    // kernel table of one instruction set, see vector_math_isa.h
+    struct Kernels;
+
+    enum class Isa {
+        scalar,
+        sse2,
+        avx2,
+        avx512,
+    };
+
+    // the instruction set the kernels currently run on
+    Isa isa();
+
+    // whether the kernels of isa are compiled in and supported by the CPU
+    bool isAvailable(const Isa &isa);
+
+    // switches the kernels to isa if it is available (tests and benchmarks), not safe to call concurrently with
+    // evaluations
+    bool selectIsa(const Isa &isa);
+
+    // the kernels of isa(), which transpiled modules receive as an argument instead of linking to this library
+    const Kernels &kernels();
+
+    void exp(const SCALAR *in, SCALAR *out, const std::size_t &size);
+
+    void log(const SCALAR *in, SCALAR *out, const std::size_t &size);
+
+    void sqrt(const SCALAR *in, SCALAR *out, const std::size_t &size);
+
+    void pow(const SCALAR *left, const SCALAR *right, SCALAR *out, const std::size_t &size);
+
+    void pow(const SCALAR *left, const SCALAR &right, SCALAR *out, const std::size_t &size);
+
+    void pow(const SCALAR &left, const SCALAR *right, SCALAR *out, const std::size_t &size);
+
+    SCALAR sum(const SCALAR *in, const std::size_t &size);
+
+    SCALAR prod(const SCALAR *in, const std::size_t &size);
+
+    // one result per block of reductions::BLOCK elements (the last one may be shorter), to be combined with
+    // reductions::Pairwise
+    void sumBlocks(const SCALAR *in, SCALAR *out, const std::size_t &size);
+
+    void prodBlocks(const SCALAR *in, SCALAR *out, const std::size_t &size);
+
+    // size > 0
+    std::size_t argmax(const SCALAR *in, const std::size_t &size);
+
+    std::size_t argmin(const SCALAR *in, const std::size_t &size);
+
+    // continues a scan for streamed data: the index of the first largest (smallest) element if it beats best, which is
+    // then updated, size otherwise
+    std::size_t scanMax(const SCALAR *in, const std::size_t &size, SCALAR &best);
+
+    std::size_t scanMin(const SCALAR *in, const std::size_t &size, SCALAR &best);
+
+}
@@ -0,0 +1,105 @@
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+#include <immintrin.h>
+
+#endif
+
+#include "vector_math_isa.h"
+#include "vector_math_simd.h"
+
+// compiled with -mavx2 -mfma (/arch:AVX2), see flexmc/src/CMakeLists.txt
+
+
+namespace flexMC::vectorMath {
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+    namespace {
+
+        struct Avx2 {
+
+            using V = __m256d;
+            using M = __m256d;
+            using I = __m256i;
+
+            static constexpr std::size_t W = 4;
+
+            static V set1(const double &value) { return _mm256_set1_pd(value); }
+
+            static I set1i(const long long &value) { return _mm256_set1_epi64x(value); }
+
+            static V load(const double *from) { return _mm256_loadu_pd(from); }
+
+            static void store(double *to, const V &value) { _mm256_storeu_pd(to, value); }
+
+            static V add(const V &a, const V &b) { return _mm256_add_pd(a, b); }
+
+            static V sub(const V &a, const V &b) { return _mm256_sub_pd(a, b); }
+
+            static V mul(const V &a, const V &b) { return _mm256_mul_pd(a, b); }
+
+            static V div(const V &a, const V &b) { return _mm256_div_pd(a, b); }
+
+            static V sqrt(const V &a) { return _mm256_sqrt_pd(a); }
+
+            static V min(const V &a, const V &b) { return _mm256_min_pd(a, b); }
+
+            static V max(const V &a, const V &b) { return _mm256_max_pd(a, b); }
+
+            static V fma(const V &a, const V &b, const V &c) { return _mm256_fmadd_pd(a, b, c); }
+
+            static V twoProd(const V &a, const V &b, V &error) {
+                const V product = mul(a, b);
+                error = _mm256_fmsub_pd(a, b, product);
+                return product;
+            }
+
+            static M lt(const V &a, const V &b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+
+            static M gt(const V &a, const V &b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+
+            static M eq(const V &a, const V &b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+
+            static M unordered(const V &a, const V &b) { return _mm256_cmp_pd(a, b, _CMP_UNORD_Q); }
+
+            static M both(const M &a, const M &b) { return _mm256_and_pd(a, b); }
+
+            static V select(const M &mask, const V &a, const V &b) { return _mm256_blendv_pd(b, a, mask); }
+
+            static unsigned maskBits(const M &mask) { return static_cast<unsigned>(_mm256_movemask_pd(mask)); }
+
+            static bool all(const M &mask) { return maskBits(mask) == 0xfU; }
+
+            static I bits(const V &a) { return _mm256_castpd_si256(a); }
+
+            static V fromBits(const I &a) { return _mm256_castsi256_pd(a); }
+
+            static I add64(const I &a, const I &b) { return _mm256_add_epi64(a, b); }
+
+            static I sub64(const I &a, const I &b) { return _mm256_sub_epi64(a, b); }
+
+            static I and64(const I &a, const I &b) { return _mm256_and_si256(a, b); }
+
+            static I or64(const I &a, const I &b) { return _mm256_or_si256(a, b); }
+
+            template<int n>
+            static I shl(const I &a) { return _mm256_slli_epi64(a, n); }
+
+            template<int n>
+            static I shr(const I &a) { return _mm256_srli_epi64(a, n); }
+
+        };
+
+        constexpr Kernels KERNELS = makeKernels<Avx2>();
+
+    }
+
+    const Kernels *avx2Kernels() { return &KERNELS; }
+
+#else
+
+    const Kernels *avx2Kernels() { return nullptr; }
+
+#endif
+
+}
@@ -0,0 +1,111 @@
+#if defined(__AVX512F__)
+
+#if defined(__GNUC__) && !defined(__clang__)
+// the _mm512_undefined_* placeholders inside GCC's own intrinsics trip -Wuninitialized
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+
+#endif
+
+#include "vector_math_isa.h"
+#include "vector_math_simd.h"
+
+// compiled with -mavx512f (/arch:AVX512), see flexmc/src/CMakeLists.txt
+
+
+namespace flexMC::vectorMath {
+
+#if defined(__AVX512F__)
+
+    namespace {
+
+        struct Avx512 {
+
+            using V = __m512d;
+            using M = __mmask8;
+            using I = __m512i;
+
+            static constexpr std::size_t W = 8;
+
+            static V set1(const double &value) { return _mm512_set1_pd(value); }
+
+            static I set1i(const long long &value) { return _mm512_set1_epi64(value); }
+
+            static V load(const double *from) { return _mm512_loadu_pd(from); }
+
+            static void store(double *to, const V &value) { _mm512_storeu_pd(to, value); }
+
+            static V add(const V &a, const V &b) { return _mm512_add_pd(a, b); }
+
+            static V sub(const V &a, const V &b) { return _mm512_sub_pd(a, b); }
+
+            static V mul(const V &a, const V &b) { return _mm512_mul_pd(a, b); }
+
+            static V div(const V &a, const V &b) { return _mm512_div_pd(a, b); }
+
+            static V sqrt(const V &a) { return _mm512_sqrt_pd(a); }
+
+            static V min(const V &a, const V &b) { return _mm512_min_pd(a, b); }
+
+            static V max(const V &a, const V &b) { return _mm512_max_pd(a, b); }
+
+            static V fma(const V &a, const V &b, const V &c) { return _mm512_fmadd_pd(a, b, c); }
+
+            static V twoProd(const V &a, const V &b, V &error) {
+                const V product = mul(a, b);
+                error = _mm512_fmsub_pd(a, b, product);
+                return product;
+            }
+
+            static M lt(const V &a, const V &b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+
+            static M gt(const V &a, const V &b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+
+            static M eq(const V &a, const V &b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+
+            static M unordered(const V &a, const V &b) { return _mm512_cmp_pd_mask(a, b, _CMP_UNORD_Q); }
+
+            static M both(const M &a, const M &b) { return static_cast<M>(a & b); }
+
+            static V select(const M &mask, const V &a, const V &b) { return _mm512_mask_blend_pd(mask, b, a); }
+
+            static unsigned maskBits(const M &mask) { return mask; }
+
+            static bool all(const M &mask) { return mask == 0xffU; }
+
+            static I bits(const V &a) { return _mm512_castpd_si512(a); }
+
+            static V fromBits(const I &a) { return _mm512_castsi512_pd(a); }
+
+            static I add64(const I &a, const I &b) { return _mm512_add_epi64(a, b); }
+
+            static I sub64(const I &a, const I &b) { return _mm512_sub_epi64(a, b); }
+
+            static I and64(const I &a, const I &b) { return _mm512_and_si512(a, b); }
+
+            static I or64(const I &a, const I &b) { return _mm512_or_si512(a, b); }
+
+            template<int n>
+            static I shl(const I &a) { return _mm512_slli_epi64(a, n); }
+
+            template<int n>
+            static I shr(const I &a) { return _mm512_srli_epi64(a, n); }
+
+        };
+
+        constexpr Kernels KERNELS = makeKernels<Avx512>();
+
+    }
+
+    const Kernels *avx512Kernels() { return &KERNELS; }
+
+#else
+
+    const Kernels *avx512Kernels() { return nullptr; }
+
+#endif
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+#include "calc_types.h"
+
+// Kernel table of one instruction set, shared between vector_math.cpp, the vector_math_<isa>.cpp units and transpiled
+// modules
+
+
+namespace flexMC::vectorMath {
+
+    struct Kernels {
+
+        void (*exp)(const SCALAR *in, SCALAR *out, std::size_t size);
+
+        void (*log)(const SCALAR *in, SCALAR *out, std::size_t size);
+
+        void (*sqrt)(const SCALAR *in, SCALAR *out, std::size_t size);
+
+        void (*powVecVec)(const SCALAR *left, const SCALAR *right, SCALAR *out, std::size_t size);
+
+        void (*powVecSc)(const SCALAR *left, const SCALAR *right, SCALAR *out, std::size_t size);
+
+        void (*powScVec)(const SCALAR *left, const SCALAR *right, SCALAR *out, std::size_t size);
+
+        void (*sumBlocks)(const SCALAR *in, SCALAR *out, std::size_t size);
+
+        void (*prodBlocks)(const SCALAR *in, SCALAR *out, std::size_t size);
+
+        std::size_t (*scanMax)(const SCALAR *in, std::size_t size, SCALAR *best);
+
+        std::size_t (*scanMin)(const SCALAR *in, std::size_t size, SCALAR *best);
+
+    };
+
+    // nullptr if the unit was compiled without the instruction set
+    const Kernels *sse2Kernels();
+
+    const Kernels *avx2Kernels();
+
+    const Kernels *avx512Kernels();
+
+}
@@ -0,0 +1,423 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include <limits>
+
+#include "calc_types.h"
+#include "vector_math_isa.h"
+#include "reductions.h"
+
+// The vectorMath algorithms, written once against register traits T and instantiated by each vector_math_<isa>.cpp
+// unit with its own target flags. T provides the register type V, the comparison mask M, the 64-bit integer view I,
+// the lane count W and static wrappers of the intrinsics used below.
+//
+// Everything lives in an unnamed namespace: the same template instantiated in two units compiled for different
+// instruction sets must not be merged by the linker. For the same reason no inline library function is called here.
+
+
+namespace flexMC::vectorMath {
+
+    namespace {
+
+        // Cody-Waite split of ln(2) (fdlibm): n * LN2_HI is exact for |n| < 2^21
+        constexpr double LN2_HI = 6.93147180369123816490e-01;
+        constexpr double LN2_LO = 1.90821492927058770002e-10;
+        constexpr double LOG2_E = 1.44269504088896338700e+00;
+        constexpr double SQRT_2 = 1.41421356237309514547e+00;
+        constexpr double TWO_THIRDS_HI = 2.0 / 3.0;
+        constexpr double TWO_THIRDS_LO = 3.700743415417188e-17;
+        // adding it rounds |x| < 2^51 to an integer, which ends up in the low bits of the mantissa
+        constexpr double ROUND_MAGIC = 0x1.8p52;
+        constexpr double INF = std::numeric_limits<double>::infinity();
+        constexpr double SMALLEST_NORMAL = std::numeric_limits<double>::min();
+        constexpr double NAN_VALUE = std::numeric_limits<double>::quiet_NaN();
+        constexpr long long MANTISSA_BITS = 0x000fffffffffffffLL;
+
+        // Taylor coefficients 1 / k! of exp(r) for k = 2..13, |r| <= ln(2) / 2
+        constexpr double EXP_COEFFICIENTS[]{
+            1.0 / 2.0, 1.0 / 6.0, 1.0 / 24.0, 1.0 / 120.0, 1.0 / 720.0, 1.0 / 5040.0,
+            1.0 / 40320.0, 1.0 / 362880.0, 1.0 / 3628800.0, 1.0 / 39916800.0, 1.0 / 479001600.0, 1.0 / 6227020800.0
+        };
+
+        // 2 / (2j + 5) for j = 0..9: 2 atanh(s) = 2s + 2s^3 / 3 + s^5 * sum_j 2 / (2j + 5) * s^2j
+        constexpr double ATANH_COEFFICIENTS[]{
+            2.0 / 5.0, 2.0 / 7.0, 2.0 / 9.0, 2.0 / 11.0, 2.0 / 13.0,
+            2.0 / 15.0, 2.0 / 17.0, 2.0 / 19.0, 2.0 / 21.0, 2.0 / 23.0
+        };
+
+        // fdlibm's minimax coefficients Lg1..Lg7 of (log(1 + f) - 2s + s * (f - hfsq)) / s^2 in s^2
+        constexpr double LOG_COEFFICIENTS[]{
+            6.666666666666735130e-01, 3.999999999940941908e-01, 2.857142874366239149e-01, 2.222219843214978396e-01,
+            1.818357216161805012e-01, 1.531383769920937332e-01, 1.479819860511658591e-01
+        };
+
+        // lanes of the padded last block
+        constexpr double PADDING = 1.0;
+
+        template<class T>
+        typename T::V roundToInteger(const typename T::V &x) {
+            return T::sub(T::add(x, T::set1(ROUND_MAGIC)), T::set1(ROUND_MAGIC));
+        }
+
+        // 2^k for integral k in [-1022, 1023]
+        template<class T>
+        typename T::V powerOfTwo(const typename T::V &k) {
+            const typename T::I integer = T::sub64(T::bits(T::add(k, T::set1(ROUND_MAGIC))),
+                                                   T::bits(T::set1(ROUND_MAGIC)));
+            return T::fromBits(T::template shl<52>(T::add64(integer, T::set1i(1023))));
+        }
+
+        // error free sum for |a| >= |b|
+        template<class T>
+        typename T::V fastTwoSum(const typename T::V &a, const typename T::V &b, typename T::V &error) {
+            const typename T::V sum = T::add(a, b);
+            error = T::sub(b, T::sub(sum, a));
+            return sum;
+        }
+
+        template<class T>
+        typename T::V twoSum(const typename T::V &a, const typename T::V &b, typename T::V &error) {
+            const typename T::V sum = T::add(a, b);
+            const typename T::V b_part = T::sub(sum, a);
+            error = T::add(T::sub(a, T::sub(sum, b_part)), T::sub(b, b_part));
+            return sum;
+        }
+
+        // c[0] + c[1] x + ... + c[size - 1] x^(size - 1) by Estrin's scheme, the dependency chain is logarithmic in size
+        // instead of linear as for Horner's
+        template<class T, std::size_t size>
+        typename T::V polynomial(const typename T::V &x, const double (&c)[size]) {
+            using V = typename T::V;
+            V terms[(size + 1) / 2];
+            for (std::size_t i{0}; i < size / 2; ++i) {
+                terms[i] = T::fma(T::set1(c[2 * i + 1]), x, T::set1(c[2 * i]));
+            }
+            if (size % 2 == 1) {
+                terms[size / 2] = T::set1(c[size - 1]);
+            }
+            V power = T::mul(x, x);
+            for (std::size_t n{(size + 1) / 2}; n > 1; n = (n + 1) / 2) {
+                for (std::size_t i{0}; i < n / 2; ++i) {
+                    terms[i] = T::fma(terms[2 * i + 1], power, terms[2 * i]);
+                }
+                if (n % 2 == 1) {
+                    terms[n / 2] = terms[n - 1];
+                }
+                power = T::mul(power, power);
+            }
+            return terms[0];
+        }
+
+        // exp(x + lo) for a correction |lo| <= ulp(x): 2^n * exp(r), n = round(x / ln(2)), |r| <= ln(2) / 2.
+        // The scale is applied as two factors so that subnormal results are rounded only once.
+        template<class T>
+        typename T::V expCore(typename T::V x, const typename T::V &lo) {
+            using V = typename T::V;
+            // NaN passes, being the second operand
+            x = T::min(T::set1(710.0), T::max(T::set1(-746.0), x));
+            const V n = roundToInteger<T>(T::mul(x, T::set1(LOG2_E)));
+            V r = T::sub(T::sub(x, T::mul(n, T::set1(LN2_HI))), T::mul(n, T::set1(LN2_LO)));
+            r = T::add(r, lo);
+            // 1 + (r + r^2 q(r)), the error of q is scaled down by r^2
+            const V q = polynomial<T>(r, EXP_COEFFICIENTS);
+            const V p = T::add(T::set1(1.0), T::fma(T::mul(r, r), q, r));
+            const V half = roundToInteger<T>(T::mul(n, T::set1(0.5)));
+            return T::mul(T::mul(p, powerOfTwo<T>(half)), powerOfTwo<T>(T::sub(n, half)));
+        }
+
+        // x = 2^k * m with m in [sqrt(2) / 2, sqrt(2)) for positive finite x, returns m
+        template<class T>
+        typename T::V reduceLog(typename T::V x, typename T::V &k) {
+            using V = typename T::V;
+            using M = typename T::M;
+            const M subnormal = T::lt(x, T::set1(SMALLEST_NORMAL));
+            x = T::select(subnormal, T::mul(x, T::set1(0x1p54)), x);
+            const typename T::I bits = T::bits(x);
+            // the biased exponent e as 2^52 + e - 2^52
+            k = T::sub(T::fromBits(T::or64(T::template shr<52>(bits), T::bits(T::set1(0x1p52)))),
+                       T::set1(0x1p52 + 1023.0));
+            V m = T::fromBits(T::or64(T::and64(bits, T::set1i(MANTISSA_BITS)), T::bits(T::set1(1.0))));
+            const M high = T::gt(m, T::set1(SQRT_2));
+            m = T::select(high, T::mul(m, T::set1(0.5)), m);
+            k = T::add(k, T::select(high, T::set1(1.0), T::set1(0.0)));
+            k = T::sub(k, T::select(subnormal, T::set1(54.0), T::set1(0.0)));
+            return m;
+        }
+
+        // log(x) for positive finite x within 1 ulp (fdlibm's e_log.c): log(m) = f - hfsq + s * (hfsq + R(s^2)) with
+        // f = m - 1, hfsq = f^2 / 2, s = f / (2 + f)
+        template<class T>
+        typename T::V logFinite(const typename T::V &x) {
+            using V = typename T::V;
+            V k;
+            const V f = T::sub(reduceLog<T>(x, k), T::set1(1.0));
+            const V hfsq = T::mul(T::set1(0.5), T::mul(f, f));
+            const V s = T::div(f, T::add(T::set1(2.0), f));
+            const V z = T::mul(s, s);
+            const V r = T::mul(z, polynomial<T>(z, LOG_COEFFICIENTS));
+            const V inner = T::add(T::mul(s, T::add(hfsq, r)), T::mul(k, T::set1(LN2_LO)));
+            return T::sub(T::mul(k, T::set1(LN2_HI)), T::sub(T::sub(hfsq, inner), f));
+        }
+
+        // log(x) = hi + lo for positive finite x with a relative error around 2^-60, with
+        // log(m) = 2 atanh(s) = 2s + 2s^3 / 3 + ..., s = (m - 1) / (m + 1). The leading terms 2s and 2s^3 / 3 are carried
+        // in double-double, POW multiplies the result by exponents up to 1000 and more.
+        template<class T>
+        typename T::V logCore(const typename T::V &x, typename T::V &lo) {
+            using V = typename T::V;
+            V k;
+            const V m = reduceLog<T>(x, k);
+
+            // s = f / (2 + f) + s_lo with f = m - 1 exact
+            const V f = T::sub(m, T::set1(1.0));
+            V d_lo;
+            const V d = fastTwoSum<T>(T::set1(2.0), f, d_lo);
+            // s need not be correctly rounded, s_lo takes the remainder
+            const V inverse = T::div(T::set1(1.0), d);
+            const V s = T::mul(f, inverse);
+            V sd_lo;
+            const V sd = T::twoProd(s, d, sd_lo);
+            const V s_lo = T::mul(T::sub(T::sub(T::sub(f, sd), sd_lo), T::mul(s, d_lo)), inverse);
+
+            // s^3 = c + cube_lo, then 2s^3 / 3 = t + t_lo
+            V z_lo;
+            const V z = T::twoProd(s, s, z_lo);
+            V c_lo;
+            const V c = T::twoProd(z, s, c_lo);
+            const V cube_lo = T::add(T::add(c_lo, T::mul(z_lo, s)), T::mul(T::mul(T::set1(3.0), z), s_lo));
+            V t_lo;
+            const V t = T::twoProd(c, T::set1(TWO_THIRDS_HI), t_lo);
+            t_lo = T::add(t_lo, T::add(T::mul(c, T::set1(TWO_THIRDS_LO)), T::mul(cube_lo, T::set1(TWO_THIRDS_HI))));
+
+            const V tail = T::mul(T::mul(c, z), polynomial<T>(z, ATANH_COEFFICIENTS));
+
+            V h_lo;
+            const V h = twoSum<T>(T::add(s, s), t, h_lo);
+            V sum_lo;
+            const V sum = twoSum<T>(T::mul(k, T::set1(LN2_HI)), h, sum_lo);
+            V rest = T::add(T::add(s_lo, s_lo), t_lo);
+            rest = T::add(T::add(rest, T::add(h_lo, sum_lo)), T::add(tail, T::mul(k, T::set1(LN2_LO))));
+            return fastTwoSum<T>(sum, rest, lo);
+        }
+
+        template<class T>
+        typename T::V expLanes(const typename T::V &x) {
+            return expCore<T>(x, T::set1(0.0));
+        }
+
+        template<class T>
+        typename T::V logLanes(const typename T::V &x) {
+            using V = typename T::V;
+            V result = logFinite<T>(x);
+            result = T::select(T::lt(x, T::set1(0.0)), T::set1(NAN_VALUE), result);
+            result = T::select(T::eq(x, T::set1(0.0)), T::set1(-INF), result);
+            result = T::select(T::eq(x, T::set1(INF)), T::set1(INF), result);
+            return T::select(T::unordered(x, x), x, result);
+        }
+
+        // exp(y * log(x)), lanes outside of x in (0, inf), |y * log(x)| < 746 are recomputed by std::pow
+        template<class T>
+        void powLanes(const typename T::V &x, const typename T::V &y, SCALAR *out) {
+            using V = typename T::V;
+            V log_lo;
+            const V log_hi = logCore<T>(x, log_lo);
+            V product_lo;
+            const V product = T::twoProd(y, log_hi, product_lo);
+            product_lo = T::add(product_lo, T::mul(y, log_lo));
+            T::store(out, expCore<T>(product, product_lo));
+
+            // the product error is not finite when Dekker's split overflows (|y| > 2^996 without FMA)
+            const typename T::M valid = T::both(
+                T::both(T::both(T::gt(x, T::set1(0.0)), T::lt(x, T::set1(INF))),
+                        T::both(T::lt(product, T::set1(746.0)), T::gt(product, T::set1(-746.0)))),
+                T::both(T::lt(product_lo, T::set1(INF)), T::gt(product_lo, T::set1(-INF)))
+            );
+            if (!T::all(valid)) {
+                SCALAR xs[T::W];
+                SCALAR ys[T::W];
+                T::store(xs, x);
+                T::store(ys, y);
+                const unsigned lanes = T::maskBits(valid);
+                for (std::size_t j{0}; j < T::W; ++j) {
+                    if (((lanes >> j) & 1U) == 0) {
+                        out[j] = std::pow(xs[j], ys[j]);
+                    }
+                }
+            }
+        }
+
+        template<class T, class vector_function>
+        void unaryLoop(const SCALAR *in, SCALAR *out, const std::size_t size, vector_function f) {
+            std::size_t i{0};
+            for (; i + T::W <= size; i += T::W) {
+                T::store(out + i, f(T::load(in + i)));
+            }
+            if (i < size) {
+                SCALAR buffer[T::W];
+                for (std::size_t j{0}; j < T::W; ++j) {
+                    buffer[j] = i + j < size ? in[i + j] : PADDING;
+                }
+                T::store(buffer, f(T::load(buffer)));
+                for (std::size_t j{0}; i + j < size; ++j) {
+                    out[i + j] = buffer[j];
+                }
+            }
+        }
+
+        // a scalar operand (vector == false) is broadcast to all lanes
+        template<class T, bool vector>
+        typename T::V loadOperand(const SCALAR *operand, const std::size_t &i) {
+            if constexpr (vector) {
+                return T::load(operand + i);
+            }
+            else {
+                return T::set1(*operand);
+            }
+        }
+
+        template<class T, bool left_vector, bool right_vector>
+        void powLoop(const SCALAR *left, const SCALAR *right, SCALAR *out, const std::size_t size) {
+            std::size_t i{0};
+            for (; i + T::W <= size; i += T::W) {
+                powLanes<T>(loadOperand<T, left_vector>(left, i), loadOperand<T, right_vector>(right, i), out + i);
+            }
+            if (i < size) {
+                SCALAR left_buffer[T::W];
+                SCALAR right_buffer[T::W];
+                SCALAR buffer[T::W];
+                for (std::size_t j{0}; j < T::W; ++j) {
+                    const bool inside = i + j < size;
+                    left_buffer[j] = inside ? left[left_vector ? i + j : 0] : PADDING;
+                    right_buffer[j] = inside ? right[right_vector ? i + j : 0] : PADDING;
+                }
+                powLanes<T>(T::load(left_buffer), T::load(right_buffer), buffer);
+                for (std::size_t j{0}; i + j < size; ++j) {
+                    out[i + j] = buffer[j];
+                }
+            }
+        }
+
+        // one SUM (PROD) per block of BLOCK elements: the ACCUMULATORS partial results of reductions.h are the lanes of
+        // ACCUMULATORS / W registers
+        template<class T, bool product>
+        void blockLoop(const SCALAR *in, SCALAR *out, const std::size_t size) {
+            using reductions::ACCUMULATORS;
+            using reductions::BLOCK;
+            static_assert(ACCUMULATORS == 8 && ACCUMULATORS % T::W == 0);
+            constexpr std::size_t registers = ACCUMULATORS / T::W;
+            const auto f = [](const SCALAR &left, const SCALAR &right) { return product ? left * right : left + right; };
+            for (std::size_t begin{0}; begin < size; begin += BLOCK) {
+                const std::size_t end = size - begin < BLOCK ? size : begin + BLOCK;
+                typename T::V accumulators[registers];
+                for (auto &accumulator: accumulators) {
+                    accumulator = T::set1(product ? 1.0 : 0.0);
+                }
+                std::size_t i{begin};
+                for (; i + ACCUMULATORS <= end; i += ACCUMULATORS) {
+                    for (std::size_t r{0}; r < registers; ++r) {
+                        const typename T::V x = T::load(in + i + r * T::W);
+                        accumulators[r] = product ? T::mul(accumulators[r], x) : T::add(accumulators[r], x);
+                    }
+                }
+                SCALAR partial[ACCUMULATORS];
+                for (std::size_t r{0}; r < registers; ++r) {
+                    T::store(partial + r * T::W, accumulators[r]);
+                }
+                for (std::size_t j{0}; i + j < end; ++j) {
+                    partial[j] = f(partial[j], in[i + j]);
+                }
+                out[begin / BLOCK] = f(f(f(partial[0], partial[1]), f(partial[2], partial[3])),
+                                       f(f(partial[4], partial[5]), f(partial[6], partial[7])));
+            }
+        }
+
+        // Each lane keeps the first of its elements beating best so far, the lanes are then merged by value and, for
+        // equal values, by index: the result is the first extreme element as found by a sequential scan. NaN never
+        // beats anything, the padding of the last register is NaN.
+        template<class T, bool largest>
+        std::size_t scanLoop(const SCALAR *in, const std::size_t size, SCALAR *best) {
+            const auto beats = [](const typename T::V &x, const typename T::V &value) {
+                return largest ? T::lt(value, x) : T::lt(x, value);
+            };
+            SCALAR offsets[T::W];
+            for (std::size_t j{0}; j < T::W; ++j) {
+                offsets[j] = static_cast<SCALAR>(j);
+            }
+            typename T::V value = T::set1(*best);
+            typename T::V index = T::set1(-1.0);
+            typename T::V position = T::load(offsets);
+            const typename T::V step = T::set1(static_cast<SCALAR>(T::W));
+            std::size_t i{0};
+            for (; i + T::W <= size; i += T::W) {
+                const typename T::V x = T::load(in + i);
+                const typename T::M better = beats(x, value);
+                value = T::select(better, x, value);
+                index = T::select(better, position, index);
+                position = T::add(position, step);
+            }
+            if (i < size) {
+                SCALAR buffer[T::W];
+                for (std::size_t j{0}; j < T::W; ++j) {
+                    buffer[j] = i + j < size ? in[i + j] : NAN_VALUE;
+                }
+                const typename T::V x = T::load(buffer);
+                const typename T::M better = beats(x, value);
+                value = T::select(better, x, value);
+                index = T::select(better, position, index);
+            }
+            SCALAR values[T::W];
+            SCALAR indices[T::W];
+            T::store(values, value);
+            T::store(indices, index);
+            std::size_t found{size};
+            SCALAR extreme{*best};
+            for (std::size_t j{0}; j < T::W; ++j) {
+                if (indices[j] < 0.0) {
+                    continue;
+                }
+                const auto k = static_cast<std::size_t>(indices[j]);
+                const bool better = largest ? extreme < values[j] : values[j] < extreme;
+                if ((found == size) || better || ((values[j] == extreme) && (k < found))) {
+                    found = k;
+                    extreme = values[j];
+                }
+            }
+            *best = extreme;
+            return found;
+        }
+
+        template<class T>
+        void expArray(const SCALAR *in, SCALAR *out, std::size_t size) {
+            unaryLoop<T>(in, out, size, [](const typename T::V &x) { return expLanes<T>(x); });
+        }
+
+        template<class T>
+        void logArray(const SCALAR *in, SCALAR *out, std::size_t size) {
+            unaryLoop<T>(in, out, size, [](const typename T::V &x) { return logLanes<T>(x); });
+        }
+
+        template<class T>
+        void sqrtArray(const SCALAR *in, SCALAR *out, std::size_t size) {
+            unaryLoop<T>(in, out, size, [](const typename T::V &x) { return T::sqrt(x); });
+        }
+
+        template<class T>
+        constexpr Kernels makeKernels() {
+            return {
+                &expArray<T>,
+                &logArray<T>,
+                &sqrtArray<T>,
+                &powLoop<T, true, true>,
+                &powLoop<T, true, false>,
+                &powLoop<T, false, true>,
+                &blockLoop<T, false>,
+                &blockLoop<T, true>,
+                &scanLoop<T, true>,
+                &scanLoop<T, false>,
+            };
+        }
+
+    }
+
+}
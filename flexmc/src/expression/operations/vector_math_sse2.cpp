@@ -0,0 +1,115 @@
+#if defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+#endif
+
+#include "vector_math_isa.h"
+#include "vector_math_simd.h"
+
+
+namespace flexMC::vectorMath {
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+    namespace {
+
+        struct Sse2 {
+
+            using V = __m128d;
+            using M = __m128d;
+            using I = __m128i;
+
+            static constexpr std::size_t W = 2;
+
+            static V set1(const double &value) { return _mm_set1_pd(value); }
+
+            static I set1i(const long long &value) { return _mm_set1_epi64x(value); }
+
+            static V load(const double *from) { return _mm_loadu_pd(from); }
+
+            static void store(double *to, const V &value) { _mm_storeu_pd(to, value); }
+
+            static V add(const V &a, const V &b) { return _mm_add_pd(a, b); }
+
+            static V sub(const V &a, const V &b) { return _mm_sub_pd(a, b); }
+
+            static V mul(const V &a, const V &b) { return _mm_mul_pd(a, b); }
+
+            static V div(const V &a, const V &b) { return _mm_div_pd(a, b); }
+
+            static V sqrt(const V &a) { return _mm_sqrt_pd(a); }
+
+            static V min(const V &a, const V &b) { return _mm_min_pd(a, b); }
+
+            static V max(const V &a, const V &b) { return _mm_max_pd(a, b); }
+
+            // not fused, only used where the rounding of the product does not matter
+            static V fma(const V &a, const V &b, const V &c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+
+            // Dekker's product: a * b = result + error exactly
+            static V twoProd(const V &a, const V &b, V &error) {
+                const V product = mul(a, b);
+                const V split = set1(134217729.0);
+                const V a_split = mul(a, split);
+                const V a_hi = sub(a_split, sub(a_split, a));
+                const V a_lo = sub(a, a_hi);
+                const V b_split = mul(b, split);
+                const V b_hi = sub(b_split, sub(b_split, b));
+                const V b_lo = sub(b, b_hi);
+                error = add(add(add(sub(mul(a_hi, b_hi), product), mul(a_hi, b_lo)), mul(a_lo, b_hi)),
+                            mul(a_lo, b_lo));
+                return product;
+            }
+
+            static M lt(const V &a, const V &b) { return _mm_cmplt_pd(a, b); }
+
+            static M gt(const V &a, const V &b) { return _mm_cmpgt_pd(a, b); }
+
+            static M eq(const V &a, const V &b) { return _mm_cmpeq_pd(a, b); }
+
+            static M unordered(const V &a, const V &b) { return _mm_cmpunord_pd(a, b); }
+
+            static M both(const M &a, const M &b) { return _mm_and_pd(a, b); }
+
+            static V select(const M &mask, const V &a, const V &b) {
+                return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+            }
+
+            static unsigned maskBits(const M &mask) { return static_cast<unsigned>(_mm_movemask_pd(mask)); }
+
+            static bool all(const M &mask) { return maskBits(mask) == 0x3U; }
+
+            static I bits(const V &a) { return _mm_castpd_si128(a); }
+
+            static V fromBits(const I &a) { return _mm_castsi128_pd(a); }
+
+            static I add64(const I &a, const I &b) { return _mm_add_epi64(a, b); }
+
+            static I sub64(const I &a, const I &b) { return _mm_sub_epi64(a, b); }
+
+            static I and64(const I &a, const I &b) { return _mm_and_si128(a, b); }
+
+            static I or64(const I &a, const I &b) { return _mm_or_si128(a, b); }
+
+            template<int n>
+            static I shl(const I &a) { return _mm_slli_epi64(a, n); }
+
+            template<int n>
+            static I shr(const I &a) { return _mm_srli_epi64(a, n); }
+
+        };
+
+        constexpr Kernels KERNELS = makeKernels<Sse2>();
+
+    }
+
+    const Kernels *sse2Kernels() { return &KERNELS; }
+
+#else
+
+    const Kernels *sse2Kernels() { return nullptr; }
+
+#endif
+
+}
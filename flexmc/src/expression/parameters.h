@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include "calc_types.h"
+
+
+namespace flexMC {
+
+    // Values of static variables inserted as parameters. Compiled code reads them at evaluation time through the slot
+    // assigned on insertion, such that updating a value does not require compiling again.
+    class Parameters {
+
+    public:
+
+        std::size_t add(const SCALAR &value) {
+            scalars_.push_back(value);
+            return scalars_.size() - 1;
+        }
+
+        std::size_t add(const VECTOR &value) {
+            vectors_.push_back(value);
+            return vectors_.size() - 1;
+        }
+
+        void set(const std::size_t &slot, const SCALAR &value) {
+            assert(slot < scalars_.size());
+            scalars_[slot] = value;
+        }
+
+        // the size of a vector is part of its type and checked at compile time, it cannot change
+        void set(const std::size_t &slot, const VECTOR &value) {
+            assert((slot < vectors_.size()) && (vectors_[slot].size() == value.size()));
+            std::copy(value.begin(), value.end(), vectors_[slot].begin());
+        }
+
+        const SCALAR &scalar(const std::size_t &slot) const { return scalars_[slot]; }
+
+        const VECTOR &vector(const std::size_t &slot) const { return vectors_[slot]; }
+
+        // all scalars by slot, only valid until the next add
+        const SCALAR *scalars() const { return scalars_.data(); }
+
+    private:
+
+        std::vector<SCALAR> scalars_;
+
+        std::vector<VECTOR> vectors_;
+
+    };
+
+}
@@ -6,10 +6,13 @@
 #include <variant>
 #include <optional>
 #include <utility>
+#include <memory>
 
 #include "calc_types.h"
 #include "language_error.h"
 #include "expression_stacks.h"
+#include "byte_code.h"
+#include "parameters.h"
 #include "utils.h"
 
 namespace flexMC {
@@ -22,7 +25,7 @@ namespace flexMC {
 
         bool contains(const std::string_view name) const { return types_.contains(name); }
 
-        CType cType(const std::string &name) const { return types_.at(name); }
+        CType cType(const std::string_view name) const { return atKey(types_, name); }
 
         bool containsUnused() const { return unused_.begin() != unused_.end(); }
 
@@ -36,6 +39,37 @@ namespace flexMC {
             unused_[name] = c_type;
             std::get<VMap < T>>
             (maps_.at(c_type)).data[name] = value;
+            if (slots_.contains(name)) {
+                slots_.erase(name);
+            }
+        }
+
+        // Scalars and vectors inserted as parameters are read at evaluation time instead of being copied into the
+        // compiled code. The returned slot updates the value in O(1) without compiling again.
+        template<class T>
+        std::size_t insertParameter(const std::string &name, const T &value) {
+            static_assert((getCType<T>() == CType::scalar) || (getCType<T>() == CType::vector),
+                          "Only scalars and vectors can be parameters");
+            insert<T>(name, value);
+            const std::size_t slot = parameters_->add(value);
+            slots_[name] = slot;
+            return slot;
+        }
+
+        bool isParameter(const std::string_view name) const { return slots_.contains(name); }
+
+        std::size_t parameterSlot(const std::string_view name) const { return atKey(slots_, name); }
+
+        // the size of a vector parameter cannot change
+        template<class T>
+        void updateParameter(const std::size_t &slot, const T &value) { parameters_->set(slot, value); }
+
+        const Parameters &parameters() const { return *parameters_; }
+
+        // the value of a date, e.g. the date a statement of a script is scheduled on
+        DATE date(const std::string_view name) {
+            assert(contains(name) && (cType(name) == CType::date));
+            return get<DATE>(name);
         }
 
     private:
@@ -55,6 +89,11 @@ namespace flexMC {
 
         StringMap<CType> unused_;
 
+        // compiled code refers to the parameters, which therefore stay in place when the storage is moved
+        std::unique_ptr<Parameters> parameters_ = std::make_unique<Parameters>();
+
+        StringMap<std::size_t> slots_;
+
         CTypeMap<VMapT> initialize() const {
             VMap<SCALAR> scalars;
             VMap<VECTOR> vectors;
@@ -91,13 +130,13 @@ namespace flexMC {
             }
         }
 
-        void use(const std::string &name) {
-            if (unused_.contains(name)) {
-                unused_.erase(name);
+        void use(const std::string_view name) {
+            if (const auto it = unused_.find(name); it != unused_.end()) {
+                unused_.erase(it);
             }
         }
 
-        void compileSingleType(Operands &stacks, const std::string &name, const CType &c_type) {
+        void compileSingleType(Operands &stacks, const std::string_view name, const CType &c_type) {
             // std::get actual value not checked
             assert((contains(name)) && (cType(name) == c_type));
             use(name);
@@ -105,16 +144,15 @@ namespace flexMC {
         };
 
         template<class T>
-        T &get(const std::string &name) {
+        T &get(const std::string_view name) {
             constexpr CType c_type = getCType<T>();
             assert((contains(name)) && (cType(name) == c_type));
             use(name);
-            return std::get<VMap<T>>
-                (maps_.at(c_type)).data.at(name);
+            return atKey(std::get<VMap<T>>(maps_.at(c_type)).data, name);
         }
 
         template<class T>
-        void compileArrayType(Operands &stacks, const std::string &name) {
+        void compileArrayType(Operands &stacks, const std::string_view name) {
             constexpr CType c_type = getCType<T>();
             static_assert((c_type == CType::vector) || (c_type == CType::date_list));
             const size_t s = get<T>(name).size();
@@ -131,37 +169,85 @@ namespace flexMC {
         };
 
         template<class T>
-        Operation compile(const std::string &name) {
+        Operation compile(const std::string_view name) {
             return compile_(name, TAlias<T>());
         }
 
         // SonarLint "this function should be declared const"
         template<class T>
-        Operation compile_(const std::string &, TAlias<T>) {
+        Operation compile_(const std::string_view, TAlias<T>) {
             static_assert(getCType<T>() != CType::undefined, "No template specialisation for the given type T");
             return Operation([](const CalcStacks &) {/* must be overwritten by template specialization */});
         }
 
-        Operation compile_(const std::string &name, TAlias<SCALAR>) {
+        Operation compile_(const std::string_view name, TAlias<SCALAR>) {
+            if (isParameter(name)) {
+                use(name);
+                const Parameters *parameters = parameters_.get();
+                const std::size_t slot = atKey(slots_, name);
+                return Operation([parameters, slot](CalcStacks &stacks) {
+                    stacks.scalars().emplace_back(parameters->scalar(slot));
+                });
+            }
             const SCALAR value = get<SCALAR>(name);
             return Operation([value](CalcStacks &stacks) { stacks.scalars().emplace_back(value); });
         }
 
-        Operation compile_(const std::string &name, TAlias<VECTOR>) {
+        Operation compile_(const std::string_view name, TAlias<VECTOR>) {
+            if (isParameter(name)) {
+                use(name);
+                const Parameters *parameters = parameters_.get();
+                const std::size_t slot = atKey(slots_, name);
+                return Operation([parameters, slot](CalcStacks &stacks) {
+                    stacks.pushVector(parameters->vector(slot));
+                });
+            }
             const VECTOR value = get<VECTOR>(name);
             return Operation([value](CalcStacks &stacks) { stacks.pushVector(value); });
         }
 
-        Operation compile_(const std::string &name, TAlias<DATE>) {
+        Operation compile_(const std::string_view name, TAlias<DATE>) {
             const DATE value = get<DATE>(name);
             return Operation([value](CalcStacks &stacks) { stacks.dates().emplace_back(value); });
         }
 
-        Operation compile_(const std::string &name, TAlias<DATE_LIST>) {
+        Operation compile_(const std::string_view name, TAlias<DATE_LIST>) {
             const DATE_LIST value = get<DATE_LIST>(name);
             return Operation([value](CalcStacks &stacks) { stacks.pushDateList(value); });
         }
 
+        void compileInto(const std::string_view name, const CType &c_type, ByteCode &code) {
+            using
+            enum CType;
+            if (isParameter(name)) {
+                assert((c_type == scalar) || (c_type == vector));
+                use(name);
+                if (c_type == scalar) {
+                    code.loadScalar(*parameters_, atKey(slots_, name));
+                }
+                else {
+                    code.loadVector(*parameters_, atKey(slots_, name));
+                }
+                return;
+            }
+            switch (c_type) {
+                case scalar:
+                    code.pushScalar(get<SCALAR>(name));
+                    break;
+                case vector:
+                    code.pushVector(get<VECTOR>(name));
+                    break;
+                case date:
+                    code.pushDate(get<DATE>(name));
+                    break;
+                case date_list:
+                    code.pushDateList(get<DATE_LIST>(name));
+                    break;
+                default:
+                    break;
+            }
+        }
+
     };
 
     class StaticVCompiler {
@@ -174,7 +260,7 @@ namespace flexMC {
         };
 
         static std::pair<Status, std::optional<Operation>>
-        tryCompile(const std::string &name, Operands &stacks, StaticVStorage &storage) {
+        tryCompile(const std::string_view name, Operands &stacks, StaticVStorage &storage) {
             using
             enum CType;
             using
@@ -203,5 +289,31 @@ namespace flexMC {
             return {not_found, {}};
         }
 
+        static Status tryCompile(const std::string_view name, Operands &stacks, StaticVStorage &storage, ByteCode &code) {
+            using
+            enum CType;
+            if (!storage.contains(name)) {
+                return Status::not_found;
+            }
+            const CType c_type = storage.cType(name);
+            assert(c_type != undefined);
+            switch (c_type) {
+                case scalar:
+                case date:
+                    storage.compileSingleType(stacks, name, c_type);
+                    break;
+                case vector:
+                    storage.compileArrayType<VECTOR>(stacks, name);
+                    break;
+                case date_list:
+                    storage.compileArrayType<DATE_LIST>(stacks, name);
+                    break;
+                default:
+                    return Status::not_found;
+            }
+            storage.compileInto(name, c_type, code);
+            return Status::found;
+        }
+
     };
 }
@@ -35,7 +35,12 @@ namespace flexMC {
         std::stringstream out;
         auto [start, size] = report.position();
         auto len = std::max<size_t>(size, 1);
-        out << fmt::format("{} Error in line:\n", err_prefix);
+        if (report.line() > 0) {
+            out << fmt::format("{} Error in line {}, column {}:\n", err_prefix, report.line(), start + 1);
+        }
+        else {
+            out << fmt::format("{} Error in line:\n", err_prefix);
+        }
         out << fmt::format("\"{}\"", line) << "\n";
         out << " " << std::string(start, ' ') << std::string(len, '^') << "\n";
         out << report.msg() << '.';
@@ -24,6 +24,11 @@ namespace flexMC {
 
         std::pair<size_t, size_t> position() const { return std::make_pair(err_at_, err_len_); }
 
+        // line of a script, counted from 1, 0 for a single line
+        void setLine(const std::size_t &line) { err_line_ = line; }
+
+        std::size_t line() const { return err_line_; }
+
         std::string msg() const { return err_msg_; }
 
     private:
@@ -34,6 +39,8 @@ namespace flexMC {
 
         std::size_t err_len_{0};
 
+        std::size_t err_line_{0};
+
     };
 
     std::string printError(const std::string_view err_prefix,
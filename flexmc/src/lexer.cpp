@@ -1,4 +1,6 @@
-#include <cassert>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 
 #include "terminals.h"
 #include "tokens.h"
@@ -7,70 +9,184 @@
 
 namespace flexMC {
 
-    Lexer::Lexer() {
-        std::string all_groups_1 = "(";
-        for (const auto &s: R_GROUPS_1) {
-            all_groups_1 += s + ")|(";
+    namespace {
+
+        // character classes of the regular expressions in terminals.h, ASCII only like std::regex in the "C" locale
+        enum CharClass : std::uint8_t {
+            ID_START = 1,  // [_a-z]
+            WORD = 2,      // \w
+            DIGIT = 4,     // \d
+            SPACE = 8,     // \s
+            UPPER = 16,    // [A-Z], the first character of a keyword, function or word operator
+        };
+
+        constexpr std::array<std::uint8_t, 256> CHAR_CLASSES = [] {
+            std::array<std::uint8_t, 256> classes{};
+            for (unsigned char c{'a'}; c <= 'z'; ++c) {
+                classes[c] = ID_START | WORD;
+            }
+            for (unsigned char c{'A'}; c <= 'Z'; ++c) {
+                classes[c] = UPPER | WORD;
+            }
+            for (unsigned char c{'0'}; c <= '9'; ++c) {
+                classes[c] = DIGIT | WORD;
+            }
+            classes['_'] = ID_START | WORD;
+            for (const unsigned char c: {' ', '\t', '\n', '\v', '\f', '\r'}) {
+                classes[c] = SPACE;
+            }
+            return classes;
+        }();
+
+        // the words of R_GROUPS_2 in the order of the alternatives, no word but PAY is a prefix of a later one
+        constexpr std::array<std::string_view, 22> WORDS{
+            IF, CONTINUOUS, ELSE, AND, OR, NOT, PAY_AT, PAY, TERMINATE, EXP, LOG, ABS, SQRT, SQUARE, MIN, MAX, SUM,
+            PROD, ARGMIN, ARGMAX, LEN, "APPEND"
+        };
+
+        bool is(const std::string_view &s, const std::size_t &at, const CharClass &char_class) {
+            return (at < s.size()) && ((CHAR_CLASSES[static_cast<unsigned char>(s[at])] & char_class) != 0);
+        }
+
+        bool is(const std::string_view &s, const std::size_t &at, const char &c) {
+            return (at < s.size()) && (s[at] == c);
+        }
+
+        std::size_t skip(const std::string_view &s, std::size_t at, const CharClass &char_class) {
+            while (is(s, at, char_class)) {
+                ++at;
+            }
+            return at;
+        }
+
+        // The match lengths below are 0 if there is no match
+
+        // R_ID
+        std::size_t matchId(const std::string_view &s) {
+            return is(s, 0, ID_START) ? skip(s, 1, WORD) : 0;
         }
 
-        std::string all_groups_2 = "(";
-        for (const auto &s: R_GROUPS_2) {
-            all_groups_2 += s + ")|(";
+        // R_NUM
+        std::size_t matchNumber(const std::string_view &s) {
+            std::size_t end{0};
+            if (is(s, 0, DIGIT)) {
+                end = skip(s, 1, DIGIT);
+                if (is(s, end, '.')) {
+                    end = skip(s, end + 1, DIGIT);
+                }
+            }
+            else if (is(s, 0, '.') && is(s, 1, DIGIT)) {
+                end = skip(s, 2, DIGIT);
+            }
+            else {
+                return 0;
+            }
+            if (is(s, end, 'e') || is(s, end, 'E')) {
+                const std::size_t sign = (is(s, end + 1, '+') || is(s, end + 1, '-')) ? 1 : 0;
+                if (is(s, end + 1 + sign, DIGIT)) {
+                    end = skip(s, end + 2 + sign, DIGIT);
+                }
+            }
+            return end;
+        }
+
+        // R_GROUPS_1
+        std::size_t matchGroup1(const std::string_view &s) {
+            if (s.starts_with(POW)) {
+                return is(s, 2, '=') ? 3 : 2;
+            }
+            return (is(s, 0, SPACE) && is(s, 1, SPACE) && is(s, 2, SPACE) && is(s, 3, SPACE)) ? 4 : 0;
+        }
+
+        // R_GROUPS_2
+        std::size_t matchGroup2(const std::string_view &s) {
+            if (is(s, 0, UPPER)) {
+                for (const auto &word: WORDS) {
+                    if (s.starts_with(word)) {
+                        return word.size();
+                    }
+                }
+                return 0;
+            }
+            if (is(s, 0, SPACE)) {
+                return 1;
+            }
+            switch (s[0]) {
+                case ':':
+                    return is(s, 1, '=') ? 2 : 0;
+                case '+':
+                case '-':
+                case '*':
+                case '/':
+                    return is(s, 1, '=') ? 2 : 1;
+                case '<':
+                    return (is(s, 1, '<') || is(s, 1, '=')) ? 2 : 1;
+                case '>':
+                    return (is(s, 1, '>') || is(s, 1, '=')) ? 2 : 1;
+                case ',':
+                case '(':
+                case ')':
+                case '[':
+                case ']':
+                    return 1;
+                default:
+                    return 0;
+            }
         }
 
-        groups_1_ = std::regex(all_groups_1.substr(0, all_groups_1.size() - 2));
-        groups_2_ = std::regex(all_groups_2.substr(0, all_groups_2.size() - 2));
-        id_ = std::regex(R_ID);
-        num_ = std::regex(R_NUM);
     }
 
-    std::deque<Token> Lexer::tokenize(const std::string_view line) {
-        auto [token, current_suffix] = nextTok(line, 0);
+    std::vector<Token> Lexer::tokenize(const std::string_view line) const {
+        std::vector<Token> out;
+        // a token takes at least one character, except for the eof and undefined tokens ending the line
+        out.reserve(std::min(line.size(), MAX_LINE_LEN + 1) + 2);
+        tokenize(line, out);
+        return out;
+    }
+
+    void Lexer::tokenize(const std::string_view line, std::vector<Token> &out) const {
+        auto [token, consumed] = nextTok(line, 0);
         Token::Type previous = token.type;
+        std::size_t position = consumed;
         std::size_t line_no = token.size;
-        std::deque<Token> out({token});
+        out.clear();
+        out.push_back(token);
 
         using
         enum Token::Type;
 
         while ((previous != eof) && (previous != undefined) && (line_no <= MAX_LINE_LEN)) {
-            auto [next, suffix] = nextTok(current_suffix, line_no);
+            auto [next, length] = nextTok(line.substr(position), line_no);
             previous = next.type;
+            position += length;
             line_no += next.size;
             out.push_back(next);
-            current_suffix = suffix;
         }
         if (out.back().type != eof) {
             out.emplace_back(eof, "", line_no);
         }
-        return out;
     }
 
-    std::pair<Token, std::string> Lexer::nextTok(const std::string_view suffix, const std::size_t &line_no) {
+    std::pair<Token, std::size_t> Lexer::nextTok(const std::string_view suffix, const std::size_t &line_no) {
         using
         enum Token::Type;
 
         if (suffix.empty()) {
-            return std::make_pair(Token(eof, "", line_no), "");
+            return {Token(eof, "", line_no), 0};
         }
-        if (std::regex_search(suffix.cbegin(), suffix.cend(), match_, id_)) {
-            auto t = Token(id, match_.str(), line_no);
-            return std::make_pair(t, match_.suffix());
+        if (const auto length = matchId(suffix); length > 0) {
+            return {Token(id, suffix.substr(0, length), line_no), length};
         }
-
-        if (std::regex_search(suffix.cbegin(), suffix.cend(), match_, num_)) {
-            auto t = Token(num, match_.str(), line_no);
-            return std::make_pair(t, match_.suffix());
+        if (const auto length = matchNumber(suffix); length > 0) {
+            return {Token(num, suffix.substr(0, length), line_no), length};
         }
-
-        if (std::regex_search(suffix.cbegin(), suffix.cend(), match_, groups_1_)) {
-            return std::make_pair(Tokens::makeContextualized(match_.str(), line_no), match_.suffix());
+        if (const auto length = matchGroup1(suffix); length > 0) {
+            return {Tokens::makeContextualized(suffix.substr(0, length), line_no), length};
         }
-
-        if (std::regex_search(suffix.cbegin(), suffix.cend(), match_, groups_2_)) {
-            return std::make_pair(Tokens::makeContextualized(match_.str(), line_no), match_.suffix());
+        if (const auto length = matchGroup2(suffix); length > 0) {
+            return {Tokens::makeContextualized(suffix.substr(0, length), line_no), length};
         }
-        return std::make_pair(Token(undefined, suffix.data(), line_no, 0), suffix.data());
+        return {Token(undefined, suffix, line_no, 0), suffix.size()};
     }
 
 }
@@ -1,31 +1,30 @@
 #pragma once
 
 #include <string_view>
-#include <regex>
-#include <deque>
 #include <utility>
+#include <vector>
 
 #include "tokens.h"
 
 namespace flexMC {
 
+    // Hand-written scanner for the token grammar of terminals.h (R_ID, R_NUM, R_GROUPS_1 and R_GROUPS_2, tried in this
+    // order, alternatives first match). Each character of a line is looked at a bounded number of times and the
+    // scanner owns no state, so a Lexer is free to construct and tokenize() is linear in the length of the line.
     class Lexer {
 
     public:
 
-        Lexer();
+        // the tokens are views into line
+        std::vector<Token> tokenize(const std::string_view line) const;
 
-        std::deque<Token> tokenize(const std::string_view line);
+        // replaces the content of out, whose capacity is reused from line to line
+        void tokenize(const std::string_view line, std::vector<Token> &out) const;
 
     private:
 
-        std::pair<Token, std::string> nextTok(const std::string_view suffix, const std::size_t &line_no);
-
-        std::regex groups_1_;
-        std::regex groups_2_;
-        std::regex id_;
-        std::regex num_;
-        std::match_results<std::string_view::const_iterator> match_;
+        // the next token and the number of characters of suffix it consumes
+        static std::pair<Token, std::size_t> nextTok(const std::string_view suffix, const std::size_t &line_no);
 
     };
 }
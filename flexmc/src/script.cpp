@@ -0,0 +1,159 @@
+#if defined(_WIN32)
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include <fmt/format.h>
+
+#include "expression_parser.h"
+#include "statement_parser.h"
+#include "script.h"
+
+
+namespace flexMC {
+
+    Script::Script(std::string source) :
+        owned_(std::make_unique<std::string>(std::move(source))) {
+        data_ = owned_->data();
+        size_ = owned_->size();
+    }
+
+    Script::Script(Script &&other) noexcept:
+        data_(other.data_),
+        size_(other.size_),
+        mapped_(other.mapped_),
+        owned_(std::move(other.owned_)) {
+        other.data_ = "";
+        other.size_ = 0;
+        other.mapped_ = 0;
+    }
+
+    Script &Script::operator=(Script &&other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = other.data_;
+            size_ = other.size_;
+            mapped_ = other.mapped_;
+            owned_ = std::move(other.owned_);
+            other.data_ = "";
+            other.size_ = 0;
+            other.mapped_ = 0;
+        }
+        return *this;
+    }
+
+    Script::~Script() { close(); }
+
+#if defined(_WIN32)
+
+    MaybeError Script::open(const std::string &path) {
+        close();
+        MaybeError report;
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            report.setMessage(fmt::format(R"(Cannot read "{}")", path));
+            return report;
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        *this = Script(content.str());
+        return report;
+    }
+
+    void Script::close() {
+        owned_.reset();
+        data_ = "";
+        size_ = 0;
+    }
+
+#else
+
+    MaybeError Script::open(const std::string &path) {
+        close();
+        MaybeError report;
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            report.setMessage(fmt::format(R"(Cannot read "{}": {})", path, std::strerror(errno)));
+            return report;
+        }
+        struct stat info{};
+        if (fstat(fd, &info) != 0) {
+            report.setMessage(fmt::format(R"(Cannot read "{}": {})", path, std::strerror(errno)));
+        }
+        else if (info.st_size > 0) {
+            // read-only private mapping, the pages are only read in as the lexer reaches them
+            void *mapping = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                report.setMessage(fmt::format(R"(Cannot map "{}": {})", path, std::strerror(errno)));
+            }
+            else {
+                madvise(mapping, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+                data_ = static_cast<const char *>(mapping);
+                size_ = static_cast<std::size_t>(info.st_size);
+                mapped_ = size_;
+            }
+        }
+        ::close(fd);
+        return report;
+    }
+
+    void Script::close() {
+        if (mapped_ > 0) {
+            munmap(const_cast<char *>(data_), mapped_);
+        }
+        owned_.reset();
+        data_ = "";
+        size_ = 0;
+        mapped_ = 0;
+    }
+
+#endif
+
+    bool ScriptLines::next() {
+        while (!rest_.empty()) {
+            const std::size_t end = rest_.find('\n');
+            line_ = rest_.substr(0, end);
+            rest_ = end == std::string_view::npos ? std::string_view() : rest_.substr(end + 1);
+            if (line_.ends_with('\r')) {
+                line_.remove_suffix(1);
+            }
+            ++number_;
+            if (line_.find_first_not_of(" \t") != std::string_view::npos) {
+                lexer_.tokenize(line_, tokens_);
+                return true;
+            }
+        }
+        line_ = {};
+        tokens_.clear();
+        return false;
+    }
+
+    std::pair<MaybeError, std::vector<ScriptStatement>> parseScript(const std::string_view source) {
+        std::vector<ScriptStatement> statements;
+        ScriptLines lines(source);
+        while (lines.next()) {
+            auto [report, parsed] = parseStartOfLine(lines.tokens());
+            std::vector<Token> postfix;
+            if (!report.isError() && !parsed.expression_infix.empty() &&
+                (parsed.expression_infix.front().type != Token::Type::eof)) {
+                auto [expression_report, expression_postfix] = infixToPostfix(parsed.expression_infix);
+                report = expression_report;
+                postfix = std::move(expression_postfix);
+            }
+            if (report.isError()) {
+                report.setLine(lines.number());
+                return {report, {}};
+            }
+            statements.push_back({lines.number(), std::move(parsed.statement_begin), std::move(postfix)});
+        }
+        return {MaybeError(), std::move(statements)};
+    }
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tokens.h"
+#include "lexer.h"
+#include "language_error.h"
+
+
+namespace flexMC {
+
+    // Source text of a multi-line script, memory mapped from a file or owned. Lines and tokens are views into it,
+    // they stay valid as long as the Script, also when it is moved.
+    class Script {
+
+    public:
+
+        Script() = default;
+
+        explicit Script(std::string source);
+
+        Script(const Script &) = delete;
+
+        Script &operator=(const Script &) = delete;
+
+        Script(Script &&other) noexcept;
+
+        Script &operator=(Script &&other) noexcept;
+
+        ~Script();
+
+        MaybeError open(const std::string &path);
+
+        std::string_view source() const { return {data_, size_}; }
+
+    private:
+
+        void close();
+
+        const char *data_{""};
+
+        std::size_t size_{0};
+
+        // length of the mapping, 0 if the source is not mapped
+        std::size_t mapped_{0};
+
+        std::unique_ptr<std::string> owned_;
+
+    };
+
+    // One pass over the lines of a source: each call to next() moves to the next line that is not blank and lexes it
+    // into the same token buffer.
+    class ScriptLines {
+
+    public:
+
+        explicit ScriptLines(const std::string_view source) : rest_(source) {}
+
+        // false after the last line
+        bool next();
+
+        // counted from 1
+        std::size_t number() const { return number_; }
+
+        // without the line break
+        std::string_view line() const { return line_; }
+
+        const std::vector<Token> &tokens() const { return tokens_; }
+
+    private:
+
+        Lexer lexer_;
+
+        std::string_view rest_;
+
+        std::string_view line_;
+
+        std::size_t number_{0};
+
+        std::vector<Token> tokens_;
+
+    };
+
+    struct ScriptStatement {
+        std::size_t line_no;
+        std::vector<Token> statement_begin;
+        // empty if the statement has no expression, e.g. ELSE
+        std::vector<Token> postfix;
+    };
+
+    // Splits, lexes and parses all lines of a script in one pass. The error carries the line it occurred in.
+    std::pair<MaybeError, std::vector<ScriptStatement>> parseScript(const std::string_view source);
+
+}
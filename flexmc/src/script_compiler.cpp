@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <optional>
+#include <fmt/format.h>
+
+#include "terminals.h"
+#include "statement_definitions.h"
+#include "peephole.h"
+#include "loop_fusion.h"
+#include "script_compiler.h"
+
+
+namespace flexMC {
+
+    CompiledScript::CompiledScript(ByteCode code, LocalVariables variables, const std::size_t &max_scalar,
+                                   const std::size_t &max_vector) :
+        code_(std::move(code)),
+        variables_(std::move(variables)),
+        max_scalar_(max_scalar),
+        max_vector_(max_vector) {}
+
+    SCALAR CompiledScript::scalar(const CalcStacks &stacks, const std::string_view name) const {
+        const LocalVariable &local = variable(name);
+        assert(local.type == CType::scalar);
+        return stacks.localScalar(local.slot);
+    }
+
+    VECTOR CompiledScript::vector(const CalcStacks &stacks, const std::string_view name) const {
+        const LocalVariable &local = variable(name);
+        assert(local.type == CType::vector);
+        return stacks.localVector(local.slot, local.size);
+    }
+
+    std::vector<SCALAR> CompiledScript::scalar(const BatchStacks &stacks, const std::string_view name) const {
+        const LocalVariable &local = variable(name);
+        assert(local.type == CType::scalar);
+        return stacks.localScalar(local.slot);
+    }
+
+    VECTOR CompiledScript::vector(const BatchStacks &stacks, const std::string_view name,
+                                  const std::size_t &path) const {
+        const LocalVariable &local = variable(name);
+        assert(local.type == CType::vector);
+        return stacks.localVector(local.slot, local.size, path);
+    }
+
+    void CompiledScript::setScalar(BatchStacks &stacks, const std::string_view name, const SCALAR *values) const {
+        const LocalVariable &local = variable(name);
+        assert(local.type == CType::scalar);
+        stacks.setLocalScalar(local.slot, values);
+    }
+
+    namespace {
+
+        using statement::Word;
+
+        // x op= e is compiled as x := x op e
+        constexpr std::array<std::pair<Word, std::string_view>, 5> COMPOUND_ASSIGNMENTS{{
+            {Word::plus_assign,  PLUS},
+            {Word::minus_assign, MINUS},
+            {Word::mul_assign,   MUL},
+            {Word::div_assign,   DIV},
+            {Word::pow_assign,   POW},
+        }};
+
+        Word wordOf(const Token &token) { return statement::intern(token.type, token.value); }
+
+        // Lowers the statements one by one. A block is a statement which is not indented together with the indented
+        // statements and the ELSE following it, its jumps are resolved when the next block starts.
+        class ScriptCompiler {
+
+        public:
+
+            explicit ScriptCompiler(StaticVStorage &storage) : storage_(storage) {}
+
+            MaybeError compile(const ScriptStatement &statement);
+
+            CompiledScript finish() {
+                closeBlock();
+                return {std::move(code_), std::move(variables_), max_scalar_, max_vector_};
+            }
+
+        private:
+
+            MaybeError compileBlockStart(const ScriptStatement &statement);
+
+            MaybeError compileIndented(const ScriptStatement &statement);
+
+            MaybeError compileElse(const Token &token);
+
+            MaybeError compileDate(const Token &token);
+
+            MaybeError compileCondition(const Token &token, const std::vector<Token> &postfix);
+
+            MaybeError compileAssignment(const Token &name, const Token &assignment, const std::vector<Token> &postfix);
+
+            // compiles the expression and appends it to the script
+            std::pair<MaybeError, CompileReport> append(const std::vector<Token> &postfix);
+
+            void closeBlock();
+
+            StaticVStorage &storage_;
+
+            ByteCode code_;
+
+            LocalVariables variables_;
+
+            std::size_t max_scalar_{0};
+
+            std::size_t max_vector_{0};
+
+            // the jumps of the open block waiting for their target
+            std::optional<std::size_t> date_jump_;
+
+            std::optional<std::size_t> if_jump_;
+
+            std::optional<std::size_t> else_jump_;
+
+        };
+
+        MaybeError unsupportedPayment(const Token &token) {
+            MaybeError report;
+            report.setError(R"(The script compiler does not support "PAY" and "PAY_AT" yet)", token);
+            return report;
+        }
+
+        MaybeError ScriptCompiler::compile(const ScriptStatement &statement) {
+            const std::vector<Token> &begin = statement.statement_begin;
+            assert(!begin.empty());
+            const Word first = wordOf(begin.front());
+            if (first == Word::tab) {
+                return compileIndented(statement);
+            }
+            if (first == Word::else_) {
+                return compileElse(begin.front());
+            }
+            closeBlock();
+            return compileBlockStart(statement);
+        }
+
+        MaybeError ScriptCompiler::compileBlockStart(const ScriptStatement &statement) {
+            const std::vector<Token> &begin = statement.statement_begin;
+            assert(begin.size() >= 2);
+            if (wordOf(begin[0]) == Word::id) {
+                if (MaybeError report = compileDate(begin[0]); report.isError()) {
+                    return report;
+                }
+            }
+            const Word second = wordOf(begin[1]);
+            if (second == Word::if_) {
+                return compileCondition(begin[1], statement.postfix);
+            }
+            if ((second == Word::pay) || (second == Word::pay_at)) {
+                return unsupportedPayment(begin[1]);
+            }
+            assert((second == Word::id) && (begin.size() == 3));
+            return compileAssignment(begin[1], begin[2], statement.postfix);
+        }
+
+        MaybeError ScriptCompiler::compileIndented(const ScriptStatement &statement) {
+            const std::vector<Token> &begin = statement.statement_begin;
+            assert(begin.size() >= 2);
+            if (!if_jump_ && !else_jump_) {
+                MaybeError report;
+                report.setError(R"(Indented statement outside of an "IF" or "ELSE" block)", begin[1]);
+                return report;
+            }
+            const Word second = wordOf(begin[1]);
+            if (second == Word::terminate) {
+                code_.terminate();
+                return {};
+            }
+            if ((second == Word::pay) || (second == Word::pay_at)) {
+                return unsupportedPayment(begin[1]);
+            }
+            assert((second == Word::id) && (begin.size() == 3));
+            return compileAssignment(begin[1], begin[2], statement.postfix);
+        }
+
+        MaybeError ScriptCompiler::compileElse(const Token &token) {
+            if (!if_jump_) {
+                MaybeError report;
+                report.setError(R"("ELSE" without a preceding "IF")", token);
+                return report;
+            }
+            else_jump_ = code_.jumpElse();
+            code_.setTarget(*if_jump_, code_.size());
+            if_jump_.reset();
+            return {};
+        }
+
+        MaybeError ScriptCompiler::compileDate(const Token &token) {
+            if (!storage_.contains(token.value) || (storage_.cType(token.value) != CType::date)) {
+                MaybeError report;
+                report.setError(fmt::format(R"(Expected a <date> variable as the date of the statement, got "{}")",
+                                            token.value), token);
+                return report;
+            }
+            date_jump_ = code_.jumpUnlessDate(storage_.date(token.value));
+            return {};
+        }
+
+        MaybeError ScriptCompiler::compileCondition(const Token &token, const std::vector<Token> &postfix) {
+            MaybeError report;
+            if (postfix.empty()) {
+                report.setError(R"(Expected a condition after "IF")", token);
+                return report;
+            }
+            const auto [compile_report, result] = append(postfix);
+            if (compile_report.isError()) {
+                return compile_report;
+            }
+            if (result.ret_type != CType::scalar) {
+                report.setError(R"(The condition of "IF" must be a <scalar>)", token);
+                return report;
+            }
+            if_jump_ = code_.jumpIfZero();
+            return report;
+        }
+
+        MaybeError ScriptCompiler::compileAssignment(const Token &name,
+                                                     const Token &assignment,
+                                                     const std::vector<Token> &postfix) {
+            MaybeError report;
+            if (storage_.contains(name.value)) {
+                report.setError(fmt::format(R"(Cannot assign to "{}", it is a static variable or a parameter)",
+                                            name.value), name);
+                return report;
+            }
+            if (postfix.empty()) {
+                report.setError("Expected an expression after the assignment", assignment);
+                return report;
+            }
+            const auto variable = variables_.find(name.value);
+            const Word word = wordOf(assignment);
+            std::vector<Token> expression;
+            if (word == Word::assign) {
+                expression = postfix;
+            }
+            else {
+                if (variable == variables_.end()) {
+                    report.setError("Variable is undefined", name);
+                    return report;
+                }
+                const auto op = std::ranges::find(COMPOUND_ASSIGNMENTS, word, &std::pair<Word, std::string_view>::first);
+                assert(op != COMPOUND_ASSIGNMENTS.end());
+                expression.reserve(postfix.size() + 2);
+                expression.push_back(name);
+                expression.insert(expression.end(), postfix.begin(), postfix.end());
+                expression.push_back(Tokens::makeContextualized(op->second, assignment.start));
+                expression.back().context.is_infix = true;
+            }
+
+            const auto [compile_report, result] = append(expression);
+            if (compile_report.isError()) {
+                return compile_report;
+            }
+            const CType type = result.ret_type;
+            if ((type != CType::scalar) && (type != CType::vector)) {
+                report.setError(fmt::format(R"(Only a <scalar> or a <vector> can be assigned to "{}")", name.value),
+                                name);
+                return report;
+            }
+            LocalVariable local{type, 0, result.ret_size};
+            if (variable == variables_.end()) {
+                local.slot = type == CType::scalar ? code_.addLocalScalar() : code_.addLocalVector(local.size);
+                variables_.emplace(std::string(name.value), local);
+            }
+            else if ((variable->second.type != type) || (variable->second.size != local.size)) {
+                report.setError(fmt::format(R"(Cannot change the type or the size of "{}")", name.value), name);
+                return report;
+            }
+            else {
+                local = variable->second;
+            }
+            if (type == CType::scalar) {
+                code_.assignScalar(local.slot);
+            }
+            else {
+                code_.assignVector(local.slot, local.size);
+            }
+            return report;
+        }
+
+        std::pair<MaybeError, CompileReport> ScriptCompiler::append(const std::vector<Token> &postfix) {
+            ByteCode statement;
+            auto [report, compile_report] = compileExpression(postfix, statement, storage_, variables_);
+            if (!report.isError()) {
+                const ByteCode fused = fuseInstructions(fuseVectorLoops(statement));
+                for (const Instruction &instruction: fused.instructions()) {
+                    code_.push_back(instruction, fused);
+                }
+                max_scalar_ = std::max(max_scalar_, compile_report.max_scalar);
+                max_vector_ = std::max(max_vector_, compile_report.max_vector);
+            }
+            return {report, compile_report};
+        }
+
+        void ScriptCompiler::closeBlock() {
+            if (if_jump_ || else_jump_) {
+                for (auto *pending: {&if_jump_, &else_jump_}) {
+                    if (*pending) {
+                        code_.setTarget(**pending, code_.size());
+                        pending->reset();
+                    }
+                }
+                code_.endIf();
+            }
+            if (date_jump_) {
+                code_.setTarget(*date_jump_, code_.size());
+                date_jump_.reset();
+            }
+        }
+
+    }
+
+    std::pair<MaybeError, CompiledScript> compileScript(const std::vector<ScriptStatement> &statements,
+                                                        StaticVStorage &storage) {
+        ScriptCompiler compiler(storage);
+        for (const auto &statement: statements) {
+            if (MaybeError report = compiler.compile(statement); report.isError()) {
+                report.setLine(statement.line_no);
+                return {report, {}};
+            }
+        }
+        return {MaybeError(), compiler.finish()};
+    }
+
+    std::pair<MaybeError, CompiledScript> compileScript(const std::string_view source, StaticVStorage &storage) {
+        const auto [report, statements] = parseScript(source);
+        if (report.isError()) {
+            return {report, {}};
+        }
+        return compileScript(statements, storage);
+    }
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "calc_types.h"
+#include "language_error.h"
+#include "utils.h"
+#include "script.h"
+#include "static_variables.h"
+#include "expression_stacks.h"
+#include "expression_compiler.h"
+#include "byte_code.h"
+
+
+namespace flexMC {
+
+    // A whole script lowered to one ByteCode. The statements scheduled on a date are skipped on other dates
+    // (jump_unless_date), IF and ELSE blocks become conditional jumps and assignments move the values into the local
+    // slots of the variables. The variables keep their values in the CalcStacks between evaluations on different dates
+    // and are 0 until they are assigned.
+    class CompiledScript {
+
+    public:
+
+        CompiledScript() = default;
+
+        CompiledScript(ByteCode code, LocalVariables variables, const std::size_t &max_scalar,
+                       const std::size_t &max_vector);
+
+        // evaluates the statements scheduled on date and the CONTINUOUS ones, false if the path was terminated
+        bool operator()(CalcStacks &stacks, const DATE &date) const { return code_(stacks, date); }
+
+        // evaluates a batch of paths, false once all of them were terminated
+        bool operator()(BatchStacks &stacks, const DATE &date) const { return code_(stacks, date); }
+
+        const ByteCode &code() const { return code_; }
+
+        bool contains(const std::string_view name) const { return variables_.contains(name); }
+
+        const LocalVariable &variable(const std::string_view name) const { return atKey(variables_, name); }
+
+        SCALAR scalar(const CalcStacks &stacks, const std::string_view name) const;
+
+        VECTOR vector(const CalcStacks &stacks, const std::string_view name) const;
+
+        // the values of all paths of the batch, terminated paths keep the values they had when they were terminated
+        std::vector<SCALAR> scalar(const BatchStacks &stacks, const std::string_view name) const;
+
+        VECTOR vector(const BatchStacks &stacks, const std::string_view name, const std::size_t &path) const;
+
+        // sets a variable from one value per path once it exists in the stacks, i.e. after an evaluation
+        void setScalar(BatchStacks &stacks, const std::string_view name, const SCALAR *values) const;
+
+        // the largest number of scalars and vectors on the stacks during an evaluation
+        std::size_t maxScalar() const { return max_scalar_; }
+
+        std::size_t maxVector() const { return max_vector_; }
+
+    private:
+
+        ByteCode code_;
+
+        LocalVariables variables_;
+
+        std::size_t max_scalar_{0};
+
+        std::size_t max_vector_{0};
+
+    };
+
+    // The error carries the line it occurred in
+    std::pair<MaybeError, CompiledScript> compileScript(const std::vector<ScriptStatement> &statements,
+                                                        StaticVStorage &storage);
+
+    std::pair<MaybeError, CompiledScript> compileScript(const std::string_view source, StaticVStorage &storage);
+
+}
@@ -1,7 +1,11 @@
 #pragma once
 
-#include <string>
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
 
 #include "terminals.h"
 #include "tokens.h"
@@ -9,77 +13,140 @@
 
 namespace flexMC::statement {
 
-    using
-    enum Token::Type;
+    // The words of the statement grammar. A token is interned once, identifiers and indentation by their type, all
+    // other words by their spelling.
+    enum class Word : std::uint8_t {
+        other,
+        id,
+        tab,
+        if_,
+        else_,
+        continuous,
+        terminate,
+        pay,
+        pay_at,
+        l_paren,
+        assign,
+        plus_assign,
+        minus_assign,
+        mul_assign,
+        div_assign,
+        pow_assign,
+    };
 
-    struct Option {
+    inline constexpr std::size_t NUM_WORDS{static_cast<std::size_t>(Word::pow_assign) + 1};
 
-        const std::string value;
-        const Token::Type type;
-        const bool check_type;
+    using WordEntry = std::pair<std::string_view, Word>;
 
-        const std::vector<Option> options;
+    template<std::size_t size>
+    consteval std::array<WordEntry, size> sortedWords(std::array<WordEntry, size> entries) {
+        std::ranges::sort(entries, {}, &WordEntry::first);
+        return entries;
+    }
 
-        Option(std::string token_value, Token::Type token_type, bool check_with_type,
-               const std::vector<Option> &next_options) :
-            value(std::move(token_value)),
-            type(token_type),
-            check_type(check_with_type),
-            options(next_options) {};
+    // sorted by spelling at compile time, intern() is a binary search
+    inline constexpr auto SPELLINGS = sortedWords(std::to_array<WordEntry>({
+        {IF,           Word::if_},
+        {ELSE,         Word::else_},
+        {CONTINUOUS,   Word::continuous},
+        {TERMINATE,    Word::terminate},
+        {PAY,          Word::pay},
+        {PAY_AT,       Word::pay_at},
+        {L_PAREN,      Word::l_paren},
+        {ASSIGN,       Word::assign},
+        {PLUS_ASSIGN,  Word::plus_assign},
+        {MINUS_ASSIGN, Word::minus_assign},
+        {MUL_ASSIGN,   Word::mul_assign},
+        {DIV_ASSIGN,   Word::div_assign},
+        {POW_ASSIGN,   Word::pow_assign},
+    }));
 
-        Option(std::string token_value, Token::Type token_type, bool check_with_type) :
-            value(std::move(token_value)),
-            type(token_type),
-            check_type(check_with_type) {};
+    constexpr Word intern(const Token::Type &type, const std::string_view &value) {
+        if (type == Token::Type::id) {
+            return Word::id;
+        }
+        if (type == Token::Type::tab) {
+            return Word::tab;
+        }
+        const auto it = std::ranges::lower_bound(SPELLINGS, value, {}, &WordEntry::first);
+        return ((it != SPELLINGS.end()) && (it->first == value)) ? it->second : Word::other;
+    }
 
+    // How far the start of a line got. Only the states before accept have transitions.
+    enum class State : std::uint8_t {
+        start,
+        after_id,
+        after_continuous,
+        after_tab,
+        assignment,
+        call,
+        accept,
+        reject,
     };
 
-    const std::vector<Option> OPTIONS = {
-        Option("", id, true, {
-            Option("", id, true, {
-                Option(ASSIGN, undefined, false),
-                Option(PLUS_ASSIGN, undefined, false),
-                Option(MINUS_ASSIGN, undefined, false),
-                Option(MUL_ASSIGN, undefined, false),
-                Option(DIV_ASSIGN, undefined, false),
-                Option(POW_ASSIGN, undefined, false),
-            }),
-            Option(IF, undefined, false),
-            Option(PAY, undefined, false, {
-                Option(L_PAREN, undefined, false),
-            }),
-            Option(PAY_AT, undefined, false, {
-                Option(L_PAREN, undefined, false),
-            })
-        }),
-        Option(CONTINUOUS, undefined, false, {
-            Option("", id, true, {
-                Option(ASSIGN, undefined, false),
-                Option(PLUS_ASSIGN, undefined, false),
-                Option(MINUS_ASSIGN, undefined, false),
-                Option(MUL_ASSIGN, undefined, false),
-                Option(DIV_ASSIGN, undefined, false),
-                Option(POW_ASSIGN, undefined, false),
-            }),
-            Option(IF, undefined, false),
-        }),
-        Option("", tab, true, {
-            Option("", id, true, {
-                Option(ASSIGN, undefined, false),
-                Option(PLUS_ASSIGN, undefined, false),
-                Option(MINUS_ASSIGN, undefined, false),
-                Option(MUL_ASSIGN, undefined, false),
-                Option(DIV_ASSIGN, undefined, false),
-                Option(POW_ASSIGN, undefined, false),
-            }),
-            Option(PAY, undefined, false, {
-                Option(L_PAREN, undefined, false),
-            }),
-            Option(PAY_AT, undefined, false, {
-                Option(L_PAREN, undefined, false),
-            }),
-            Option(TERMINATE, undefined, false),
-        }),
-        Option(ELSE, undefined, false),
+    inline constexpr std::size_t NUM_STATES{static_cast<std::size_t>(State::accept)};
+
+    struct Transition {
+        State from;
+        Word word;
+        State to;
     };
+
+    // The admissible starts of a line, the error messages list the options of a state in this order
+    inline constexpr auto GRAMMAR = std::to_array<Transition>({
+        {State::start,            Word::id,           State::after_id},
+        {State::start,            Word::continuous,   State::after_continuous},
+        {State::start,            Word::tab,          State::after_tab},
+        {State::start,            Word::else_,        State::accept},
+
+        {State::after_id,         Word::id,           State::assignment},
+        {State::after_id,         Word::if_,          State::accept},
+        {State::after_id,         Word::pay,          State::call},
+        {State::after_id,         Word::pay_at,       State::call},
+
+        {State::after_continuous, Word::id,           State::assignment},
+        {State::after_continuous, Word::if_,          State::accept},
+
+        {State::after_tab,        Word::id,           State::assignment},
+        {State::after_tab,        Word::pay,          State::call},
+        {State::after_tab,        Word::pay_at,       State::call},
+        {State::after_tab,        Word::terminate,    State::accept},
+
+        {State::assignment,       Word::assign,       State::accept},
+        {State::assignment,       Word::plus_assign,  State::accept},
+        {State::assignment,       Word::minus_assign, State::accept},
+        {State::assignment,       Word::mul_assign,   State::accept},
+        {State::assignment,       Word::div_assign,   State::accept},
+        {State::assignment,       Word::pow_assign,   State::accept},
+
+        {State::call,             Word::l_paren,      State::accept},
+    });
+
+    // The longest path through the grammar, e.g. tab, PAY, "("
+    inline constexpr std::size_t MAX_STATEMENT_SIZE{3};
+
+    using Table = std::array<std::array<State, NUM_WORDS>, NUM_STATES>;
+
+    template<std::size_t size>
+    consteval Table compile(const std::array<Transition, size> &grammar) {
+        Table table{};
+        for (auto &row: table) {
+            row.fill(State::reject);
+        }
+        for (const auto &[from, word, to]: grammar) {
+            table[static_cast<std::size_t>(from)][static_cast<std::size_t>(word)] = to;
+        }
+        return table;
+    }
+
+    inline constexpr Table TRANSITIONS = compile(GRAMMAR);
+
+    constexpr State step(const State &from, const Word &word) {
+        return TRANSITIONS[static_cast<std::size_t>(from)][static_cast<std::size_t>(word)];
+    }
+
+    static_assert(intern(Token::Type::keyword, POW_ASSIGN) == Word::pow_assign);
+    static_assert(intern(Token::Type::fun, EXP) == Word::other);
+    static_assert(step(step(step(State::start, Word::tab), Word::pay_at), Word::l_paren) == State::accept);
+    static_assert(step(State::start, Word::terminate) == State::reject);
 }
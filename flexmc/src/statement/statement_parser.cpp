@@ -3,9 +3,7 @@
 #include <fmt/format.h>
 #include <ranges>
 #include <algorithm>
-#include <numeric>
-#include <functional>
-#include <iostream>
+#include <iterator>
 
 #include "statement_definitions.h"
 #include "expression_parser.h"
@@ -21,29 +19,25 @@ namespace flexMC {
 
         auto IS_NOT_SPACE = [](const Token &t) { return ((t.type != wsp) && (t.type != tab)); };
 
-        auto UNDEFINED = [](const Token &t) { return t.type == undefined; };
-
-        std::size_t countFrontSpaces(const std::deque<Token> &line) {
-            auto end = std::ranges::find_if(line, IS_NOT_SPACE);
-            return std::accumulate(line.begin(), end, 0, [](std::size_t acc, const Token &t) {
-                return acc + (t.type == wsp ? 1 : 4);
-            });
-        }
-
-        auto findStatementOption(const auto &begin, const auto &end, const Token &token) {
-            return std::ranges::find_if(
-                begin, end,
-                [token](const statement::Option &op) {
-                    return op.check_type ? op.type == token.type : op.value == token.value;
-                }
-            );
+        std::string printWord(const statement::Word &word) {
+            using statement::Word;
+            if (word == Word::id) {
+                return fmt::format("<{}>", Tokens::printType(id));
+            }
+            if (word == Word::tab) {
+                return fmt::format("<{}>", Tokens::printType(tab));
+            }
+            const auto it = std::ranges::find(statement::SPELLINGS, word, &statement::WordEntry::second);
+            assert(it != statement::SPELLINGS.end());
+            return fmt::format(R"_("{}")_", it->first);
         }
 
-        std::string printOptions(auto begin, const auto &end, const std::string &context) {
+        std::string printOptions(const statement::State &state, const std::string &context) {
             std::vector<std::string> options_out;
-            for (const auto &option: std::ranges::subrange(begin, end)) {
-                options_out.emplace_back(option.check_type ? fmt::format("<{}>", Tokens::printType(option.type))
-                                                           : fmt::format(R"_("{}")_", option.value));
+            for (const auto &transition: statement::GRAMMAR) {
+                if (transition.from == state) {
+                    options_out.emplace_back(printWord(transition.word));
+                }
             }
             return fmt::format("{}, admissible <type> or \"value\" options are: [{}]",
                                context,
@@ -53,8 +47,7 @@ namespace flexMC {
         void setOptionContextError(MaybeError &report,
                                    const int &err_code,
                                    const Token &token,
-                                   const auto &options_begin,
-                                   const auto &options_end) {
+                                   const statement::State &state) {
             assert(!report.isError());
             assert((1 <= err_code) && (err_code <= 5));
             std::stringstream context;
@@ -83,69 +76,75 @@ namespace flexMC {
                     context << "Internal Error";
                     break;
             }
-            report.setError(printOptions(options_begin, options_end, context.str()), token);
+            report.setError(printOptions(state, context.str()), token);
         }
 
-        bool isPayLine(const std::deque<Token> &start_of_line) {
-            if (start_of_line.size() < 2) {
-                return false;
-            }
-            auto it_end = start_of_line.rbegin();
-            if (it_end->value != L_PAREN) {
-                return false;
-            }
-            ++it_end;
-            if ((it_end->value != PAY) && (it_end->value != PAY_AT)) {
-                return false;
-            }
-            return true;
-        }
-
-
     }
 
 
-    std::tuple<MaybeError, std::deque<Token>, std::deque<Token>> lineParseUtils::splitLine(
-        const std::size_t &spaces, auto line) {
-        MaybeError report;
-        auto c_beg = statement::OPTIONS.begin();
-        auto c_end = statement::OPTIONS.end();
+    MaybeError lineParseUtils::matchStartOfLine(const std::span<const Token> line, StatementMatch &match) {
+        using statement::State;
+        using statement::Word;
+        assert(!line.empty() && (line.back().type == eof));
 
-        std::deque<Token> expression_infix(line.begin(), line.end());
-        std::deque<Token> statement_begin;
+        MaybeError report;
+        match = {};
+
+        // one pass for undefined tokens and the indentation
+        std::size_t spaces{0};
+        std::size_t first{line.size()};
+        for (std::size_t i{0}; i < line.size(); ++i) {
+            const Token &tok = line[i];
+            if (tok.type == undefined) {
+                setOptionContextError(report, 2, tok, State::start);
+                return report;
+            }
+            if ((first == line.size()) && IS_NOT_SPACE(tok)) {
+                first = i;
+            }
+            else if (first == line.size()) {
+                spaces += tok.type == wsp ? 1 : 4;
+            }
+        }
+        if ((spaces != 0) && (spaces != 4)) {
+            setOptionContextError(report, 3, Token(id, "", 0, spaces), State::start);
+            return report;
+        }
 
+        State state = State::start;
         if (spaces == 4) {
-            auto indent = Token(Token::Type::tab, "    ", 0);
-            auto indent_it = findStatementOption(c_beg, c_end, indent);
-            if (indent_it == c_end) {
-                setOptionContextError(report, 4, indent, c_beg, c_end);
-                return {report, {}, {}};
+            // four spaces are lexed into one tab token
+            state = statement::step(state, Word::tab);
+            if (state == State::reject) {
+                setOptionContextError(report, 4, Token(tab, "    ", 0), State::start);
+                return report;
             }
-            statement_begin.push_back(indent);
-            c_beg = indent_it->options.begin();
-            c_end = indent_it->options.end();
+            match.words[match.size++] = Word::tab;
         }
 
-        while ((!report.isError()) && (c_beg != c_end)) {
-            const Token &next = expression_infix.front();
-            if (next.type == eof) {
-                setOptionContextError(report, 1, line.front(), c_beg, c_end);
-                break;
+        std::size_t next{first};
+        while (state != State::accept) {
+            const Token &tok = line[next];
+            if (tok.type == eof) {
+                setOptionContextError(report, 1, line[first], state);
+                return report;
             }
-            auto option_it = findStatementOption(c_beg, c_end, next);
-            if (option_it != c_end) {
-                c_beg = option_it->options.begin();
-                c_end = option_it->options.end();
-                statement_begin.push_back(next);
-                expression_infix.pop_front();
-                continue;
+            const Word word = statement::intern(tok.type, tok.value);
+            const State to = statement::step(state, word);
+            if (to == State::reject) {
+                setOptionContextError(report, 5, tok, state);
+                return report;
             }
-            else {
-                setOptionContextError(report, 5, next, c_beg, c_end);
+            match.tokens[match.size] = static_cast<std::uint32_t>(next);
+            match.words[match.size++] = word;
+            state = to;
+            ++next;
+            while (!IS_NOT_SPACE(line[next])) {
+                ++next;
             }
         }
-
-        return {report, statement_begin, expression_infix};
+        match.rest = static_cast<std::uint32_t>(next);
+        return report;
     }
 
 
@@ -175,9 +174,9 @@ namespace flexMC {
         }
     }
 
-    std::deque<Token> lineParseUtils::makePaymentExpression(MaybeError &report,
-                                                            std::deque<Token> &start_of_line,
-                                                            const std::deque<Token> &rest_of_line) {
+    std::vector<Token> lineParseUtils::makePaymentExpression(MaybeError &report,
+                                                             std::vector<Token> &start_of_line,
+                                                             const std::vector<Token> &rest_of_line) {
         // start_of_line is [..., "PAY" or "PAY_AT", "("] at this point
         // The "(" will be removed from start_of_line
 
@@ -199,61 +198,59 @@ namespace flexMC {
             return {};
         }
 
-        const auto [expression_report, _] = infixToPostfix(std::deque<Token>(it_assign + 1, rest_of_line.end()));
+        // only checked here, the expression is parsed again as part of the payment
+        std::vector<PostfixNode> postfix;
+        std::vector<PostfixNode> operators;
+        const MaybeError expression_report = infixToPostfix(std::span<const Token>(it_assign + 1, rest_of_line.end()),
+                                                            postfix, operators);
         if (expression_report.isError()) {
             report = expression_report;
             return {};
         }
 
         // OK
-        // Have to create a new deque since Token is not copyable (has const qualified members)
-        std::deque<Token> new_rest_of_line(rest_of_line.begin(), it_r_paren);
+        assert(rest_of_line.back().type == eof);
+        const auto at = rest_of_line.back().start;
+        std::vector<Token> new_rest_of_line;
+        new_rest_of_line.reserve(rest_of_line.size() + 2);
+        new_rest_of_line.push_back(start_of_line[start_of_line.size() - 2]); // Copying "PAY" or "PAY_AT"
+        new_rest_of_line.push_back(start_of_line.back());
+        start_of_line.pop_back(); // Removing the "("
+        new_rest_of_line.insert(new_rest_of_line.end(), rest_of_line.begin(), it_r_paren);
         new_rest_of_line.emplace_back(Token::Type::op, COMMA, it_r_paren->start);
-        for (auto it = it_assign + 1; it != rest_of_line.end(); ++it) {
-            new_rest_of_line.push_back(*it);
-        }
-        assert(new_rest_of_line.back().type == eof);
-        auto at = new_rest_of_line.back().start;
-        new_rest_of_line.pop_back();
+        new_rest_of_line.insert(new_rest_of_line.end(), it_assign + 1, rest_of_line.end() - 1);
         new_rest_of_line.emplace_back(Token::Type::rparen, R_PAREN, at);
         new_rest_of_line.emplace_back(Token::Type::eof, "", at);  // + 1 ?
-        new_rest_of_line.push_front(start_of_line.back());
-        start_of_line.pop_back(); // Removing the "("
-        new_rest_of_line.push_front(start_of_line.back()); // Copying "PAY" or "PAY_AT"
         return new_rest_of_line;
     };
 
 
-    std::pair<MaybeError, LineParseResult> parseStartOfLine(const std::deque<Token> &line) {
-        auto undefined = std::ranges::find_if(line, UNDEFINED);
-        if (std::ranges::find_if(line, UNDEFINED) != line.end()) {
-            MaybeError report;
-            setOptionContextError(report, 2, *undefined, statement::OPTIONS.begin(), statement::OPTIONS.end());
+    std::pair<MaybeError, LineParseResult> parseStartOfLine(const std::vector<Token> &line) {
+        StatementMatch match;
+        MaybeError report = lineParseUtils::matchStartOfLine(line, match);
+        if (report.isError()) {
             return {report, {}};
         }
-        const std::size_t spaces = countFrontSpaces(line);
-        if ((spaces != 0) && (spaces != 4)) {
-            MaybeError report;
-            auto tok = Token(Token::Type::id, std::string(spaces, ' '), 0);
-            setOptionContextError(report, 3, tok, statement::OPTIONS.begin(), statement::OPTIONS.end());
-            return {report, {}};
+        LineParseResult result;
+        result.statement_begin.reserve(match.size);
+        for (std::size_t i{0}; i < match.size; ++i) {
+            result.statement_begin.push_back(match.words[i] == statement::Word::tab ? Token(tab, "    ", 0)
+                                                                                    : line[match.tokens[i]]);
         }
-        auto spaces_filtered = line | std::ranges::views::filter(IS_NOT_SPACE);
-
-        auto [split_rep, statement_begin, expression] = lineParseUtils::splitLine(spaces,
-                                                                                  std::move(spaces_filtered));
-        if (split_rep.isError()) {
-            return {split_rep, {}};
-        }
-        MaybeError report;
-        if (isPayLine(statement_begin)) {
-            std::deque<Token> pay_expr = lineParseUtils::makePaymentExpression(report, statement_begin, expression);
+        result.expression_infix.reserve(line.size() - match.rest);
+        std::ranges::copy_if(line.begin() + match.rest, line.end(), std::back_inserter(result.expression_infix),
+                             IS_NOT_SPACE);
+
+        if (match.words[match.size - 1] == statement::Word::l_paren) {
+            std::vector<Token> pay_expr = lineParseUtils::makePaymentExpression(report,
+                                                                                result.statement_begin,
+                                                                                result.expression_infix);
             if (report.isError()) {
                 return {report, {}};
             }
-            return {report, LineParseResult(statement_begin, pay_expr)};
+            result.expression_infix = std::move(pay_expr);
         }
-        return {report, LineParseResult(statement_begin, expression)};
+        return {report, std::move(result)};
     }
 
-}
\ No newline at end of file
+}
@@ -1,38 +1,41 @@
 #pragma once
 
-#include <deque>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
 
 #include "language_error.h"
+#include "statement_definitions.h"
 
 
 namespace flexMC {
 
     struct LineParseResult {
-        const std::deque<Token> statement_begin;
-        const std::deque<Token> expression_infix;
-
-        LineParseResult() : statement_begin({}), expression_infix({}) {}
+        std::vector<Token> statement_begin;
+        std::vector<Token> expression_infix;
+    };
 
-        LineParseResult(const std::deque<Token> &line_start,
-                        const std::deque<Token> &expr_infix)
-            : statement_begin(line_start), expression_infix(expr_infix) {}
+    // The start of a line as indices into its tokens and the words they were interned to
+    struct StatementMatch {
+        std::array<std::uint32_t, statement::MAX_STATEMENT_SIZE> tokens{};
+        std::array<statement::Word, statement::MAX_STATEMENT_SIZE> words{};
+        std::uint32_t size{0};
+        // index of the first token after the start of the line
+        std::uint32_t rest{0};
     };
 
     namespace lineParseUtils {
 
-        // Can use auto in function declaration in C++20 according to the accepted answer in the link below.
-        // It's an abbreviation for function template.
-        // https://stackoverflow.com/questions/29944985/is-there-a-way-to-pass-auto-as-an-argument-in-c
-        // type is meant to be the return type of >> std::deque<Token> | std::ranges::views::filter <<.
-        std::tuple<MaybeError, std::deque<Token>, std::deque<Token>> splitLine(const std::size_t &spaces,
-                                                                               auto line);
+        // Runs the start of the line through statement::TRANSITIONS, one look-up per token and no allocation.
+        MaybeError matchStartOfLine(std::span<const Token> line, StatementMatch &match);
 
-        std::deque<Token> makePaymentExpression(MaybeError &report,
-                                                std::deque<Token> &line_start,
-                                                const std::deque<Token> &rest_of_line);
+        std::vector<Token> makePaymentExpression(MaybeError &report,
+                                                 std::vector<Token> &line_start,
+                                                 const std::vector<Token> &rest_of_line);
 
     }
 
-    std::pair<MaybeError, LineParseResult> parseStartOfLine(const std::deque<Token> &line_infix);
+    std::pair<MaybeError, LineParseResult> parseStartOfLine(const std::vector<Token> &line_infix);
 
-}
\ No newline at end of file
+}
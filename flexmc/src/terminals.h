@@ -1,80 +1,85 @@
 #pragma once
 
-#include <string>
 #include <array>
+#include <cstddef>
+#include <string_view>
+
+// Spellings of the terminals, constant initialised: including this header adds no start-up work to a translation
+// unit.
 
 namespace flexMC {
 
     // Keywords
-    const std::string TERMINATE = "TERMINATE";
-    const std::string IF = "IF";
-    const std::string CONTINUOUS = "CONTINUOUS";
-    const std::string ELSE = "ELSE";
-    const std::string ASSIGN = ":=";
-    const std::string PLUS_ASSIGN = "+=";
-    const std::string MINUS_ASSIGN = "-=";
-    const std::string MUL_ASSIGN = "*=";
-    const std::string DIV_ASSIGN = "/=";
-    const std::string POW_ASSIGN = "**=";
+    inline constexpr std::string_view TERMINATE = "TERMINATE";
+    inline constexpr std::string_view IF = "IF";
+    inline constexpr std::string_view CONTINUOUS = "CONTINUOUS";
+    inline constexpr std::string_view ELSE = "ELSE";
+    inline constexpr std::string_view ASSIGN = ":=";
+    inline constexpr std::string_view PLUS_ASSIGN = "+=";
+    inline constexpr std::string_view MINUS_ASSIGN = "-=";
+    inline constexpr std::string_view MUL_ASSIGN = "*=";
+    inline constexpr std::string_view DIV_ASSIGN = "/=";
+    inline constexpr std::string_view POW_ASSIGN = "**=";
 
     // Payment functions (internal assign and save functions)
-    const std::string PAY = "PAY";
-    const std::string PAY_AT = "PAY_AT";
+    inline constexpr std::string_view PAY = "PAY";
+    inline constexpr std::string_view PAY_AT = "PAY_AT";
 
     // Real functions taking a scalar or vector
-    const std::string EXP = "EXP";
-    const std::string LOG = "LOG";
-    const std::string ABS = "ABS";
-    const std::string SQRT = "SQRT";
-    const std::string SQUARE = "SQUARE";
+    inline constexpr std::string_view EXP = "EXP";
+    inline constexpr std::string_view LOG = "LOG";
+    inline constexpr std::string_view ABS = "ABS";
+    inline constexpr std::string_view SQRT = "SQRT";
+    inline constexpr std::string_view SQUARE = "SQUARE";
 
     // Real functions taking a vector or positive number of reals
-    const std::string MIN = "MIN";
-    const std::string MAX = "MAX";
-    const std::string SUM = "SUM";
-    const std::string PROD = "PROD";
-    const std::string ARGMIN = "ARGMIN";
-    const std::string ARGMAX = "ARGMAX";
+    inline constexpr std::string_view MIN = "MIN";
+    inline constexpr std::string_view MAX = "MAX";
+    inline constexpr std::string_view SUM = "SUM";
+    inline constexpr std::string_view PROD = "PROD";
+    inline constexpr std::string_view ARGMIN = "ARGMIN";
+    inline constexpr std::string_view ARGMAX = "ARGMAX";
 
     // Real functions taking a vector
-    const std::string LEN = "LEN";
+    inline constexpr std::string_view LEN = "LEN";
 
     // Operators
-    const std::string AND = "AND";
-    const std::string OR = "OR";
-    const std::string NOT = "NOT";
-    const std::string PLUS = "+";
-    const std::string MINUS = "-";
-    const std::string MUL = "*";
-    const std::string DIV = "/";
-    const std::string POW = "**";
-    const std::string LT = "<";
-    const std::string GT = ">";
-    const std::string LE = "<=";
-    const std::string GE = ">=";
-    const std::string SMOOTH_LT = "<<";
-    const std::string SMOOTH_GT = ">>";
-    const std::string COMMA = ",";
-    const std::string L_PAREN = "(";
-    const std::string R_PAREN = ")";
-    const std::string L_BRACKET = "[";
-    const std::string R_BRACKET = "]";
+    inline constexpr std::string_view AND = "AND";
+    inline constexpr std::string_view OR = "OR";
+    inline constexpr std::string_view NOT = "NOT";
+    inline constexpr std::string_view PLUS = "+";
+    inline constexpr std::string_view MINUS = "-";
+    inline constexpr std::string_view MUL = "*";
+    inline constexpr std::string_view DIV = "/";
+    inline constexpr std::string_view POW = "**";
+    inline constexpr std::string_view LT = "<";
+    inline constexpr std::string_view GT = ">";
+    inline constexpr std::string_view LE = "<=";
+    inline constexpr std::string_view GE = ">=";
+    inline constexpr std::string_view SMOOTH_LT = "<<";
+    inline constexpr std::string_view SMOOTH_GT = ">>";
+    inline constexpr std::string_view COMMA = ",";
+    inline constexpr std::string_view L_PAREN = "(";
+    inline constexpr std::string_view R_PAREN = ")";
+    inline constexpr std::string_view L_BRACKET = "[";
+    inline constexpr std::string_view R_BRACKET = "]";
 
     // Internal function call and list append operators
-    const std::string CALL_ = "CALL_";
-    const std::string APPEND_ = "APPEND_";
-    const std::string INDEX_ = "INDEX_";
+    inline constexpr std::string_view CALL_ = "CALL_";
+    inline constexpr std::string_view APPEND_ = "APPEND_";
+    inline constexpr std::string_view INDEX_ = "INDEX_";
 
+    // The token grammar, implemented by the scanner in lexer.cpp and tried in this order.
     // Identifiers must start with either a lower case letter or "_"
-    const std::string R_ID = R"(^[_a-z]\w*)";
-    const std::string R_NUM = R"(^(\d+(\.\d*)?|\.\d+)([eE][+-]?\d+)?)";
+    inline constexpr std::string_view R_ID = R"(^[_a-z]\w*)";
+    inline constexpr std::string_view R_NUM = R"(^(\d+(\.\d*)?|\.\d+)([eE][+-]?\d+)?)";
 
-    const std::array<std::string, 2> R_GROUPS_1 = {
+    inline constexpr std::array<std::string_view, 2> R_GROUPS_1 = {
         R"(^\*\*(=?))",
         R"(^\s{4})",
     };
 
-    const std::array<std::string, 36> R_GROUPS_2 = {
+    inline constexpr std::array<std::string_view, 36> R_GROUPS_2 = {
         R"(^IF)",
         R"(^CONTINUOUS)",
         R"(^ELSE)",
@@ -113,5 +118,5 @@ namespace flexMC {
         R"(^\s)",
     };
 
-    const std::size_t MAX_LINE_LEN = 1000;
+    inline constexpr std::size_t MAX_LINE_LEN = 1000;
 };
@@ -67,9 +67,9 @@ namespace flexMC {
         return tok.type2String();
     }
 
-    Token::Type Tokens::getType(const std::string &symbol) {
-        auto it = Tokens::TYPES.find(symbol);
-        if (it == Tokens::TYPES.end()) {
+    Token::Type Tokens::getType(const std::string_view &symbol) {
+        auto it = std::ranges::lower_bound(Tokens::TYPES, symbol, {}, &TypeEntry::first);
+        if ((it == Tokens::TYPES.end()) || (it->first != symbol)) {
             return Token::Type::undefined;
         }
         else {
@@ -101,7 +101,7 @@ namespace flexMC {
         return call;
     }
 
-    Token Tokens::makeOperator(const Token::Type &t, const std::string &val, const std::size_t &at) {
+    Token Tokens::makeOperator(const Token::Type &t, const std::string_view &val, const std::size_t &at) {
         ParsingContext context;
         if (val == POW) {
             context.precedence = 9;
@@ -135,11 +135,11 @@ namespace flexMC {
             context.is_infix = true;
             return {t, val, at, context};
         }
+        // prefix only, binds less tightly than the comparisons: NOT x < 1 is NOT (x < 1)
         if (val == NOT) {
             context.precedence = 4;
             context.left_associative = false;
-            context.maybe_infix = true;
-            context.is_infix = true;
+            context.maybe_prefix = true;
             return {t, val, at, context};
         }
         if (val == AND) {
@@ -164,7 +164,7 @@ namespace flexMC {
         return {Token::Type::undefined, val, at};
     }
 
-    Token Tokens::makeContextualized(const std::string &val, const std::size_t &at) {
+    Token Tokens::makeContextualized(const std::string_view &val, const std::size_t &at) {
         using
         enum Token::Type;
         Token::Type t = getType(val);
@@ -1,6 +1,12 @@
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 #include "terminals.h"
 #include "utils.h"
@@ -9,18 +15,21 @@
 namespace flexMC {
 
     struct ParsingContext {
-        std::size_t precedence = 0;
+        std::uint32_t num_args = 0;
+        std::uint8_t precedence = 0;
         bool maybe_prefix = false;
         bool maybe_infix = false;
         bool is_prefix = false;
         bool is_infix = false;
-        std::size_t num_args = 0;
         bool left_associative = true;
     };
 
+    // A token is a view: value refers to the source line it was lexed from (or to a static spelling for the tokens the
+    // parsers insert) and is valid as long as that line. Tokens are trivially copyable and are passed around in
+    // std::vector by value.
     struct Token {
 
-        enum class Type {
+        enum class Type : std::uint8_t {
             eof,
             wsp,
             tab,
@@ -39,42 +48,39 @@ namespace flexMC {
             index_
         };
 
-        Token(Type t, const std::string &val, const std::size_t &at) :
-            type(t),
-            value(val),
-            start(at),
-            size(val.length()) {}
+        Token(Type t, const std::string_view &val, const std::size_t &at) :
+            Token(t, val, at, val.length()) {}
 
-        Token(Type t, const std::string &val, const std::size_t &at, const ParsingContext &con) :
-            type(t),
-            value(val),
-            start(at),
-            size(val.length()),
-            context(con) {}
+        Token(Type t, const std::string_view &val, const std::size_t &at, const ParsingContext &con) :
+            Token(t, val, at, val.length()) {
+            context = con;
+        }
 
-        Token(Type t, const std::string &val, const std::size_t &at, const std::size_t &length) :
-            type(t),
+        Token(Type t, const std::string_view &val, const std::size_t &at, const std::size_t &length) :
             value(val),
-            start(at),
-            size(length) {}
+            start(static_cast<std::uint32_t>(at)),
+            size(static_cast<std::uint32_t>(length)),
+            type(t) {}
 
         [[nodiscard]] std::string toString() const;
 
         [[nodiscard]] std::string type2String() const;
 
-        const Type type;
-        const std::string value;
-        const std::size_t start;
-        const std::size_t size;
+        std::string_view value;
+        std::uint32_t start;
+        std::uint32_t size;
+        Type type;
         ParsingContext context;
     };
 
+    static_assert(std::is_trivially_copyable_v<Token>);
+
 
     namespace Tokens {
 
-        Token::Type getType(const std::string &symbol);
+        Token::Type getType(const std::string_view &symbol);
 
-        Token makeContextualized(const std::string &val, const std::size_t &at);
+        Token makeContextualized(const std::string_view &val, const std::size_t &at);
 
         Token makeCall(const std::size_t &num_args, const std::size_t &at);
 
@@ -82,11 +88,20 @@ namespace flexMC {
 
         Token makeIndex(const std::size_t &at);
 
-        Token makeOperator(const Token::Type &t, const std::string &val, const std::size_t &at);
+        Token makeOperator(const Token::Type &t, const std::string_view &val, const std::size_t &at);
 
         std::string printType(const Token::Type &t);
 
-        const std::unordered_map<std::string, Token::Type, SHash, std::equal_to<>> TYPES = {
+        using TypeEntry = std::pair<std::string_view, Token::Type>;
+
+        // sorted by spelling at compile time, getType() is a binary search
+        template<std::size_t size>
+        consteval std::array<TypeEntry, size> sortedTypes(std::array<TypeEntry, size> entries) {
+            std::ranges::sort(entries, {}, &TypeEntry::first);
+            return entries;
+        }
+
+        inline constexpr auto TYPES = sortedTypes(std::to_array<TypeEntry>({
 
             {IF,           Token::Type::keyword},
             {CONTINUOUS,   Token::Type::keyword},
@@ -139,6 +154,6 @@ namespace flexMC {
             {"\t",         Token::Type::tab},
             {"    ",       Token::Type::tab},
             {" ",          Token::Type::wsp},
-        };
+        }));
     }
 }
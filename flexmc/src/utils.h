@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <string_view>
 #include <unordered_map>
 
@@ -19,4 +20,12 @@ namespace flexMC {
     template<class T>
     using StringMap = std::unordered_map<std::string, T, SHash, std::equal_to<>>;
 
+    // StringMap::at() for a string_view key, std::unordered_map::at() is heterogeneous only from C++26 on
+    template<class Map>
+    auto &atKey(Map &map, const std::string_view key) {
+        const auto it = map.find(key);
+        assert(it != map.end());
+        return it->second;
+    }
+
 }
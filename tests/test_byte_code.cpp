@@ -0,0 +1,758 @@
+#include <gtest/gtest.h>
+
+#include <bit>
+#include <cstdint>
+
+#include "lexer.h"
+#include "script.h"
+#include "script_compiler.h"
+#include "expression_parser.h"
+#include "expression_compiler.h"
+#include "byte_code.h"
+#include "register_code.h"
+#include "constant_folding.h"
+#include "peephole.h"
+#include "loop_fusion.h"
+#include "transpiler.h"
+#include "jit_code.h"
+#include "native_library.h"
+#include "vector_math.h"
+#include "kernels.h"
+#include "operand.h"
+#include "operators_calc.h"
+#include "functions_real.h"
+
+
+using namespace flexMC;
+
+
+namespace {
+
+    StaticVStorage makeStorage() {
+        StaticVStorage storage;
+        storage.insert<SCALAR>("x", 2);
+        storage.insert<SCALAR>("y", 3);
+        storage.insert<SCALAR>("z", 4);
+        storage.insert<VECTOR>("performances", {-2, 3, 4});
+        storage.insert<VECTOR>("basketValues", {-2, -3, -4, -3, 4});
+        storage.insert<DATE>("d", 4);
+        storage.insert<DATE_LIST>("d_l", {1, 0});
+        return storage;
+    }
+
+    std::vector<std::string> sameResultCases() {
+        return {
+            "(2 * +3**LOG(EXP(-2))) / -(5 - 2) + +10",
+            "2 + -ABS(-(5 * 4)) / (3 - 1)**2",
+            "(12 / 3) * -(7 - (4 + 1))**2 + 10 / 2",
+            "2**-3 - -5 * (4 - 2) + 8 / 4",
+            "SQRT(16) - SQUARE(x) * y + z",
+            "2 * MAX(-x, y, z) + 1",
+            "2 * MIN((-x, y, z)) + 1",
+            "2 * ARGMAX( (x, y, z, y, z) * 3 + 1) + 1",
+            "2 * ARGMIN(2, 3, 1, 1, 4, 1, 3, 4) + 1",
+            "2 * ARGMIN(1 / basketValues) + 1",
+            "2 * SUM(performances) + SUM(x, y, z)",
+            "2 * PROD(ABS((basketValues))) + PROD(x, y, z)",
+            // more arguments than unrolled kernels
+            "SUM(x / 3, y / 7, z / 11, x, y, z, 0.1, 0.2, 0.3, x / 13) + PROD(x / 3, y / 7, 1.1, 1.3, z / 11)",
+            "MAX(x, -y, z / 3, 1, 2, 3, 4, 5, 6, -7, x * z) - MIN(x / 3, y / 7, z / 11, 0.1 * x, 0.2)",
+            "2 * LEN((1,1,1,1)) + LEN(performances)",
+            "(2, 1) * (3 + 4)",
+            "2**(3, 3) + 4**5",
+            "3 + 4 * 5 / (EXP(LOG((2, 2) - (1, 1))))",
+            "-SQRT((4, 4, 4, 4)) - (x, y, z, x) / 2",
+            "(performances ** 2 - performances) * performances",
+            // comparisons and logical operators are 1 or 0
+            "(x < y) + 2 * (y >= 3) - (z <= 1) + (x > z)",
+            "x < y AND NOT z > 5 OR 0",
+            "NOT (x - 2) + NOT 0 * 3",
+            "(performances > 0) * performances + (x <= performances)",
+            "(basketValues < -2) OR (basketValues >= 4) AND (1, 0, 1, 1, 0)",
+            "NOT (performances - 3) AND 2",
+            "SUM(performances > 1) + MAX(ABS(basketValues) <= 3)",
+            "d",
+            "d_l",
+        };
+    }
+
+    std::vector<Token> toPostfix(const std::string_view infix) {
+        Lexer lexer;
+        const auto [parse_report, postfix] = infixToPostfix(lexer.tokenize(infix));
+        EXPECT_FALSE(parse_report.isError()) << infix;
+        return postfix;
+    }
+
+}
+
+
+TEST(ByteCode, SameResultsAsExpression) {
+
+    const std::vector<std::string> test_data = sameResultCases();
+
+    StaticVStorage storage = makeStorage();
+
+    for (const auto &infix: test_data) {
+
+        const std::vector<Token> postfix = toPostfix(infix);
+
+        Expression expression;
+        const auto [e_report, e_compile_report] = compileExpression(postfix, expression, storage);
+        ASSERT_FALSE(e_report.isError()) << infix;
+
+        ByteCode code;
+        const auto [b_report, b_compile_report] = compileExpression(postfix, code, storage);
+        ASSERT_FALSE(b_report.isError()) << infix;
+
+        ASSERT_EQ(e_compile_report.ret_type, b_compile_report.ret_type);
+        ASSERT_EQ(e_compile_report.max_scalar, b_compile_report.max_scalar);
+        ASSERT_EQ(e_compile_report.max_vector, b_compile_report.max_vector);
+
+        CalcStacks e_stacks(e_compile_report.max_scalar, e_compile_report.max_vector, 1, 1);
+        CalcStacks b_stacks(b_compile_report.max_scalar, b_compile_report.max_vector, 1, 1);
+
+        // running twice checks that the byte code leaves no garbage behind
+        for (int i = 0; i < 2; ++i) {
+            expression(e_stacks);
+            code(b_stacks);
+            switch (b_compile_report.ret_type) {
+                case CType::scalar:
+                    EXPECT_DOUBLE_EQ(e_stacks.scalars().back(), b_stacks.scalars().back()) << infix;
+                    e_stacks.scalars().pop_back();
+                    b_stacks.scalars().pop_back();
+                    break;
+                case CType::vector:
+                    EXPECT_EQ(e_stacks.vectorResult(), b_stacks.vectorResult()) << infix;
+                    e_stacks.popVectorResult();
+                    b_stacks.popVectorResult();
+                    break;
+                case CType::date:
+                    EXPECT_EQ(e_stacks.dates().back(), b_stacks.dates().back()) << infix;
+                    e_stacks.dates().pop_back();
+                    b_stacks.dates().pop_back();
+                    break;
+                case CType::date_list:
+                    EXPECT_EQ(e_stacks.dateListResult(), b_stacks.dateListResult()) << infix;
+                    e_stacks.popDateListResult();
+                    b_stacks.popDateListResult();
+                    break;
+                default:
+                    FAIL() << infix;
+            }
+            ASSERT_TRUE(e_stacks.ready());
+            ASSERT_TRUE(b_stacks.ready());
+        }
+    }
+
+}
+
+
+TEST(ByteCode, ConstantsAreFolded) {
+
+    StaticVStorage storage = makeStorage();
+
+    const std::vector<std::pair<std::string, VECTOR>> test_data = {
+        {"-(x + 2.5) * (1, 2)",                  {-4.5, -9.0}},
+        {"performances * 2 + LEN(basketValues)", {1.0, 11.0, 13.0}},
+        {"(SUM(x, y, z), 1) - (SQRT(4), 1)",     {7.0, 0.0}},
+    };
+
+    for (const auto &[infix, expected]: test_data) {
+        ByteCode code;
+        const auto [report, _] = compileExpression(toPostfix(infix), code, storage);
+        ASSERT_FALSE(report.isError()) << infix;
+
+        ASSERT_EQ(1, code.size()) << infix;
+        EXPECT_EQ(OpCode::push_vector, code.instructions()[0].code) << infix;
+        EXPECT_EQ(expected, code.vectorPool()) << infix;
+    }
+
+}
+
+
+TEST(ByteCode, LengthIsFoldedFromSize) {
+
+    // LEN does not need the values of its argument, the vector is neither pushed nor computed
+    ByteCode code;
+    code.pushVector({1.0, 2.0, 3.0});
+    code.push_back({OpCode::exp_vec, 0});
+    code.push_back({OpCode::len_vec, 0});
+    code.pushScalar(2.0);
+    code.push_back({OpCode::mul_sc_sc, 0});
+
+    const ByteCode folded = foldConstants(code);
+    ASSERT_EQ(1, folded.size());
+    EXPECT_EQ(OpCode::push_scalar, folded.instructions()[0].code);
+    EXPECT_DOUBLE_EQ(6.0, folded.instructions()[0].scalar);
+    EXPECT_TRUE(folded.vectorPool().empty());
+
+}
+
+
+TEST(ByteCode, ParametersAreReadAtEvaluation) {
+
+    StaticVStorage storage = makeStorage();
+    const std::size_t spot = storage.insertParameter<SCALAR>("spot", 100.0);
+    const std::size_t fixings = storage.insertParameter<VECTOR>("fixings", {90.0, 110.0});
+
+    const std::vector<Token> postfix = toPostfix("MAX(SUM(fixings) / LEN(fixings) - spot, (2 - 2))");
+
+    Expression expression;
+    const auto [e_report, compile_report] = compileExpression(postfix, expression, storage);
+    ASSERT_FALSE(e_report.isError());
+    ByteCode byte_code;
+    ASSERT_FALSE(compileExpression(postfix, byte_code, storage).first.isError());
+    RegisterCode register_code;
+    ASSERT_FALSE(compileExpression(postfix, register_code, storage).first.isError());
+
+    // the parameters are not folded, LEN and (2 - 2) are
+    using
+    enum OpCode;
+    const std::vector<OpCode> expected = {load_vector, sum_vec, push_scalar, div_sc_sc, load_scalar, minus_sc_sc,
+                                          push_scalar, max_args};
+    ASSERT_EQ(expected.size(), byte_code.size());
+    for (std::size_t i{0}; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], byte_code.instructions()[i].code);
+    }
+
+    CalcStacks stacks(compile_report.max_scalar, compile_report.max_vector, 0, 0);
+    Registers registers = register_code.makeRegisters();
+    auto evaluate = [&]() {
+        expression(stacks);
+        const SCALAR e_result = stacks.scalars().back();
+        stacks.scalars().pop_back();
+        byte_code(stacks);
+        EXPECT_DOUBLE_EQ(e_result, stacks.scalars().back());
+        stacks.scalars().pop_back();
+        register_code(registers);
+        EXPECT_DOUBLE_EQ(e_result, register_code.scalarResult(registers));
+        return e_result;
+    };
+
+    EXPECT_DOUBLE_EQ(0.0, evaluate());
+    storage.updateParameter(spot, 95.0);
+    EXPECT_DOUBLE_EQ(5.0, evaluate());
+    storage.updateParameter(fixings, VECTOR{100.0, 120.0});
+    EXPECT_DOUBLE_EQ(15.0, evaluate());
+    EXPECT_EQ(spot, storage.parameterSlot("spot"));
+
+}
+
+
+TEST(ByteCode, SharedSubexpressionsAreComputedOnce) {
+
+    StaticVStorage storage = makeStorage();
+    storage.insertParameter<SCALAR>("r", 0.05);
+    storage.insertParameter<SCALAR>("t", 2.0);
+    storage.insertParameter<VECTOR>("s", {90.0, 100.0, 110.0});
+
+    // x is the static variable 2, it is resolved before hashing such that 2 * t and x * t are the same
+    const std::vector<std::string> script = {
+        "EXP(-r * t) * MAX(s)",
+        "EXP(-r * t) * SQRT(2 * t)",
+        "SQRT(x * t) + SUM(s / SQRT(x * t))",
+        "s / SQRT(x * t)",
+    };
+    std::vector<std::vector<Token>> postfixes;
+    for (const auto &line: script) {
+        postfixes.push_back(toPostfix(line));
+    }
+
+    ByteCode code;
+    const auto [report, compile_reports] = compileStatements(postfixes, code, storage);
+    ASSERT_FALSE(report.isError());
+    ASSERT_EQ(script.size(), compile_reports.size());
+
+    std::size_t separate_size{0};
+    CalcStacks expected(10, 10, 0, 0);
+    for (const auto &postfix: postfixes) {
+        ByteCode statement;
+        ASSERT_FALSE(compileExpression(postfix, statement, storage).first.isError());
+        statement(expected);
+        separate_size += statement.size();
+    }
+
+    // EXP(-r * t), SQRT(x * t) and s / SQRT(x * t) are stored once and fetched afterwards
+    using
+    enum OpCode;
+    const auto count = [&code](const OpCode &op_code) { return std::ranges::count(code.instructions(), op_code,
+                                                                                   &Instruction::code); };
+    EXPECT_EQ(2, count(store_scalar));
+    EXPECT_EQ(1, count(store_vector));
+    EXPECT_EQ(3, count(fetch_scalar));
+    EXPECT_EQ(1, count(fetch_vector));
+    EXPECT_EQ(1, count(exp_sc));
+    EXPECT_EQ(1, count(sqrt_sc));
+    EXPECT_LT(code.size(), separate_size);
+
+    // run twice, the locals are overwritten on every evaluation
+    for (int i = 0; i < 2; ++i) {
+        CalcStacks stacks(10, 10, 0, 0);
+        code(stacks);
+        EXPECT_EQ(expected.scalars(), stacks.scalars());
+        EXPECT_EQ(expected.vectors(), stacks.vectors());
+        EXPECT_EQ(expected.vectorSizes(), stacks.vectorSizes());
+    }
+
+    BatchStacks batch(3, 10, 10, 0, 0);
+    code(batch);
+    ASSERT_EQ(3 * expected.scalars().size(), batch.scalars().size());
+    EXPECT_DOUBLE_EQ(expected.scalars().back(), batch.scalars().back());
+    ASSERT_EQ(3 * expected.vectors().size(), batch.vectors().size());
+    EXPECT_DOUBLE_EQ(expected.vectors().back(), batch.vectors().back());
+
+}
+
+
+TEST(ByteCode, FusedInstructions) {
+
+    StaticVStorage storage = makeStorage();
+    storage.insertParameter<SCALAR>("spot", 105.0);
+    storage.insertParameter<SCALAR>("r", 0.05);
+    storage.insertParameter<SCALAR>("t", 2.0);
+
+    using
+    enum OpCode;
+    const std::vector<std::pair<std::string, std::vector<OpCode>>> test_data = {
+        {"MAX(spot - 100, 0)",                {load_scalar, call_imm}},
+        {"MIN(spot * x, 200)",                {load_scalar, mul_sc_imm, min_imm}},
+        {"2 - spot / r",                      {push_scalar, load_scalar, div_sc_load, minus_sc_sc}},
+        {"1 - spot",                          {load_scalar, minus_imm_sc}},
+        {"spot + EXP(r) * EXP(t)",            {load_scalar, load_scalar, exp_sc, load_scalar, exp_sc, mul_add_sc}},
+        {"EXP(r) * EXP(t) + 1",               {load_scalar, exp_sc, load_scalar, exp_sc, mul_add_imm}},
+        {"(spot, r) * t",                     {load_scalar, load_scalar, append, load_scalar, mul_vec_sc}},
+    };
+
+    for (const auto &[infix, expected]: test_data) {
+        ByteCode code;
+        const auto [report, compile_report] = compileExpression(toPostfix(infix), code, storage);
+        ASSERT_FALSE(report.isError()) << infix;
+        const ByteCode fused = fuseInstructions(code);
+
+        ASSERT_EQ(expected.size(), fused.size()) << infix;
+        for (std::size_t i{0}; i < expected.size(); ++i) {
+            EXPECT_EQ(expected[i], fused.instructions()[i].code) << infix;
+        }
+
+        CalcStacks stacks(compile_report.max_scalar, compile_report.max_vector, 0, 0);
+        BatchStacks batch(2, compile_report.max_scalar, compile_report.max_vector, 0, 0);
+        code(stacks);
+        fused(stacks);
+        fused(batch);
+        if (compile_report.ret_type == CType::scalar) {
+            EXPECT_DOUBLE_EQ(stacks.scalars()[0], stacks.scalars()[1]) << infix;
+            EXPECT_EQ(std::vector<SCALAR>(2, stacks.scalars()[0]), batch.scalarResult()) << infix;
+        }
+        else {
+            EXPECT_EQ(std::vector<SCALAR>({105.0 * 2.0, 0.05 * 2.0, 105.0 * 2.0, 0.05 * 2.0}), stacks.vectors());
+        }
+    }
+
+}
+
+
+TEST(ByteCode, FusedVectorLoops) {
+
+    // longer than one tile of the fused loop
+    VECTOR fixings(300);
+    for (std::size_t i{0}; i < fixings.size(); ++i) {
+        fixings[i] = 0.5 + static_cast<SCALAR>(i) / 100.0;
+    }
+    StaticVStorage storage = makeStorage();
+    storage.insertParameter<VECTOR>("v", fixings);
+    storage.insertParameter<SCALAR>("spot", 105.0);
+
+    using
+    enum OpCode;
+    const std::vector<std::pair<std::string, std::vector<OpCode>>> test_data = {
+        {"SQUARE(SQRT(ABS(-1 * LOG(EXP(v)))))", {load_vector, map_vec}},
+        {"2 * (v - 1) / 4",                     {load_vector, map_vec}},
+        {"EXP(v * x)",                          {load_vector, map_vec}},
+        {"EXP(v) * v",                          {load_vector, exp_vec, load_vector, mul_vec_vec}},
+        {"v * spot + 1",                        {load_vector, load_scalar, mul_vec_sc, push_scalar, plus_vec_sc}},
+        {"SQRT(v + v) * 2",                     {load_vector, load_vector, plus_vec_vec, map_vec}},
+        {"SUM(-LOG(v) + 1)",                    {load_vector, map_reduce_vec}},
+        {"SUM(ABS(v))",                         {load_vector, map_reduce_vec}},
+        {"MAX(EXP(v) - 1)",                     {load_vector, map_reduce_vec}},
+        {"ARGMIN(ABS(v - 2))",                  {load_vector, map_reduce_vec}},
+        {"SUM(v * v)",                          {load_vector, load_vector, zip_reduce_vec}},
+        {"PROD(v / v)",                         {load_vector, load_vector, zip_reduce_vec}},
+        {"ARGMAX(SQRT(v * v ** 2))",            {load_vector, load_vector, push_scalar, pow_vec_sc, zip_reduce_vec}},
+        {"MIN(v)",                              {load_vector, min_vec}},
+        {"SUM(v > 1)",                          {load_vector, map_reduce_vec}},
+        {"NOT (v < x) * 2",                     {load_vector, map_vec}},
+    };
+
+    for (const auto &[infix, expected]: test_data) {
+        ByteCode code;
+        const auto [report, compile_report] = compileExpression(toPostfix(infix), code, storage);
+        ASSERT_FALSE(report.isError()) << infix;
+        const ByteCode fused = fuseVectorLoops(code);
+
+        ASSERT_EQ(expected.size(), fused.size()) << infix;
+        for (std::size_t i{0}; i < expected.size(); ++i) {
+            EXPECT_EQ(expected[i], fused.instructions()[i].code) << infix;
+        }
+
+        CalcStacks stacks(compile_report.max_scalar, compile_report.max_vector, 0, 0);
+        CalcStacks fused_stacks(compile_report.max_scalar, compile_report.max_vector, 0, 0);
+        BatchStacks batch(2, compile_report.max_scalar, compile_report.max_vector, 0, 0);
+        code(stacks);
+        fused(fused_stacks);
+        fused(batch);
+        if (compile_report.ret_type == CType::scalar) {
+            EXPECT_EQ(stacks.scalars(), fused_stacks.scalars()) << infix;
+            EXPECT_EQ(std::vector<SCALAR>(2, stacks.scalars().back()), batch.scalarResult()) << infix;
+        }
+        else {
+            EXPECT_EQ(stacks.vectors(), fused_stacks.vectors()) << infix;
+            EXPECT_EQ(stacks.vectors(), batch.vectorResult(0)) << infix;
+            EXPECT_EQ(stacks.vectors(), batch.vectorResult(1)) << infix;
+        }
+    }
+
+}
+
+
+TEST(ByteCode, CompileErrors) {
+
+    StaticVStorage storage = makeStorage();
+
+    const std::vector<std::string> test_data = {
+        "unknown + 1",
+        "(1, 2) + (1, 2, 3)",
+        "d + 1",
+        "SUM((1, 2), 3)",
+    };
+
+    for (const auto &infix: test_data) {
+        ByteCode code;
+        const auto [report, _] = compileExpression(toPostfix(infix), code, storage);
+        EXPECT_TRUE(report.isError()) << infix;
+    }
+
+}
+
+
+TEST(RegisterCode, SameResultsAsExpression) {
+
+    StaticVStorage storage = makeStorage();
+
+    for (const auto &infix: sameResultCases()) {
+
+        const std::vector<Token> postfix = toPostfix(infix);
+
+        Expression expression;
+        const auto [e_report, e_compile_report] = compileExpression(postfix, expression, storage);
+        ASSERT_FALSE(e_report.isError()) << infix;
+
+        RegisterCode code;
+        const auto [r_report, r_compile_report] = compileExpression(postfix, code, storage);
+        ASSERT_FALSE(r_report.isError()) << infix;
+        ASSERT_EQ(e_compile_report.ret_type, code.resultType()) << infix;
+
+        CalcStacks stacks(e_compile_report.max_scalar, e_compile_report.max_vector, 1, 1);
+        Registers registers = code.makeRegisters();
+
+        // running twice checks that the constants are not overwritten
+        for (int i = 0; i < 2; ++i) {
+            expression(stacks);
+            code(registers);
+            switch (code.resultType()) {
+                case CType::scalar:
+                    EXPECT_DOUBLE_EQ(stacks.scalars().back(), code.scalarResult(registers)) << infix;
+                    stacks.scalars().pop_back();
+                    break;
+                case CType::vector:
+                    EXPECT_EQ(stacks.vectorResult(), code.vectorResult(registers)) << infix;
+                    stacks.popVectorResult();
+                    break;
+                case CType::date:
+                    EXPECT_EQ(stacks.dates().back(), code.dateResult(registers)) << infix;
+                    stacks.dates().pop_back();
+                    break;
+                case CType::date_list:
+                    EXPECT_EQ(stacks.dateListResult(), code.dateListResult(registers)) << infix;
+                    stacks.popDateListResult();
+                    break;
+                default:
+                    FAIL() << infix;
+            }
+            ASSERT_TRUE(stacks.ready());
+        }
+    }
+
+}
+
+
+TEST(RegisterCode, OperandsAreNotPushed) {
+
+    // (x + 2.5) * y - SUM(x, 1) before constant folding
+    ByteCode byte_code;
+    byte_code.pushScalar(2.0);
+    byte_code.pushScalar(2.5);
+    byte_code.push_back({OpCode::plus_sc_sc, 0});
+    byte_code.pushScalar(3.0);
+    byte_code.push_back({OpCode::mul_sc_sc, 0});
+    byte_code.pushScalar(2.0);
+    byte_code.pushScalar(1.0);
+    byte_code.push_back({OpCode::sum_args, 2});
+    byte_code.push_back({OpCode::minus_sc_sc, 0});
+    const RegisterCode code(byte_code);
+
+    // x, 2.5, y and 1 live in constant slots, only the arguments of SUM are loaded into a contiguous range
+    using
+    enum OpCode;
+    const std::vector<OpCode> expected = {plus_sc_sc, mul_sc_sc, push_scalar, push_scalar, sum_args, minus_sc_sc};
+    ASSERT_EQ(expected.size(), code.size());
+    for (std::size_t i{0}; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i], code.instructions()[i].code);
+    }
+
+    Registers registers = code.makeRegisters();
+    code(registers);
+    EXPECT_DOUBLE_EQ(10.5, code.scalarResult(registers));
+
+}
+
+
+TEST(RegisterCode, ConstantResult) {
+
+    StaticVStorage storage = makeStorage();
+
+    RegisterCode code;
+    const auto [report, _] = compileExpression(toPostfix("(x + 2.5) * y - SUM(x, 1)"), code, storage);
+    ASSERT_FALSE(report.isError());
+
+    // the folded result is a constant which is moved into a temporary
+    ASSERT_EQ(1, code.size());
+    Registers registers = code.makeRegisters();
+    code(registers);
+    EXPECT_DOUBLE_EQ(10.5, code.scalarResult(registers));
+
+}
+
+
+TEST(RegisterCode, RejectsFusedInstructions) {
+
+    StaticVStorage storage = makeStorage();
+    storage.insertParameter<SCALAR>("spot", 105.0);
+
+    for (const auto &infix: {"MAX(spot - 100, 0)", "SUM(ABS(performances * spot))"}) {
+        ByteCode code;
+        ASSERT_FALSE(compileExpression(toPostfix(infix), code, storage).first.isError()) << infix;
+        EXPECT_TRUE(RegisterCode::isLowerable(code)) << infix;
+        for (const ByteCode &fused: {fuseInstructions(code), fuseVectorLoops(code)}) {
+            if (fused.size() == code.size()) {
+                continue;
+            }
+            EXPECT_FALSE(RegisterCode::isLowerable(fused)) << infix;
+            const RegisterCode register_code(fused);
+            EXPECT_EQ(0, register_code.size()) << infix;
+            EXPECT_EQ(CType::undefined, register_code.resultType()) << infix;
+        }
+    }
+
+}
+
+
+TEST(ByteCode, BatchSameResultsAsScalar) {
+
+    StaticVStorage storage = makeStorage();
+    constexpr std::size_t lanes{5};
+
+    for (const auto &infix: sameResultCases()) {
+
+        ByteCode code;
+        const auto [report, compile_report] = compileExpression(toPostfix(infix), code, storage);
+        ASSERT_FALSE(report.isError()) << infix;
+
+        CalcStacks stacks(compile_report.max_scalar, compile_report.max_vector, 1, 1);
+        BatchStacks batch(lanes, compile_report.max_scalar, compile_report.max_vector, 1, 1);
+
+        code(stacks);
+        code(batch);
+        switch (compile_report.ret_type) {
+            case CType::scalar:
+                for (const auto &lane: batch.scalarResult()) {
+                    EXPECT_DOUBLE_EQ(stacks.scalars().back(), lane) << infix;
+                }
+                batch.popScalarResult();
+                break;
+            case CType::vector:
+                for (std::size_t l{0}; l < lanes; ++l) {
+                    EXPECT_EQ(stacks.vectorResult(), batch.vectorResult(l)) << infix;
+                }
+                batch.popVectorResult();
+                break;
+            case CType::date:
+                EXPECT_EQ(stacks.dates().back(), batch.dates().back()) << infix;
+                batch.dates().pop_back();
+                break;
+            case CType::date_list:
+                EXPECT_EQ(stacks.dateListResult(), DATE_LIST(batch.datesLists().begin(), batch.datesLists().end()))
+                                    << infix;
+                batch.datesLists().clear();
+                batch.dateListSizes().clear();
+                break;
+            default:
+                FAIL() << infix;
+        }
+        ASSERT_TRUE(batch.ready()) << infix;
+    }
+
+}
+
+
+TEST(ByteCode, BatchLanesAreIndependent) {
+
+    // (x, x * x) with a different x per lane
+    BatchStacks batch(3, 4, 2, 0, 0);
+    const std::vector<SCALAR> x = {1.0, -2.0, 3.0};
+    batch.pushScalarLanes(x.data());
+    batch.pushScalarLanes(x.data());
+    batch.pushScalarLanes(x.data());
+    operatorsCalc::binary::scSc(batch, kernels::MUL_F);
+    VectorAppend(2)(batch);
+    functionsReal::reduceVector::argmax(batch);
+
+    EXPECT_EQ(std::vector<SCALAR>({0.0, 1.0, 1.0}), batch.scalarResult());
+
+}
+
+
+TEST(ByteCode, TranspiledFunction) {
+
+    StaticVStorage storage = makeStorage();
+    const std::size_t spot = storage.insertParameter<SCALAR>("spot", 100.0);
+
+    std::vector<std::vector<Token>> postfixes = {toPostfix("MAX(spot * x - 90, 0)"), toPostfix("performances * spot")};
+    ByteCode code;
+    ASSERT_FALSE(compileStatements(postfixes, code, storage).first.isError());
+
+    const auto [report, source] = transpile("payoff", code);
+    ASSERT_FALSE(report.isError()) << report.msg();
+    EXPECT_NE(std::string::npos, source.find("extern \"C\" void payoff(flexMC::CalcStacks &stacks"));
+    EXPECT_NE(std::string::npos, source.find("parameters.scalar(" + std::to_string(spot) + ")"));
+    // the scalar statement is straight-line, the vector statement is one loop
+    EXPECT_EQ(source.find("for ("), source.rfind("for ("));
+    EXPECT_NE(std::string::npos, source.find("stacks.scalars().push_back("));
+    EXPECT_NE(std::string::npos, source.find("stacks.vectorSizes().push_back(3);"));
+
+}
+
+
+TEST(ByteCode, TranspileRejectsScriptControlFlow) {
+
+    StaticVStorage storage;
+    storage.insert<DATE>("today", 7);
+    storage.insertParameter<SCALAR>("flag", 1.0);
+    const auto [script_report, script] = compileScript("today IF flag\n    x := 1\nELSE\n    TERMINATE\n", storage);
+    ASSERT_FALSE(script_report.isError()) << script_report.msg();
+
+    const auto [report, source] = transpile("script", script.code());
+    EXPECT_TRUE(report.isError());
+    EXPECT_TRUE(source.empty());
+
+}
+
+
+TEST(ByteCode, TranspiledFunctionMatchesByteCode) {
+#if defined(FLEXMC_TEST_NATIVE_MODULE)
+
+    // the statements of the module, v is its only parameter
+    Script script;
+    ASSERT_FALSE(script.open(FLEXMC_TEST_NATIVE_SCRIPT).isError());
+    std::vector<std::vector<Token>> postfixes;
+    for (ScriptLines lines(script.source()); lines.next();) {
+        postfixes.push_back(infixToPostfix(lines.tokens()).second);
+    }
+    StaticVStorage storage;
+    // negative, zero and huge elements take the fallback lanes of the kernels
+    storage.insertParameter<VECTOR>("v", {-1.5, 0.0, 1e-300, 0.3, 0.5, 1.0, 2.75, 10.0, 123.456, 700.0, 1e300});
+    ByteCode code;
+    ASSERT_FALSE(compileStatements(postfixes, code, storage).first.isError());
+
+    NativeLibrary library;
+    const MaybeError open_report = library.open(FLEXMC_TEST_NATIVE_MODULE);
+    ASSERT_FALSE(open_report.isError()) << open_report.msg();
+    const auto [report, function] = library.function("vector_math");
+    ASSERT_FALSE(report.isError()) << report.msg();
+
+    const auto bits = [](const std::vector<SCALAR> &values) {
+        std::vector<std::uint64_t> out;
+        for (const SCALAR &value: values) {
+            out.push_back(std::bit_cast<std::uint64_t>(value));
+        }
+        return out;
+    };
+    const vectorMath::Isa selected = vectorMath::isa();
+    for (const auto &isa: {vectorMath::Isa::scalar, vectorMath::Isa::sse2, vectorMath::Isa::avx2,
+                           vectorMath::Isa::avx512}) {
+        if (!vectorMath::selectIsa(isa)) {
+            continue;
+        }
+        CalcStacks b_stacks(32, 256, 0, 0);
+        CalcStacks n_stacks(32, 256, 0, 0);
+        code(b_stacks);
+        function(n_stacks, storage.parameters(), vectorMath::kernels());
+        EXPECT_EQ(bits(b_stacks.scalars()), bits(n_stacks.scalars())) << static_cast<int>(isa);
+        EXPECT_EQ(bits(b_stacks.vectors()), bits(n_stacks.vectors())) << static_cast<int>(isa);
+        EXPECT_EQ(b_stacks.vectorSizes(), n_stacks.vectorSizes()) << static_cast<int>(isa);
+    }
+    vectorMath::selectIsa(selected);
+
+#else
+    GTEST_SKIP() << "no transpiled module on this platform";
+#endif
+}
+
+
+TEST(ByteCode, JitSameResultsAsByteCode) {
+
+    // parameters keep the expressions from being folded into one constant
+    StaticVStorage storage;
+    storage.insertParameter<SCALAR>("x", 2);
+    storage.insertParameter<SCALAR>("y", -3);
+    storage.insertParameter<SCALAR>("z", 0.5);
+    storage.insertParameter<VECTOR>("v", {1, 2});
+
+    const std::vector<std::string> scalar_cases = {
+        "(2 * x**LOG(EXP(-y))) / -(5 - z) + +10",
+        "SQRT(16 * z) - SQUARE(x) * y + ABS(y) - 2 / x",
+        "MAX(-x, y, z, z) + MIN(x * 2, 3) - MAX(x - 3, 0)",
+        "ARGMAX(x, y, z, x, z) + 10 * ARGMIN(z, y, x, y)",
+        "SUM(x, y, z, -0) * PROD(x, y, z) + x * y + z",
+        "2**x + x**2 + y**z + EXP(x) * LOG(z)",
+        "x + (y + (z + (x + (y + (z + (x + (y + (z + (x + (y + (z + EXP(x * y))))))))))))",
+    };
+    for (const auto &infix: scalar_cases) {
+        ByteCode code;
+        JitCode jit;
+        ASSERT_FALSE(compileExpression(toPostfix(infix), code, storage).first.isError()) << infix;
+        ASSERT_FALSE(compileExpression(toPostfix(infix), jit, storage).first.isError()) << infix;
+#if defined(__x86_64__) && !defined(_WIN32)
+        EXPECT_TRUE(jit.isNative()) << infix;
+#endif
+        for (const SCALAR x: {2.0, -1.5, 0.0}) {
+            storage.updateParameter<SCALAR>(storage.parameterSlot("x"), x);
+            CalcStacks expected(20, 0, 0, 0);
+            CalcStacks stacks(20, 0, 0, 0);
+            code(expected);
+            jit(stacks);
+            ASSERT_EQ(1, stacks.scalars().size()) << infix;
+            EXPECT_EQ(std::bit_cast<std::uint64_t>(expected.scalars().back()),
+                      std::bit_cast<std::uint64_t>(stacks.scalars().back())) << infix << " " << x;
+        }
+    }
+
+    // falls back to the interpreter
+    JitCode jit;
+    ASSERT_FALSE(compileExpression(toPostfix("SUM(v * x) + LEN(v)"), jit, storage).first.isError());
+    EXPECT_FALSE(jit.isNative());
+    storage.updateParameter<SCALAR>(storage.parameterSlot("x"), 2.0);
+    CalcStacks stacks(4, 4, 0, 0);
+    jit(stacks);
+    EXPECT_EQ(8.0, stacks.scalars().back());
+
+}
@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <fmt/format.h>
+
 #include "lexer.h"
 #include "expression_parser.h"
 #include "expression_compiler.h"
+#include "terminals.h"
+#include "symbols.h"
 
 
 using namespace flexMC;
@@ -64,7 +69,7 @@ TEST(ExpressionCompiler, RealOperatorsScalar) {
 
     for (const auto &c: test_data) {
 
-        const std::deque<Token> infix = lexer.tokenize(c.infix);
+        const std::vector<Token> infix = lexer.tokenize(c.infix);
         const auto [parse_report, postfix] = infixToPostfix(infix);
 
         EXPECT_FALSE(parse_report.isError());
@@ -143,7 +148,7 @@ TEST(ExpressionCompiler, RealOperatorsVector) {
 
     for (const auto &c: test_data) {
 
-        const std::deque<Token> infix = lexer.tokenize(c.infix);
+        const std::vector<Token> infix = lexer.tokenize(c.infix);
         const auto [parse_report, postfix] = infixToPostfix(infix);
 
         EXPECT_FALSE(parse_report.isError());
@@ -215,7 +220,7 @@ TEST(ExpressionCompiler, RealOperatorsReduce) {
 
     for (const auto &c: test_data) {
 
-        const std::deque<Token> infix = lexer.tokenize(c.infix);
+        const std::vector<Token> infix = lexer.tokenize(c.infix);
         const auto [parse_report, postfix] = infixToPostfix(infix);
 
         EXPECT_FALSE(parse_report.isError());
@@ -254,6 +259,48 @@ TEST(ExpressionCompiler, RealOperatorsReduce) {
 }
 
 
+TEST(ExpressionCompiler, ReduceArgumentsEveryCount) {
+
+    Lexer lexer;
+    StaticVStorage storage;
+
+    // unrolled kernels up to reduceArguments::MAX_UNROLLED arguments, a loop beyond (a single scalar is no list)
+    for (std::size_t n{2}; n <= 10; ++n) {
+        std::vector<SCALAR> args;
+        std::string list;
+        for (std::size_t i{0}; i < n; ++i) {
+            args.push_back(static_cast<SCALAR>((i * 5) % 7) / 3.0 - 1.0);
+            list += (i == 0 ? "" : ", ") + fmt::format("{}", args.back());
+        }
+        // from the last argument to the first
+        SCALAR sum{0.0};
+        SCALAR prod{1.0};
+        for (std::size_t i{n}; i-- > 0;) {
+            sum += args[i];
+            prod *= args[i];
+        }
+        const std::vector<std::pair<std::string, SCALAR>> test_data = {
+            {fmt::format("SUM({})", list),  sum},
+            {fmt::format("PROD({})", list), prod},
+            {fmt::format("MAX({})", list),  std::ranges::max(args)},
+            {fmt::format("MIN({})", list),  std::ranges::min(args)},
+        };
+        for (const auto &[infix, expected]: test_data) {
+            const auto [parse_report, postfix] = infixToPostfix(lexer.tokenize(infix));
+            ASSERT_FALSE(parse_report.isError()) << infix;
+            Expression expression;
+            const auto [error_report, compile_report] = compileExpression(postfix, expression, storage);
+            ASSERT_FALSE(error_report.isError()) << infix;
+            CalcStacks stacks(compile_report.max_scalar, compile_report.max_vector, 0, 0);
+            expression(stacks);
+            ASSERT_EQ(stacks.scalars().size(), 1) << infix;
+            EXPECT_EQ(stacks.scalars().back(), expected) << infix;
+        }
+    }
+
+}
+
+
 TEST(ExpressionCompiler, ScalarStaticVariables) {
 
     struct TestCase {
@@ -304,7 +351,7 @@ TEST(ExpressionCompiler, ScalarStaticVariables) {
 
     for (const auto &c: test_data) {
 
-        const std::deque<Token> infix = lexer.tokenize(c.infix);
+        const std::vector<Token> infix = lexer.tokenize(c.infix);
         const auto [parse_report, postfix] = infixToPostfix(infix);
 
         EXPECT_FALSE(parse_report.isError());
@@ -340,4 +387,54 @@ TEST(ExpressionCompiler, ScalarStaticVariables) {
         }
     }
 
-}
\ No newline at end of file
+}
+
+
+TEST(ExpressionCompiler, SymbolsMatchTerminals) {
+    const std::vector<std::pair<std::string_view, Symbol>> test_data = {
+        {PLUS,   Symbol::plus},
+        {MINUS,  Symbol::minus},
+        {MUL,    Symbol::mul},
+        {DIV,    Symbol::div},
+        {POW,    Symbol::pow},
+        {LT,     Symbol::lt},
+        {GT,     Symbol::gt},
+        {LE,     Symbol::le},
+        {GE,     Symbol::ge},
+        {AND,    Symbol::and_},
+        {OR,     Symbol::or_},
+        {NOT,    Symbol::not_},
+        {EXP,    Symbol::exp},
+        {LOG,    Symbol::log},
+        {ABS,    Symbol::abs},
+        {SQRT,   Symbol::sqrt},
+        {SQUARE, Symbol::square},
+        {SUM,    Symbol::sum},
+        {PROD,   Symbol::prod},
+        {MAX,    Symbol::max},
+        {MIN,    Symbol::min},
+        {ARGMAX, Symbol::argmax},
+        {ARGMIN, Symbol::argmin},
+        {LEN,    Symbol::len},
+        {PAY,    Symbol::undefined},
+        {SMOOTH_LT, Symbol::undefined},
+    };
+    for (const auto &[terminal, symbol]: test_data) {
+        EXPECT_EQ(toSymbol(terminal), symbol) << terminal;
+    }
+}
+
+
+TEST(ExpressionCompiler, NumberOutOfRange) {
+    Lexer lexer;
+    StaticVStorage storage;
+    const std::string infix = "2 * 1e999";
+    const auto [parse_report, postfix] = infixToPostfix(lexer.tokenize(infix));
+    ASSERT_FALSE(parse_report.isError());
+    Expression expression;
+    const auto [error_report, _] = compileExpression(postfix, expression, storage);
+    ASSERT_TRUE(error_report.isError());
+    const auto [at, length] = error_report.position();
+    EXPECT_EQ(at, 4);
+    EXPECT_EQ(length, 5);
+}
@@ -37,13 +37,17 @@ TEST(ExpressionParser, OperatorsAndOperands) {
         {"2 * x ** 3 - 5",        "2 x 3 ** * 5 -"},
         {"(a + b)**2",            "a b + 2 **"},
         {"x **(y + z) / 2",       "x y z + ** 2 /"},
+        {"a + 1 < b * 2",         "a 1 + b 2 * <"},
+        {"NOT x < 1",             "x 1 < NOT"},
+        {"a < b AND c >= d",      "a b < c d >= AND"},
+        {"a OR NOT b AND c",      "a b NOT c AND OR"},
     };
 
     Lexer lexer;
 
     for (const auto &c: test_data) {
 
-        const std::deque<Token> infix = lexer.tokenize(c.infix);
+        const std::vector<Token> infix = lexer.tokenize(c.infix);
         const auto [parse_report, postfix] = infixToPostfix(infix);
         EXPECT_FALSE(parse_report.isError());
         std::string res;
@@ -60,4 +64,59 @@ TEST(ExpressionParser, OperatorsAndOperands) {
 
     }
 
-}
\ No newline at end of file
+}
+
+TEST(ExpressionParser, IndexMode) {
+
+    using namespace flexMC;
+
+    const std::vector<std::string> test_data = {
+        "a + b * (c - d) / e",
+        "-x ** 2 + +y",
+        "EXP(a, b) * LEN([1, 2, 3][0])",
+        "SUM((1, 2, x)) - MAX(1, 2)",
+        "v[i + 1] ** -(2)",
+        "SUM() + 1",
+        "a + (b",
+        "a + ) b",
+    };
+
+    Lexer lexer;
+    std::vector<PostfixNode> postfix;
+    std::vector<PostfixNode> operators;
+    postfix.reserve(64);
+    operators.reserve(64);
+    const PostfixNode *postfix_data = postfix.data();
+    const PostfixNode *operators_data = operators.data();
+
+    for (const auto &c: test_data) {
+        const std::vector<Token> infix = lexer.tokenize(c);
+        const auto [token_report, tokens] = infixToPostfix(infix);
+        const MaybeError report = infixToPostfix(infix, postfix, operators);
+        EXPECT_EQ(report.isError(), token_report.isError()) << c;
+        EXPECT_EQ(report.position(), token_report.position()) << c;
+        ASSERT_EQ(postfix.size(), tokens.size()) << c;
+        for (std::size_t i{0}; i < postfix.size(); ++i) {
+            const Token tok = nodeToken(postfix[i], infix);
+            EXPECT_EQ(tok.type, tokens[i].type) << c;
+            EXPECT_EQ(tok.value, tokens[i].value) << c;
+            EXPECT_EQ(tok.start, tokens[i].start) << c;
+            EXPECT_EQ(tok.context.num_args, tokens[i].context.num_args) << c;
+            EXPECT_EQ(tok.context.is_prefix, tokens[i].context.is_prefix) << c;
+            if (postfix[i].type == Token::Type::op || postfix[i].type == Token::Type::num) {
+                EXPECT_EQ(infix[postfix[i].token].value.data(), tok.value.data()) << c;
+            }
+        }
+    }
+    // the buffers are reused
+    EXPECT_EQ(postfix.data(), postfix_data);
+    EXPECT_EQ(operators.data(), operators_data);
+
+    const std::vector<Token> infix = lexer.tokenize("EXP(-a, 2)");
+    ASSERT_FALSE(infixToPostfix(infix, postfix, operators).isError());
+    ASSERT_EQ(postfix.size(), 5);
+    EXPECT_TRUE(postfix[2].is_prefix);
+    EXPECT_EQ(postfix[4].type, Token::Type::call_);
+    EXPECT_EQ(postfix[4].num_args, 2);
+    EXPECT_EQ(infix[postfix[4].token].value, ")");
+}
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
+#include <random>
 #include <ranges>
+#include <regex>
 
 #include "lexer.h"
+#include "terminals.h"
 
 
 using namespace flexMC;
@@ -112,7 +115,7 @@ TEST(Lexer, ValidKeywordsAndSymbols) {
 
 
     Lexer lexer;
-    std::deque<Token> tokens = lexer.tokenize(testStr);
+    std::vector<Token> tokens = lexer.tokenize(testStr);
     EXPECT_EQ(expected.size(), tokens.size());
     for (const auto &[exp, res]: std::ranges::zip_view(expected, tokens)) {
         EXPECT_EQ(exp.toString(), res.toString());
@@ -289,10 +292,110 @@ TEST(Lexer, ValidNumbersAndIdentifiers) {
     testStr += "-    1.";
 
     Lexer lexer;
-    std::deque<Token> tokens = lexer.tokenize(testStr);
+    std::vector<Token> tokens = lexer.tokenize(testStr);
     EXPECT_EQ(expected.size(), tokens.size());
     for (const auto &[exp, res]: std::ranges::zip_view(expected, tokens)) {
         EXPECT_EQ(exp.toString(), res.toString());
     }
 };
 
+
+
+namespace {
+
+    // The regular expression tokenizer the Lexer replaced, defines the token grammar
+    std::vector<Token> regexTokenize(const std::string &line) {
+        auto join = [](const auto &groups) {
+            std::string all = "(";
+            for (const auto &group: groups) {
+                all.append(group).append(")|(");
+            }
+            return std::regex(all.substr(0, all.size() - 2));
+        };
+        const std::regex groups_1 = join(R_GROUPS_1);
+        const std::regex groups_2 = join(R_GROUPS_2);
+        const std::regex id_regex(R_ID.data(), R_ID.size());
+        const std::regex num_regex(R_NUM.data(), R_NUM.size());
+
+        using
+        enum Token::Type;
+
+        std::vector<Token> out;
+        std::string suffix = line;
+        std::size_t line_no{0};
+        while (out.empty() || ((out.back().type != eof) && (out.back().type != undefined) && (line_no <= MAX_LINE_LEN))) {
+            // the tokens are views into line
+            const std::string_view rest = std::string_view(line).substr(line.size() - suffix.size());
+            std::smatch match;
+            if (suffix.empty()) {
+                out.emplace_back(eof, "", line_no);
+            }
+            else if (std::regex_search(suffix, match, id_regex)) {
+                out.emplace_back(id, rest.substr(0, match.length()), line_no);
+            }
+            else if (std::regex_search(suffix, match, num_regex)) {
+                out.emplace_back(num, rest.substr(0, match.length()), line_no);
+            }
+            else if (std::regex_search(suffix, match, groups_1) || std::regex_search(suffix, match, groups_2)) {
+                out.push_back(Tokens::makeContextualized(rest.substr(0, match.length()), line_no));
+            }
+            else {
+                out.emplace_back(undefined, rest, line_no, 0);
+            }
+            line_no += out.back().size;
+            suffix = match.empty() ? "" : match.suffix().str();
+        }
+        if (out.back().type != eof) {
+            out.emplace_back(eof, "", line_no);
+        }
+        return out;
+    }
+
+    void expectSameTokens(const std::string &line) {
+        const auto expected = regexTokenize(line);
+        const auto tokens = Lexer().tokenize(line);
+        ASSERT_EQ(expected.size(), tokens.size()) << line;
+        for (const auto &[exp, res]: std::ranges::zip_view(expected, tokens)) {
+            EXPECT_EQ(exp.toString(), res.toString()) << line;
+            EXPECT_EQ(exp.start, res.start) << line;
+            EXPECT_EQ(exp.size, res.size) << line;
+        }
+    }
+
+}
+
+
+TEST(Lexer, MatchesRegexGrammar) {
+    const std::vector<std::string> lines = {
+        "",
+        "x := 1.5e-3 * SQRT(y) ** 2",
+        "IF x < 1 AND y >= 2 OR NOT z",
+        "\tx += 1",
+        "\t\t\t\ty",
+        "  \t x",
+        "1e 1e+ 1.e5 .e5 . 1.2.3 007",
+        "IFX ORx SQUAREROOT MINIMUM PAY_A PAY_AT( APPEND LENGTH",
+        "x\ny",
+        "a<<b>>c<=d>=e<>f",
+        "v[1] := (1, 2, 3)",
+        "x := 1 # comment",
+        "x := \xe4",
+        std::string(MAX_LINE_LEN + 10, 'x'),
+        std::string(MAX_LINE_LEN / 2, '\t') + "x",
+    };
+    for (const auto &line: lines) {
+        expectSameTokens(line);
+    }
+
+    const std::string alphabet = "xyzAEIFLNOPRSTUX_019.eE+-*/<>=:,()[] \t\n";
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<std::size_t> letter(0, alphabet.size() - 1);
+    std::uniform_int_distribution<std::size_t> length(0, 40);
+    for (std::size_t i{0}; i < 1000; ++i) {
+        std::string line(length(gen), ' ');
+        for (auto &c: line) {
+            c = alphabet[letter(gen)];
+        }
+        expectSameTokens(line);
+    }
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "script.h"
+#include "language_error.h"
+
+using namespace flexMC;
+
+
+TEST(Script, LinesSkipBlanksAndLineBreaks) {
+    const std::string source = "x := 1\r\n\n   \r\n\tTERMINATE\n\ny := x + 2";
+    ScriptLines lines(source);
+    std::vector<std::pair<std::size_t, std::string_view>> found;
+    while (lines.next()) {
+        found.emplace_back(lines.number(), lines.line());
+        EXPECT_EQ(lines.tokens().back().type, Token::Type::eof);
+    }
+    const std::vector<std::pair<std::size_t, std::string_view>> expected = {
+        {1, "x := 1"},
+        {4, "\tTERMINATE"},
+        {6, "y := x + 2"},
+    };
+    EXPECT_EQ(found, expected);
+}
+
+
+TEST(Script, ParseStatements) {
+    const Script script(
+        "myDate x := EXP(0) + y\n"
+        "\n"
+        "myDate IF x > 1\n"
+        "    PAY(a) := x\n"
+        "ELSE\n"
+        "    TERMINATE\n"
+    );
+    const auto [report, statements] = parseScript(script.source());
+    ASSERT_FALSE(report.isError()) << report.msg();
+    ASSERT_EQ(statements.size(), 5);
+
+    const std::vector<std::size_t> line_numbers = {1, 3, 4, 5, 6};
+    const std::vector<std::size_t> statement_sizes = {3, 2, 2, 1, 2};
+    const std::vector<std::size_t> postfix_sizes = {5, 3, 4, 0, 0};
+    for (std::size_t i{0}; i < statements.size(); ++i) {
+        EXPECT_EQ(statements[i].line_no, line_numbers[i]) << i;
+        EXPECT_EQ(statements[i].statement_begin.size(), statement_sizes[i]) << i;
+        EXPECT_EQ(statements[i].postfix.size(), postfix_sizes[i]) << i;
+    }
+    // tokens are views into the script
+    EXPECT_EQ(statements[0].statement_begin[1].value.data(), script.source().data() + 7);
+}
+
+
+TEST(Script, ErrorLineAndColumn) {
+    const Script script("myDate x := 1\n\nmyDate y := (x + 2\n");
+    const auto [report, statements] = parseScript(script.source());
+    ASSERT_TRUE(report.isError());
+    EXPECT_TRUE(statements.empty());
+    EXPECT_EQ(report.line(), 3);
+    EXPECT_EQ(report.position().first, 18);
+    const std::string message = printError("Parse", "myDate y := (x + 2", report);
+    EXPECT_NE(message.find("line 3, column 19"), std::string::npos) << message;
+}
+
+
+TEST(Script, MapFile) {
+    const auto path = std::filesystem::temp_directory_path() / "flexmc_test_script.flexmc";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "myDate x := 1\nmyDate y := x * 2\n";
+    }
+    Script script;
+    ASSERT_FALSE(script.open(path.string()).isError());
+    // views stay valid when the script is moved
+    const std::string_view source = script.source();
+    const Script moved(std::move(script));
+    EXPECT_EQ(moved.source().data(), source.data());
+    EXPECT_TRUE(script.source().empty());
+
+    const auto [report, statements] = parseScript(moved.source());
+    ASSERT_FALSE(report.isError()) << report.msg();
+    EXPECT_EQ(statements.size(), 2);
+    std::filesystem::remove(path);
+
+    Script missing;
+    EXPECT_TRUE(missing.open(path.string()).isError());
+    EXPECT_TRUE(missing.source().empty());
+}
@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "script_compiler.h"
+#include "static_variables.h"
+
+
+using namespace flexMC;
+
+
+TEST(ScriptCompiler, AssignmentsOnDates) {
+    StaticVStorage storage;
+    storage.insert<DATE>("first", 1);
+    storage.insert<DATE>("second", 2);
+    storage.insert<SCALAR>("k", 3.0);
+
+    const auto [report, script] = compileScript(
+        "first x := 2\n"
+        "first x += k\n"
+        "first v := (1, 2, 3) * x\n"
+        "second x *= 2\n"
+        "CONTINUOUS y := x + SUM(v)\n",
+        storage);
+    ASSERT_FALSE(report.isError()) << report.msg();
+
+    CalcStacks stacks(script.maxScalar(), script.maxVector(), 0, 0);
+    EXPECT_TRUE(script(stacks, 1));
+    EXPECT_EQ(script.scalar(stacks, "x"), 5.0);
+    EXPECT_EQ(script.vector(stacks, "v"), VECTOR({5.0, 10.0, 15.0}));
+    EXPECT_EQ(script.scalar(stacks, "y"), 35.0);
+    EXPECT_TRUE(stacks.scalars().empty());
+    EXPECT_TRUE(stacks.vectors().empty());
+
+    // the variables are carried from date to date
+    EXPECT_TRUE(script(stacks, 2));
+    EXPECT_EQ(script.scalar(stacks, "x"), 10.0);
+    EXPECT_EQ(script.scalar(stacks, "y"), 40.0);
+
+    EXPECT_TRUE(script(stacks, 3));
+    EXPECT_EQ(script.scalar(stacks, "x"), 10.0);
+}
+
+
+TEST(ScriptCompiler, IfElseBlocks) {
+    StaticVStorage storage;
+    storage.insert<DATE>("today", 7);
+    const std::size_t flag = storage.insertParameter<SCALAR>("flag", 1.0);
+
+    const auto [report, script] = compileScript(
+        "today IF flag\n"
+        "    x := 1\n"
+        "    z := 5\n"
+        "ELSE\n"
+        "    x := 2\n"
+        "    TERMINATE\n"
+        "today y := x + 10\n"
+        "today IF flag - 1\n"
+        "    y := 0\n",
+        storage);
+    ASSERT_FALSE(report.isError()) << report.msg();
+
+    // one flat program: the date guards and the IF conditions are the only jumps
+    std::size_t jumps{0};
+    for (const Instruction &instruction: script.code().instructions()) {
+        jumps += (OpCode::jump <= instruction.code) && (instruction.code <= OpCode::jump_unless_date);
+    }
+    EXPECT_EQ(jumps, 6);
+
+    CalcStacks stacks(script.maxScalar(), script.maxVector(), 0, 0);
+    EXPECT_TRUE(script(stacks, 7));
+    EXPECT_EQ(script.scalar(stacks, "x"), 1.0);
+    EXPECT_EQ(script.scalar(stacks, "y"), 11.0);
+    EXPECT_EQ(script.scalar(stacks, "z"), 5.0);
+
+    storage.updateParameter(flag, 0.0);
+    CalcStacks terminated(script.maxScalar(), script.maxVector(), 0, 0);
+    EXPECT_FALSE(script(terminated, 7));
+    EXPECT_EQ(script.scalar(terminated, "x"), 2.0);
+    EXPECT_EQ(script.scalar(terminated, "y"), 0.0);
+    EXPECT_EQ(script.scalar(terminated, "z"), 0.0);
+
+    storage.updateParameter(flag, 2.0);
+    EXPECT_TRUE(script(stacks, 7));
+    EXPECT_EQ(script.scalar(stacks, "y"), 0.0);
+
+    // nothing is scheduled on other dates
+    storage.updateParameter(flag, 0.0);
+    EXPECT_TRUE(script(stacks, 8));
+}
+
+
+TEST(ScriptCompiler, BatchMatchesPaths) {
+    StaticVStorage storage;
+    const std::vector<std::string> dates = {"start", "first", "second", "third", "fourth", "fifth"};
+    for (std::size_t i{0}; i < dates.size(); ++i) {
+        storage.insert<DATE>(dates[i], static_cast<DATE>(i + 1));
+    }
+    const std::size_t input = storage.insertParameter<SCALAR>("input", 0.0);
+
+    const auto [report, script] = compileScript(
+        "start s := input\n"
+        "start total := 0\n"
+        "first IF s - 1\n"
+        "    x := s * 2\n"
+        "    v := (s, x)\n"
+        "ELSE\n"
+        "    x := s + 10\n"
+        "    v := (x, x)\n"
+        "first total += x\n"
+        "second IF s + 10\n"
+        "    total += 1\n"
+        "third IF s - 2\n"
+        "    TERMINATE\n"
+        "third total *= 10\n"
+        "fourth total += SUM(v)\n"
+        "fifth IF 1\n"
+        "    TERMINATE\n",
+        storage);
+    ASSERT_FALSE(report.isError()) << report.msg();
+
+    // the lanes disagree on the IF of first and third and agree on the ones of second and fifth
+    const std::vector<SCALAR> s = {0.0, 1.0, 2.0, 3.0};
+    BatchStacks batch(s.size(), script.maxScalar(), script.maxVector(), 0, 0);
+    EXPECT_TRUE(script(batch, 1));
+    script.setScalar(batch, "s", s.data());
+    for (DATE date{2}; date <= 5; ++date) {
+        EXPECT_TRUE(script(batch, date)) << date;
+        EXPECT_TRUE(batch.ready()) << date;
+    }
+    EXPECT_EQ(batch.live(), 1);
+    EXPECT_TRUE(batch.isLive(2));
+    // compacted to the live lane
+    EXPECT_EQ(batch.lanes(), 1);
+    EXPECT_FALSE(script(batch, 6));
+    EXPECT_EQ(batch.live(), 0);
+
+    const std::vector<SCALAR> totals = script.scalar(batch, "total");
+    for (std::size_t lane{0}; lane < s.size(); ++lane) {
+        storage.updateParameter(input, s[lane]);
+        CalcStacks stacks(script.maxScalar(), script.maxVector(), 0, 0);
+        bool live{true};
+        for (DATE date{1}; live && (date <= 6); ++date) {
+            live = script(stacks, date);
+        }
+        EXPECT_EQ(totals[lane], script.scalar(stacks, "total")) << lane;
+        EXPECT_EQ(script.vector(batch, "v", lane), script.vector(stacks, "v")) << lane;
+    }
+    EXPECT_EQ(totals, std::vector<SCALAR>({1.0, 12.0, 56.0, 7.0}));
+}
+
+
+TEST(ScriptCompiler, ComparisonConditions) {
+    StaticVStorage storage;
+    storage.insert<DATE>("start", 1);
+    storage.insert<DATE>("expiry", 2);
+    const std::size_t input = storage.insertParameter<SCALAR>("input", 0.0);
+
+    const auto [report, script] = compileScript(
+        "start spot := input\n"
+        "expiry inside := spot >= 90 AND spot <= 110\n"
+        "expiry IF NOT inside OR spot < 0\n"
+        "    payoff := 0\n"
+        "ELSE\n"
+        "    payoff := spot - 90\n",
+        storage);
+    ASSERT_FALSE(report.isError()) << report.msg();
+
+    const std::vector<SCALAR> spots = {-5.0, 85.0, 90.0, 100.0, 110.0, 120.0};
+    BatchStacks batch(spots.size(), script.maxScalar(), script.maxVector(), 0, 0);
+    EXPECT_TRUE(script(batch, 1));
+    script.setScalar(batch, "spot", spots.data());
+    EXPECT_TRUE(script(batch, 2));
+    EXPECT_EQ(script.scalar(batch, "inside"), std::vector<SCALAR>({0.0, 0.0, 1.0, 1.0, 1.0, 0.0}));
+    EXPECT_EQ(script.scalar(batch, "payoff"), std::vector<SCALAR>({0.0, 0.0, 0.0, 10.0, 20.0, 0.0}));
+
+    for (std::size_t lane{0}; lane < spots.size(); ++lane) {
+        storage.updateParameter(input, spots[lane]);
+        CalcStacks stacks(script.maxScalar(), script.maxVector(), 0, 0);
+        EXPECT_TRUE(script(stacks, 1));
+        EXPECT_TRUE(script(stacks, 2));
+        EXPECT_EQ(script.scalar(batch, "payoff")[lane], script.scalar(stacks, "payoff")) << lane;
+    }
+}
+
+
+TEST(ScriptCompiler, BatchCompaction) {
+    StaticVStorage storage;
+    storage.insert<DATE>("start", 0);
+    const std::size_t input = storage.insertParameter<SCALAR>("input", 0.0);
+
+    // one path is terminated per date, in a masked IF branch
+    const auto [report, script] = compileScript(
+        "start s := input\n"
+        "start k := -0.1\n"
+        "start v := (0, 0, 0)\n"
+        "CONTINUOUS k += 0.1\n"
+        "CONTINUOUS IF MAX(k - s, 0)\n"
+        "    v += (1, 2, 3) * k\n"
+        "    TERMINATE\n"
+        "ELSE\n"
+        "    v := v * 0.5 + (k, 1, 2)\n",
+        storage);
+    ASSERT_FALSE(report.isError()) << report.msg();
+
+    constexpr std::size_t paths{10};
+    std::vector<SCALAR> s(paths);
+    for (std::size_t path{0}; path < paths; ++path) {
+        s[path] = 0.05 + 0.1 * static_cast<SCALAR>(paths - path - 1);
+    }
+
+    std::vector<std::vector<SCALAR>> expected_v;
+    for (std::size_t path{0}; path < paths; ++path) {
+        storage.updateParameter(input, s[path]);
+        CalcStacks stacks(script.maxScalar(), script.maxVector(), 0, 0);
+        for (DATE date{0}; script(stacks, date); ++date) {}
+        expected_v.push_back(script.vector(stacks, "v"));
+    }
+
+    for (const SCALAR threshold: {0.0, 0.5, 1.0}) {
+        BatchStacks batch(paths, script.maxScalar(), script.maxVector(), 0, 0);
+        batch.setCompactionThreshold(threshold);
+        EXPECT_TRUE(script(batch, 0));
+        script.setScalar(batch, "s", s.data());
+        std::size_t min_lanes{paths};
+        for (DATE date{1}; script(batch, date); ++date) {
+            EXPECT_EQ(batch.live(), paths - static_cast<std::size_t>(date)) << threshold;
+            min_lanes = std::min(min_lanes, batch.lanes());
+        }
+        EXPECT_EQ(min_lanes, threshold == 0.0 ? paths : 1) << threshold;
+        for (std::size_t path{0}; path < paths; ++path) {
+            EXPECT_FALSE(batch.isLive(path));
+            EXPECT_EQ(script.vector(batch, "v", path), expected_v[path]) << threshold << ", " << path;
+        }
+        EXPECT_EQ(script.scalar(batch, "s"), s);
+    }
+}
+
+
+TEST(ScriptCompiler, Errors) {
+
+    struct TestCase {
+        std::string source;
+        std::size_t line;
+        std::string message;
+    };
+
+    const std::vector<TestCase> test_data = {
+        {"d x := 1\n    y := 2",             2, "outside of"},
+        {"ELSE",                             1, "without a preceding"},
+        {"d IF 1\n    x := 1\nELSE\nELSE",   4, "without a preceding"},
+        {"k x := 1",                         1, "<date> variable"},
+        {"d k := 1",                         1, "static variable"},
+        {"d x := 1\n\nd x := (1, 2)",        3, "type or the size"},
+        {"d x += 1",                         1, "undefined"},
+        {"d x := y",                         1, "undefined"},
+        {"d PAY(a) := 1",                    1, "PAY"},
+        {"d IF (1, 2)",                      1, "<scalar>"},
+        {"d x := (1",                        1, "Unmatched"},
+    };
+
+    for (const auto &c: test_data) {
+        StaticVStorage storage;
+        storage.insert<DATE>("d", 1);
+        storage.insert<SCALAR>("k", 1.0);
+        const auto [report, script] = compileScript(c.source, storage);
+        ASSERT_TRUE(report.isError()) << c.source;
+        EXPECT_EQ(report.line(), c.line) << c.source;
+        EXPECT_NE(report.msg().find(c.message), std::string::npos) << c.source << ": " << report.msg();
+    }
+}
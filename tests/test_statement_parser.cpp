@@ -69,14 +69,14 @@ TEST(StatementParser, StartOfLineStripper) {
     Lexer lexer;
 
     for (const auto &c: valid_cases) {
-        std::deque<Token> tokens = lexer.tokenize(c.infix);
+        std::vector<Token> tokens = lexer.tokenize(c.infix);
         const auto [parse_report, parse_result] = parseStartOfLine(tokens);
         EXPECT_FALSE(parse_report.isError()) << "Expected no error for valid case: " << c.infix;
         EXPECT_EQ(parse_result.statement_begin.size(), c.n_tokens) << "Token size mismatch for valid case: " << c.infix;
     }
 
     for (const auto &infix: bad_cases) {
-        std::deque<Token> tokens = lexer.tokenize(infix);
+        std::vector<Token> tokens = lexer.tokenize(infix);
         const auto [parse_report, _] = parseStartOfLine(tokens);
         EXPECT_TRUE(parse_report.isError()) << "Expected error for bad case: " << infix;
     }
@@ -84,11 +84,11 @@ TEST(StatementParser, StartOfLineStripper) {
 }
 
 TEST(StatementParser, MakePaymentExpressionValid) {
-    std::deque<Token> start_of_line = {
+    std::vector<Token> start_of_line = {
         Token(Token::Type::id, "PAY", 0),
         Token(Token::Type::lparen, "(", 3)
     };
-    std::deque<Token> rest_of_line = {
+    std::vector<Token> rest_of_line = {
         Token(Token::Type::id, "enum_1", 0),
         Token(Token::Type::op, ",", 0),
         Token(Token::Type::id, "enum_2", 0),
@@ -98,7 +98,7 @@ TEST(StatementParser, MakePaymentExpressionValid) {
         Token(Token::Type::eof, "", 0)
     };
 
-    std::deque<Token> expected = {
+    std::vector<Token> expected = {
         Token(Token::Type::id, "PAY", 0),
         Token(Token::Type::lparen, "(", 0),
         Token(Token::Type::id, "enum_1", 0),
@@ -112,7 +112,7 @@ TEST(StatementParser, MakePaymentExpressionValid) {
 
     MaybeError report;
 
-    std::deque<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
+    std::vector<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
 
     ASSERT_FALSE(report.isError()) << "Expected no error for valid payment expression";
     ASSERT_EQ(result.size(), expected.size()) << "Token size mismatch for valid payment expression";
@@ -124,11 +124,11 @@ TEST(StatementParser, MakePaymentExpressionValid) {
 
 TEST(StatementParser, PaymentMissingClosingParenthesis) {
     MaybeError report;
-    std::deque<Token> start_of_line = {
+    std::vector<Token> start_of_line = {
         Token(Token::Type::id, "PAY", 0),
         Token(Token::Type::lparen, "(", 3)
     };
-    std::deque<Token> rest_of_line = {
+    std::vector<Token> rest_of_line = {
         Token(Token::Type::id, "enum_1", 4),
         Token(Token::Type::op, ",", 10),
         Token(Token::Type::id, "enum_2", 12),
@@ -137,20 +137,20 @@ TEST(StatementParser, PaymentMissingClosingParenthesis) {
         Token(Token::Type::eof, "", 22)
     };
 
-    std::deque<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
+    std::vector<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
 
     ASSERT_TRUE(report.isError()) << "Expected error for missing closing parenthesis";
 }
 
 TEST(StatementParser, EmptyRestOfLine) {
     MaybeError report;
-    std::deque<Token> start_of_line = {
+    std::vector<Token> start_of_line = {
         Token(Token::Type::id, "PAY", 0),
         Token(Token::Type::lparen, "(", 3)
     };
-    std::deque<Token> rest_of_line = {};
+    std::vector<Token> rest_of_line = {};
 
-    std::deque<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
+    std::vector<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
 
     ASSERT_TRUE(report.isError()) << "Expected error for empty rest of line";
     ASSERT_TRUE(result.empty()) << "Expected empty result for empty rest of line";
@@ -158,11 +158,11 @@ TEST(StatementParser, EmptyRestOfLine) {
 
 TEST(StatementParser, NoAssignmentOperator) {
     MaybeError report;
-    std::deque<Token> start_of_line = {
+    std::vector<Token> start_of_line = {
         Token(Token::Type::id, "PAY", 0),
         Token(Token::Type::lparen, "(", 3)
     };
-    std::deque<Token> rest_of_line = {
+    std::vector<Token> rest_of_line = {
         Token(Token::Type::id, "enum_1", 4),
         Token(Token::Type::op, ",", 10),
         Token(Token::Type::id, "enum_2", 12),
@@ -170,7 +170,7 @@ TEST(StatementParser, NoAssignmentOperator) {
         Token(Token::Type::eof, "", 19)
     };
 
-    std::deque<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
+    std::vector<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
 
     ASSERT_TRUE(report.isError()) << "Expected error for missing assignment operator";
     ASSERT_TRUE(result.empty()) << "Expected empty result for missing assignment operator";
@@ -178,11 +178,11 @@ TEST(StatementParser, NoAssignmentOperator) {
 
 TEST(StatementParser, NoTokensAfterAssignmentOperator) {
     MaybeError report;
-    std::deque<Token> start_of_line = {
+    std::vector<Token> start_of_line = {
         Token(Token::Type::id, "PAY", 0),
         Token(Token::Type::lparen, "(", 3)
     };
-    std::deque<Token> rest_of_line = {
+    std::vector<Token> rest_of_line = {
         Token(Token::Type::id, "enum_1", 4),
         Token(Token::Type::op, ",", 10),
         Token(Token::Type::id, "enum_2", 12),
@@ -191,7 +191,7 @@ TEST(StatementParser, NoTokensAfterAssignmentOperator) {
         Token(Token::Type::eof, "", 22)
     };
 
-    std::deque<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
+    std::vector<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
 
     ASSERT_TRUE(report.isError()) << "Expected error for no tokens after assignment operator";
     ASSERT_TRUE(result.empty()) << "Expected empty result for no tokens after assignment operator";
@@ -199,11 +199,11 @@ TEST(StatementParser, NoTokensAfterAssignmentOperator) {
 
 TEST(StatementParser, UnexpectedTokenBetweenParenAndAssignment) {
     MaybeError report;
-    std::deque<Token> start_of_line = {
+    std::vector<Token> start_of_line = {
         Token(Token::Type::id, "PAY", 0),
         Token(Token::Type::lparen, "(", 3)
     };
-    std::deque<Token> rest_of_line = {
+    std::vector<Token> rest_of_line = {
         Token(Token::Type::id, "enum_1", 4),
         Token(Token::Type::op, ",", 10),
         Token(Token::Type::id, "enum_2", 12),
@@ -214,7 +214,7 @@ TEST(StatementParser, UnexpectedTokenBetweenParenAndAssignment) {
         Token(Token::Type::eof, "", 30)
     };
 
-    std::deque<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
+    std::vector<Token> result = lineParseUtils::makePaymentExpression(report, start_of_line, rest_of_line);
 
     ASSERT_TRUE(report.isError()) << "Expected error for unexpected token between parenthesis and assignment";
     ASSERT_TRUE(result.empty()) << "Expected empty result for unexpected token between parenthesis and assignment";
@@ -261,7 +261,7 @@ TEST(StatementParser, LineParser) {
 
     Lexer l;
     for (const auto &[v_case, e_expected]: std::ranges::zip_view(valid_cases, expression_infix_expected)) {
-        std::deque<Token> line_infix = l.tokenize(v_case.line);
+        std::vector<Token> line_infix = l.tokenize(v_case.line);
 
         auto [report, result] = parseStartOfLine(line_infix);
 
@@ -280,4 +280,42 @@ TEST(StatementParser, LineParser) {
         }
     }
 
-}
\ No newline at end of file
+}
+
+TEST(StatementParser, MatchStartOfLine) {
+
+    using statement::Word;
+
+    Lexer l;
+    StatementMatch match;
+
+    const std::vector<Token> pay_line = l.tokenize("    PAY_AT (d, a) := x");
+    ASSERT_FALSE(lineParseUtils::matchStartOfLine(pay_line, match).isError());
+    ASSERT_EQ(match.size, 3);
+    EXPECT_EQ(match.words[0], Word::tab);
+    EXPECT_EQ(match.words[1], Word::pay_at);
+    EXPECT_EQ(match.words[2], Word::l_paren);
+    EXPECT_EQ(pay_line[match.tokens[1]].value, "PAY_AT");
+    EXPECT_EQ(pay_line[match.tokens[2]].value, "(");
+    EXPECT_EQ(pay_line[match.rest].value, "d");
+
+    const std::vector<Token> assign_line = l.tokenize("CONTINUOUS  x  **=  y");
+    ASSERT_FALSE(lineParseUtils::matchStartOfLine(assign_line, match).isError());
+    ASSERT_EQ(match.size, 3);
+    EXPECT_EQ(match.words[0], Word::continuous);
+    EXPECT_EQ(match.words[1], Word::id);
+    EXPECT_EQ(match.words[2], Word::pow_assign);
+    EXPECT_EQ(assign_line[match.tokens[2]].start, 15);
+
+    const std::vector<Token> else_line = l.tokenize("ELSE");
+    ASSERT_FALSE(lineParseUtils::matchStartOfLine(else_line, match).isError());
+    EXPECT_EQ(match.size, 1);
+    EXPECT_EQ(else_line[match.rest].type, Token::Type::eof);
+
+    // the options of the state the line got stuck in, in the order of statement::GRAMMAR
+    const std::vector<Token> bad_line = l.tokenize("myDate := x");
+    const MaybeError report = lineParseUtils::matchStartOfLine(bad_line, match);
+    ASSERT_TRUE(report.isError());
+    EXPECT_EQ(report.position().first, 7);
+    EXPECT_NE(report.msg().find(R"([<variable name>, "IF", "PAY", "PAY_AT"])"), std::string::npos) << report.msg();
+}
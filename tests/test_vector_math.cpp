@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vector_math.h"
+#include "reductions.h"
+
+
+using namespace flexMC;
+
+
+namespace {
+
+    const std::vector<vectorMath::Isa> ALL_ISAS{
+        vectorMath::Isa::scalar,
+        vectorMath::Isa::sse2,
+        vectorMath::Isa::avx2,
+        vectorMath::Isa::avx512,
+    };
+
+    // not a multiple of any lane count, the padded last block is covered
+    constexpr std::size_t SAMPLES = 100003;
+
+    // distance in representable doubles, both NaN counts as equal
+    std::int64_t ulpDistance(const double &a, const double &b) {
+        if (std::isnan(a) || std::isnan(b)) {
+            return std::isnan(a) && std::isnan(b) ? 0 : std::numeric_limits<std::int64_t>::max();
+        }
+        if (a == b) {
+            return 0;
+        }
+        const auto ordered = [](const double &value) {
+            std::int64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits < 0 ? std::numeric_limits<std::int64_t>::min() - bits : bits;
+        };
+        const std::int64_t diff = ordered(a) - ordered(b);
+        return diff < 0 ? -diff : diff;
+    }
+
+    template<class reference_function>
+    std::int64_t maxUlpError(const std::vector<double> &result, const std::vector<double> &x, reference_function f) {
+        std::int64_t max_error{0};
+        for (std::size_t i{0}; i < x.size(); ++i) {
+            max_error = std::max(max_error, ulpDistance(result[i], f(i)));
+        }
+        return max_error;
+    }
+
+    std::string isaName(const vectorMath::Isa &isa) {
+        return "isa " + std::to_string(static_cast<int>(isa));
+    }
+
+    // runs test on every instruction set of this machine and restores the selection
+    template<class isa_test>
+    void forEachIsa(isa_test test) {
+        const vectorMath::Isa selected = vectorMath::isa();
+        for (const auto &isa: ALL_ISAS) {
+            if (vectorMath::selectIsa(isa)) {
+                test(isa);
+            }
+        }
+        vectorMath::selectIsa(selected);
+    }
+
+}
+
+
+TEST(VectorMath, ScalarIsAlwaysAvailable) {
+    EXPECT_TRUE(vectorMath::isAvailable(vectorMath::Isa::scalar));
+    EXPECT_TRUE(vectorMath::isAvailable(vectorMath::isa()));
+}
+
+
+TEST(VectorMath, AccuracyAgainstLibm) {
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::vector<double> x(SAMPLES);
+    std::vector<double> y(SAMPLES);
+    std::vector<double> positive(SAMPLES);
+    std::vector<double> near_one(SAMPLES);
+    std::vector<double> large_exponent(SAMPLES);
+    for (std::size_t i{0}; i < SAMPLES; ++i) {
+        x[i] = unit(generator) * 740.0;
+        y[i] = unit(generator) * 30.0;
+        positive[i] = std::exp(unit(generator) * 700.0);
+        near_one[i] = 1.0 + unit(generator) * 0.1;
+        large_exponent[i] = unit(generator) * 7000.0;
+    }
+    std::vector<double> result(SAMPLES);
+    std::vector<double> small(SAMPLES);
+    for (std::size_t i{0}; i < SAMPLES; ++i) {
+        small[i] = std::exp(x[i] / 37.0);
+    }
+
+    forEachIsa([&](const vectorMath::Isa &isa) {
+        vectorMath::exp(x.data(), result.data(), SAMPLES);
+        EXPECT_LE(maxUlpError(result, x, [&](const std::size_t &i) { return std::exp(x[i]); }), 2) << isaName(isa);
+
+        vectorMath::log(positive.data(), result.data(), SAMPLES);
+        EXPECT_LE(maxUlpError(result, x, [&](const std::size_t &i) { return std::log(positive[i]); }), 2)
+                        << isaName(isa);
+        vectorMath::log(near_one.data(), result.data(), SAMPLES);
+        EXPECT_LE(maxUlpError(result, x, [&](const std::size_t &i) { return std::log(near_one[i]); }), 2)
+                        << isaName(isa);
+
+        vectorMath::sqrt(positive.data(), result.data(), SAMPLES);
+        EXPECT_EQ(maxUlpError(result, x, [&](const std::size_t &i) { return std::sqrt(positive[i]); }), 0)
+                        << isaName(isa);
+
+        vectorMath::pow(small.data(), y.data(), result.data(), SAMPLES);
+        EXPECT_LE(maxUlpError(result, x, [&](const std::size_t &i) { return std::pow(small[i], y[i]); }), 2)
+                        << isaName(isa);
+        // log(x) close to zero and results close to overflow and underflow
+        vectorMath::pow(near_one.data(), large_exponent.data(), result.data(), SAMPLES);
+        EXPECT_LE(maxUlpError(result, x, [&](const std::size_t &i) {
+            return std::pow(near_one[i], large_exponent[i]);
+        }), 2) << isaName(isa);
+    });
+}
+
+
+TEST(VectorMath, SpecialValues) {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double denormal = std::numeric_limits<double>::denorm_min();
+    const std::vector<double> values{
+        0.0, -0.0, 1.0, -1.0, 2.0, -2.5, 0.5, inf, -inf, nan, denormal, 1e-310, 1e308, 709.8, 710.0, -745.1, -746.0, 3.0
+    };
+    const std::size_t n = values.size();
+    std::vector<double> result(n);
+
+    forEachIsa([&](const vectorMath::Isa &isa) {
+        vectorMath::exp(values.data(), result.data(), n);
+        for (std::size_t i{0}; i < n; ++i) {
+            EXPECT_LE(ulpDistance(result[i], std::exp(values[i])), 1) << isaName(isa) << " exp " << values[i];
+        }
+        vectorMath::log(values.data(), result.data(), n);
+        for (std::size_t i{0}; i < n; ++i) {
+            EXPECT_LE(ulpDistance(result[i], std::log(values[i])), 1) << isaName(isa) << " log " << values[i];
+        }
+        vectorMath::sqrt(values.data(), result.data(), n);
+        for (std::size_t i{0}; i < n; ++i) {
+            EXPECT_EQ(ulpDistance(result[i], std::sqrt(values[i])), 0) << isaName(isa) << " sqrt " << values[i];
+        }
+        for (const double &exponent: values) {
+            vectorMath::pow(values.data(), exponent, result.data(), n);
+            for (std::size_t i{0}; i < n; ++i) {
+                EXPECT_LE(ulpDistance(result[i], std::pow(values[i], exponent)), 1)
+                                << isaName(isa) << " pow " << values[i] << " " << exponent;
+            }
+        }
+    });
+}
+
+
+TEST(VectorMath, OperandsAndAliasing) {
+    const std::vector<double> base{0.5, 1.5, 2.0, 3.0, 4.0, 5.0, 6.5, 7.0, 8.0, 9.0, 10.0};
+    const std::vector<double> exponents{2.0, -1.0, 0.5, 3.0, 1.0, 0.0, 2.0, -2.0, 1.0 / 3.0, 0.5, 1.5};
+    const std::size_t n = base.size();
+
+    forEachIsa([&](const vectorMath::Isa &isa) {
+        std::vector<double> result(base);
+        vectorMath::pow(result.data(), exponents.data(), result.data(), n);
+        for (std::size_t i{0}; i < n; ++i) {
+            EXPECT_LE(ulpDistance(result[i], std::pow(base[i], exponents[i])), 1) << isaName(isa);
+        }
+        result = exponents;
+        vectorMath::pow(2.0, result.data(), result.data(), n);
+        for (std::size_t i{0}; i < n; ++i) {
+            EXPECT_LE(ulpDistance(result[i], std::pow(2.0, exponents[i])), 1) << isaName(isa);
+        }
+        result = base;
+        vectorMath::exp(result.data(), result.data(), n);
+        for (std::size_t i{0}; i < n; ++i) {
+            EXPECT_LE(ulpDistance(result[i], std::exp(base[i])), 1) << isaName(isa);
+        }
+        // shorter than any register
+        result = base;
+        vectorMath::log(result.data(), result.data(), 1);
+        EXPECT_EQ(result[0], std::log(base[0])) << isaName(isa);
+        EXPECT_EQ(result[1], base[1]) << isaName(isa);
+    });
+}
+
+
+TEST(VectorMath, ReductionsMatchOnEveryIsa) {
+    std::mt19937_64 generator(7);
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::vector<double> x(SAMPLES);
+    std::vector<double> near_one(SAMPLES);
+    for (std::size_t i{0}; i < SAMPLES; ++i) {
+        // few distinct values, the first largest and smallest element is not the only one
+        x[i] = std::round(unit(generator) * 1000.0) / 8.0;
+        near_one[i] = 1.0 + unit(generator) * 1e-3;
+    }
+    const std::vector<std::size_t> sizes{1, 2, 7, 8, 9, 127, 128, 129, 1000, 8193, SAMPLES};
+
+    forEachIsa([&](const vectorMath::Isa &isa) {
+        EXPECT_EQ(vectorMath::sum(x.data(), 0), 0.0) << isaName(isa);
+        EXPECT_EQ(vectorMath::prod(x.data(), 0), 1.0) << isaName(isa);
+        for (const std::size_t &size: sizes) {
+            EXPECT_EQ(vectorMath::sum(x.data(), size), reductions::sum(x.data(), size)) << isaName(isa) << " " << size;
+            EXPECT_EQ(vectorMath::prod(near_one.data(), size), reductions::prod(near_one.data(), size))
+                            << isaName(isa) << " " << size;
+            const auto largest = std::max_element(x.begin(), x.begin() + static_cast<std::ptrdiff_t>(size));
+            const auto smallest = std::min_element(x.begin(), x.begin() + static_cast<std::ptrdiff_t>(size));
+            EXPECT_EQ(vectorMath::argmax(x.data(), size), static_cast<std::size_t>(largest - x.begin()))
+                            << isaName(isa) << " " << size;
+            EXPECT_EQ(vectorMath::argmin(x.data(), size), static_cast<std::size_t>(smallest - x.begin()))
+                            << isaName(isa) << " " << size;
+        }
+    });
+}
+
+
+TEST(VectorMath, ReductionSpecialValues) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    const std::vector<double> late_nan{1.0, 3.0, nan, 3.0, 5.0, nan, 5.0, -2.0, 0.0, -2.0, 4.0};
+    const std::vector<double> first_nan{nan, 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0};
+    const std::vector<double> zeros{0.0, -0.0, 0.0, -0.0, -inf, inf, -0.0, 0.0, -0.0};
+
+    forEachIsa([&](const vectorMath::Isa &isa) {
+        for (const auto &values: {late_nan, first_nan, zeros}) {
+            EXPECT_EQ(vectorMath::argmax(values.data(), values.size()),
+                      static_cast<std::size_t>(std::max_element(values.begin(), values.end()) - values.begin()))
+                            << isaName(isa);
+            EXPECT_EQ(vectorMath::argmin(values.data(), values.size()),
+                      static_cast<std::size_t>(std::min_element(values.begin(), values.end()) - values.begin()))
+                            << isaName(isa);
+        }
+        EXPECT_TRUE(std::isnan(vectorMath::sum(late_nan.data(), late_nan.size()))) << isaName(isa);
+        EXPECT_TRUE(std::isnan(vectorMath::sum(zeros.data(), zeros.size()))) << isaName(isa);
+    });
+}
+
+
+TEST(VectorMath, PairwiseSummationAccuracy) {
+    // 0.1 is not representable, a running sum of a million of them is off by about 1e-6
+    const std::size_t size{1000000};
+    const std::vector<double> x(size, 0.1);
+    const double exact = static_cast<double>(static_cast<long double>(0.1) * size);
+
+    forEachIsa([&](const vectorMath::Isa &isa) {
+        EXPECT_NEAR(vectorMath::sum(x.data(), size), exact, 1e-9) << isaName(isa);
+    });
+}
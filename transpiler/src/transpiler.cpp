@@ -0,0 +1,138 @@
+// flexmc_transpile : compiles scripts ahead of time into C++ functions which are built into a shared library
+//
+// usage: flexmc_transpile -o <out.cpp> [-s name=value]... [-p name=value]... <script>...
+//   -s  static variable, its value is compiled into the functions
+//   -p  parameter, read at evaluation from the Parameters passed in, slots in the order of the flags
+//   values containing commas are vectors. Each script becomes one function named after the file stem,
+//   its non-empty lines are the expressions whose results are pushed onto the stacks.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "lexer.h"
+#include "script.h"
+#include "language_error.h"
+#include "expression_parser.h"
+#include "expression_compiler.h"
+#include "static_variables.h"
+#include "transpiler.h"
+
+
+using namespace flexMC;
+
+
+namespace {
+
+    bool insertVariable(const std::string &definition, StaticVStorage &storage, const bool &parameter) {
+        const std::size_t equals = definition.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "expected name=value instead of " << definition << "\n";
+            return false;
+        }
+        const std::string name = definition.substr(0, equals);
+        std::stringstream values(definition.substr(equals + 1));
+        VECTOR vector;
+        std::string value;
+        try {
+            while (std::getline(values, value, ',')) {
+                vector.push_back(std::stod(value));
+            }
+        }
+        catch (const std::exception &) {
+            std::cerr << "invalid value for " << name << ": " << value << "\n";
+            return false;
+        }
+        if (vector.empty()) {
+            std::cerr << "missing value for " << name << "\n";
+            return false;
+        }
+        const bool scalar = (vector.size() == 1) && (definition.find(',') == std::string::npos);
+        if (parameter) {
+            scalar ? static_cast<void>(storage.insertParameter<SCALAR>(name, vector.front()))
+                   : static_cast<void>(storage.insertParameter<VECTOR>(name, vector));
+        }
+        else {
+            scalar ? storage.insert<SCALAR>(name, vector.front()) : storage.insert<VECTOR>(name, vector);
+        }
+        return true;
+    }
+
+    bool transpileScript(const std::filesystem::path &path, StaticVStorage &storage, std::string &out) {
+        // tokens are views into the script, which stays mapped until it is compiled
+        Script script;
+        if (const MaybeError open_report = script.open(path.string()); open_report.isError()) {
+            std::cerr << open_report.msg() << "\n";
+            return false;
+        }
+        std::vector<std::vector<Token>> postfixes;
+        for (ScriptLines lines(script.source()); lines.next();) {
+            auto [report, postfix] = infixToPostfix(lines.tokens());
+            if (report.isError()) {
+                report.setLine(lines.number());
+                std::cerr << path.string() << "\n" << printError("Parse Error", lines.line(), report) << "\n";
+                return false;
+            }
+            postfixes.push_back(std::move(postfix));
+        }
+        ByteCode code;
+        const auto [report, compile_reports] = compileStatements(postfixes, code, storage);
+        if (report.isError()) {
+            std::cerr << path.string() << "\n" << report.msg() << "\n";
+            return false;
+        }
+        const auto [transpile_report, function] = transpile(path.stem().string(), code);
+        if (transpile_report.isError()) {
+            std::cerr << path.string() << "\n" << transpile_report.msg() << "\n";
+            return false;
+        }
+        out += function;
+        return true;
+    }
+
+}
+
+
+int main(int argc, char *argv[]) {
+
+    std::string output;
+    StaticVStorage storage;
+    std::vector<std::filesystem::path> scripts;
+
+    for (int i{1}; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-o" || arg == "-s" || arg == "-p") && (i + 1 == argc)) {
+            std::cerr << "missing value after " << arg << "\n";
+            return 1;
+        }
+        if (arg == "-o") {
+            output = argv[++i];
+        }
+        else if ((arg == "-s") || (arg == "-p")) {
+            if (!insertVariable(argv[++i], storage, arg == "-p")) {
+                return 1;
+            }
+        }
+        else {
+            scripts.emplace_back(arg);
+        }
+    }
+    if (output.empty() || scripts.empty()) {
+        std::cerr << "usage: flexmc_transpile -o <out.cpp> [-s name=value]... [-p name=value]... <script>...\n";
+        return 1;
+    }
+
+    std::string source = transpilePreamble();
+    for (const auto &script: scripts) {
+        if (!transpileScript(script, storage, source)) {
+            return 1;
+        }
+    }
+
+    std::ofstream file(output);
+    file << source;
+    return file ? 0 : 1;
+}